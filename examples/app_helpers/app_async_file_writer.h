@@ -0,0 +1,332 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include "utility/span.h"
+#include "./app_io_buffers.h"
+
+#if !_WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct AsyncFileWriterConfig {
+    size_t block_size = size_t(1) << 20;    // bytes per write request, rounded up to ALIGNMENT
+    size_t total_blocks = 32;               // maximum amount of queued data is block_size*total_blocks
+    size_t total_threads = 4;               // concurrent writes in flight for regular files
+    bool is_direct_io = true;               // bypass the page cache with O_DIRECT if the filesystem supports it
+    bool is_drop_on_full = false;           // drop whole writes instead of blocking the producer
+};
+
+struct AsyncFileWriterStats {
+    uint64_t total_bytes_written = 0;
+    uint64_t total_bytes_dropped = 0;
+    uint64_t total_stalls = 0;
+    uint64_t total_errors = 0;
+    size_t queue_depth = 0;
+    size_t peak_queue_depth = 0;
+};
+
+// Writes a high rate stream to a file from background threads so the producer never waits on disk writeback
+// - Data is copied into aligned blocks which are written with pwrite(...) at their final offset
+//   This lets several blocks be in flight at once for regular files
+// - Uses O_DIRECT where supported so captures don't fill the page cache and trigger writeback stalls
+//   The final partial block is padded for O_DIRECT and the file is truncated back to its real length on close
+//   If the filesystem accepts the O_DIRECT flag but rejects the writes we fall back to buffered writes
+// - Pipes, stdout and Windows fall back to a single thread doing sequential fwrite(...)
+class AsyncFileWriter
+{
+public:
+    static constexpr size_t ALIGNMENT = 4096;
+private:
+    struct AlignedDeleter {
+        void operator()(uint8_t* data) const { operator delete[](data, std::align_val_t(ALIGNMENT)); }
+    };
+    struct Request {
+        size_t block_index;
+        size_t length;
+        uint64_t offset;
+    };
+    static constexpr size_t NONE = ~size_t(0);
+
+    FILE* m_file;
+    AsyncFileWriterConfig m_config;
+    int m_fd = -1;
+    bool m_is_seekable = false;
+    std::atomic<bool> m_is_direct_io{false};
+    std::atomic<bool> m_is_padded{false};
+    std::unique_ptr<uint8_t[], AlignedDeleter> m_blocks;
+    // producer
+    bool m_is_closed = false;
+    size_t m_current_block = NONE;
+    size_t m_current_length = 0;
+    uint64_t m_start_offset = 0;
+    uint64_t m_write_offset = 0;
+    // shared
+    std::mutex m_mutex;
+    std::condition_variable m_cv_request;
+    std::condition_variable m_cv_free;
+    std::deque<Request> m_requests;
+    std::vector<size_t> m_free_blocks;
+    AsyncFileWriterStats m_stats;
+    LatencyHistogram m_write_latency;
+    bool m_is_running = true;
+    std::vector<std::thread> m_threads;
+public:
+    explicit AsyncFileWriter(FILE* file, const AsyncFileWriterConfig& config = {})
+    : m_file(file), m_config(config)
+    {
+        m_config.block_size = std::max(m_config.block_size, ALIGNMENT);
+        m_config.block_size = (m_config.block_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        m_config.total_blocks = std::max(m_config.total_blocks, size_t(2));
+        m_config.total_threads = std::max(m_config.total_threads, size_t(1));
+        m_blocks.reset(new (std::align_val_t(ALIGNMENT)) uint8_t[m_config.block_size*m_config.total_blocks]);
+        for (size_t i = 0; i < m_config.total_blocks; i++) {
+            m_free_blocks.push_back(m_config.total_blocks-1-i);
+        }
+
+        fflush(m_file);
+#if !_WIN32
+        m_fd = fileno(m_file);
+        struct stat file_stat;
+        if ((fstat(m_fd, &file_stat) == 0) && S_ISREG(file_stat.st_mode)) {
+            const off_t offset = lseek(m_fd, 0, SEEK_CUR);
+            if (offset >= 0) {
+                m_is_seekable = true;
+                m_start_offset = uint64_t(offset);
+                m_write_offset = m_start_offset;
+            }
+        }
+#if defined(O_DIRECT)
+        // O_DIRECT requires aligned file offsets
+        if (m_is_seekable && m_config.is_direct_io && ((m_write_offset % ALIGNMENT) == 0)) {
+            const int flags = fcntl(m_fd, F_GETFL);
+            m_is_direct_io = (flags >= 0) && (fcntl(m_fd, F_SETFL, flags | O_DIRECT) == 0);
+        }
+#endif
+#endif
+        // sequential writes can't be reordered
+        const size_t total_threads = m_is_seekable ? m_config.total_threads : 1;
+        for (size_t i = 0; i < total_threads; i++) {
+            m_threads.emplace_back(&AsyncFileWriter::RunnerThread, this);
+        }
+    }
+    ~AsyncFileWriter() {
+        close();
+    }
+    AsyncFileWriter(AsyncFileWriter&) = delete;
+    AsyncFileWriter(AsyncFileWriter&&) = delete;
+    AsyncFileWriter& operator=(AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(AsyncFileWriter&&) = delete;
+
+    bool is_direct_io() const { return m_is_direct_io.load(); }
+    AsyncFileWriterStats get_stats() {
+        auto lock = std::scoped_lock(m_mutex);
+        return m_stats;
+    }
+    const LatencyHistogram& get_write_latency() const { return m_write_latency; }
+
+    // Returns number of bytes accepted which is either all of them or none if dropped
+    size_t write(tcb::span<const uint8_t> src) {
+        if (m_is_closed) return 0;
+        if (m_config.is_drop_on_full) {
+            const size_t current_free = (m_current_block != NONE) ? (m_config.block_size - m_current_length) : 0;
+            auto lock = std::scoped_lock(m_mutex);
+            const size_t total_free = current_free + m_free_blocks.size()*m_config.block_size;
+            if (src.size() > total_free) {
+                m_stats.total_bytes_dropped += src.size();
+                return 0;
+            }
+        }
+
+        const size_t total_bytes = src.size();
+        while (!src.empty()) {
+            if (m_current_block == NONE) {
+                m_current_block = acquire_block();
+                m_current_length = 0;
+                if (m_current_block == NONE) return total_bytes - src.size();
+            }
+            const size_t length = std::min(m_config.block_size - m_current_length, src.size());
+            memcpy(get_block(m_current_block) + m_current_length, src.data(), length);
+            m_current_length += length;
+            src = src.subspan(length);
+            if (m_current_length == m_config.block_size) {
+                submit_current_block();
+            }
+        }
+        return total_bytes;
+    }
+
+    // Submits any partially filled block and waits for all writes to complete
+    void close() {
+        if (m_is_closed) return;
+        m_is_closed = true;
+        if (m_current_block != NONE) {
+            submit_current_block();
+        }
+        {
+            auto lock = std::scoped_lock(m_mutex);
+            m_is_running = false;
+        }
+        m_cv_request.notify_all();
+        m_cv_free.notify_all();
+        for (auto& thread: m_threads) {
+            thread.join();
+        }
+        m_threads.clear();
+#if !_WIN32
+        if (m_is_seekable) {
+            // remove padding from the last O_DIRECT write and leave file position at the end
+            if (m_is_padded && (ftruncate(m_fd, off_t(m_write_offset)) != 0)) {
+                fprintf(stderr, "Failed to truncate output file (%d)\n", errno);
+            }
+            lseek(m_fd, off_t(m_write_offset), SEEK_SET);
+        }
+        disable_direct_io();
+#endif
+        // failed writes leave holes in the output so always tell the user
+        const auto stats = get_stats();
+        if (stats.total_errors > 0) {
+            fprintf(stderr, "Failed %" PRIu64 " writes to output file, %" PRIu64 "/%" PRIu64 " bytes were written\n",
+                stats.total_errors, stats.total_bytes_written, m_write_offset - m_start_offset);
+        }
+    }
+private:
+    uint8_t* get_block(size_t index) {
+        return m_blocks.get() + index*m_config.block_size;
+    }
+
+    size_t acquire_block() {
+        auto lock = std::unique_lock(m_mutex);
+        if (m_free_blocks.empty() && m_is_running) {
+            m_stats.total_stalls++;
+            m_cv_free.wait(lock, [this]() { return !m_free_blocks.empty() || !m_is_running; });
+        }
+        if (m_free_blocks.empty()) return NONE;
+        const size_t index = m_free_blocks.back();
+        m_free_blocks.pop_back();
+        return index;
+    }
+
+    void submit_current_block() {
+        Request request;
+        request.block_index = m_current_block;
+        request.length = m_current_length;
+        request.offset = m_write_offset;
+        m_write_offset += m_current_length;
+        m_current_block = NONE;
+        m_current_length = 0;
+        {
+            auto lock = std::scoped_lock(m_mutex);
+            m_requests.push_back(request);
+            m_stats.queue_depth++;
+            m_stats.peak_queue_depth = std::max(m_stats.peak_queue_depth, m_stats.queue_depth);
+        }
+        m_cv_request.notify_one();
+    }
+
+    void RunnerThread() {
+        auto lock = std::unique_lock(m_mutex);
+        while (true) {
+            m_cv_request.wait(lock, [this]() { return !m_requests.empty() || !m_is_running; });
+            // drain all pending requests before exiting
+            if (m_requests.empty()) break;
+            const auto request = m_requests.front();
+            m_requests.pop_front();
+            lock.unlock();
+
+            const auto start = std::chrono::steady_clock::now();
+            const bool is_success = write_block(request);
+            m_write_latency.add(std::chrono::steady_clock::now() - start);
+
+            lock.lock();
+            m_stats.queue_depth--;
+            if (is_success) {
+                m_stats.total_bytes_written += request.length;
+            } else {
+                m_stats.total_errors++;
+            }
+            m_free_blocks.push_back(request.block_index);
+            m_cv_free.notify_one();
+        }
+    }
+
+#if !_WIN32
+    // returns true if this call turned direct io off
+    bool disable_direct_io() {
+#if defined(O_DIRECT)
+        if (!m_is_direct_io.exchange(false)) return false;
+        const int flags = fcntl(m_fd, F_GETFL);
+        if (flags >= 0) fcntl(m_fd, F_SETFL, flags & ~O_DIRECT);
+        return true;
+#else
+        return false;
+#endif
+    }
+#endif
+
+    bool write_block(const Request& request) {
+        uint8_t* data = get_block(request.block_index);
+#if !_WIN32
+        if (m_is_seekable) {
+            bool is_direct_io = m_is_direct_io;
+            size_t length = request.length;
+            if (is_direct_io && ((length % ALIGNMENT) != 0)) {
+                const size_t padded_length = (length + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+                memset(data + length, 0, padded_length - length);
+                length = padded_length;
+                m_is_padded = true;
+            }
+            size_t total_written = 0;
+            while (total_written < length) {
+                const ssize_t res = pwrite(m_fd, data + total_written, length - total_written, off_t(request.offset + total_written));
+                if (res < 0 && errno == EINTR) continue;
+                if (res < 0 && errno == EINVAL && is_direct_io) {
+                    // some filesystems accept the O_DIRECT flag in fcntl(...) but reject the io itself
+                    if (disable_direct_io()) {
+                        fprintf(stderr, "Direct I/O write was rejected, falling back to buffered writes\n");
+                    }
+                    is_direct_io = false;
+                    length = std::max(request.length, total_written);
+                    continue;
+                }
+                if (res <= 0) return false;
+                total_written += size_t(res);
+            }
+            return true;
+        }
+#endif
+        return fwrite(data, sizeof(uint8_t), request.length, m_file) == request.length;
+    }
+};
+
+template <typename T>
+class AsyncOutputFile: public OutputBuffer<T>
+{
+private:
+    AsyncFileWriter m_writer;
+public:
+    explicit AsyncOutputFile(FILE* file, const AsyncFileWriterConfig& config = {}): m_writer(file, config) {}
+    ~AsyncOutputFile() override = default;
+    AsyncFileWriter& get_writer() { return m_writer; }
+    void close() { m_writer.close(); }
+    size_t write(tcb::span<const T> src) override {
+        const auto bytes = tcb::span<const uint8_t>(reinterpret_cast<const uint8_t*>(src.data()), src.size_bytes());
+        return m_writer.write(bytes) / sizeof(T);
+    }
+};
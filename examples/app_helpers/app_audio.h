@@ -2,31 +2,49 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include "basic_radio/basic_radio.h"
 #include "basic_radio/basic_audio_channel.h"
 #include "basic_radio/basic_audio_params.h"
 #include "dab/database/dab_database_types.h"
+#include "utility/latency_tracer.h"
 #include "utility/span.h"
 #include "../audio/audio_pipeline.h"
 #include "../audio/frame.h"
 
-static void attach_audio_pipeline_to_radio(std::shared_ptr<AudioPipeline> audio_pipeline, BasicRadio& basic_radio) {
+// Realtime inputs (tuners, paced replays) never block on the sink and rely on drift compensation instead
+// Otherwise the sink applies backpressure so file inputs play back at the sink's rate
+static void attach_audio_pipeline_to_radio(
+    std::shared_ptr<AudioPipeline> audio_pipeline, BasicRadio& basic_radio, const bool is_realtime_input
+) {
     if (audio_pipeline == nullptr) return;
+    auto* latency_tracer = &basic_radio.GetLatencyTracer();
     basic_radio.On_Audio_Channel().Attach(
-        [audio_pipeline](subchannel_id_t subchannel_id, Basic_Audio_Channel& channel) {
+        [audio_pipeline, latency_tracer, is_realtime_input](subchannel_id_t subchannel_id, Basic_Audio_Channel& channel) {
             auto& controls = channel.GetControls();
             auto audio_source = std::make_shared<AudioPipelineSource>();
             audio_pipeline->add_source(audio_source);
             channel.OnAudioData().Attach(
-                [&controls, audio_source, audio_pipeline]
+                [&controls, audio_source, audio_pipeline, latency_tracer, is_realtime_input]
                 (BasicAudioParams params, tcb::span<const uint8_t> buf) {
                     if (!controls.GetIsPlayAudio()) return;
+                    const auto time_decoded = FrameTimestamp::clock::now();
                     auto frame_ptr = reinterpret_cast<const Frame<int16_t>*>(buf.data());
                     const size_t total_frames = buf.size() / sizeof(Frame<int16_t>);
                     auto frame_buf = tcb::span(frame_ptr, total_frames);
-                    const bool is_blocking = audio_pipeline->get_sink() != nullptr;
+                    const bool is_sink = audio_pipeline->get_sink() != nullptr;
+                    const bool is_blocking = is_sink && !is_realtime_input;
                     audio_source->write(frame_buf, float(params.frequency), is_blocking);
+                    if (!is_sink) return;
+                    // the first sample of this block plays once everything queued before it is read by the sink
+                    const float block_duration = float(total_frames) / float(params.frequency);
+                    const float queue_duration = std::max(audio_source->get_buffered_duration() - block_duration, 0.0f);
+                    const auto time_played = FrameTimestamp::clock::now() + 
+                        std::chrono::duration_cast<FrameTimestamp::clock::duration>(std::chrono::duration<float>(queue_duration));
+                    latency_tracer->add(LatencyStage::AUDIO_OUTPUT, time_decoded, time_played);
+                    latency_tracer->add(LatencyStage::TOTAL_AUDIO, params.timestamp.time_received, time_played);
                 }
             );
         }
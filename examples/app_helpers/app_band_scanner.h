@@ -0,0 +1,215 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "basic_radio/basic_fic_runner.h"
+#include "dab/constants/dab_parameters.h"
+#include "dab/database/dab_database.h"
+#include "dab/database/dab_database_entities.h"
+#include "dab/database/dab_database_updater.h"
+#include "ofdm/ofdm_demodulator.h"
+#include "utility/latency_tracer.h"
+#include "utility/span.h"
+#include "viterbi_config.h"
+#include "./app_ofdm_blocks.h"
+
+struct BandScanConfig {
+    float sampling_rate = 2'048'000.0f;
+    float settle_seconds = 0.0f;            // samples right after retuning are discarded while the tuner settles
+    float presence_timeout_seconds = 0.19f; // block is empty if the PRS isn't found this long after retuning (includes settling)
+    int min_synced_frames = 1;              // number of PRS correlation peaks required for a signal to be present
+    float ensemble_timeout_seconds = 10.0f; // give up waiting for the full service list after this
+    int stable_frames = 10;                 // service list is complete if it hasn't changed for this many frames
+};
+
+struct BandScanService {
+    service_id_t reference = 0;
+    std::string label;
+};
+
+struct BandScanResult {
+    enum class Status { EMPTY, PARTIAL, COMPLETE };
+    std::string block_label;
+    uint32_t frequency = 0;
+    Status status = Status::EMPTY;
+    int total_synced_frames = 0;
+    int total_fic_frames = 0;
+    ensemble_id_t ensemble_reference = 0;
+    std::string ensemble_label;
+    std::vector<BandScanService> services;
+    float stream_seconds = 0.0f;            // amount of signal needed to reach the decision
+    float elapsed_seconds = 0.0f;           // wall clock time spent on the block
+    static const char* get_status_name(Status status) {
+        switch (status) {
+        case Status::EMPTY:     return "empty";
+        case Status::PARTIAL:   return "partial";
+        case Status::COMPLETE:  return "complete";
+        default:                return "unknown";
+        }
+    }
+};
+
+// Decides as quickly as possible whether a block contains a DAB ensemble and what it carries
+// 1. Empty blocks are rejected if the null symbol and PRS correlation doesn't lock within a few frames
+// 2. Occupied blocks only decode the FIC and stop once the ensemble id, label and service list are known
+// Decisions are made against the number of samples received so accelerated replays behave like a tuner
+class BandScanner
+{
+private:
+    const BandScanConfig m_config;
+    const DAB_Parameters m_dab_params;
+    std::unique_ptr<OFDM_Demod> m_ofdm_demod;
+    std::vector<std::complex<float>> m_buffer;
+    // current block
+    BandScanResult m_result;
+    bool m_is_finished = true;
+    uint64_t m_total_block_samples = 0;
+    int m_start_synced_frames = 0;
+    std::chrono::steady_clock::time_point m_time_start;
+    std::atomic<uint64_t> m_start_sample_index{0};
+    // fic decoding on the ofdm coordinator thread
+    std::mutex m_mutex_fic;
+    std::unique_ptr<BasicFICRunner> m_fic_runner;
+    std::atomic<bool> m_is_ensemble_complete{false};
+    int m_total_fic_frames = 0;
+    int m_total_stable_frames = 0;
+    size_t m_last_total_entities = 0;
+public:
+    BandScanner(const int transmission_mode, const BandScanConfig& config, const size_t total_ofdm_threads=1)
+    : m_config(config), m_dab_params(get_dab_parameters(transmission_mode))
+    {
+        const auto ofdm_params = get_DAB_OFDM_params(transmission_mode);
+        auto ofdm_prs_ref = std::vector<std::complex<float>>(ofdm_params.nb_fft);
+        get_DAB_PRS_reference(transmission_mode, ofdm_prs_ref);
+        auto ofdm_mapper_ref = std::vector<int>(ofdm_params.nb_data_carriers);
+        get_DAB_mapper_ref(ofdm_mapper_ref, ofdm_params.nb_fft);
+        m_ofdm_demod = std::make_unique<OFDM_Demod>(ofdm_params, ofdm_prs_ref, ofdm_mapper_ref, int(total_ofdm_threads));
+        m_fic_runner = std::make_unique<BasicFICRunner>(m_dab_params);
+        m_ofdm_demod->On_OFDM_Frame().Attach([this](tcb::span<const viterbi_bit_t> buf, const FrameTimestamp& timestamp) {
+            // frames still in the pipeline from the previous block are ignored
+            if (timestamp.sample_index <= m_start_sample_index.load(std::memory_order_acquire)) return;
+            process_fic(buf.first(size_t(m_dab_params.nb_fic_bits)));
+        });
+    }
+    BandScanner(BandScanner&) = delete;
+    BandScanner(BandScanner&&) = delete;
+    BandScanner& operator=(BandScanner&) = delete;
+    BandScanner& operator=(BandScanner&&) = delete;
+    auto& get_ofdm_demod() { return *(m_ofdm_demod.get()); }
+    bool is_finished() const { return m_is_finished; }
+    const BandScanResult& get_result() const { return m_result; }
+    // Call after tuning to a new block
+    void start_block(const std::string& label, const uint32_t frequency) {
+        m_ofdm_demod->Reset();
+        m_start_sample_index.store(m_ofdm_demod->GetTotalSamplesRead(), std::memory_order_release);
+        m_start_synced_frames = m_ofdm_demod->GetTotalFramesSynced();
+        {
+            auto lock = std::unique_lock(m_mutex_fic);
+            m_fic_runner = std::make_unique<BasicFICRunner>(m_dab_params);
+            m_is_ensemble_complete.store(false, std::memory_order_release);
+            m_total_fic_frames = 0;
+            m_total_stable_frames = 0;
+            m_last_total_entities = 0;
+        }
+        m_result = BandScanResult{};
+        m_result.block_label = label;
+        m_result.frequency = frequency;
+        m_total_block_samples = 0;
+        m_is_finished = false;
+        m_time_start = std::chrono::steady_clock::now();
+    }
+    // Returns true once a decision has been made for the current block
+    bool process(tcb::span<const RawIQ> buf) {
+        if (m_is_finished) return true;
+        const uint64_t total_settle_samples = to_samples(m_config.settle_seconds);
+        if (m_total_block_samples < total_settle_samples) {
+            const size_t total_skip = size_t(std::min(uint64_t(buf.size()), total_settle_samples - m_total_block_samples));
+            m_total_block_samples += total_skip;
+            buf = buf.subspan(total_skip);
+        }
+        if (!buf.empty()) {
+            m_buffer.resize(buf.size());
+            for (size_t i = 0; i < buf.size(); i++) {
+                m_buffer[i] = buf[i].to_c32();
+            }
+            m_ofdm_demod->Process(m_buffer);
+            m_total_block_samples += buf.size();
+        }
+
+        const int total_synced_frames = m_ofdm_demod->GetTotalFramesSynced() - m_start_synced_frames;
+        if (m_is_ensemble_complete.load(std::memory_order_acquire)) {
+            finish(BandScanResult::Status::COMPLETE, total_synced_frames);
+        } else if (
+            (total_synced_frames < m_config.min_synced_frames) &&
+            (m_total_block_samples >= to_samples(m_config.presence_timeout_seconds))
+        ) {
+            finish(BandScanResult::Status::EMPTY, total_synced_frames);
+        } else if (m_total_block_samples >= total_settle_samples + to_samples(m_config.ensemble_timeout_seconds)) {
+            finish(BandScanResult::Status::PARTIAL, total_synced_frames);
+        }
+        return m_is_finished;
+    }
+    // End of input for the current block
+    void stop() {
+        if (m_is_finished) return;
+        const int total_synced_frames = m_ofdm_demod->GetTotalFramesSynced() - m_start_synced_frames;
+        const auto status = (total_synced_frames >= m_config.min_synced_frames) ?
+            BandScanResult::Status::PARTIAL : BandScanResult::Status::EMPTY;
+        finish(status, total_synced_frames);
+    }
+private:
+    uint64_t to_samples(float seconds) const {
+        return uint64_t(double(seconds)*double(m_config.sampling_rate));
+    }
+    void process_fic(tcb::span<const viterbi_bit_t> fic_bits) {
+        auto lock = std::unique_lock(m_mutex_fic);
+        m_fic_runner->Process(fic_bits);
+        m_total_fic_frames++;
+        const auto& db_updater = m_fic_runner->GetDatabaseUpdater();
+        const size_t total_entities = db_updater.GetStatistics().nb_total;
+        if (total_entities != m_last_total_entities) {
+            m_last_total_entities = total_entities;
+            m_total_stable_frames = 0;
+        } else {
+            m_total_stable_frames++;
+        }
+        if (is_ensemble_complete(db_updater.GetDatabase())) {
+            m_is_ensemble_complete.store(true, std::memory_order_release);
+        }
+    }
+    bool is_ensemble_complete(const DAB_Database& db) const {
+        const auto& ensemble = db.ensemble;
+        if ((ensemble.reference == 0) || ensemble.label.empty()) return false;
+        if (db.services.empty()) return false;
+        for (const auto& service: db.services) {
+            if (service.label.empty()) return false;
+        }
+        // FIG 0/7 gives us the number of services otherwise wait until no new services show up
+        if (ensemble.nb_services > 0) return db.services.size() >= size_t(ensemble.nb_services);
+        return m_total_stable_frames >= m_config.stable_frames;
+    }
+    void finish(BandScanResult::Status status, int total_synced_frames) {
+        m_is_finished = true;
+        m_result.status = status;
+        m_result.total_synced_frames = total_synced_frames;
+        m_result.stream_seconds = float(double(m_total_block_samples)/double(m_config.sampling_rate));
+        m_result.elapsed_seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_time_start).count();
+        auto lock = std::unique_lock(m_mutex_fic);
+        m_result.total_fic_frames = m_total_fic_frames;
+        if (status == BandScanResult::Status::EMPTY) return;
+        const auto& db = m_fic_runner->GetDatabaseUpdater().GetDatabase();
+        m_result.ensemble_reference = db.ensemble.reference;
+        m_result.ensemble_label = db.ensemble.label;
+        for (const auto& service: db.services) {
+            m_result.services.push_back({ service.reference, service.label });
+        }
+    }
+};
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "basic_radio/basic_audio_channel.h"
+#include "basic_radio/basic_data_packet_channel.h"
+#include "basic_radio/basic_msc_runner.h"
+#include "basic_radio/basic_radio.h"
+#include "dab/database/dab_database.h"
+#include "dab/database/dab_database_entities.h"
+#include "ofdm/ofdm_demodulator.h"
+#include "utility/latency_tracer.h"
+#include "utility/stage_timer.h"
+#include "viterbi_config.h"
+#include "./app_json_writer.h"
+
+struct BenchmarkConfig {
+    std::string program_name;
+    std::string input_filename;
+    int transmission_mode = 1;
+    size_t ofdm_total_threads = 0;
+    size_t radio_total_threads = 0;
+};
+
+// Heap allocations made while the pipeline was running
+struct BenchmarkMemoryStats {
+    bool is_allocations_counted = false;
+    uint64_t total_allocations = 0;
+    uint64_t total_allocated_bytes = 0;
+    // highest live heap usage of the process since startup
+    uint64_t peak_heap_bytes = 0;
+};
+
+inline uint64_t get_peak_rss_bytes() {
+#if _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return uint64_t(counters.PeakWorkingSetSize);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return uint64_t(usage.ru_maxrss);
+#else
+    return uint64_t(usage.ru_maxrss)*1024;
+#endif
+#endif
+}
+
+// Writes build, host, throughput, per stage timing, latency and memory usage of a benchmark run as json
+// ofdm_demod and radio are optional depending on which parts of the pipeline were run
+class BenchmarkReport
+{
+private:
+    // DOC: docs/DAB_parameters.pdf
+    // Clause A1.1 - Each common interleaved frame is 24ms
+    static constexpr double CIF_DURATION_SECONDS = 24e-3;
+    static constexpr double SAMPLING_RATE = 2.048e6;
+    const BenchmarkConfig m_config;
+    const double m_elapsed_seconds;
+    const OFDM_Demod* m_ofdm_demod = nullptr;
+    BasicRadio* m_radio = nullptr;
+    BenchmarkMemoryStats m_memory_stats;
+public:
+    BenchmarkReport(const BenchmarkConfig& config, double elapsed_seconds)
+    : m_config(config), m_elapsed_seconds(elapsed_seconds) {}
+    void set_ofdm_demod(const OFDM_Demod* ofdm_demod) { m_ofdm_demod = ofdm_demod; }
+    void set_radio(BasicRadio* radio) { m_radio = radio; }
+    void set_memory_stats(const BenchmarkMemoryStats& stats) { m_memory_stats = stats; }
+    void write(FILE* fp) {
+        auto json = JsonWriter(fp);
+        json.begin_object();
+        json.field("program", m_config.program_name);
+        write_json_build_info(json);
+        write_json_host_info(json);
+        write_config(json);
+        write_throughput(json);
+        write_stages(json);
+        write_subchannels(json);
+        write_latency(json);
+        write_memory(json);
+        json.end_object();
+        fputc('\n', fp);
+    }
+private:
+    void write_config(JsonWriter& json) {
+        json.key("config");
+        json.begin_object();
+        json.field("input", m_config.input_filename.empty() ? std::string("stdin") : m_config.input_filename);
+        json.field("transmission_mode", m_config.transmission_mode);
+        json.field("is_ofdm_used", m_ofdm_demod != nullptr);
+        json.field("is_dab_used", m_radio != nullptr);
+        json.field("ofdm_total_threads", uint64_t(m_config.ofdm_total_threads));
+        json.field("radio_total_threads", uint64_t(m_config.radio_total_threads));
+        json.end_object();
+    }
+    void write_throughput(JsonWriter& json) {
+        const auto dab_params = get_dab_parameters(m_config.transmission_mode);
+        const double frame_seconds = double(dab_params.nb_cifs)*CIF_DURATION_SECONDS;
+        const double elapsed = (m_elapsed_seconds > 0.0) ? m_elapsed_seconds : 1e-9;
+        uint64_t total_ofdm_frames = 0;
+        uint64_t total_samples = 0;
+        if (m_ofdm_demod != nullptr) {
+            total_ofdm_frames = uint64_t(m_ofdm_demod->GetTotalFramesRead());
+            total_samples = m_ofdm_demod->GetTotalSamplesRead();
+        }
+        uint64_t total_radio_frames = 0;
+        if (m_radio != nullptr) {
+            total_radio_frames = m_radio->GetLatencyTracer().get(LatencyStage::TOTAL_FRAME).get_total_count();
+        }
+        const uint64_t total_frames = (m_radio != nullptr) ? total_radio_frames : total_ofdm_frames;
+        // samples are only known when we demodulate, otherwise estimate from the duration of each frame
+        const double stream_seconds = (m_ofdm_demod != nullptr) ?
+            double(total_samples)/SAMPLING_RATE :
+            double(total_radio_frames)*frame_seconds;
+
+        json.key("throughput");
+        json.begin_object();
+        json.field("elapsed_seconds", m_elapsed_seconds);
+        json.field("stream_seconds", stream_seconds);
+        json.field("total_samples", total_samples);
+        json.field("total_ofdm_frames", total_ofdm_frames);
+        json.field("total_radio_frames", total_radio_frames);
+        if (m_ofdm_demod != nullptr) {
+            json.field("total_ofdm_desyncs", uint64_t(m_ofdm_demod->GetTotalFramesDesync()));
+        }
+        json.field("frames_per_second", double(total_frames)/elapsed);
+        json.field("realtime_factor", stream_seconds/elapsed);
+        json.end_object();
+    }
+    void write_stage(JsonWriter& json, const char* name, uint64_t calls, uint64_t ns) {
+        const double elapsed = (m_elapsed_seconds > 0.0) ? m_elapsed_seconds : 1e-9;
+        json.key(name);
+        json.begin_object();
+        json.field("calls", calls);
+        json.field("total_ms", double(ns)*1e-6);
+        json.field("mean_us", (calls > 0) ? double(ns)*1e-3/double(calls) : 0.0);
+        // can exceed 1.0 if the stage runs on multiple threads
+        json.field("load", double(ns)*1e-9/elapsed);
+        json.end_object();
+    }
+    void write_stage(JsonWriter& json, const char* name, const StageTimer& timer) {
+        write_stage(json, name, timer.get_total_calls(), timer.get_total_ns());
+    }
+    void write_stages(JsonWriter& json) {
+        json.key("stages");
+        json.begin_object();
+        if (m_ofdm_demod != nullptr) {
+            const auto& timers = m_ofdm_demod->GetStageTimers();
+            write_stage(json, "ofdm_sync", timers.sync);
+            write_stage(json, "ofdm_fft", timers.fft);
+            write_stage(json, "ofdm_dqpsk", timers.dqpsk);
+        }
+        if (m_radio != nullptr) {
+            write_stage(json, "fic", m_radio->GetFICTimer());
+            // totals across subchannels
+            struct Total { uint64_t calls = 0; uint64_t ns = 0; };
+            Total viterbi, reed_solomon, aac_decode, mp2_decode;
+            const auto merge = [](Total& dest, const StageTimer& src) {
+                dest.calls += src.get_total_calls();
+                dest.ns += src.get_total_ns();
+            };
+            for_each_runner([&](subchannel_id_t, const char*, const Basic_MSC_Runner& runner) {
+                const auto& timers = runner.GetStageTimers();
+                merge(viterbi, timers.viterbi);
+                merge(reed_solomon, timers.reed_solomon);
+                merge(aac_decode, timers.aac_decode);
+                merge(mp2_decode, timers.mp2_decode);
+            });
+            write_stage(json, "msc_viterbi", viterbi.calls, viterbi.ns);
+            write_stage(json, "msc_reed_solomon", reed_solomon.calls, reed_solomon.ns);
+            write_stage(json, "aac_decode", aac_decode.calls, aac_decode.ns);
+            write_stage(json, "mp2_decode", mp2_decode.calls, mp2_decode.ns);
+        }
+        json.end_object();
+    }
+    void write_subchannels(JsonWriter& json) {
+        if (m_radio == nullptr) return;
+        json.key("subchannels");
+        json.begin_array();
+        for_each_runner([&](subchannel_id_t id, const char* type, const Basic_MSC_Runner& runner) {
+            const auto& timers = runner.GetStageTimers();
+            json.begin_object();
+            json.field("id", int(id));
+            json.field("type", type);
+            write_stage(json, "viterbi", timers.viterbi);
+            if (timers.reed_solomon.get_total_calls() > 0) write_stage(json, "reed_solomon", timers.reed_solomon);
+            if (timers.aac_decode.get_total_calls() > 0) write_stage(json, "aac_decode", timers.aac_decode);
+            if (timers.mp2_decode.get_total_calls() > 0) write_stage(json, "mp2_decode", timers.mp2_decode);
+            json.end_object();
+        });
+        json.end_array();
+    }
+    void write_latency(JsonWriter& json) {
+        if (m_radio == nullptr) return;
+        const auto& tracer = m_radio->GetLatencyTracer();
+        json.key("latency");
+        json.begin_object();
+        for (size_t i = 0; i < LatencyTracer::TOTAL_STAGES; i++) {
+            const auto stage = LatencyStage(i);
+            const auto& histogram = tracer.get(stage);
+            const uint64_t count = histogram.get_total_count();
+            if (count == 0) continue;
+            json.key(LatencyTracer::get_stage_name(stage));
+            json.begin_object();
+            json.field("count", count);
+            json.field("mean_us", double(histogram.get_total_ns())*1e-3/double(count));
+            // percentiles are the upper bound of their log2 histogram bucket
+            json.field("p50_us", histogram.get_percentile_us(0.50));
+            json.field("p99_us", histogram.get_percentile_us(0.99));
+            json.field("max_us", double(histogram.get_max_ns())*1e-3);
+            json.end_object();
+        }
+        json.end_object();
+    }
+    void write_memory(JsonWriter& json) {
+        json.key("memory");
+        json.begin_object();
+        json.field("peak_rss_bytes", get_peak_rss_bytes());
+        if (m_memory_stats.is_allocations_counted) {
+            json.field("total_allocations", m_memory_stats.total_allocations);
+            json.field("total_allocated_bytes", m_memory_stats.total_allocated_bytes);
+            json.field("peak_heap_bytes", m_memory_stats.peak_heap_bytes);
+        }
+        json.end_object();
+    }
+    template <typename F>
+    void for_each_runner(F&& func) {
+        auto& database = m_radio->GetDatabase();
+        for (const auto& subchannel: database.subchannels) {
+            const auto* audio_channel = m_radio->Get_Audio_Channel(subchannel.id);
+            if (audio_channel != nullptr) {
+                const bool is_dab_plus = audio_channel->GetType() == AudioServiceType::DAB_PLUS;
+                func(subchannel.id, is_dab_plus ? "dab_plus" : "dab", *audio_channel);
+                continue;
+            }
+            const auto* data_channel = m_radio->Get_Data_Packet_Channel(subchannel.id);
+            if (data_channel != nullptr) {
+                func(subchannel.id, "data_packet", *data_channel);
+            }
+        }
+    }
+};
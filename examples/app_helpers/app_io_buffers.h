@@ -1,18 +1,35 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <thread>
 #include <vector>
+#include "utility/latency_tracer.h"
 #include "utility/span.h"
-#include "../audio/ring_buffer.h"
+#include "./app_mapped_file.h"
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
 
 template <typename T>
 struct InputBuffer {
     virtual ~InputBuffer() {}
     virtual size_t read(tcb::span<T> dest) = 0;
+    // Zero copy read that returns a view into the buffer's own storage
+    // The view is only valid until the next read
+    // Returns std::nullopt if this isn't supported and read(...) should be used instead
+    virtual std::optional<tcb::span<const T>> read_view(size_t /*length*/) { return std::nullopt; }
 };
 
 template <typename T>
@@ -28,6 +45,10 @@ private:
 public:
     explicit FileWrapper(FILE* file): m_file(file) {}
     virtual ~FileWrapper() { close(); }
+    bool is_open() {
+        auto lock = std::shared_lock(m_mutex);
+        return m_file != nullptr;
+    }
     void close() {
         auto lock = std::unique_lock(m_mutex);
         if (m_file != nullptr) {
@@ -49,14 +70,49 @@ public:
     }
 };
 
+// Regular files are memory mapped so readers can consume data without copying it
+// Pipes and devices fall back to buffered reads
 template <typename T>
 class InputFile: public InputBuffer<T>, public FileWrapper {
 private:
+    std::unique_ptr<MappedFile> m_mapped_file = nullptr;
+    tcb::span<const T> m_mapped_data;
+    size_t m_mapped_index = 0;
 public:
-    explicit InputFile(FILE* file): FileWrapper(file) {}
+    explicit InputFile(FILE* file, bool is_memory_mapped=true): FileWrapper(file) {
+        if (is_memory_mapped) {
+            m_mapped_file = MappedFile::open(file);
+        }
+        if (m_mapped_file != nullptr) {
+            const auto data = m_mapped_file->get_data();
+            if ((reinterpret_cast<uintptr_t>(data.data()) % alignof(T)) == 0) {
+                // trailing partial element is ignored like with fread
+                m_mapped_data = { reinterpret_cast<const T*>(data.data()), data.size() / sizeof(T) };
+            } else {
+                m_mapped_file = nullptr;
+            }
+        }
+    }
     ~InputFile() override = default; 
+    bool is_memory_mapped() const { return m_mapped_file != nullptr; }
     size_t read(tcb::span<T> dest) override {
-        return FileWrapper::read(dest);
+        if (m_mapped_file == nullptr) {
+            return FileWrapper::read(dest);
+        }
+        const auto src = read_view(dest.size());
+        if (!src.has_value()) return 0;
+        memcpy(dest.data(), src->data(), src->size()*sizeof(T));
+        return src->size();
+    }
+    std::optional<tcb::span<const T>> read_view(size_t length) override {
+        if (m_mapped_file == nullptr) return std::nullopt;
+        if (!is_open()) return tcb::span<const T>();
+        length = std::min(length, m_mapped_data.size()-m_mapped_index);
+        // only the previous view is consumed so the pages of the returned view must stay mapped
+        m_mapped_file->advise(m_mapped_index*sizeof(T));
+        const auto view = m_mapped_data.subspan(m_mapped_index, length);
+        m_mapped_index += length;
+        return view;
     }
 };
 
@@ -83,63 +139,164 @@ public:
     }
 };
 
-// single producer single consumer ring buffer
+// Lock free single producer single consumer ring buffer
+// - Read and write positions are monotonic counters on separate cache lines to avoid false sharing
+// - Each read/write copies all available data and publishes it with a single atomic store
+// - Waiting spins briefly, then yields, then sleeps on a condition variable
+//   The peer only takes the mutex to wake us if we are actually asleep
 template <typename T>
 class ThreadedRingBuffer: public InputBuffer<T>, public OutputBuffer<T>
 {
 private:
-    RingBuffer<T> m_ring_buffer;
-    std::mutex m_mutex_ring_buffer;
-    std::condition_variable m_cv_reader;
-    std::condition_variable m_cv_writer;
-    bool m_is_closed = false;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr int TOTAL_SPINS = 256;
+    static constexpr int TOTAL_YIELDS = 16;
+    std::vector<T> m_data;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_total_written{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_total_read{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> m_is_closed{false};
+    std::atomic<bool> m_is_reader_sleeping{false};
+    std::atomic<bool> m_is_writer_sleeping{false};
+    std::mutex m_mutex_sleep;
+    std::condition_variable m_cv_sleep;
+    LatencyHistogram m_reader_waits;
+    LatencyHistogram m_writer_waits;
 public:
-    explicit ThreadedRingBuffer(size_t length): m_ring_buffer(length) {}
+    explicit ThreadedRingBuffer(size_t length): m_data(length) {}
     ~ThreadedRingBuffer() override {
         close();
     }
+    ThreadedRingBuffer(ThreadedRingBuffer&) = delete;
+    ThreadedRingBuffer(ThreadedRingBuffer&&) = delete;
+    ThreadedRingBuffer& operator=(ThreadedRingBuffer&) = delete;
+    ThreadedRingBuffer& operator=(ThreadedRingBuffer&&) = delete;
 
     void close() {
         {
-            auto lock = std::unique_lock(m_mutex_ring_buffer);
-            m_is_closed = true;
+            auto lock = std::unique_lock(m_mutex_sleep);
+            m_is_closed.store(true);
         }
-        m_cv_reader.notify_all();
-        m_cv_writer.notify_all();
+        m_cv_sleep.notify_all();
     }
 
+    size_t get_size() const { return m_data.size(); }
+    size_t get_total_used() const {
+        const uint64_t total_read = m_total_read.load(std::memory_order_acquire);
+        const uint64_t total_written = m_total_written.load(std::memory_order_acquire);
+        return size_t(total_written - total_read);
+    }
+    float get_fill_level() const { return float(get_total_used()) / float(get_size()); }
+    // time the consumer spent waiting for data
+    const LatencyHistogram& get_reader_waits() const { return m_reader_waits; }
+    // time the producer spent waiting for space
+    const LatencyHistogram& get_writer_waits() const { return m_writer_waits; }
+
     size_t read(tcb::span<T> dest) override {
-        auto lock = std::unique_lock(m_mutex_ring_buffer);
-        size_t total_written = 0;
-        while (true) {
-            const size_t length = m_ring_buffer.read(dest);
-            total_written += length;
+        const size_t N = m_data.size();
+        const uint64_t start_index = m_total_read.load(std::memory_order_relaxed);
+        uint64_t read_index = start_index;
+        while (!dest.empty()) {
+            const uint64_t write_index = m_total_written.load(std::memory_order_acquire);
+            const size_t total_used = size_t(write_index - read_index);
+            if (total_used == 0) {
+                const bool is_ready = wait_until(m_is_reader_sleeping, m_reader_waits, [this, read_index]() {
+                    return m_total_written.load(std::memory_order_acquire) != read_index;
+                });
+                if (!is_ready) break;
+                continue;
+            }
+
+            const size_t length = std::min(total_used, dest.size());
+            const size_t offset = size_t(read_index % N);
+            const size_t head_length = std::min(length, N-offset);
+            memcpy(dest.data(), m_data.data() + offset, head_length*sizeof(T));
+            memcpy(dest.data() + head_length, m_data.data(), (length-head_length)*sizeof(T));
+            read_index += length;
             dest = dest.subspan(length);
-            if (length > 0) m_cv_reader.notify_one();
-            if (dest.empty()) break;
-            m_cv_writer.wait(lock, [this](){
-                return m_is_closed || !m_ring_buffer.is_empty();
-            });
-            if (m_is_closed) break;
+            m_total_read.store(read_index, std::memory_order_release);
+            wake(m_is_writer_sleeping);
         }
-        return total_written;
+        return size_t(read_index - start_index);
     }
 
     size_t write(tcb::span<const T> src) override {
-        auto lock = std::unique_lock(m_mutex_ring_buffer);
-        size_t total_read = 0;
-        while (true) {
-            const size_t length = m_ring_buffer.write(src);
-            total_read += length;
+        const size_t N = m_data.size();
+        const uint64_t start_index = m_total_written.load(std::memory_order_relaxed);
+        uint64_t write_index = start_index;
+        while (!src.empty()) {
+            if (m_is_closed.load(std::memory_order_relaxed)) break;
+            const uint64_t read_index = m_total_read.load(std::memory_order_acquire);
+            const size_t total_free = N - size_t(write_index - read_index);
+            if (total_free == 0) {
+                const bool is_ready = wait_until(m_is_writer_sleeping, m_writer_waits, [this, write_index, N]() {
+                    return size_t(write_index - m_total_read.load(std::memory_order_acquire)) != N;
+                });
+                if (!is_ready) break;
+                continue;
+            }
+
+            const size_t length = std::min(total_free, src.size());
+            const size_t offset = size_t(write_index % N);
+            const size_t head_length = std::min(length, N-offset);
+            memcpy(m_data.data() + offset, src.data(), head_length*sizeof(T));
+            memcpy(m_data.data(), src.data() + head_length, (length-head_length)*sizeof(T));
+            write_index += length;
             src = src.subspan(length);
-            if (length > 0) m_cv_writer.notify_one();
-            if (src.empty()) break;
-            m_cv_reader.wait(lock, [this](){
-                return m_is_closed || !m_ring_buffer.is_full();
+            m_total_written.store(write_index, std::memory_order_release);
+            wake(m_is_reader_sleeping);
+        }
+        return size_t(write_index - start_index);
+    }
+private:
+    static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        _mm_pause();
+#endif
+    }
+
+    // returns false if the buffer was closed before the condition was met
+    template <typename F>
+    bool wait_until(std::atomic<bool>& is_sleeping, LatencyHistogram& histogram, F&& is_ready) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto record = [&histogram, start]() {
+            histogram.add(std::chrono::steady_clock::now() - start);
+        };
+        for (int i = 0; i < TOTAL_SPINS+TOTAL_YIELDS; i++) {
+            if (is_ready()) {
+                record();
+                return true;
+            }
+            if (m_is_closed.load(std::memory_order_relaxed)) return false;
+            if (i < TOTAL_SPINS) {
+                cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        bool is_success = false;
+        {
+            auto lock = std::unique_lock(m_mutex_sleep);
+            is_sleeping.store(true, std::memory_order_relaxed);
+            // pairs with fence in wake(...) so either we see the update or they see us sleeping
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_cv_sleep.wait(lock, [this, &is_ready]() {
+                return is_ready() || m_is_closed.load(std::memory_order_relaxed);
             });
-            if (m_is_closed) break;
+            is_sleeping.store(false, std::memory_order_relaxed);
+            is_success = is_ready();
+        }
+        record();
+        return is_success;
+    }
+
+    void wake(std::atomic<bool>& is_sleeping) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!is_sleeping.load(std::memory_order_relaxed)) return;
+        {
+            auto lock = std::unique_lock(m_mutex_sleep);
         }
-        return total_read;
+        m_cv_sleep.notify_all();
     }
 };
 
@@ -163,3 +320,26 @@ public:
         return max_length;
     };
 };
+
+// Passes the timestamp of each OFDM frame alongside its bits which go through a separate byte stream
+// Frames are written and read whole and in order so timestamps can be matched by position
+// Oldest timestamps are dropped if the reader isn't consuming them
+class FrameTimestampQueue {
+private:
+    static constexpr size_t MAX_LENGTH = 32;
+    std::deque<FrameTimestamp> m_queue;
+    std::mutex m_mutex;
+public:
+    void push(const FrameTimestamp& timestamp) {
+        auto lock = std::scoped_lock(m_mutex);
+        if (m_queue.size() >= MAX_LENGTH) m_queue.pop_front();
+        m_queue.push_back(timestamp);
+    }
+    std::optional<FrameTimestamp> pop() {
+        auto lock = std::scoped_lock(m_mutex);
+        if (m_queue.empty()) return std::nullopt;
+        const auto timestamp = m_queue.front();
+        m_queue.pop_front();
+        return timestamp;
+    }
+};
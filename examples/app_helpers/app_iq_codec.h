@@ -0,0 +1,426 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "utility/span.h"
+#include "./app_io_buffers.h"
+
+// Compressed archive format for 8bit IQ captures
+// The stream is a sequence of independent blocks so it can be concatenated, seeked and decoded in parallel
+// Each block has a 16 byte header followed by its payload
+//   [0:4]   magic "IQZB"
+//   [4:8]   number of raw bytes (little endian)
+//   [8:12]  number of payload bytes (little endian)
+//   [12]    mode (see IQ_Codec_Mode)
+//   [13]    number of low bits discarded for near lossless compression (0 = lossless)
+//   [14:16] reserved
+// Entropy coded payloads start with a 256 entry frequency table (uint16 little endian) followed by rANS data
+// DOC: https://arxiv.org/abs/1311.2540
+// Asymmetric numeral systems: entropy coding combining speed of Huffman coding with compression rate of arithmetic coding
+
+enum class IQ_Codec_Mode: uint8_t {
+    STORED = 0,             // raw bytes
+    ORDER0 = 1,             // rANS coded bytes
+    DELTA_ORDER0 = 2,       // rANS coded difference between consecutive I or Q values
+};
+
+constexpr size_t IQ_CODEC_HEADER_SIZE = 16;
+constexpr size_t IQ_CODEC_TABLE_SIZE = 256*sizeof(uint16_t);
+constexpr uint8_t IQ_CODEC_MAGIC[4] = {'I','Q','Z','B'};
+// the decoder allocates the raw block from the header so a corrupt header can't request gigabytes
+constexpr size_t IQ_CODEC_MAX_BLOCK_SIZE = size_t(1) << 26;
+
+struct IQ_Codec_Header {
+    uint32_t total_raw_bytes = 0;
+    uint32_t total_payload_bytes = 0;
+    IQ_Codec_Mode mode = IQ_Codec_Mode::STORED;
+    uint8_t quantise_bits = 0;
+};
+
+static void iq_codec_write_u32(uint8_t* dest, uint32_t x) {
+    for (int i = 0; i < 4; i++) dest[i] = uint8_t(x >> (8*i));
+}
+
+static uint32_t iq_codec_read_u32(const uint8_t* src) {
+    uint32_t x = 0;
+    for (int i = 0; i < 4; i++) x |= uint32_t(src[i]) << (8*i);
+    return x;
+}
+
+static void iq_codec_write_header(uint8_t* dest, const IQ_Codec_Header& header) {
+    memcpy(dest, IQ_CODEC_MAGIC, sizeof(IQ_CODEC_MAGIC));
+    iq_codec_write_u32(dest+4, header.total_raw_bytes);
+    iq_codec_write_u32(dest+8, header.total_payload_bytes);
+    dest[12] = uint8_t(header.mode);
+    dest[13] = header.quantise_bits;
+    dest[14] = 0;
+    dest[15] = 0;
+}
+
+static std::optional<IQ_Codec_Header> iq_codec_read_header(const uint8_t* src) {
+    if (memcmp(src, IQ_CODEC_MAGIC, sizeof(IQ_CODEC_MAGIC)) != 0) return std::nullopt;
+    IQ_Codec_Header header;
+    header.total_raw_bytes = iq_codec_read_u32(src+4);
+    header.total_payload_bytes = iq_codec_read_u32(src+8);
+    header.mode = IQ_Codec_Mode(src[12]);
+    header.quantise_bits = src[13];
+    if (header.mode > IQ_Codec_Mode::DELTA_ORDER0) return std::nullopt;
+    if (header.quantise_bits >= 8) return std::nullopt;
+    if (header.total_raw_bytes > IQ_CODEC_MAX_BLOCK_SIZE) return std::nullopt;
+    // the encoder stores blocks as is when coding them wouldn't make them smaller
+    if (header.total_payload_bytes > header.total_raw_bytes) return std::nullopt;
+    return header;
+}
+
+// Byte oriented rANS with a 12bit probability scale
+class IQ_Rans
+{
+public:
+    static constexpr uint32_t PROB_BITS = 12;
+    static constexpr uint32_t PROB_SCALE = 1u << PROB_BITS;
+    static constexpr uint32_t RANS_L = 1u << 23;
+    using Frequencies = std::array<uint16_t, 256>;
+
+    // Scale histogram so it sums to PROB_SCALE while keeping every used symbol non-zero
+    static Frequencies normalise(const std::array<uint32_t, 256>& counts, size_t total) {
+        Frequencies freqs{};
+        if (total == 0) return freqs;
+        int32_t sum = 0;
+        for (size_t i = 0; i < 256; i++) {
+            if (counts[i] == 0) continue;
+            const uint32_t freq = uint32_t((uint64_t(counts[i]) * PROB_SCALE) / total);
+            freqs[i] = uint16_t(std::max(freq, uint32_t(1)));
+            sum += freqs[i];
+        }
+        // correct rounding error using the most probable symbols
+        while (sum != int32_t(PROB_SCALE)) {
+            size_t best = 0;
+            for (size_t i = 1; i < 256; i++) {
+                if (freqs[i] > freqs[best]) best = i;
+            }
+            if (sum > int32_t(PROB_SCALE)) {
+                const int32_t excess = std::min(sum - int32_t(PROB_SCALE), int32_t(freqs[best]) - 1);
+                if (excess == 0) break;
+                freqs[best] = uint16_t(freqs[best] - excess);
+                sum -= excess;
+            } else {
+                freqs[best] = uint16_t(freqs[best] + (int32_t(PROB_SCALE) - sum));
+                sum = int32_t(PROB_SCALE);
+            }
+        }
+        return freqs;
+    }
+
+    // Encodes into the back of dest and returns the used suffix
+    static tcb::span<uint8_t> encode(tcb::span<const uint8_t> src, const Frequencies& freqs, tcb::span<uint8_t> dest) {
+        std::array<uint32_t, 256> starts;
+        uint32_t start = 0;
+        for (size_t i = 0; i < 256; i++) {
+            starts[i] = start;
+            start += freqs[i];
+        }
+        uint8_t* end = dest.data() + dest.size();
+        uint8_t* ptr = end;
+        uint32_t x = RANS_L;
+        // rANS is last in first out so encode backwards
+        for (size_t i = src.size(); i > 0; i--) {
+            const uint8_t s = src[i-1];
+            const uint32_t freq = freqs[s];
+            const uint32_t x_max = ((RANS_L >> PROB_BITS) << 8) * freq;
+            while (x >= x_max) {
+                *--ptr = uint8_t(x & 0xFF);
+                x >>= 8;
+            }
+            x = ((x / freq) << PROB_BITS) + (x % freq) + starts[s];
+        }
+        ptr -= 4;
+        iq_codec_write_u32(ptr, x);
+        return { ptr, size_t(end - ptr) };
+    }
+
+    // Returns false if the payload is corrupt
+    static bool decode(tcb::span<const uint8_t> src, const Frequencies& freqs, tcb::span<uint8_t> dest) {
+        // lookup symbol from slot
+        std::array<uint8_t, PROB_SCALE> symbols;
+        std::array<uint32_t, 256> starts;
+        uint32_t start = 0;
+        for (size_t i = 0; i < 256; i++) {
+            starts[i] = start;
+            if (start + freqs[i] > PROB_SCALE) return false;
+            memset(symbols.data() + start, int(i), freqs[i]);
+            start += freqs[i];
+        }
+        if ((start != PROB_SCALE) || (src.size() < 4)) return false;
+
+        const uint8_t* ptr = src.data();
+        const uint8_t* end = src.data() + src.size();
+        uint32_t x = iq_codec_read_u32(ptr);
+        ptr += 4;
+        for (auto& y: dest) {
+            const uint32_t slot = x & (PROB_SCALE-1);
+            const uint8_t s = symbols[slot];
+            y = s;
+            x = freqs[s] * (x >> PROB_BITS) + slot - starts[s];
+            while (x < RANS_L) {
+                if (ptr == end) return false;
+                x = (x << 8) | *ptr++;
+            }
+        }
+        return true;
+    }
+};
+
+// Encodes and decodes a single block
+class IQ_Block_Codec
+{
+private:
+    std::vector<uint8_t> m_symbols;
+    std::vector<uint8_t> m_scratch;
+public:
+    // Returns encoded block including header
+    tcb::span<const uint8_t> encode(tcb::span<const uint8_t> raw, uint8_t quantise_bits) {
+        const size_t N = raw.size();
+        // quantise and compute histograms for each transform to pick the cheapest
+        m_symbols.resize(N*2);
+        auto symbols = tcb::span(m_symbols).first(N);
+        auto deltas = tcb::span(m_symbols).last(N);
+        std::array<uint32_t, 256> symbol_counts{};
+        std::array<uint32_t, 256> delta_counts{};
+        uint8_t prev[2] = {0,0};
+        for (size_t i = 0; i < N; i++) {
+            const uint8_t x = uint8_t(raw[i] >> quantise_bits);
+            const uint8_t d = uint8_t(x - prev[i & 1]);
+            prev[i & 1] = x;
+            symbols[i] = x;
+            deltas[i] = d;
+            symbol_counts[x]++;
+            delta_counts[d]++;
+        }
+
+        const double symbol_cost = get_entropy_bytes(symbol_counts, N);
+        const double delta_cost = get_entropy_bytes(delta_counts, N);
+        IQ_Codec_Header header;
+        header.total_raw_bytes = uint32_t(N);
+        header.quantise_bits = quantise_bits;
+        header.mode = (delta_cost < symbol_cost) ? IQ_Codec_Mode::DELTA_ORDER0 : IQ_Codec_Mode::ORDER0;
+        auto src = (header.mode == IQ_Codec_Mode::DELTA_ORDER0) ? deltas : symbols;
+        const auto& counts = (header.mode == IQ_Codec_Mode::DELTA_ORDER0) ? delta_counts : symbol_counts;
+
+        // rANS can expand incompressible data slightly so reserve room for the worst case
+        const size_t max_payload_bytes = IQ_CODEC_TABLE_SIZE + N + N/2 + 16;
+        m_scratch.resize(IQ_CODEC_HEADER_SIZE + max_payload_bytes);
+        const auto freqs = IQ_Rans::normalise(counts, N);
+        uint8_t* table = m_scratch.data() + IQ_CODEC_HEADER_SIZE;
+        for (size_t i = 0; i < 256; i++) {
+            table[2*i+0] = uint8_t(freqs[i] & 0xFF);
+            table[2*i+1] = uint8_t(freqs[i] >> 8);
+        }
+        auto rans_buf = tcb::span(m_scratch).subspan(IQ_CODEC_HEADER_SIZE+IQ_CODEC_TABLE_SIZE);
+        const auto rans_data = IQ_Rans::encode(src, freqs, rans_buf);
+        header.total_payload_bytes = uint32_t(IQ_CODEC_TABLE_SIZE + rans_data.size());
+
+        // store incompressible blocks as is
+        if (header.total_payload_bytes >= N) {
+            header.mode = IQ_Codec_Mode::STORED;
+            header.quantise_bits = 0;
+            header.total_payload_bytes = uint32_t(N);
+            m_scratch.resize(IQ_CODEC_HEADER_SIZE + N);
+            memcpy(m_scratch.data() + IQ_CODEC_HEADER_SIZE, raw.data(), N);
+        } else {
+            memmove(table + IQ_CODEC_TABLE_SIZE, rans_data.data(), rans_data.size());
+            m_scratch.resize(IQ_CODEC_HEADER_SIZE + header.total_payload_bytes);
+        }
+        iq_codec_write_header(m_scratch.data(), header);
+        return m_scratch;
+    }
+
+    // Returns false if the payload is corrupt
+    static bool decode(const IQ_Codec_Header& header, tcb::span<const uint8_t> payload, tcb::span<uint8_t> raw) {
+        assert(raw.size() == header.total_raw_bytes);
+        assert(payload.size() == header.total_payload_bytes);
+        const size_t N = raw.size();
+        if (header.mode == IQ_Codec_Mode::STORED) {
+            if (payload.size() != N) return false;
+            memcpy(raw.data(), payload.data(), N);
+            return true;
+        }
+
+        if (payload.size() < IQ_CODEC_TABLE_SIZE) return false;
+        IQ_Rans::Frequencies freqs;
+        for (size_t i = 0; i < 256; i++) {
+            freqs[i] = uint16_t(payload[2*i+0] | (payload[2*i+1] << 8));
+        }
+        if (!IQ_Rans::decode(payload.subspan(IQ_CODEC_TABLE_SIZE), freqs, raw)) return false;
+
+        if (header.mode == IQ_Codec_Mode::DELTA_ORDER0) {
+            uint8_t prev[2] = {0,0};
+            for (size_t i = 0; i < N; i++) {
+                prev[i & 1] = uint8_t(prev[i & 1] + raw[i]);
+                raw[i] = prev[i & 1];
+            }
+        }
+
+        // reconstruct at the centre of the quantisation step to halve the error
+        const uint8_t k = header.quantise_bits;
+        if (k > 0) {
+            const uint8_t half = uint8_t(1u << (k-1));
+            for (auto& x: raw) {
+                x = uint8_t((x << k) | half);
+            }
+        }
+        return true;
+    }
+private:
+    static double get_entropy_bytes(const std::array<uint32_t, 256>& counts, size_t total) {
+        double bits = 0.0;
+        for (const uint32_t count: counts) {
+            if (count == 0) continue;
+            bits -= double(count) * std::log2(double(count) / double(total));
+        }
+        return bits / 8.0;
+    }
+};
+
+// Compresses a stream of IQ samples into blocks written to the output stream
+template <typename T>
+class IQ_Compressor: public OutputBuffer<T>
+{
+private:
+    std::shared_ptr<OutputBuffer<uint8_t>> m_output = nullptr;
+    IQ_Block_Codec m_codec;
+    std::vector<uint8_t> m_block;
+    size_t m_block_size;
+    uint8_t m_quantise_bits;
+    uint64_t m_total_raw_bytes = 0;
+    uint64_t m_total_compressed_bytes = 0;
+public:
+    // quantise_bits > 0 discards that many low bits for near lossless compression with error <= 2^(bits-1)
+    explicit IQ_Compressor(size_t block_size=size_t(1) << 20, uint8_t quantise_bits=0)
+    : m_block_size(std::clamp(block_size - (block_size % sizeof(T)), sizeof(T), IQ_CODEC_MAX_BLOCK_SIZE - (IQ_CODEC_MAX_BLOCK_SIZE % sizeof(T)))),
+      m_quantise_bits(std::min(quantise_bits, uint8_t(7)))
+    {
+        m_block.reserve(m_block_size);
+    }
+    ~IQ_Compressor() override {
+        flush();
+    }
+    void set_output_stream(std::shared_ptr<OutputBuffer<uint8_t>> output) {
+        m_output = output;
+    }
+    uint64_t get_total_raw_bytes() const { return m_total_raw_bytes; }
+    uint64_t get_total_compressed_bytes() const { return m_total_compressed_bytes; }
+    size_t write(tcb::span<const T> src) override {
+        if (m_output == nullptr) return 0;
+        auto bytes = tcb::span<const uint8_t>(reinterpret_cast<const uint8_t*>(src.data()), src.size_bytes());
+        while (!bytes.empty()) {
+            const size_t length = std::min(m_block_size - m_block.size(), bytes.size());
+            m_block.insert(m_block.end(), bytes.begin(), bytes.begin() + length);
+            bytes = bytes.subspan(length);
+            if ((m_block.size() == m_block_size) && !flush()) {
+                return (src.size_bytes() - bytes.size()) / sizeof(T);
+            }
+        }
+        return src.size();
+    }
+    // Compress any partially filled block
+    bool flush() {
+        if (m_block.empty() || (m_output == nullptr)) return true;
+        const auto encoded = m_codec.encode(m_block, m_quantise_bits);
+        m_total_raw_bytes += m_block.size();
+        m_total_compressed_bytes += encoded.size();
+        m_block.clear();
+        return m_output->write(encoded) == encoded.size();
+    }
+};
+
+// Decompresses blocks from the input stream
+// Supports read_view(...) so readers can consume decoded samples without another copy
+template <typename T>
+class IQ_Decompressor: public InputBuffer<T>
+{
+private:
+    std::shared_ptr<InputBuffer<uint8_t>> m_input = nullptr;
+    std::vector<uint8_t> m_payload;
+    std::vector<uint8_t> m_block;
+    size_t m_block_offset = 0;
+    std::vector<T> m_view_buffer;
+    bool m_is_error = false;
+    uint64_t m_total_compressed_bytes = 0;
+public:
+    IQ_Decompressor() {}
+    ~IQ_Decompressor() override = default;
+    void set_input_stream(std::shared_ptr<InputBuffer<uint8_t>> input) {
+        m_input = input;
+    }
+    bool get_is_error() const { return m_is_error; }
+    uint64_t get_total_compressed_bytes() const { return m_total_compressed_bytes; }
+    size_t read(tcb::span<T> dest) override {
+        auto bytes = tcb::span<uint8_t>(reinterpret_cast<uint8_t*>(dest.data()), dest.size_bytes());
+        size_t total_read = 0;
+        while (total_read < bytes.size()) {
+            if ((m_block_offset == m_block.size()) && !decode_block()) break;
+            const size_t length = std::min(bytes.size() - total_read, m_block.size() - m_block_offset);
+            memcpy(bytes.data() + total_read, m_block.data() + m_block_offset, length);
+            m_block_offset += length;
+            total_read += length;
+        }
+        // drop trailing partial element at the end of the stream
+        return total_read / sizeof(T);
+    }
+    std::optional<tcb::span<const T>> read_view(size_t length) override {
+        if ((m_block_offset == m_block.size()) && !decode_block()) return tcb::span<const T>();
+        // borrow the decoded block if it holds all of the requested samples
+        const size_t total_remain = m_block.size() - m_block_offset;
+        if ((total_remain >= length*sizeof(T)) && ((m_block_offset % alignof(T)) == 0)) {
+            const auto view = tcb::span<const T>(reinterpret_cast<const T*>(m_block.data() + m_block_offset), length);
+            m_block_offset += length*sizeof(T);
+            return view;
+        }
+        // otherwise decode across block boundaries into a staging buffer
+        // callers treat a short view as the end of the stream
+        m_view_buffer.resize(length);
+        const size_t total_read = read(m_view_buffer);
+        return tcb::span<const T>(m_view_buffer.data(), total_read);
+    }
+private:
+    // borrows the payload from the input if possible
+    std::optional<tcb::span<const uint8_t>> read_payload(size_t length) {
+        if (auto view = m_input->read_view(length); view.has_value()) {
+            if (view->size() != length) return std::nullopt;
+            return view;
+        }
+        m_payload.resize(length);
+        if (m_input->read(m_payload) != length) return std::nullopt;
+        return tcb::span<const uint8_t>(m_payload);
+    }
+
+    bool decode_block() {
+        if ((m_input == nullptr) || m_is_error) return false;
+        uint8_t header_buf[IQ_CODEC_HEADER_SIZE];
+        const size_t total_header = m_input->read(header_buf);
+        if (total_header == 0) return false;
+        const auto header = (total_header == IQ_CODEC_HEADER_SIZE) ? iq_codec_read_header(header_buf) : std::nullopt;
+        if (!header.has_value()) {
+            m_is_error = true;
+            return false;
+        }
+        m_block.resize(header->total_raw_bytes);
+        m_block_offset = 0;
+        const auto payload = read_payload(header->total_payload_bytes);
+        m_total_compressed_bytes += IQ_CODEC_HEADER_SIZE + header->total_payload_bytes;
+        if (!payload.has_value() || !IQ_Block_Codec::decode(header.value(), payload.value(), m_block)) {
+            m_block.clear();
+            m_is_error = true;
+            return false;
+        }
+        return true;
+    }
+};
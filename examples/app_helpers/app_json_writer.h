@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !_WIN32
+#include <sys/utsname.h>
+#endif
+
+#include "detect_architecture.h"
+#include "simd_flags.h" // NOLINT
+#include "viterbi_config.h"
+
+// Minimal streaming json writer that tracks when values need a separating comma
+class JsonWriter
+{
+private:
+    FILE* m_file;
+    std::vector<bool> m_is_first;
+    bool m_is_key = false;
+public:
+    explicit JsonWriter(FILE* file): m_file(file) {}
+    void begin_object() { begin_value(); fputc('{', m_file); m_is_first.push_back(true); }
+    void end_object() { m_is_first.pop_back(); fputc('}', m_file); }
+    void begin_array() { begin_value(); fputc('[', m_file); m_is_first.push_back(true); }
+    void end_array() { m_is_first.pop_back(); fputc(']', m_file); }
+    void key(const char* name) {
+        begin_value();
+        write_string(name);
+        fputc(':', m_file);
+        m_is_key = true;
+    }
+    void value(const char* str) { begin_value(); write_string(str); }
+    void value(const std::string& str) { value(str.c_str()); }
+    void value(bool x) { begin_value(); fputs(x ? "true" : "false", m_file); }
+    void value(int x) { begin_value(); fprintf(m_file, "%d", x); }
+    void value(uint64_t x) { begin_value(); fprintf(m_file, "%" PRIu64, x); }
+    void value(double x) { begin_value(); fprintf(m_file, "%.6g", x); }
+    template <typename T>
+    void field(const char* name, const T& x) { key(name); value(x); }
+private:
+    void begin_value() {
+        if (m_is_key) {
+            m_is_key = false;
+            return;
+        }
+        if (m_is_first.empty()) return;
+        if (!m_is_first.back()) fputc(',', m_file);
+        m_is_first.back() = false;
+    }
+    void write_string(const char* str) {
+        fputc('"', m_file);
+        for (const char* c = str; *c != 0; c++) {
+            switch (*c) {
+            case '"':  fputs("\\\"", m_file); break;
+            case '\\': fputs("\\\\", m_file); break;
+            case '\n': fputs("\\n", m_file); break;
+            case '\t': fputs("\\t", m_file); break;
+            default:
+                if ((unsigned char)(*c) < 0x20) fprintf(m_file, "\\u%04x", (unsigned int)(unsigned char)(*c));
+                else fputc(*c, m_file);
+            }
+        }
+        fputc('"', m_file);
+    }
+};
+
+// Compiler, build type and instruction sets the binary was compiled for
+static void write_json_build_info(JsonWriter& json) {
+    json.key("build");
+    json.begin_object();
+#if defined(__clang__)
+    json.field("compiler", "clang " __clang_version__);
+#elif defined(__GNUC__)
+    json.field("compiler", "gcc " __VERSION__);
+#elif defined(_MSC_VER)
+    json.field("compiler", std::string("msvc ") + std::to_string(_MSC_FULL_VER));
+#else
+    json.field("compiler", "unknown");
+#endif
+#if defined(NDEBUG)
+    json.field("is_debug", false);
+#else
+    json.field("is_debug", true);
+#endif
+    json.field("build_date", __DATE__ " " __TIME__);
+#if defined(__ARCH_X86__)
+    json.field("architecture", "x86");
+#elif defined(__ARCH_AARCH64__)
+    json.field("architecture", "aarch64");
+#else
+    json.field("architecture", "unknown");
+#endif
+    json.key("simd");
+    json.begin_array();
+#if defined(__SSE4_1__)
+    json.value("sse4.1");
+#endif
+#if defined(__AVX__)
+    json.value("avx");
+#endif
+#if defined(__AVX2__)
+    json.value("avx2");
+#endif
+#if defined(__FMA__)
+    json.value("fma");
+#endif
+#if defined(__AVX512F__)
+    json.value("avx512f");
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    json.value("neon");
+#endif
+    json.end_array();
+    json.field("viterbi_bit_size", int(sizeof(viterbi_bit_t)));
+    json.end_object();
+}
+// Machine the binary is running on
+static void write_json_host_info(JsonWriter& json) {
+    json.key("host");
+    json.begin_object();
+    json.field("total_hardware_threads", uint64_t(std::thread::hardware_concurrency()));
+#if _WIN32
+    json.field("os", "windows");
+#else
+    struct utsname info;
+    if (uname(&info) == 0) {
+        json.field("os", info.sysname);
+        json.field("kernel", info.release);
+        json.field("kernel_version", info.version);
+        json.field("machine", info.machine);
+        json.field("hostname", info.nodename);
+    }
+#endif
+    json.end_object();
+}
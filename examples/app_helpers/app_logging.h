@@ -16,6 +16,8 @@ static void setup_easylogging(bool is_default, bool is_basic_radio, bool is_basi
     config.setGlobally(el::ConfigurationType::Enabled, is_default ? "true" : "false");
     el::Loggers::reconfigureAllLoggers(config);
     // basic radio
+    get_dab_logging_enabled() = is_basic_radio;
+    get_basic_radio_logging_enabled() = is_basic_radio;
     config.setGlobally(el::ConfigurationType::Enabled, is_basic_radio ? "true" : "false");
     for (const char* name: get_dab_registered_loggers()) {
         logger = el::Loggers::getLogger(name);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <memory>
+#include "utility/span.h"
+
+#if _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read only memory mapping of a regular file starting from the file's current read position
+// Pipes, character devices and empty files can't be mapped and should use buffered reads
+class MappedFile
+{
+private:
+    // read ahead and release pages in chunks this size so memory usage stays bounded for large files
+    static constexpr size_t ADVISE_WINDOW_SIZE = size_t(16) << 20;
+    uint8_t* m_mapping = nullptr;
+    size_t m_mapping_size = 0;
+    size_t m_start_offset = 0;
+    size_t m_advised_until = 0;
+    size_t m_released_until = 0;
+#if _WIN32
+    HANDLE m_mapping_handle = nullptr;
+#endif
+public:
+    // returns nullptr if the file isn't mappable
+    static std::unique_ptr<MappedFile> open(FILE* fp) {
+        if (fp == nullptr) return nullptr;
+        const long position = ftell(fp);
+        if (position < 0) return nullptr;
+        auto file = std::unique_ptr<MappedFile>(new MappedFile());
+        if (!file->map(fp)) return nullptr;
+        if (size_t(position) > file->m_mapping_size) return nullptr;
+        file->m_start_offset = size_t(position);
+        file->advise(0);
+        return file;
+    }
+    ~MappedFile() {
+#if _WIN32
+        if (m_mapping != nullptr) UnmapViewOfFile(m_mapping);
+        if (m_mapping_handle != nullptr) CloseHandle(m_mapping_handle);
+#else
+        if (m_mapping != nullptr) munmap(m_mapping, m_mapping_size);
+#endif
+    }
+    MappedFile(MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+    // bytes from the starting read position until the end of the file
+    tcb::span<const uint8_t> get_data() const {
+        return { m_mapping + m_start_offset, m_mapping_size - m_start_offset };
+    }
+    // hint that all bytes before offset are consumed and the bytes after it are needed soon
+    void advise(size_t offset) {
+#if !_WIN32
+        offset += m_start_offset;
+        if (offset < m_advised_until) return;
+        const size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+        const size_t consumed = offset - (offset % page_size);
+        if (consumed > m_released_until) {
+            madvise(m_mapping + m_released_until, consumed - m_released_until, MADV_DONTNEED);
+            m_released_until = consumed;
+        }
+        const size_t length = std::min(ADVISE_WINDOW_SIZE, m_mapping_size-consumed);
+        if (length > 0) madvise(m_mapping + consumed, length, MADV_WILLNEED);
+        m_advised_until = consumed + length/2;
+#else
+        (void)offset;
+#endif
+    }
+private:
+    MappedFile() = default;
+    bool map(FILE* fp) {
+#if _WIN32
+        HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(fp)));
+        if (file_handle == INVALID_HANDLE_VALUE) return false;
+        if (GetFileType(file_handle) != FILE_TYPE_DISK) return false;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_handle, &file_size)) return false;
+        if (file_size.QuadPart <= 0) return false;
+        m_mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping_handle == nullptr) return false;
+        m_mapping = reinterpret_cast<uint8_t*>(MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+        if (m_mapping == nullptr) return false;
+        m_mapping_size = size_t(file_size.QuadPart);
+        return true;
+#else
+        const int fd = fileno(fp);
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0) return false;
+        if (!S_ISREG(file_stat.st_mode)) return false;
+        if (file_stat.st_size <= 0) return false;
+        const size_t size = size_t(file_stat.st_size);
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) return false;
+        m_mapping = reinterpret_cast<uint8_t*>(mapping);
+        m_mapping_size = size;
+        madvise(m_mapping, m_mapping_size, MADV_SEQUENTIAL);
+        return true;
+#endif
+    }
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "./app_json_writer.h"
+
+struct MicroBenchmarkConfig {
+    double min_time_seconds = 0.1;  // for each repetition
+    int total_repetitions = 5;
+    std::string filter;             // only run benchmarks where "name/variant" contains this
+};
+
+struct MicroBenchmarkResult {
+    std::string name;
+    std::string variant;
+    // unit and amount of work done each iteration, e.g. samples or bits
+    std::string item_type;
+    uint64_t items_per_iteration = 0;
+    uint64_t total_iterations = 0;
+    double min_ns = 0.0;
+    double median_ns = 0.0;
+    double mean_ns = 0.0;
+};
+
+// Stops the compiler from removing a kernel whose result would otherwise be unused
+static volatile float g_microbenchmark_sink = 0.0f;
+static void microbenchmark_keep(const float x) { g_microbenchmark_sink = x; }
+
+// Times each kernel over several repetitions that each run for a minimum amount of time
+// Iterations are run in batches so the clock overhead is negligible for short kernels
+class MicroBenchmarkRunner
+{
+private:
+    using clock = std::chrono::steady_clock;
+    const MicroBenchmarkConfig m_config;
+    std::vector<MicroBenchmarkResult> m_results;
+public:
+    explicit MicroBenchmarkRunner(const MicroBenchmarkConfig& config): m_config(config) {}
+    bool is_selected(const char* name, const char* variant) const {
+        if (m_config.filter.empty()) return true;
+        const std::string id = std::string(name) + "/" + variant;
+        return id.find(m_config.filter) != std::string::npos;
+    }
+    template <typename F>
+    void run(const char* name, const char* variant, const char* item_type, uint64_t items_per_iteration, F&& func) {
+        if (!is_selected(name, variant)) return;
+        func();
+        const uint64_t batch_size = get_batch_size(func);
+        const auto min_duration = std::chrono::duration<double>(m_config.min_time_seconds);
+        std::vector<double> ns_per_iteration;
+        uint64_t total_iterations = 0;
+        for (int i = 0; i < m_config.total_repetitions; i++) {
+            uint64_t iterations = 0;
+            const auto start = clock::now();
+            auto elapsed = clock::duration(0);
+            while (elapsed < min_duration) {
+                for (uint64_t j = 0; j < batch_size; j++) func();
+                iterations += batch_size;
+                elapsed = clock::now() - start;
+            }
+            const double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            ns_per_iteration.push_back(ns / double(iterations));
+            total_iterations += iterations;
+        }
+        std::sort(ns_per_iteration.begin(), ns_per_iteration.end());
+        double sum_ns = 0.0;
+        for (const double ns: ns_per_iteration) sum_ns += ns;
+
+        MicroBenchmarkResult result;
+        result.name = name;
+        result.variant = variant;
+        result.item_type = item_type;
+        result.items_per_iteration = items_per_iteration;
+        result.total_iterations = total_iterations;
+        result.min_ns = ns_per_iteration.front();
+        result.median_ns = ns_per_iteration[ns_per_iteration.size()/2];
+        result.mean_ns = sum_ns / double(ns_per_iteration.size());
+        fprintf(stderr, "%-32s %-8s %12.1f ns %14.3f M%s/s\n",
+            name, variant, result.median_ns, get_items_per_second(result)*1e-6, item_type);
+        m_results.push_back(result);
+    }
+    // Kernels that aren't called directly, e.g. stages of a threaded pipeline, report their own timings
+    void add_result(const MicroBenchmarkResult& result) {
+        if (!is_selected(result.name.c_str(), result.variant.c_str())) return;
+        fprintf(stderr, "%-32s %-8s %12.1f ns %14.3f M%s/s\n",
+            result.name.c_str(), result.variant.c_str(), result.median_ns,
+            get_items_per_second(result)*1e-6, result.item_type.c_str());
+        m_results.push_back(result);
+    }
+    void write_json(FILE* fp, const char* program_name) const {
+        auto json = JsonWriter(fp);
+        json.begin_object();
+        json.field("program", program_name);
+        write_json_build_info(json);
+        write_json_host_info(json);
+        json.key("config");
+        json.begin_object();
+        json.field("min_time_seconds", m_config.min_time_seconds);
+        json.field("total_repetitions", m_config.total_repetitions);
+        json.field("filter", m_config.filter);
+        json.end_object();
+        json.key("benchmarks");
+        json.begin_array();
+        for (const auto& result: m_results) {
+            json.begin_object();
+            json.field("name", result.name);
+            json.field("variant", result.variant);
+            json.field("item_type", result.item_type);
+            json.field("items_per_iteration", result.items_per_iteration);
+            json.field("total_iterations", result.total_iterations);
+            json.field("min_ns", result.min_ns);
+            json.field("median_ns", result.median_ns);
+            json.field("mean_ns", result.mean_ns);
+            json.field("items_per_second", get_items_per_second(result));
+            json.end_object();
+        }
+        json.end_array();
+        json.end_object();
+        fputc('\n', fp);
+    }
+private:
+    template <typename F>
+    uint64_t get_batch_size(F&& func) {
+        constexpr auto min_batch_duration = std::chrono::microseconds(100);
+        constexpr uint64_t max_batch_size = uint64_t(1) << 20;
+        uint64_t batch_size = 1;
+        while (batch_size < max_batch_size) {
+            const auto start = clock::now();
+            for (uint64_t i = 0; i < batch_size; i++) func();
+            if ((clock::now() - start) >= min_batch_duration) break;
+            batch_size *= 2;
+        }
+        return batch_size;
+    }
+    static double get_items_per_second(const MicroBenchmarkResult& result) {
+        if (result.median_ns <= 0.0) return 0.0;
+        return double(result.items_per_iteration) * 1e9 / result.median_ns;
+    }
+};
@@ -42,12 +42,18 @@ public:
     }
     size_t read(tcb::span<std::complex<float>> dest) override {
         if (m_input == nullptr) return 0;
-        m_buffer.resize(dest.size());
-        const size_t length = m_input->read(m_buffer);
-        for (size_t i = 0; i < length; i++) {
-            dest[i] = m_buffer[i].to_c32(); 
+        tcb::span<const RawIQ> src;
+        if (auto view = m_input->read_view(dest.size()); view.has_value()) {
+            src = view.value();
+        } else {
+            m_buffer.resize(dest.size());
+            const size_t length = m_input->read(m_buffer);
+            src = tcb::span<const RawIQ>(m_buffer).first(length);
         }
-        return length;
+        for (size_t i = 0; i < src.size(); i++) {
+            dest[i] = src[i].to_c32(); 
+        }
+        return src.size();
     }
 };
 
@@ -56,6 +62,7 @@ class OFDM_Block
 private:
     std::shared_ptr<InputBuffer<std::complex<float>>> m_input_stream = nullptr;
     std::shared_ptr<OutputBuffer<viterbi_bit_t>> m_output_stream = nullptr;
+    std::shared_ptr<FrameTimestampQueue> m_timestamp_output = nullptr;
     std::unique_ptr<OFDM_Demod> m_ofdm_demod = nullptr;
     std::vector<std::complex<float>> m_buffer;
 public:
@@ -66,8 +73,10 @@ public:
         auto ofdm_mapper_ref = std::vector<int>(ofdm_params.nb_data_carriers);
         get_DAB_mapper_ref(ofdm_mapper_ref, ofdm_params.nb_fft);
         m_ofdm_demod = std::make_unique<OFDM_Demod>(ofdm_params, ofdm_prs_ref, ofdm_mapper_ref, int(total_threads));
-        m_ofdm_demod->On_OFDM_Frame().Attach([this](tcb::span<const viterbi_bit_t> buf){
+        m_ofdm_demod->On_OFDM_Frame().Attach([this](tcb::span<const viterbi_bit_t> buf, const FrameTimestamp& timestamp){
             if (m_output_stream == nullptr) return; 
+            // reader can get the timestamp as soon as the bits are available
+            if (m_timestamp_output != nullptr) m_timestamp_output->push(timestamp);
             m_output_stream->write(buf);
         });
     }
@@ -79,6 +88,9 @@ public:
     void set_output_stream(std::shared_ptr<OutputBuffer<viterbi_bit_t>> stream) { 
         m_output_stream = stream; 
     }
+    void set_timestamp_output(std::shared_ptr<FrameTimestampQueue> timestamps) {
+        m_timestamp_output = timestamps;
+    }
     void run(size_t block_size) {
         if (m_input_stream == nullptr) return;
         m_buffer.resize(block_size);
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <stddef.h>
+#include <functional>
 #include <memory>
 #include <vector>
 #include "basic_radio/basic_radio.h"
+#include "utility/span.h"
 #include "dab/constants/dab_parameters.h"
 #include "viterbi_config.h"
 #include "./app_io_buffers.h"
@@ -12,9 +14,11 @@ class Basic_Radio_Block
 {
 private:
     std::shared_ptr<InputBuffer<viterbi_bit_t>> m_input_stream = nullptr;
+    std::shared_ptr<FrameTimestampQueue> m_timestamp_input = nullptr;
     std::unique_ptr<BasicRadio> m_basic_radio = nullptr;
     std::vector<viterbi_bit_t> m_bits_buffer;
     DAB_Parameters m_dab_params;
+    std::function<void()> m_on_frame_processed = nullptr;
 public:
     Basic_Radio_Block(const int transmission_mode, const size_t total_threads)
     {
@@ -26,12 +30,30 @@ public:
     void set_input_stream(std::shared_ptr<InputBuffer<viterbi_bit_t>> stream) { 
         m_input_stream = stream; 
     }
+    void set_timestamp_input(std::shared_ptr<FrameTimestampQueue> timestamps) {
+        m_timestamp_input = timestamps;
+    }
+    // called from the radio thread after each frame has been fully decoded
+    void set_frame_callback(std::function<void()> callback) {
+        m_on_frame_processed = callback;
+    }
     void run() {
         if (m_input_stream == nullptr) return;  
         while (true) {
-            const size_t length = m_input_stream->read(m_bits_buffer);
-            if (length != m_bits_buffer.size()) return;
-            m_basic_radio->Process(m_bits_buffer);
+            tcb::span<const viterbi_bit_t> buf = m_bits_buffer;
+            if (auto view = m_input_stream->read_view(m_bits_buffer.size()); view.has_value()) {
+                buf = view.value();
+            } else {
+                const size_t length = m_input_stream->read(m_bits_buffer);
+                buf = buf.first(length);
+            }
+            if (buf.size() != m_bits_buffer.size()) return;
+            FrameTimestamp timestamp;
+            if (m_timestamp_input != nullptr) {
+                timestamp = m_timestamp_input->pop().value_or(FrameTimestamp{});
+            }
+            m_basic_radio->Process(buf, timestamp);
+            if (m_on_frame_processed) m_on_frame_processed();
         }
     }
 };
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utility/span.h"
+#include "./app_io_buffers.h"
+
+// Arrival of a single usb transfer relative to when it should have arrived at the nominal sample rate
+struct ReplayBurst {
+    double jitter_us;
+    size_t length;
+};
+
+struct ReplayPacerConfig {
+    double bytes_per_second = 2'048'000.0*2.0;  // 8bit IQ at the DAB sampling rate
+    double speed = 1.0;                         // multiple of the nominal rate
+    size_t burst_size = 16*16384;               // default usb transfer size of librtlsdr
+    double random_jitter_us = 0.0;              // each burst is delayed by a random amount up to this
+    double max_backlog_seconds = 1.0;           // consumer lagging more than this resyncs the clock (a real receiver would overflow)
+    std::vector<ReplayBurst> recorded_bursts;   // replaces burst_size and random jitter with a recorded sequence if not empty
+};
+
+struct ReplayPacerStats {
+    uint64_t total_bursts = 0;
+    uint64_t total_bytes = 0;
+    uint64_t total_resyncs = 0;
+    double max_backlog_seconds = 0.0;
+};
+
+// Reads a timing capture with one "<arrival_time_us> <length>" pair per line
+// Arrival times are converted to jitter relative to the nominal rate so the average rate is still paced by the clock
+inline bool load_replay_bursts(const char* filename, double bytes_per_second, std::vector<ReplayBurst>& bursts) {
+    FILE* fp = fopen(filename, "r");
+    if (fp == nullptr) return false;
+    bursts.clear();
+    double arrival_us = 0.0;
+    size_t length = 0;
+    uint64_t total_bytes = 0;
+    double min_jitter_us = 0.0;
+    while (fscanf(fp, "%lf %zu", &arrival_us, &length) == 2) {
+        if (length == 0) continue;
+        const double expected_us = double(total_bytes)*1e6/bytes_per_second;
+        const double jitter_us = arrival_us - expected_us;
+        min_jitter_us = bursts.empty() ? jitter_us : std::min(min_jitter_us, jitter_us);
+        bursts.push_back({ jitter_us, length });
+        total_bytes += length;
+    }
+    fclose(fp);
+    // the earliest burst defines zero latency
+    for (auto& burst: bursts) {
+        burst.jitter_us -= min_jitter_us;
+    }
+    return !bursts.empty();
+}
+
+// Records when each usb transfer arrives in the format read by load_replay_bursts(...)
+// record(...) is called from the usb callback so it only appends to a buffer
+// A background thread formats and writes the buffered records so stdio never blocks the callback
+class ReplayTimingRecorder
+{
+private:
+    using clock = std::chrono::steady_clock;
+    struct Record {
+        double arrival_us;
+        size_t length;
+    };
+    // enough for a few minutes of transfers so the callback doesn't have to reallocate between flushes
+    static constexpr size_t RESERVED_RECORDS = 4096;
+    static constexpr auto FLUSH_PERIOD = std::chrono::seconds(1);
+    FILE* m_file;
+    clock::time_point m_time_start;
+    bool m_is_started = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cv_stop;
+    bool m_is_running = true;
+    std::vector<Record> m_pending;
+    std::thread m_thread;
+public:
+    explicit ReplayTimingRecorder(FILE* file): m_file(file) {
+        m_pending.reserve(RESERVED_RECORDS);
+        m_thread = std::thread(&ReplayTimingRecorder::RunnerThread, this);
+    }
+    // writes any remaining records before closing the file
+    ~ReplayTimingRecorder() {
+        {
+            auto lock = std::scoped_lock(m_mutex);
+            m_is_running = false;
+        }
+        m_cv_stop.notify_one();
+        m_thread.join();
+        fclose(m_file);
+    }
+    ReplayTimingRecorder(ReplayTimingRecorder&) = delete;
+    ReplayTimingRecorder(ReplayTimingRecorder&&) = delete;
+    ReplayTimingRecorder& operator=(ReplayTimingRecorder&) = delete;
+    ReplayTimingRecorder& operator=(ReplayTimingRecorder&&) = delete;
+    void record(size_t length) {
+        const auto now = clock::now();
+        if (!m_is_started) {
+            m_is_started = true;
+            m_time_start = now;
+        }
+        const double arrival_us = std::chrono::duration<double, std::micro>(now - m_time_start).count();
+        auto lock = std::scoped_lock(m_mutex);
+        m_pending.push_back({ arrival_us, length });
+    }
+private:
+    void RunnerThread() {
+        std::vector<Record> records;
+        records.reserve(RESERVED_RECORDS);
+        auto lock = std::unique_lock(m_mutex);
+        while (true) {
+            m_cv_stop.wait_for(lock, FLUSH_PERIOD, [this]() { return !m_is_running; });
+            const bool is_running = m_is_running;
+            // hand the callback an empty buffer that is already reserved
+            std::swap(records, m_pending);
+            lock.unlock();
+            for (const auto& record: records) {
+                fprintf(m_file, "%.1f %zu\n", record.arrival_us, record.length);
+            }
+            fflush(m_file);
+            records.clear();
+            lock.lock();
+            if (!is_running) break;
+        }
+    }
+};
+
+// Releases data in bursts at the times a receiver would have produced them
+// - Deadlines are computed from the total bytes released against a monotonic clock
+//   so oversleeping on one burst doesn't accumulate as drift
+// - Jitter only delays individual bursts and never shifts the schedule of later ones
+class ReplayPacer
+{
+private:
+    using clock = std::chrono::steady_clock;
+    ReplayPacerConfig m_config;
+    ReplayPacerStats m_stats;
+    clock::time_point m_time_start;
+    bool m_is_started = false;
+    uint64_t m_scheduled_bytes = 0;
+    size_t m_recorded_index = 0;
+    std::mt19937 m_random_generator{ 0 };
+public:
+    explicit ReplayPacer(const ReplayPacerConfig& config): m_config(config) {
+        m_config.speed = std::max(m_config.speed, 1e-3);
+        m_config.burst_size = std::max(m_config.burst_size, size_t(1));
+    }
+    const ReplayPacerConfig& get_config() const { return m_config; }
+    const ReplayPacerStats& get_stats() const { return m_stats; }
+    // Blocks until the next burst would have arrived and returns its length in bytes
+    size_t wait_next_burst() {
+        const auto now = clock::now();
+        if (!m_is_started) {
+            m_is_started = true;
+            m_time_start = now;
+        }
+
+        size_t length = m_config.burst_size;
+        double jitter_us = 0.0;
+        if (!m_config.recorded_bursts.empty()) {
+            const auto& burst = m_config.recorded_bursts[m_recorded_index];
+            m_recorded_index = (m_recorded_index+1) % m_config.recorded_bursts.size();
+            length = burst.length;
+            jitter_us = burst.jitter_us;
+        } else if (m_config.random_jitter_us > 0.0) {
+            auto distribution = std::uniform_real_distribution<double>(0.0, m_config.random_jitter_us);
+            jitter_us = distribution(m_random_generator);
+        }
+
+        // burst arrives once its last byte has been sampled
+        m_scheduled_bytes += length;
+        const double scale = 1.0/(m_config.bytes_per_second*m_config.speed);
+        const double deadline_seconds = double(m_scheduled_bytes)*scale + jitter_us*1e-6/m_config.speed;
+        const auto deadline = m_time_start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(deadline_seconds));
+
+        if (deadline > now) {
+            std::this_thread::sleep_until(deadline);
+        } else {
+            const double backlog_seconds = std::chrono::duration<double>(now - deadline).count()*m_config.speed;
+            m_stats.max_backlog_seconds = std::max(m_stats.max_backlog_seconds, backlog_seconds);
+            if (backlog_seconds > m_config.max_backlog_seconds) {
+                // consumer can't keep up so restart the schedule from now instead of bursting to catch up
+                m_stats.total_resyncs++;
+                m_time_start = now - std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(double(m_scheduled_bytes)*scale));
+            }
+        }
+        m_stats.total_bursts++;
+        m_stats.total_bytes += length;
+        return length;
+    }
+    void print_stats(FILE* fp) const {
+        fprintf(fp, "Replayed %" PRIu64 " bytes in %" PRIu64 " bursts, max backlog %.3fs, %" PRIu64 " resyncs.\n",
+            m_stats.total_bytes, m_stats.total_bursts, m_stats.max_backlog_seconds, m_stats.total_resyncs);
+    }
+};
+
+// Limits how fast a consumer can pull from an input to the rate of a real receiver
+// Reads block until enough bursts have arrived to fill them so end of stream is still signalled by a short read
+template <typename T>
+class PacedInputBuffer: public InputBuffer<T>
+{
+private:
+    std::shared_ptr<InputBuffer<T>> m_input = nullptr;
+    ReplayPacer m_pacer;
+    size_t m_available_bytes = 0;
+public:
+    explicit PacedInputBuffer(const ReplayPacerConfig& config): m_pacer(config) {}
+    ~PacedInputBuffer() override = default;
+    void set_input_stream(std::shared_ptr<InputBuffer<T>> input) {
+        m_input = input;
+    }
+    const ReplayPacer& get_pacer() const { return m_pacer; }
+    size_t read(tcb::span<T> dest) override {
+        if (m_input == nullptr) return 0;
+        wait_available(dest.size());
+        const size_t length = m_input->read(dest);
+        consume(length);
+        return length;
+    }
+    std::optional<tcb::span<const T>> read_view(size_t length) override {
+        if (m_input == nullptr) return tcb::span<const T>();
+        wait_available(length);
+        auto view = m_input->read_view(length);
+        if (view.has_value()) consume(view->size());
+        return view;
+    }
+private:
+    void wait_available(size_t length) {
+        const size_t total_bytes = length*sizeof(T);
+        while (m_available_bytes < total_bytes) {
+            m_available_bytes += m_pacer.wait_next_burst();
+        }
+    }
+    void consume(size_t length) {
+        m_available_bytes -= std::min(m_available_bytes, length*sizeof(T));
+    }
+};
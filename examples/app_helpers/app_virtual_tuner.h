@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include "device/device_virtual.h"
+#include "block_frequencies.h"
+
+// Virtual tuner that plays [DIRECTORY]/[BLOCK].raw when tuned to a block
+// Blocks without a recording are noise like an empty channel
+static std::shared_ptr<VirtualDevice> create_virtual_tuner_from_recordings(
+    const std::string& directory, const VirtualDeviceConfig& config, const uint32_t sampling_frequency=2048000
+) {
+    auto descriptor = DeviceDescriptor{ "Virtual", "Recordings", directory };
+    auto device = std::make_shared<VirtualDevice>(descriptor, config);
+    for (const auto& [label, frequency]: block_frequencies) {
+        const std::string filename = directory + "/" + label + ".raw";
+        FILE* fp = fopen(filename.c_str(), "rb");
+        if (fp == nullptr) continue;
+        device->SetSource(frequency, std::make_shared<VirtualRecordingSource>(fp, sampling_frequency));
+    }
+    return device;
+}
@@ -64,13 +64,20 @@ public:
     size_t read(tcb::span<uint8_t> bytes_buffer) override {
         constexpr size_t BITS_PER_BYTE = 8;
         if (m_input == nullptr) return 0;
-        m_bits_buffer.resize(bytes_buffer.size()*BITS_PER_BYTE);
-        const size_t length = m_input->read(m_bits_buffer);
+        tcb::span<const viterbi_bit_t> bits;
+        if (auto view = m_input->read_view(bytes_buffer.size()*BITS_PER_BYTE); view.has_value()) {
+            bits = view.value();
+        } else {
+            m_bits_buffer.resize(bytes_buffer.size()*BITS_PER_BYTE);
+            const size_t length = m_input->read(m_bits_buffer);
+            bits = tcb::span<const viterbi_bit_t>(m_bits_buffer).first(length);
+        }
+        const size_t length = bits.size();
         assert(length % BITS_PER_BYTE == 0);
         const size_t total_bits = length - (length % BITS_PER_BYTE);
         const size_t total_bytes = total_bits / BITS_PER_BYTE;
         convert_viterbi_bits_to_bytes(
-            tcb::span(m_bits_buffer).first(total_bits),
+            bits.first(total_bits),
             bytes_buffer.first(total_bytes)
         );
         return total_bytes;
@@ -111,11 +118,18 @@ public:
         assert(bits_buffer.size() % BITS_PER_BYTE == 0);
         const size_t max_bits = bits_buffer.size() - (bits_buffer.size() % BITS_PER_BYTE);
         bits_buffer = bits_buffer.first(max_bits);
-        m_bytes_buffer.resize(bits_buffer.size()/BITS_PER_BYTE);
-        const size_t total_bytes = m_input->read(m_bytes_buffer);
+        tcb::span<const uint8_t> bytes;
+        if (auto view = m_input->read_view(bits_buffer.size()/BITS_PER_BYTE); view.has_value()) {
+            bytes = view.value();
+        } else {
+            m_bytes_buffer.resize(bits_buffer.size()/BITS_PER_BYTE);
+            const size_t length = m_input->read(m_bytes_buffer);
+            bytes = tcb::span<const uint8_t>(m_bytes_buffer).first(length);
+        }
+        const size_t total_bytes = bytes.size();
         const size_t total_bits = total_bytes * BITS_PER_BYTE;
         convert_viterbi_bytes_to_bits(
-            tcb::span(m_bytes_buffer).first(total_bytes),
+            bytes,
             bits_buffer.first(total_bits)
         );
         return total_bits;
@@ -1,10 +1,15 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <algorithm>
 #include <complex>
 #include <exception>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 #include "utility/span.h"
@@ -15,28 +20,93 @@
 #endif
 
 #include <argparse/argparse.hpp>
+#include "basic_radio/basic_thread_pool.h"
 #include "ofdm/dsp/apply_pll.h"
+#include "./app_helpers/app_async_file_writer.h"
+#include "./app_helpers/app_io_buffers.h"
 
-constexpr float DC_LEVEL = 127.0f;
-constexpr float SCALE = 128.0f;
-
-struct RawIQ {
-    uint8_t I;
-    uint8_t Q;
+enum class SampleFormat {
+    U8, S8, S16, F32,
 };
 
-static std::complex<float> raw_iq_to_c32(RawIQ x) {
-    return std::complex<float>(
-        (float(x.I) - DC_LEVEL) / SCALE,
-        (float(x.Q) - DC_LEVEL) / SCALE
-    );
+// bytes per IQ sample
+static size_t get_sample_size(SampleFormat format) {
+    switch (format) {
+    case SampleFormat::U8:  return 2*sizeof(uint8_t);
+    case SampleFormat::S8:  return 2*sizeof(int8_t);
+    case SampleFormat::S16: return 2*sizeof(int16_t);
+    case SampleFormat::F32: return 2*sizeof(float);
+    default:                return 0;
+    }
+}
+
+template <typename T>
+static void convert_int_to_c32(tcb::span<const uint8_t> src, tcb::span<std::complex<float>> dest, float dc_level, float scale) {
+    const size_t N = dest.size()*2;
+    const T* x = reinterpret_cast<const T*>(src.data());
+    float* y = reinterpret_cast<float*>(dest.data());
+    const float inv_scale = 1.0f/scale;
+    for (size_t i = 0; i < N; i++) {
+        y[i] = (float(x[i]) - dc_level) * inv_scale;
+    }
+}
+
+template <typename T>
+static void convert_c32_to_int(tcb::span<const std::complex<float>> src, tcb::span<uint8_t> dest, float dc_level, float scale) {
+    constexpr int32_t MIN_VALUE = int32_t(std::numeric_limits<T>::min());
+    constexpr int32_t MAX_VALUE = int32_t(std::numeric_limits<T>::max());
+    // shift range to be non-negative so truncation rounds to nearest without a call to std::round
+    constexpr float LOWER = -0.5f;
+    constexpr float UPPER = float(MAX_VALUE-MIN_VALUE) + 0.49f;
+    const float offset = dc_level - float(MIN_VALUE) + 0.5f;
+    const size_t N = src.size()*2;
+    const float* x = reinterpret_cast<const float*>(src.data());
+    T* y = reinterpret_cast<T*>(dest.data());
+    for (size_t i = 0; i < N; i++) {
+        const float v = std::clamp(x[i]*scale + offset, 0.0f, UPPER-LOWER);
+        y[i] = T(int32_t(v) + MIN_VALUE);
+    }
+}
+
+static void convert_to_c32(SampleFormat format, tcb::span<const uint8_t> src, tcb::span<std::complex<float>> dest) {
+    switch (format) {
+    case SampleFormat::U8:  return convert_int_to_c32<uint8_t>(src, dest, 127.0f, 128.0f);
+    case SampleFormat::S8:  return convert_int_to_c32<int8_t>(src, dest, 0.0f, 128.0f);
+    case SampleFormat::S16: return convert_int_to_c32<int16_t>(src, dest, 0.0f, 32768.0f);
+    case SampleFormat::F32: memcpy(dest.data(), src.data(), dest.size_bytes()); return;
+    default:                return;
+    }
+}
+
+static void convert_from_c32(SampleFormat format, tcb::span<const std::complex<float>> src, tcb::span<uint8_t> dest) {
+    switch (format) {
+    case SampleFormat::U8:  return convert_c32_to_int<uint8_t>(src, dest, 127.0f, 128.0f);
+    case SampleFormat::S8:  return convert_c32_to_int<int8_t>(src, dest, 0.0f, 128.0f);
+    case SampleFormat::S16: return convert_c32_to_int<int16_t>(src, dest, 0.0f, 32768.0f);
+    case SampleFormat::F32: memcpy(dest.data(), src.data(), src.size_bytes()); return;
+    default:                return;
+    }
+}
+
+static SampleFormat get_sample_format(const std::string& name) {
+    if (name.compare("s8") == 0) return SampleFormat::S8;
+    if (name.compare("s16") == 0) return SampleFormat::S16;
+    if (name.compare("f32") == 0) return SampleFormat::F32;
+    return SampleFormat::U8;
 }
 
-static RawIQ c32_to_raw_iq(std::complex<float> x) {
-    RawIQ y;
-    y.I = uint8_t(x.real()*SCALE + DC_LEVEL);
-    y.Q = uint8_t(x.imag()*SCALE + DC_LEVEL);
-    return y;
+// Each block's starting phase is derived from its absolute sample index
+// This lets blocks be shifted independently on any thread without accumulating phase error
+static void apply_frequency_shift_block(
+    tcb::span<const uint8_t> src, SampleFormat src_format,
+    tcb::span<uint8_t> dest, SampleFormat dest_format,
+    tcb::span<std::complex<float>> scratch, const float freq_norm, const uint64_t sample_index)
+{
+    double dt = std::fmod(double(sample_index)*double(freq_norm), 1.0);
+    dt = dt - std::round(dt);
+    convert_to_c32(src_format, src, scratch);
+    apply_pll_auto(scratch, scratch, freq_norm, float(dt));
+    convert_from_c32(dest_format, scratch, dest);
 }
 
 void init_parser(argparse::ArgumentParser& parser) {
@@ -44,7 +114,7 @@ void init_parser(argparse::ArgumentParser& parser) {
         .default_value(float(0.0f)).scan<'g', float>()
         .metavar("FREQUENCY")
         .nargs(1).required()
-        .help("Amount of Hz to shift 8bit IQ signal");
+        .help("Amount of Hz to shift IQ signal");
     parser.add_argument("-s", "--sampling-rate")
         .default_value(float(2'048'000)).scan<'g', float>()
         .metavar("SAMPLING_RATE")
@@ -54,7 +124,24 @@ void init_parser(argparse::ArgumentParser& parser) {
         .default_value(size_t(8192)).scan<'u', size_t>()
         .metavar("BLOCK_SIZE")
         .nargs(1).required()
-        .help("Number of IQ samples to read at once");
+        .help("Number of IQ samples to shift at once");
+    parser.add_argument("-t", "--threads")
+        .default_value(size_t(0)).scan<'u', size_t>()
+        .metavar("TOTAL_THREADS")
+        .nargs(1).required()
+        .help("Number of threads to shift blocks in parallel (0 uses all cores)");
+    parser.add_argument("--input-format")
+        .default_value(std::string("u8"))
+        .choices("u8", "s8", "s16", "f32")
+        .metavar("FORMAT")
+        .nargs(1).required()
+        .help("Format of interleaved IQ input");
+    parser.add_argument("--output-format")
+        .default_value(std::string("u8"))
+        .choices("u8", "s8", "s16", "f32")
+        .metavar("FORMAT")
+        .nargs(1).required()
+        .help("Format of interleaved IQ output");
     parser.add_argument("-i", "--input")
         .default_value(std::string(""))
         .metavar("INPUT_FILENAME")
@@ -71,6 +158,9 @@ struct Args {
     float frequency;
     float sampling_rate;
     size_t block_size;
+    size_t total_threads;
+    SampleFormat input_format;
+    SampleFormat output_format;
     std::string input_filename;
     std::string output_filename;
 };
@@ -80,6 +170,9 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     args.frequency = parser.get<float>("--frequency");
     args.sampling_rate = parser.get<float>("--sampling-rate");
     args.block_size = parser.get<size_t>("--block-size");
+    args.total_threads = parser.get<size_t>("--threads");
+    args.input_format = get_sample_format(parser.get<std::string>("--input-format"));
+    args.output_format = get_sample_format(parser.get<std::string>("--output-format"));
     args.input_filename = parser.get<std::string>("--input");
     args.output_filename = parser.get<std::string>("--output");
     return args;
@@ -87,7 +180,7 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
 
 int main(int argc, char** argv) {
     auto parser = argparse::ArgumentParser("apply_frequency_shift", "0.1.0");
-    parser.add_description("Shifts an 8bit IQ signal by a set frequency");
+    parser.add_description("Shifts an IQ signal by a set frequency");
     init_parser(parser);
     try {
         parser.parse_args(argc, argv);
@@ -133,31 +226,66 @@ int main(int argc, char** argv) {
 
     const size_t N = args.block_size;
     const float frequency_shift = args.frequency / args.sampling_rate;
-    auto rx_in = std::vector<RawIQ>(N);
-    auto rx_float = std::vector<std::complex<float>>(N);
-    float dt = 0.0f;
+    const size_t input_sample_size = get_sample_size(args.input_format);
+    const size_t output_sample_size = get_sample_size(args.output_format);
+    auto thread_pool = std::unique_ptr<BasicThreadPool>(nullptr);
+    size_t total_threads = 1;
+    if (args.total_threads != 1) {
+        thread_pool = std::make_unique<BasicThreadPool>(args.total_threads);
+        total_threads = thread_pool->GetTotalThreads();
+    }
+
+    // read and shift a block per thread at a time
+    const size_t total_batch_samples = N*total_threads;
+    auto input = InputFile<uint8_t>(fp_in);
+    auto output = AsyncFileWriter(fp_out);
+    auto input_buffer = std::vector<uint8_t>();
+    auto output_buffer = std::vector<uint8_t>(total_batch_samples*output_sample_size);
+    auto scratch_buffer = std::vector<std::complex<float>>(total_batch_samples);
+    uint64_t sample_index = 0;
     while (true) {
-        const size_t nb_read = fread(rx_in.data(), sizeof(RawIQ), N, fp_in);
-        if (nb_read != N) {
-            fprintf(stderr, "Failed to read in block %zu/%zu\n", nb_read, N);
-            break;
-        }
-        for (size_t i = 0; i < N; i++) {
-            rx_float[i] = raw_iq_to_c32(rx_in[i]);
+        const size_t total_batch_bytes = total_batch_samples*input_sample_size;
+        tcb::span<const uint8_t> input_bytes;
+        if (auto view = input.read_view(total_batch_bytes); view.has_value()) {
+            input_bytes = view.value();
+        } else {
+            input_buffer.resize(total_batch_bytes);
+            const size_t total_read = input.read(input_buffer);
+            input_bytes = tcb::span<const uint8_t>(input_buffer).first(total_read);
         }
+        const size_t total_samples = input_bytes.size() / input_sample_size;
+        if (total_samples == 0) break;
 
-        apply_pll_auto(rx_float, rx_float, frequency_shift, dt);
-        dt += float(N)*frequency_shift;
-        dt = dt - std::round(dt);
- 
-        for (size_t i = 0; i < N; i++) {
-            rx_in[i] = c32_to_raw_iq(rx_float[i]);
+        for (size_t i = 0; i < total_samples; i += N) {
+            const size_t length = std::min(N, total_samples-i);
+            auto task = [&, i, length]() {
+                apply_frequency_shift_block(
+                    input_bytes.subspan(i*input_sample_size, length*input_sample_size), args.input_format,
+                    tcb::span(output_buffer).subspan(i*output_sample_size, length*output_sample_size), args.output_format,
+                    tcb::span(scratch_buffer).subspan(i, length), frequency_shift, sample_index+i
+                );
+            };
+            if (thread_pool != nullptr) {
+                thread_pool->PushTask(task);
+            } else {
+                task();
+            }
         }
-        const size_t nb_write = fwrite(rx_in.data(), sizeof(RawIQ), N, fp_out);
-        if (nb_write != N) {
-            fprintf(stderr, "Failed to write out frame %zu/%zu\n", nb_write, N);
+        if (thread_pool != nullptr) thread_pool->WaitAll();
+
+        const auto output_bytes = tcb::span<const uint8_t>(output_buffer).first(total_samples*output_sample_size);
+        if (output.write(output_bytes) != output_bytes.size()) {
+            fprintf(stderr, "Failed to write out block\n");
             break;
         }
+        sample_index += total_samples;
+        if (input_bytes.size() != total_batch_bytes) break;
+    }
+    output.close();
+    const auto stats = output.get_stats();
+    if (stats.total_errors > 0) {
+        fprintf(stderr, "Failed to write %" PRIu64 " blocks to output\n", stats.total_errors);
+        return 1;
     }
 
     return 0;
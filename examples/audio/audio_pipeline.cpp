@@ -2,13 +2,18 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
-#include <cstring>
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
+#include "detect_architecture.h"
+#include "simd_flags.h" // NOLINT
 #include "utility/span.h"
 #include "./frame.h"
 
@@ -41,124 +46,393 @@ static void audio_resample_with_callback(tcb::span<const Frame<T>> src, tcb::spa
     }
 }
 
-template <typename T, typename F>
-static void audio_resample_same_type_with_callback(tcb::span<const Frame<T>> src, tcb::span<Frame<T>> dest, F&& func) {
-    if (src.size() == dest.size()) {
-        audio_map_with_callback<T,T>(src, dest, std::move(func));
-    } else {
-        audio_resample_with_callback<T,T>(src, dest, std::move(func));
+// Frames are interleaved channels so the mixing kernels can work on flat float arrays
+static_assert(sizeof(Frame<float>) == sizeof(float)*Frame<float>::TOTAL_AUDIO_CHANNELS);
+
+static tcb::span<float> audio_as_floats(tcb::span<Frame<float>> buf) {
+    return { reinterpret_cast<float*>(buf.data()), buf.size()*Frame<float>::TOTAL_AUDIO_CHANNELS };
+}
+
+static tcb::span<const float> audio_as_floats(tcb::span<const Frame<float>> buf) {
+    return { reinterpret_cast<const float*>(buf.data()), buf.size()*Frame<float>::TOTAL_AUDIO_CHANNELS };
+}
+
+static void audio_mix_add_scalar(tcb::span<const float> src, tcb::span<float> dest) {
+    assert(src.size() == dest.size());
+    const size_t N = src.size();
+    for (size_t i = 0; i < N; i++) {
+        dest[i] += src[i];
     }
 }
 
-template <typename T>
-static void audio_clamp_inplace(tcb::span<Frame<T>> buf, const T v_min, const T v_max) {
+static void audio_gain_clamp_scalar(tcb::span<float> buf, const float gain, const float v_min, const float v_max) {
     const size_t N = buf.size();
     for (size_t i = 0; i < N; i++) {
-        auto& v = buf[i];
-        for (int j = 0; j < Frame<T>::TOTAL_AUDIO_CHANNELS; j++) {
-            auto& x = v.channels[j];
-            x = (x > v_min) ? x : v_min;
-            x = (x > v_max) ? v_max : x;
-        }
+        const float x = buf[i]*gain;
+        buf[i] = std::min(std::max(x, v_min), v_max);
+    }
+}
+
+// x86
+#if defined(__ARCH_X86__)
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+
+static void audio_mix_add_sse(tcb::span<const float> src, tcb::span<float> dest) {
+    assert(src.size() == dest.size());
+    const size_t N = src.size();
+    // 128bits = 16bytes = 4*4bytes
+    const size_t K = 4u;
+    const size_t N_vector = (N/K)*K;
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const __m128 x = _mm_loadu_ps(&src[i]);
+        const __m128 y = _mm_loadu_ps(&dest[i]);
+        _mm_storeu_ps(&dest[i], _mm_add_ps(x, y));
+    }
+    audio_mix_add_scalar(src.subspan(N_vector), dest.subspan(N_vector));
+}
+
+static void audio_gain_clamp_sse(tcb::span<float> buf, const float gain, const float v_min, const float v_max) {
+    const size_t N = buf.size();
+    // 128bits = 16bytes = 4*4bytes
+    const size_t K = 4u;
+    const size_t N_vector = (N/K)*K;
+    const __m128 g = _mm_set1_ps(gain);
+    const __m128 lo = _mm_set1_ps(v_min);
+    const __m128 hi = _mm_set1_ps(v_max);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        __m128 x = _mm_loadu_ps(&buf[i]);
+        x = _mm_mul_ps(x, g);
+        x = _mm_min_ps(_mm_max_ps(x, lo), hi);
+        _mm_storeu_ps(&buf[i], x);
     }
+    audio_gain_clamp_scalar(buf.subspan(N_vector), gain, v_min, v_max);
 }
+#endif
+
+#if defined(__AVX__)
+#include <immintrin.h>
+
+static void audio_mix_add_avx(tcb::span<const float> src, tcb::span<float> dest) {
+    assert(src.size() == dest.size());
+    const size_t N = src.size();
+    // 256bits = 32bytes = 8*4bytes
+    const size_t K = 8u;
+    const size_t N_vector = (N/K)*K;
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const __m256 x = _mm256_loadu_ps(&src[i]);
+        const __m256 y = _mm256_loadu_ps(&dest[i]);
+        _mm256_storeu_ps(&dest[i], _mm256_add_ps(x, y));
+    }
+    audio_mix_add_scalar(src.subspan(N_vector), dest.subspan(N_vector));
+}
+
+static void audio_gain_clamp_avx(tcb::span<float> buf, const float gain, const float v_min, const float v_max) {
+    const size_t N = buf.size();
+    // 256bits = 32bytes = 8*4bytes
+    const size_t K = 8u;
+    const size_t N_vector = (N/K)*K;
+    const __m256 g = _mm256_set1_ps(gain);
+    const __m256 lo = _mm256_set1_ps(v_min);
+    const __m256 hi = _mm256_set1_ps(v_max);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        __m256 x = _mm256_loadu_ps(&buf[i]);
+        x = _mm256_mul_ps(x, g);
+        x = _mm256_min_ps(_mm256_max_ps(x, lo), hi);
+        _mm256_storeu_ps(&buf[i], x);
+    }
+    audio_gain_clamp_scalar(buf.subspan(N_vector), gain, v_min, v_max);
+}
+#endif
+
+// arm
+#elif defined(__SIMD_NEON__)
+#include <arm_neon.h>
+
+static void audio_mix_add_neon(tcb::span<const float> src, tcb::span<float> dest) {
+    assert(src.size() == dest.size());
+    const size_t N = src.size();
+    // 128bits = 16bytes = 4*4bytes
+    const size_t K = 4u;
+    const size_t N_vector = (N/K)*K;
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const float32x4_t x = vld1q_f32(&src[i]);
+        const float32x4_t y = vld1q_f32(&dest[i]);
+        vst1q_f32(&dest[i], vaddq_f32(x, y));
+    }
+    audio_mix_add_scalar(src.subspan(N_vector), dest.subspan(N_vector));
+}
+
+static void audio_gain_clamp_neon(tcb::span<float> buf, const float gain, const float v_min, const float v_max) {
+    const size_t N = buf.size();
+    // 128bits = 16bytes = 4*4bytes
+    const size_t K = 4u;
+    const size_t N_vector = (N/K)*K;
+    const float32x4_t lo = vdupq_n_f32(v_min);
+    const float32x4_t hi = vdupq_n_f32(v_max);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        float32x4_t x = vld1q_f32(&buf[i]);
+        x = vmulq_n_f32(x, gain);
+        x = vminq_f32(vmaxq_f32(x, lo), hi);
+        vst1q_f32(&buf[i], x);
+    }
+    audio_gain_clamp_scalar(buf.subspan(N_vector), gain, v_min, v_max);
+}
+
+#endif
+
+static void audio_mix_add(tcb::span<const Frame<float>> src, tcb::span<Frame<float>> dest) {
+    const auto x = audio_as_floats(src);
+    const auto y = audio_as_floats(dest);
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX__)
+        audio_mix_add_avx(x, y);
+        #elif defined(__SSE__)
+        audio_mix_add_sse(x, y);
+        #else
+        audio_mix_add_scalar(x, y);
+        #endif
+    #elif defined(__SIMD_NEON__)
+        audio_mix_add_neon(x, y);
+    #else
+        audio_mix_add_scalar(x, y);
+    #endif
+}
+
+static void audio_gain_clamp(tcb::span<Frame<float>> buf, const float gain, const float v_min, const float v_max) {
+    const auto x = audio_as_floats(buf);
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX__)
+        audio_gain_clamp_avx(x, gain, v_min, v_max);
+        #elif defined(__SSE__)
+        audio_gain_clamp_sse(x, gain, v_min, v_max);
+        #else
+        audio_gain_clamp_scalar(x, gain, v_min, v_max);
+        #endif
+    #elif defined(__SIMD_NEON__)
+        audio_gain_clamp_neon(x, gain, v_min, v_max);
+    #else
+        audio_gain_clamp_scalar(x, gain, v_min, v_max);
+    #endif
+}
+
+constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV1A_PRIME = 0x100000001b3ull;
 
 AudioPipelineSource::AudioPipelineSource(float sampling_rate, size_t buffer_length)
-: m_sampling_rate(sampling_rate), m_ring_buffer(buffer_length)
+: m_sampling_rate(sampling_rate), m_ring_buffer(buffer_length), m_checksum(FNV1A_OFFSET_BASIS)
 {}
 
 void AudioPipelineSource::write(tcb::span<const Frame<int16_t>> src, float src_sampling_rate, bool is_blocking) {
+    uint64_t hash = m_checksum.load(std::memory_order_relaxed);
+    for (const auto& x: src) {
+        for (int i = 0; i < Frame<int16_t>::TOTAL_AUDIO_CHANNELS; i++) {
+            const auto v = uint16_t(x.channels[i]);
+            hash = (hash ^ uint64_t(v & 0xFF)) * FNV1A_PRIME;
+            hash = (hash ^ uint64_t(v >> 8)) * FNV1A_PRIME;
+        }
+    }
+    m_checksum.store(hash, std::memory_order_relaxed);
+    m_total_decoded_frames.fetch_add(uint64_t(src.size()), std::memory_order_relaxed);
+
     const float gain = m_gain / float(std::numeric_limits<int16_t>::max());
-    const size_t resample_length = size_t(float(src.size()) * m_sampling_rate / src_sampling_rate);
-    m_resampling_buffer.resize(resample_length);
-
-    if (resample_length == src.size()) {
-        audio_map_with_callback<int16_t,float>(
-            src, m_resampling_buffer, 
-            [gain](Frame<float>& v_dest, const Frame<int16_t>& v_src) {
-                v_dest = static_cast<Frame<float>>(v_src) * gain;
-            }
-        );
-    } else {
-        audio_resample_with_callback<int16_t,float>(
-            src, m_resampling_buffer, 
-            [gain](Frame<float>& v_dest, const Frame<float>& v_src) {
-                v_dest = v_src * gain;
-            }
-        );
+    m_convert_buffer.resize(src.size());
+    audio_map_with_callback<int16_t,float>(
+        src, m_convert_buffer,
+        [gain](Frame<float>& v_dest, const Frame<int16_t>& v_src) {
+            v_dest = static_cast<Frame<float>>(v_src) * gain;
+        }
+    );
+
+    if ((m_resampler == nullptr) || (m_resampler->get_input_rate() != src_sampling_rate)) {
+        m_resampler = std::make_unique<AudioResampler>(src_sampling_rate, m_sampling_rate);
+        m_average_fill = 0.5f;
     }
 
-    auto lock = std::unique_lock(m_mutex_ring_buffer);
-    if (!is_blocking) {
-        m_ring_buffer.write_forcefully(m_resampling_buffer);
-        return;
+    if (is_blocking) {
+        // backpressure already paces the producer to the sink
+        m_resampler->set_ratio_correction(1.0f);
+    } else {
+        // proportional control on a smoothed fill level so the ratio doesn't jitter with each sink callback
+        constexpr float FILL_SMOOTHING = 0.05f;
+        constexpr float FILL_TARGET = 0.5f;
+        constexpr float CORRECTION_GAIN = 0.02f;
+        constexpr float MAX_CORRECTION = 0.01f;
+        const uint64_t read_index = m_total_read.load(std::memory_order_acquire);
+        const uint64_t write_index = m_total_written.load(std::memory_order_relaxed);
+        const float fill = float(write_index - read_index) / float(m_ring_buffer.size());
+        m_average_fill += FILL_SMOOTHING*(fill - m_average_fill);
+        const float correction = std::clamp(
+            -CORRECTION_GAIN*(m_average_fill - FILL_TARGET),
+            -MAX_CORRECTION, MAX_CORRECTION);
+        m_resampler->set_ratio_correction(1.0f + correction);
     }
 
-    auto read_buffer = tcb::span<const Frame<float>>(m_resampling_buffer);
+    m_resampling_buffer.resize(m_resampler->get_max_output_length(m_convert_buffer.size()));
+    const size_t total_resampled = m_resampler->process(m_convert_buffer, m_resampling_buffer);
+
+    auto write_buffer = tcb::span<const Frame<float>>(m_resampling_buffer).first(total_resampled);
     while (true) {
-        const size_t total_read = m_ring_buffer.write(read_buffer);
-        read_buffer = read_buffer.subspan(total_read);
-        if (read_buffer.empty()) break;
-        m_cv_ring_buffer.wait(lock, [this]{ 
-            return !m_ring_buffer.is_full();
-        });
+        const size_t total_written = write_available(write_buffer);
+        write_buffer = write_buffer.subspan(total_written);
+        if (write_buffer.empty()) break;
+        if (!is_blocking) break;
+        // the sink callback can't wake us up without locking so sleep for about as long as it takes to make room
+        constexpr float MIN_WAIT_SECONDS = 0.5e-3f;
+        constexpr float MAX_WAIT_SECONDS = 10e-3f;
+        const float wait_seconds = std::clamp(
+            float(write_buffer.size()) / m_sampling_rate,
+            MIN_WAIT_SECONDS, MAX_WAIT_SECONDS);
+        std::this_thread::sleep_for(std::chrono::duration<float>(wait_seconds));
     }
 }
 
+size_t AudioPipelineSource::write_available(tcb::span<const Frame<float>> src) {
+    const size_t N = m_ring_buffer.size();
+    const uint64_t write_index = m_total_written.load(std::memory_order_relaxed);
+    const uint64_t read_index = m_total_read.load(std::memory_order_acquire);
+    const size_t total_free = N - size_t(write_index - read_index);
+    const size_t length = std::min(total_free, src.size());
+    const size_t offset = size_t(write_index % N);
+    const size_t head_length = std::min(length, N-offset);
+    memcpy(m_ring_buffer.data() + offset, src.data(), head_length*sizeof(Frame<float>));
+    memcpy(m_ring_buffer.data(), src.data() + head_length, (length-head_length)*sizeof(Frame<float>));
+    m_total_written.store(write_index + length, std::memory_order_release);
+    return length;
+}
+
 bool AudioPipelineSource::read(tcb::span<Frame<float>> dest) {
-    auto lock = std::unique_lock(m_mutex_ring_buffer);
-    if (m_ring_buffer.get_total_used() < dest.size()) {
+    const size_t N = m_ring_buffer.size();
+    const uint64_t read_index = m_total_read.load(std::memory_order_relaxed);
+    const uint64_t write_index = m_total_written.load(std::memory_order_acquire);
+    const size_t total_used = size_t(write_index - read_index);
+    if (total_used < dest.size()) {
         return false;
     }
-    m_ring_buffer.read(dest);
-    lock.unlock();
-    m_cv_ring_buffer.notify_one();
+    const size_t length = dest.size();
+    const size_t offset = size_t(read_index % N);
+    const size_t head_length = std::min(length, N-offset);
+    memcpy(dest.data(), m_ring_buffer.data() + offset, head_length*sizeof(Frame<float>));
+    memcpy(dest.data() + head_length, m_ring_buffer.data(), (length-head_length)*sizeof(Frame<float>));
+    m_total_read.store(read_index + length, std::memory_order_release);
     return true;
 }
 
+float AudioPipelineSource::get_buffered_duration() const {
+    const uint64_t read_index = m_total_read.load(std::memory_order_acquire);
+    const uint64_t write_index = m_total_written.load(std::memory_order_acquire);
+    return float(write_index - read_index) / m_sampling_rate;
+}
+
+AudioPipeline::AudioPipeline() {
+    auto lock = std::scoped_lock(m_mutex_sources);
+    publish_sources();
+}
+
+AudioPipeline::~AudioPipeline() {
+    // stop the sink callback before freeing the list it reads
+    m_sink = nullptr;
+    delete m_mixer_list.exchange(nullptr);
+}
+
 void AudioPipeline::set_sink(std::unique_ptr<AudioPipelineSink>&& sink) {
+    auto lock = std::scoped_lock(m_mutex_sources);
     m_sink = std::move(sink);
     if (m_sink == nullptr) return;
+    m_sink_sample_rate = m_sink->get_sample_rate();
+    m_sink_frames_per_buffer = m_sink->get_frames_per_buffer();
+    publish_sources();
     m_sink->set_callback([this](tcb::span<Frame<float>> dest, float dest_sampling_rate) {
-        mix_sources_to_sink(dest, dest_sampling_rate); 
+        return mix_sources_to_sink(dest, dest_sampling_rate);
     });
 }
 
-void AudioPipeline::mix_sources_to_sink(tcb::span<Frame<float>> dest, float dest_sampling_rate) {
-    const size_t N_dest = dest.size();
-    for (auto& v: dest) {
-        for (size_t i = 0; i < Frame<float>::TOTAL_AUDIO_CHANNELS; i++) {
-            v.channels[i] = 0.0f;
-        }
-    }
-    std::vector<std::shared_ptr<AudioPipelineSource>> sources;
-    {
-        auto lock = std::scoped_lock(m_mutex_sources);
-        sources = m_sources;
+void AudioPipeline::add_source(std::shared_ptr<AudioPipelineSource>& source) {
+    auto lock = std::scoped_lock(m_mutex_sources);
+    m_sources.push_back(source);
+    publish_sources();
+}
+
+void AudioPipeline::clear_sources() {
+    auto lock = std::scoped_lock(m_mutex_sources);
+    m_sources.clear();
+    publish_sources();
+}
+
+std::vector<std::shared_ptr<AudioPipelineSource>> AudioPipeline::get_sources() {
+    auto lock = std::scoped_lock(m_mutex_sources);
+    return m_sources;
+}
+
+// Caller must hold m_mutex_sources
+void AudioPipeline::publish_sources() {
+    // allocate everything the sink callback needs here so it doesn't have to
+    auto* list = new MixerSourceList();
+    list->frames_per_buffer = std::max(m_sink_frames_per_buffer, size_t(1));
+    list->sources.reserve(m_sources.size());
+    for (auto& source: m_sources) {
+        const float ratio = source->get_sampling_rate() / m_sink_sample_rate;
+        const size_t total_scratch = size_t(std::ceil(float(list->frames_per_buffer) * ratio)) + 1;
+        list->sources.push_back({ source, std::vector<Frame<float>>(total_scratch) });
     }
-    size_t total_sources_mixed = 0;
-    for (auto& source: sources) {
-        const float src_sampling_rate = source->get_sampling_rate();
-        const size_t N_src = size_t(float(N_dest) * src_sampling_rate / dest_sampling_rate);
-        m_read_buffer.resize(N_src);
 
-        if (!source->read(m_read_buffer)) {
-            continue;
+    MixerSourceList* old_list = m_mixer_list.exchange(list);
+    // an odd epoch means the sink callback might still be mixing with the old list
+    const uint64_t epoch = m_mixer_epoch.load();
+    if (epoch % 2 == 1) {
+        while (m_mixer_epoch.load() == epoch) {
+            std::this_thread::yield();
         }
+    }
+    delete old_list;
+}
+
+bool AudioPipeline::mix_sources_to_sink(tcb::span<Frame<float>> dest, float dest_sampling_rate) {
+    m_mixer_epoch.fetch_add(1);
+    MixerSourceList* list = m_mixer_list.load();
+    const float global_gain = m_global_gain;
+    bool is_any_mixed = false;
+
+    while (!dest.empty()) {
+        const size_t N_dest = std::min(dest.size(), list->frames_per_buffer);
+        auto block = dest.first(N_dest);
+        dest = dest.subspan(N_dest);
+        std::fill(block.begin(), block.end(), Frame<float>{});
 
-        audio_resample_same_type_with_callback<float>(
-            m_read_buffer, dest,
-            [](Frame<float>& v_dest, const Frame<float>& v_src) { 
-                v_dest += v_src;
+        size_t total_sources_mixed = 0;
+        for (auto& mixer_source: list->sources) {
+            auto& source = *(mixer_source.source.get());
+            const float src_sampling_rate = source.get_sampling_rate();
+            const size_t N_src = size_t(float(N_dest) * src_sampling_rate / dest_sampling_rate);
+            if (N_src > mixer_source.scratch.size()) {
+                m_total_skipped_sources.fetch_add(1, std::memory_order_relaxed);
+                continue;
             }
-        );
-        total_sources_mixed++;
-    }
+            auto scratch = tcb::span(mixer_source.scratch).first(N_src);
+            if (!source.read(scratch)) {
+                continue;
+            }
+
+            if (N_src == N_dest) {
+                audio_mix_add(scratch, block);
+            } else {
+                audio_resample_with_callback<float,float>(
+                    scratch, block,
+                    [](Frame<float>& v_dest, const Frame<float>& v_src) {
+                        v_dest += v_src;
+                    }
+                );
+            }
+            total_sources_mixed++;
+        }
 
-    const float gain = m_global_gain / std::log10(float(total_sources_mixed * 10.0f));
-    for (auto& v: dest) {
-        v = v * gain;
+        if (total_sources_mixed == 0) continue;
+        is_any_mixed = true;
+        const float gain = global_gain / std::log10(float(total_sources_mixed * 10.0f));
+        audio_gain_clamp(block, gain, -1.0f, 1.0f);
     }
 
-    audio_clamp_inplace(dest, -1.0f, 1.0f);
+    m_mixer_epoch.fetch_add(1, std::memory_order_release);
+    return is_any_mixed;
 }
@@ -2,7 +2,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
-#include <condition_variable>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -10,7 +10,7 @@
 #include <vector>
 #include "utility/span.h"
 #include "./frame.h"
-#include "./ring_buffer.h"
+#include "./audio_resampler.h"
 
 constexpr float DEFAULT_AUDIO_SAMPLE_RATE = 48000.0f;
 constexpr float DEFAULT_AUDIO_SINK_DURATION = 0.1f;
@@ -21,52 +21,100 @@ constexpr size_t DEFAULT_AUDIO_SOURCE_SAMPLES = size_t(DEFAULT_AUDIO_SAMPLE_RATE
 class AudioPipelineSink
 {
 public:
-    using Callback = std::function<void(tcb::span<Frame<float>>, float)>;
+    // returns false if none of the sources had audio ready so the buffer was filled with silence
+    using Callback = std::function<bool(tcb::span<Frame<float>>, float)>;
     virtual ~AudioPipelineSink() {}
     virtual void set_callback(Callback callback) = 0;
     virtual std::string_view get_name() const = 0;
+    // used to preallocate mixing buffers so the callback never has to
+    virtual float get_sample_rate() const = 0;
+    virtual size_t get_frames_per_buffer() const = 0;
 };
 
-class AudioPipelineSource 
+// Single producer (decoder thread) and single consumer (sink callback)
+// The consumer never locks or allocates so it can be called from a real time audio thread
+class AudioPipelineSource
 {
 private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
     const float m_sampling_rate;
     float m_gain = 1.0f;
 
+    // only used by the producer
+    std::unique_ptr<AudioResampler> m_resampler = nullptr;
+    float m_average_fill = 0.5f;
+    std::vector<Frame<float>> m_convert_buffer;
     std::vector<Frame<float>> m_resampling_buffer;
-    RingBuffer<Frame<float>> m_ring_buffer;
-    std::vector<Frame<float>> m_read_buffer;
-
-    std::mutex m_mutex_ring_buffer;
-    std::condition_variable m_cv_ring_buffer;
+    std::vector<Frame<float>> m_ring_buffer;
+    // fnv-1a over the decoded audio before it is resampled or mixed so it doesn't depend on timing
+    std::atomic<uint64_t> m_total_decoded_frames{0};
+    std::atomic<uint64_t> m_checksum;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_total_written{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_total_read{0};
 public:
     explicit AudioPipelineSource(float sampling_rate=DEFAULT_AUDIO_SAMPLE_RATE, size_t buffer_length=DEFAULT_AUDIO_SOURCE_SAMPLES);
-    void write(tcb::span<const Frame<int16_t>> src, float src_sampling_rate, bool is_blocking); 
+    AudioPipelineSource(AudioPipelineSource&) = delete;
+    AudioPipelineSource(AudioPipelineSource&&) = delete;
+    AudioPipelineSource& operator=(AudioPipelineSource&) = delete;
+    AudioPipelineSource& operator=(AudioPipelineSource&&) = delete;
+    // Blocking writes wait for the sink to make room, otherwise audio that doesn't fit is dropped
+    // Non-blocking writes nudge the resampling ratio to keep the buffer half full so the
+    // clock drift between the source and the sink doesn't under or overrun it
+    void write(tcb::span<const Frame<int16_t>> src, float src_sampling_rate, bool is_blocking);
+    // Reads nothing and returns false if there isn't enough audio to fill dest
     bool read(tcb::span<Frame<float>> dest);
     float get_sampling_rate() const { return m_sampling_rate; }
+    // seconds of audio waiting to be read by the sink
+    float get_buffered_duration() const;
+    // > 1 if the source is being stretched to make up for a sink that runs faster than it
+    float get_ratio_correction() const { return m_resampler ? m_resampler->get_ratio_correction() : 1.0f; }
+    uint64_t get_total_decoded_frames() const { return m_total_decoded_frames.load(std::memory_order_relaxed); }
+    uint64_t get_checksum() const { return m_checksum.load(std::memory_order_relaxed); }
+private:
+    size_t write_available(tcb::span<const Frame<float>> src);
 };
 
+// Mixes sources into the sink from the sink's callback
+// Sources are published as an immutable list which the callback picks up without locking (read-copy-update)
 class AudioPipeline
 {
 private:
+    struct MixerSource {
+        std::shared_ptr<AudioPipelineSource> source;
+        std::vector<Frame<float>> scratch;
+    };
+    struct MixerSourceList {
+        size_t frames_per_buffer = 0;
+        std::vector<MixerSource> sources;
+    };
+
     float m_global_gain = 1.0f;
-    std::vector<std::shared_ptr<AudioPipelineSource>> m_sources;
     std::unique_ptr<AudioPipelineSink> m_sink = nullptr;
-    std::vector<Frame<float>> m_read_buffer;
+    // only taken by threads that change the sink or sources
     std::mutex m_mutex_sources;
+    std::vector<std::shared_ptr<AudioPipelineSource>> m_sources;
+    float m_sink_sample_rate = DEFAULT_AUDIO_SAMPLE_RATE;
+    size_t m_sink_frames_per_buffer = DEFAULT_AUDIO_SINK_SAMPLES;
+    // list read by the sink callback and a counter that is odd while it is mixing
+    std::atomic<MixerSourceList*> m_mixer_list{nullptr};
+    std::atomic<uint64_t> m_mixer_epoch{0};
+    std::atomic<uint64_t> m_total_skipped_sources{0};
 public:
-    AudioPipeline() {}
+    AudioPipeline();
+    ~AudioPipeline();
+    AudioPipeline(AudioPipeline&) = delete;
+    AudioPipeline(AudioPipeline&&) = delete;
+    AudioPipeline& operator=(AudioPipeline&) = delete;
+    AudioPipeline& operator=(AudioPipeline&&) = delete;
     void set_sink(std::unique_ptr<AudioPipelineSink>&& sink);
     AudioPipelineSink* get_sink() { return m_sink.get(); }
-    void add_source(std::shared_ptr<AudioPipelineSource>& source) { 
-        auto lock = std::scoped_lock(m_mutex_sources);
-        m_sources.push_back(source); 
-    }
-    void clear_sources() { 
-        auto lock = std::scoped_lock(m_mutex_sources);
-        m_sources.clear(); 
-    }
+    void add_source(std::shared_ptr<AudioPipelineSource>& source);
+    void clear_sources();
+    std::vector<std::shared_ptr<AudioPipelineSource>> get_sources();
     float& get_global_gain() { return m_global_gain; }
+    // number of times a source was left out of the mix because the sink asked for more than was preallocated
+    uint64_t get_total_skipped_sources() const { return m_total_skipped_sources.load(std::memory_order_relaxed); }
 private:
-    void mix_sources_to_sink(tcb::span<Frame<float>> dest, float dest_sampling_rate);
+    void publish_sources();
+    bool mix_sources_to_sink(tcb::span<Frame<float>> dest, float dest_sampling_rate);
 };
@@ -0,0 +1,198 @@
+#include "./audio_resampler.h"
+#include <assert.h>
+#include <stddef.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "detect_architecture.h"
+#include "simd_flags.h" // NOLINT
+#include "utility/span.h"
+#include "./frame.h"
+
+constexpr size_t TOTAL_CHANNELS = size_t(Frame<float>::TOTAL_AUDIO_CHANNELS);
+constexpr size_t TOTAL_TAPS = AudioResampler::TOTAL_TAPS;
+constexpr size_t TOTAL_PHASES = AudioResampler::TOTAL_PHASES;
+// coefficients and input frames are both interleaved as [L0 R0 L1 R1 ...]
+constexpr size_t TOTAL_TAP_FLOATS = TOTAL_TAPS*TOTAL_CHANNELS;
+static_assert(sizeof(Frame<float>) == sizeof(float)*TOTAL_CHANNELS);
+static_assert(TOTAL_CHANNELS == 2, "Dot product kernels sum alternating lanes as left and right channels");
+
+static Frame<float> resampler_dot_scalar(const float* coefficients, const float* frames) {
+    Frame<float> y;
+    float acc[TOTAL_CHANNELS] = {0.0f};
+    for (size_t i = 0; i < TOTAL_TAP_FLOATS; i+=TOTAL_CHANNELS) {
+        for (size_t j = 0; j < TOTAL_CHANNELS; j++) {
+            acc[j] += coefficients[i+j]*frames[i+j];
+        }
+    }
+    for (size_t j = 0; j < TOTAL_CHANNELS; j++) {
+        y.channels[j] = acc[j];
+    }
+    return y;
+}
+
+// x86
+#if defined(__ARCH_X86__)
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+
+static Frame<float> resampler_dot_sse(const float* coefficients, const float* frames) {
+    // 128bits = 16bytes = 4*4bytes = 2 frames
+    constexpr size_t K = 4u;
+    static_assert(TOTAL_TAP_FLOATS % K == 0);
+    __m128 acc = _mm_setzero_ps();
+    for (size_t i = 0; i < TOTAL_TAP_FLOATS; i+=K) {
+        const __m128 h = _mm_loadu_ps(&coefficients[i]);
+        const __m128 x = _mm_loadu_ps(&frames[i]);
+        acc = _mm_add_ps(acc, _mm_mul_ps(h, x));
+    }
+    // [L0 R0 L1 R1] => [L0+L1 R0+R1 ...]
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    alignas(16) float res[K];
+    _mm_store_ps(res, acc);
+    Frame<float> y;
+    y.channels[0] = res[0];
+    y.channels[1] = res[1];
+    return y;
+}
+#endif
+
+#if defined(__AVX__)
+#include <immintrin.h>
+
+static Frame<float> resampler_dot_avx(const float* coefficients, const float* frames) {
+    // 256bits = 32bytes = 8*4bytes = 4 frames
+    constexpr size_t K = 8u;
+    static_assert(TOTAL_TAP_FLOATS % K == 0);
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t i = 0; i < TOTAL_TAP_FLOATS; i+=K) {
+        const __m256 h = _mm256_loadu_ps(&coefficients[i]);
+        const __m256 x = _mm256_loadu_ps(&frames[i]);
+        #if defined(__FMA__)
+        acc = _mm256_fmadd_ps(h, x, acc);
+        #else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(h, x));
+        #endif
+    }
+    __m128 res_128 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    res_128 = _mm_add_ps(res_128, _mm_movehl_ps(res_128, res_128));
+    alignas(16) float res[4];
+    _mm_store_ps(res, res_128);
+    Frame<float> y;
+    y.channels[0] = res[0];
+    y.channels[1] = res[1];
+    return y;
+}
+#endif
+
+// arm
+#elif defined(__SIMD_NEON__)
+#include <arm_neon.h>
+
+static Frame<float> resampler_dot_neon(const float* coefficients, const float* frames) {
+    // 128bits = 16bytes = 4*4bytes = 2 frames
+    constexpr size_t K = 4u;
+    static_assert(TOTAL_TAP_FLOATS % K == 0);
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < TOTAL_TAP_FLOATS; i+=K) {
+        const float32x4_t h = vld1q_f32(&coefficients[i]);
+        const float32x4_t x = vld1q_f32(&frames[i]);
+        acc = vfmaq_f32(acc, h, x);
+    }
+    const float32x2_t res = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    Frame<float> y;
+    y.channels[0] = vget_lane_f32(res, 0);
+    y.channels[1] = vget_lane_f32(res, 1);
+    return y;
+}
+
+#endif
+
+static Frame<float> resampler_dot(const float* coefficients, const float* frames) {
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX__)
+        return resampler_dot_avx(coefficients, frames);
+        #elif defined(__SSE__)
+        return resampler_dot_sse(coefficients, frames);
+        #else
+        return resampler_dot_scalar(coefficients, frames);
+        #endif
+    #elif defined(__SIMD_NEON__)
+        return resampler_dot_neon(coefficients, frames);
+    #else
+        return resampler_dot_scalar(coefficients, frames);
+    #endif
+}
+
+AudioResampler::AudioResampler(float input_rate, float output_rate)
+: m_input_rate(input_rate), m_output_rate(output_rate)
+{
+    // lowpass below the lower of the two nyquist frequencies to avoid aliasing when downsampling
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double TRANSITION_MARGIN = 0.9;
+    const double cutoff = 0.5 * std::min(1.0, double(output_rate)/double(input_rate)) * TRANSITION_MARGIN;
+    const double centre = double(TOTAL_TAPS/2 - 1);
+    const double width = double(TOTAL_TAPS);
+
+    // an extra phase so a fractional position that rounds up to the next frame doesn't need to wrap around
+    m_coefficients.resize((TOTAL_PHASES+1)*TOTAL_TAP_FLOATS);
+    auto phase_taps = std::vector<double>(TOTAL_TAPS);
+    for (size_t phase = 0; phase <= TOTAL_PHASES; phase++) {
+        const double frac = double(phase) / double(TOTAL_PHASES);
+        double sum = 0.0;
+        for (size_t k = 0; k < TOTAL_TAPS; k++) {
+            const double t = double(k) - centre - frac;
+            const double x = 2.0*cutoff*t;
+            const double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(PI*x)/(PI*x);
+            // blackman window centred on t = 0
+            const double n = t/width + 0.5;
+            const double window = (n <= 0.0 || n >= 1.0) ? 0.0 :
+                0.42 - 0.5*std::cos(2.0*PI*n) + 0.08*std::cos(4.0*PI*n);
+            phase_taps[k] = sinc*window;
+            sum += phase_taps[k];
+        }
+        // unity gain at dc for every phase
+        float* coefficients = &m_coefficients[phase*TOTAL_TAP_FLOATS];
+        for (size_t k = 0; k < TOTAL_TAPS; k++) {
+            for (size_t j = 0; j < TOTAL_CHANNELS; j++) {
+                coefficients[k*TOTAL_CHANNELS+j] = float(phase_taps[k] / sum);
+            }
+        }
+    }
+
+    // first output frame is centred on the first input frame
+    m_history.resize(TOTAL_TAPS/2 - 1, Frame<float>{});
+}
+
+size_t AudioResampler::get_max_output_length(size_t input_length) const {
+    const double step = double(m_input_rate) / (double(m_output_rate)*double(m_ratio_correction));
+    return size_t(double(m_history.size() + input_length) / step) + 2;
+}
+
+size_t AudioResampler::process(tcb::span<const Frame<float>> src, tcb::span<Frame<float>> dest) {
+    m_history.insert(m_history.end(), src.begin(), src.end());
+    const double step = double(m_input_rate) / (double(m_output_rate)*double(m_ratio_correction));
+    const size_t N = m_history.size();
+    const auto* frames = reinterpret_cast<const float*>(m_history.data());
+
+    size_t total_output = 0;
+    while (total_output < dest.size()) {
+        size_t index = size_t(m_position);
+        if (index + TOTAL_TAPS > N) break;
+        const double frac = m_position - double(index);
+        const size_t phase = size_t(frac*double(TOTAL_PHASES) + 0.5);
+        assert(phase <= TOTAL_PHASES);
+        dest[total_output] = resampler_dot(
+            &m_coefficients[phase*TOTAL_TAP_FLOATS],
+            &frames[index*TOTAL_CHANNELS]
+        );
+        total_output++;
+        m_position += step;
+    }
+
+    const size_t total_consumed = std::min(size_t(m_position), N);
+    m_history.erase(m_history.begin(), m_history.begin() + total_consumed);
+    m_position -= double(total_consumed);
+    return total_output;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "utility/span.h"
+#include "./frame.h"
+
+// Polyphase windowed sinc resampler with a continuously adjustable ratio
+// The ratio can be nudged every block to track drift between the input and output clocks
+class AudioResampler
+{
+public:
+    static constexpr size_t TOTAL_TAPS = 32;
+    static constexpr size_t TOTAL_PHASES = 256;
+private:
+    const float m_input_rate;
+    const float m_output_rate;
+    float m_ratio_correction = 1.0f;
+    // coefficients for each phase are duplicated for each channel to match interleaved frames
+    std::vector<float> m_coefficients;
+    // last TOTAL_TAPS-1 input frames followed by the new input
+    std::vector<Frame<float>> m_history;
+    // position of the next output frame relative to the start of the history in input frames
+    double m_position = 0.0;
+public:
+    explicit AudioResampler(float input_rate, float output_rate);
+    float get_input_rate() const { return m_input_rate; }
+    float get_output_rate() const { return m_output_rate; }
+    // > 1 produces more output frames for the same input
+    void set_ratio_correction(float correction) { m_ratio_correction = correction; }
+    float get_ratio_correction() const { return m_ratio_correction; }
+    size_t get_max_output_length(size_t input_length) const;
+    // Consumes all of the input and returns the number of frames written to dest
+    // dest must have room for get_max_output_length(src.size()) frames
+    size_t process(tcb::span<const Frame<float>> src, tcb::span<Frame<float>> dest);
+};
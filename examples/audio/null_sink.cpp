@@ -0,0 +1,105 @@
+#include "./null_sink.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "utility/span.h"
+#include "./frame.h"
+
+NullAudioSink::NullAudioSink(const NullAudioSinkConfig& config)
+: m_config(config)
+{
+    m_buffer.resize(std::max(m_config.frames_per_buffer, size_t(1)));
+    m_runner_thread = std::make_unique<std::thread>([this]() {
+        runner_thread();
+    });
+}
+
+NullAudioSink::~NullAudioSink() {
+    m_is_running = false;
+    if (m_runner_thread->joinable()) m_runner_thread->join();
+}
+
+void NullAudioSink::drain_and_stop() {
+    m_is_draining = true;
+    if (m_runner_thread->joinable()) m_runner_thread->join();
+}
+
+void NullAudioSink::set_callback(AudioPipelineSink::Callback callback) {
+    auto lock = std::scoped_lock(m_mutex_callback);
+    m_callback = callback;
+}
+
+NullAudioSinkStats NullAudioSink::get_stats() {
+    auto lock = std::scoped_lock(m_mutex_stats);
+    NullAudioSinkStats stats = m_stats;
+    for (int i = 0; i < Frame<float>::TOTAL_AUDIO_CHANNELS; i++) {
+        stats.rms[i] = (stats.total_frames > 0) ? float(std::sqrt(m_sum_squares[i] / double(stats.total_frames))) : 0.0f;
+    }
+    return stats;
+}
+
+void NullAudioSink::runner_thread() {
+    using clock = std::chrono::steady_clock;
+    const bool is_paced = m_config.speed > 0.0f;
+    const auto buffer_period = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(double(m_buffer.size()) / (double(m_config.sample_rate) * double(m_config.speed)))
+    );
+    // sources fill up at the rate the decoder produces audio so back off instead of spinning on an empty pipeline
+    constexpr auto UNDERRUN_BACKOFF = std::chrono::milliseconds(1);
+
+    auto time_next = clock::now();
+    while (m_is_running) {
+        const bool is_draining = m_is_draining;
+        const bool is_consumed = pull_buffer(is_draining);
+        if (is_draining) {
+            // the producers have stopped so an empty pipeline is the end of the stream
+            if (!is_consumed) break;
+        } else if (is_paced) {
+            // a paced sink behaves like a sound card and keeps its clock through underruns
+            time_next += buffer_period;
+            const auto time_now = clock::now();
+            if (time_next < time_now) time_next = time_now;
+            std::this_thread::sleep_until(time_next);
+        } else if (!is_consumed) {
+            std::this_thread::sleep_for(UNDERRUN_BACKOFF);
+        }
+    }
+}
+
+bool NullAudioSink::pull_buffer(const bool is_draining) {
+    bool is_consumed = false;
+    {
+        auto lock = std::scoped_lock(m_mutex_callback);
+        if (!m_callback) return false;
+        is_consumed = m_callback(m_buffer, m_config.sample_rate);
+    }
+
+    // decoded silence still counts as audio, only an empty pipeline is an underrun
+    if (!is_consumed) {
+        if (is_draining) return false;
+        auto lock = std::scoped_lock(m_mutex_stats);
+        m_stats.total_underruns++;
+        return false;
+    }
+    update_stats(m_buffer);
+    return true;
+}
+
+void NullAudioSink::update_stats(tcb::span<const Frame<float>> buf) {
+    auto lock = std::scoped_lock(m_mutex_stats);
+    m_stats.total_frames += uint64_t(buf.size());
+    if (m_config.is_measure_levels) {
+        for (const auto& x: buf) {
+            for (int i = 0; i < Frame<float>::TOTAL_AUDIO_CHANNELS; i++) {
+                const float v = x.channels[i];
+                m_stats.peak[i] = std::max(m_stats.peak[i], std::abs(v));
+                m_sum_squares[i] += double(v)*double(v);
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "./audio_pipeline.h"
+#include "./frame.h"
+
+struct NullAudioSinkConfig {
+    float sample_rate = DEFAULT_AUDIO_SAMPLE_RATE;
+    size_t frames_per_buffer = DEFAULT_AUDIO_SINK_SAMPLES;
+    // multiple of realtime playback, <= 0 consumes as fast as audio is produced
+    float speed = 0.0f;
+    bool is_measure_levels = true;
+};
+
+struct NullAudioSinkStats {
+    uint64_t total_frames = 0;
+    // buffers where no source had audio ready so nothing was consumed
+    uint64_t total_underruns = 0;
+    float peak[Frame<float>::TOTAL_AUDIO_CHANNELS] = {0.0f};
+    float rms[Frame<float>::TOTAL_AUDIO_CHANNELS] = {0.0f};
+};
+
+// Sink without an audio device for running the whole pipeline offline
+// Pulls from the pipeline on its own thread at a fixed rate or as fast as possible
+class NullAudioSink: public AudioPipelineSink
+{
+private:
+    const NullAudioSinkConfig m_config;
+    std::mutex m_mutex_callback;
+    AudioPipelineSink::Callback m_callback;
+    std::vector<Frame<float>> m_buffer;
+    std::mutex m_mutex_stats;
+    NullAudioSinkStats m_stats;
+    double m_sum_squares[Frame<float>::TOTAL_AUDIO_CHANNELS] = {0.0};
+    std::atomic<bool> m_is_running{true};
+    std::atomic<bool> m_is_draining{false};
+    std::unique_ptr<std::thread> m_runner_thread;
+public:
+    explicit NullAudioSink(const NullAudioSinkConfig& config);
+    ~NullAudioSink() override;
+    NullAudioSink(NullAudioSink&) = delete;
+    NullAudioSink(NullAudioSink&&) = delete;
+    NullAudioSink& operator=(NullAudioSink&) = delete;
+    NullAudioSink& operator=(NullAudioSink&&) = delete;
+    void set_callback(AudioPipelineSink::Callback callback) override;
+    std::string_view get_name() const override { return "Null"; }
+    float get_sample_rate() const override { return m_config.sample_rate; }
+    size_t get_frames_per_buffer() const override { return m_config.frames_per_buffer; }
+    // Pulls until none of the sources have enough audio left to fill a buffer then stops the sink
+    // Call this once the producers have finished so the stats include everything they wrote
+    void drain_and_stop();
+    NullAudioSinkStats get_stats();
+private:
+    void runner_thread();
+    bool pull_buffer(bool is_draining);
+    void update_stats(tcb::span<const Frame<float>> buf);
+};
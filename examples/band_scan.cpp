@@ -0,0 +1,296 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+#include <easylogging++.h>
+#include "utility/span.h"
+#include "./app_helpers/app_band_scanner.h"
+#include "./app_helpers/app_io_buffers.h"
+#include "./app_helpers/app_logging.h"
+#include "./app_helpers/app_ofdm_blocks.h"
+#include "./app_helpers/app_virtual_tuner.h"
+#include "./block_frequencies.h"
+#include "./device/device.h"
+#include "./device/device_list.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("--virtual-recordings")
+        .default_value(std::string(""))
+        .metavar("DIRECTORY")
+        .nargs(1).required()
+        .help("Scan with a virtual tuner that plays [BLOCK].raw recordings (missing blocks are noise)");
+    parser.add_argument("--virtual-speed")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("SPEED")
+        .nargs(1).required()
+        .help("Multiple of the sampling rate the virtual tuner delivers samples at (0 = as fast as possible)");
+    parser.add_argument("--virtual-retune-ms")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("MILLISECONDS")
+        .nargs(1).required()
+        .help("Virtual tuner delivers noise for this long after retuning");
+    parser.add_argument("--device-index")
+        .default_value(size_t(0)).scan<'u', size_t>()
+        .metavar("INDEX")
+        .nargs(1).required()
+        .help("Index of the rtlsdr device to scan with");
+    parser.add_argument("--tuner-manual-gain")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("GAIN")
+        .nargs(1).required()
+        .help("Manual gain for tuner which overrides automatic gain");
+    parser.add_argument("--tuner-auto-gain")
+        .default_value(false).implicit_value(true)
+        .help("Set automatic gain for tuner");
+    parser.add_argument("--blocks")
+        .default_value(std::string("III"))
+        .metavar("BLOCKS")
+        .nargs(1).required()
+        .choices("I", "III", "all")
+        .help("Which band of blocks to scan");
+    parser.add_argument("--transmission-mode")
+        .default_value(int(1)).scan<'i', int>()
+        .metavar("MODE")
+        .nargs(1).required()
+        .choices(1,2,3,4)
+        .help("Transmission mode");
+    parser.add_argument("--block-size")
+        .default_value(size_t(8192)).scan<'u', size_t>()
+        .metavar("BLOCK_SIZE")
+        .nargs(1).required()
+        .help("Number of samples given to the OFDM demodulator at once");
+    parser.add_argument("--ofdm-total-threads")
+        .default_value(size_t(1)).scan<'u', size_t>()
+        .metavar("TOTAL_THREADS")
+        .nargs(1).required()
+        .help("Number of OFDM demodulator threads (0 = max number of threads)");
+    parser.add_argument("--settle-ms")
+        .default_value(float(50.0f)).scan<'g', float>()
+        .metavar("MILLISECONDS")
+        .nargs(1).required()
+        .help("Samples to discard after retuning while the tuner settles");
+    parser.add_argument("--presence-timeout-ms")
+        .default_value(float(190.0f)).scan<'g', float>()
+        .metavar("MILLISECONDS")
+        .nargs(1).required()
+        .help("Block is skipped if the OFDM demodulator doesn't synchronise within this time after retuning (includes --settle-ms, keep under 200 so empty blocks are aborted quickly)");
+    parser.add_argument("--ensemble-timeout-ms")
+        .default_value(float(10'000.0f)).scan<'g', float>()
+        .metavar("MILLISECONDS")
+        .nargs(1).required()
+        .help("Stop waiting for the full service list after this time");
+    parser.add_argument("--stable-frames")
+        .default_value(int(10)).scan<'i', int>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Service list is complete once it hasn't changed for this many frames");
+    parser.add_argument("--radio-enable-logging")
+        .default_value(false).implicit_value(true)
+        .help("Enable verbose logging for radio");
+}
+
+struct Args {
+    std::string virtual_recordings;
+    float virtual_speed;
+    float virtual_retune_ms;
+    size_t device_index;
+    float tuner_manual_gain;
+    bool tuner_auto_gain;
+    std::string blocks;
+    int transmission_mode;
+    size_t block_size;
+    size_t ofdm_total_threads;
+    float settle_ms;
+    float presence_timeout_ms;
+    float ensemble_timeout_ms;
+    int stable_frames;
+    bool radio_enable_logging;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.virtual_recordings = parser.get<std::string>("--virtual-recordings");
+    args.virtual_speed = parser.get<float>("--virtual-speed");
+    args.virtual_retune_ms = parser.get<float>("--virtual-retune-ms");
+    args.device_index = parser.get<size_t>("--device-index");
+    args.tuner_manual_gain = parser.get<float>("--tuner-manual-gain");
+    args.tuner_auto_gain = parser.get<bool>("--tuner-auto-gain");
+    args.blocks = parser.get<std::string>("--blocks");
+    args.transmission_mode = parser.get<int>("--transmission-mode");
+    args.block_size = parser.get<size_t>("--block-size");
+    args.ofdm_total_threads = parser.get<size_t>("--ofdm-total-threads");
+    args.settle_ms = parser.get<float>("--settle-ms");
+    args.presence_timeout_ms = parser.get<float>("--presence-timeout-ms");
+    args.ensemble_timeout_ms = parser.get<float>("--ensemble-timeout-ms");
+    args.stable_frames = parser.get<int>("--stable-frames");
+    args.radio_enable_logging = parser.get<bool>("--radio-enable-logging");
+    return args;
+}
+
+static std::vector<std::pair<std::string, uint32_t>> get_scan_blocks(const std::string& band) {
+    constexpr uint32_t BAND_III_START = 174'000'000u;
+    std::vector<std::pair<std::string, uint32_t>> blocks;
+    for (const auto& [label, frequency]: block_frequencies) {
+        const bool is_band_iii = frequency >= BAND_III_START;
+        if ((band == "I") && is_band_iii) continue;
+        if ((band == "III") && !is_band_iii) continue;
+        blocks.push_back({ label, frequency });
+    }
+    // labels don't sort by frequency (10A comes before 5A) and retuning in small steps settles faster
+    std::sort(blocks.begin(), blocks.end(), [](const auto& a, const auto& b) {
+        return a.second < b.second;
+    });
+    return blocks;
+}
+
+static void print_result(const BandScanResult& result) {
+    fprintf(stdout, "%-4s %7.3fMHz %-8s stream=%6.3fs elapsed=%6.3fs",
+        result.block_label.c_str(), float(result.frequency)*1e-6f,
+        BandScanResult::get_status_name(result.status),
+        result.stream_seconds, result.elapsed_seconds);
+    if (result.status != BandScanResult::Status::EMPTY) {
+        fprintf(stdout, " ensemble=%04X '%s' services=%zu",
+            unsigned(result.ensemble_reference), result.ensemble_label.c_str(), result.services.size());
+    }
+    fprintf(stdout, "\n");
+    for (const auto& service: result.services) {
+        fprintf(stdout, "    %08X '%s'\n", unsigned(service.reference), service.label.c_str());
+    }
+    fflush(stdout);
+}
+
+static void scan_device(BandScanner& scanner, ThreadedRingBuffer<RawIQ>& device_buffer, size_t block_size) {
+    auto buf = std::vector<RawIQ>(block_size);
+    while (!scanner.is_finished()) {
+        const size_t length = device_buffer.read(buf);
+        if (length == 0) {
+            scanner.stop();
+            break;
+        }
+        scanner.process(tcb::span(buf).first(length));
+    }
+}
+
+INITIALIZE_EASYLOGGINGPP
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("band_scan", "0.1.0");
+    parser.add_description("Scans a band for DAB ensembles and lists their services");
+    parser.add_epilog("Empty blocks are skipped once the OFDM demodulator fails to synchronise");
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+    if (args.block_size == 0) {
+        fprintf(stderr, "Block size cannot be zero\n");
+        return 1;
+    }
+    if (args.settle_ms >= args.presence_timeout_ms) {
+        fprintf(stderr, "Settle time must be shorter than the presence timeout since it is counted within it\n");
+        return 1;
+    }
+    setup_easylogging(false, args.radio_enable_logging, false);
+
+    BandScanConfig config;
+    config.settle_seconds = args.settle_ms*1e-3f;
+    config.presence_timeout_seconds = args.presence_timeout_ms*1e-3f;
+    config.ensemble_timeout_seconds = args.ensemble_timeout_ms*1e-3f;
+    config.stable_frames = args.stable_frames;
+    auto scanner = std::make_unique<BandScanner>(args.transmission_mode, config, args.ofdm_total_threads);
+
+    std::shared_ptr<Device> device = nullptr;
+    if (!args.virtual_recordings.empty()) {
+        VirtualDeviceConfig virtual_config;
+        virtual_config.speed = args.virtual_speed;
+        virtual_config.retune_settle_seconds = args.virtual_retune_ms*1e-3f;
+        device = create_virtual_tuner_from_recordings(args.virtual_recordings, virtual_config);
+    } else {
+        auto device_list = DeviceList();
+        device_list.refresh();
+        if (args.device_index >= device_list.get_descriptors().size()) {
+            fprintf(stderr, "Device %zu is not available (%zu devices found)\n",
+                args.device_index, device_list.get_descriptors().size());
+            return 1;
+        }
+        device = device_list.get_device(args.device_index);
+        if (device == nullptr) {
+            fprintf(stderr, "Failed to open device %zu\n", args.device_index);
+            return 1;
+        }
+    }
+    if (args.tuner_auto_gain) {
+        device->SetAutoGain();
+    } else {
+        device->SetNearestGain(args.tuner_manual_gain);
+    }
+    // samples are dropped while retuning so stale data from the last block never reaches the scanner
+    // the callback holds the write lock while writing so we can wait for a write that started before the retune
+    auto is_device_scanning = std::make_shared<std::atomic<bool>>(false);
+    auto mutex_device_write = std::make_shared<std::mutex>();
+    auto device_buffer = std::make_shared<ThreadedRingBuffer<RawIQ>>(args.block_size*16);
+    device->SetDataCallback([device_buffer, is_device_scanning, mutex_device_write](tcb::span<const uint8_t> bytes) {
+        auto lock = std::unique_lock(*mutex_device_write);
+        if (!is_device_scanning->load(std::memory_order_acquire)) return bytes.size();
+        constexpr size_t BYTES_PER_SAMPLE = sizeof(RawIQ);
+        const size_t total_samples = bytes.size() / BYTES_PER_SAMPLE;
+        auto raw_iq = tcb::span(reinterpret_cast<const RawIQ*>(bytes.data()), total_samples);
+        device_buffer->write(raw_iq);
+        return bytes.size();
+    });
+    // discard everything written for the previous block
+    // a write blocked on a full buffer can only finish if we keep reading, so drain until it releases the lock
+    // afterwards any new callback sees that we aren't scanning and drops its samples
+    auto discard_buffer = std::vector<RawIQ>(device_buffer->get_size());
+    const auto flush_device_buffer = [&]() {
+        auto lock = std::unique_lock(*mutex_device_write, std::defer_lock);
+        while (true) {
+            const size_t total_used = device_buffer->get_total_used();
+            device_buffer->read(tcb::span(discard_buffer).first(total_used));
+            if (lock.try_lock()) break;
+            std::this_thread::yield();
+        }
+        device_buffer->read(tcb::span(discard_buffer).first(device_buffer->get_total_used()));
+    };
+
+    const auto blocks = get_scan_blocks(args.blocks);
+    const auto time_start = std::chrono::steady_clock::now();
+    size_t total_ensembles = 0;
+    for (const auto& [label, frequency]: blocks) {
+        is_device_scanning->store(false, std::memory_order_release);
+        device->SetCenterFrequency(label, frequency);
+        flush_device_buffer();
+        if (!device->IsRunning()) {
+            fprintf(stderr, "Device stopped while scanning\n");
+            break;
+        }
+        scanner->start_block(label, frequency);
+        is_device_scanning->store(true, std::memory_order_release);
+        scan_device(*scanner, *device_buffer, args.block_size);
+        const auto& result = scanner->get_result();
+        if (result.status != BandScanResult::Status::EMPTY) total_ensembles++;
+        print_result(result);
+    }
+    is_device_scanning->store(false, std::memory_order_release);
+    device_buffer->close();
+    const auto time_end = std::chrono::steady_clock::now();
+    const float elapsed = std::chrono::duration<float>(time_end - time_start).count();
+    fprintf(stdout, "Found %zu ensembles in %zu blocks in %.3fs\n", total_ensembles, blocks.size(), elapsed);
+    return 0;
+}
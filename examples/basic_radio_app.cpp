@@ -1,11 +1,14 @@
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <chrono>
 #include <exception>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <thread>
+#include <sys/stat.h>
 
 #if _WIN32
 #include <io.h>
@@ -19,13 +22,23 @@
 #include "basic_scraper/basic_scraper.h"
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_types.h"
+#include "utility/allocation_tracker.h"
 #include "viterbi_config.h"
 #include "./app_helpers/app_io_buffers.h"
+#include "./app_helpers/app_iq_codec.h"
 #include "./app_helpers/app_logging.h"
 #include "./app_helpers/app_ofdm_blocks.h"
 #include "./app_helpers/app_radio_blocks.h"
+#include "./app_helpers/app_replay_pacer.h"
 #include "./app_helpers/app_viterbi_convert_block.h"
 
+#if BUILD_COMMAND_LINE
+#include "./app_helpers/app_audio.h"
+#include "./app_helpers/app_benchmark_report.h"
+#include "./audio/audio_pipeline.h"
+#include "./audio/null_sink.h"
+#endif
+
 #if !BUILD_COMMAND_LINE
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include <imgui.h>
@@ -48,6 +61,20 @@ void init_parser(argparse::ArgumentParser& parser) {
         .metavar("INPUT_FILENAME")
         .nargs(1).required()
         .help("Filename of input to radio (defaults to stdin)");
+    parser.add_argument("--input-compressed")
+        .default_value(false).implicit_value(true)
+        .help("Input IQ was compressed with compress_iq");
+    parser.add_argument("--input-realtime-speed")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("SPEED")
+        .nargs(1).required()
+        .help("Pace input IQ at a multiple of the sampling rate like a receiver (0 reads as fast as possible)");
+    parser.add_argument("--input-realtime")
+        .default_value(std::string("auto"))
+        .choices("auto", "yes", "no")
+        .metavar("MODE")
+        .nargs(1).required()
+        .help("Whether the input runs in realtime so audio never blocks the decoder (auto = paced input or a pipe or device on stdin)");
     parser.add_argument("--transmission-mode")
         .default_value(int(1)).scan<'i', int>()
         .choices(1,2,3,4)
@@ -113,6 +140,9 @@ void init_parser(argparse::ArgumentParser& parser) {
         .default_value(false).implicit_value(true)
         .help("Disable automatic scraping of new channels");
     // other
+    parser.add_argument("--print-latency")
+        .default_value(false).implicit_value(true)
+        .help("Print latency histograms from IQ samples to decoded audio and data on exit");
 #if !BUILD_COMMAND_LINE
     parser.add_argument("--audio-no-auto-select")
         .default_value(false).implicit_value(true)
@@ -121,11 +151,35 @@ void init_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("--radio-enable-benchmark")
         .default_value(false).implicit_value(true)
         .help("Enables data and audio decoding for cli benchmarking");
+    parser.add_argument("--benchmark-report")
+        .default_value(std::string(""))
+        .metavar("REPORT_FILENAME")
+        .nargs(1).required()
+        .help("Write json report of throughput, per stage timings, latency and memory usage on exit (enables benchmarking)");
+    parser.add_argument("--radio-check-allocations")
+        .default_value(false).implicit_value(true)
+        .help("Exit with an error if any thread in the process allocates on the heap between radio frames once the radio has warmed up");
+    parser.add_argument("--radio-warmup-frames")
+        .default_value(size_t(100)).scan<'u', size_t>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Number of frames to ignore while channels are found and their decoders are created");
+    parser.add_argument("--audio-null-sink")
+        .default_value(false).implicit_value(true)
+        .help("Play all audio channels into a null sink and print levels and a checksum per channel on exit");
+    parser.add_argument("--audio-null-speed")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("SPEED")
+        .nargs(1).required()
+        .help("Consume audio at a multiple of realtime playback (0 consumes as fast as it is decoded)");
 #endif
 }
 
 struct Args {
     std::string input_file; 
+    bool is_input_compressed;
+    float input_realtime_speed;
+    std::string input_realtime;
     int transmission_mode;
     bool is_ofdm_used;
     bool is_dab_used;
@@ -146,16 +200,25 @@ struct Args {
     bool scraper_disable_logging;
     bool scraper_disable_auto;
     // other
+    bool is_print_latency;
 #if !BUILD_COMMAND_LINE
     bool audio_no_auto_select;
 #else
     bool radio_enable_benchmark;
+    std::string benchmark_report;
+    bool radio_check_allocations;
+    size_t radio_warmup_frames;
+    bool audio_null_sink;
+    float audio_null_speed;
 #endif
 };
 
 Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     Args args;
     args.input_file = parser.get<std::string>("--input");
+    args.is_input_compressed = parser.get<bool>("--input-compressed");
+    args.input_realtime_speed = parser.get<float>("--input-realtime-speed");
+    args.input_realtime = parser.get<std::string>("--input-realtime");
     args.transmission_mode = parser.get<int>("--transmission-mode");
     auto configuration = parser.get<std::string>("--configuration");
     args.is_ofdm_used = true;
@@ -182,16 +245,51 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     args.scraper_disable_logging = parser.get<bool>("--scraper-disable-logging");
     args.scraper_disable_auto = parser.get<bool>("--scraper-disable-auto");
     // other
+    args.is_print_latency = parser.get<bool>("--print-latency");
 #if !BUILD_COMMAND_LINE
     args.audio_no_auto_select = parser.get<bool>("--audio-no-auto-select");
 #else
-    args.radio_enable_benchmark = parser.get<bool>("--radio-enable-benchmark");
+    args.benchmark_report = parser.get<std::string>("--benchmark-report");
+    args.radio_enable_benchmark = parser.get<bool>("--radio-enable-benchmark") || !args.benchmark_report.empty();
+    args.radio_check_allocations = parser.get<bool>("--radio-check-allocations");
+    args.radio_warmup_frames = parser.get<size_t>("--radio-warmup-frames");
+    args.audio_null_sink = parser.get<bool>("--audio-null-sink");
+    args.audio_null_speed = parser.get<float>("--audio-null-speed");
 #endif
     return args;
 }
 
 
 INITIALIZE_EASYLOGGINGPP
+#if BUILD_COMMAND_LINE || ALLOCATION_TRACKING
+INITIALIZE_ALLOCATION_TRACKER
+#endif
+// A tuner piped into stdin keeps producing samples whether or not we read them
+// Regular files (including redirects) can wait for the audio sink instead
+static bool get_is_realtime_input(const Args& args, FILE* fp_in) {
+    if (args.input_realtime.compare("yes") == 0) return true;
+    if (args.input_realtime.compare("no") == 0) return false;
+    if (args.input_realtime_speed > 0.0f) return true;
+#if _WIN32
+    struct _stat stat_in;
+    if (_fstat(_fileno(fp_in), &stat_in) != 0) return false;
+    return ((stat_in.st_mode & _S_IFIFO) != 0) || ((stat_in.st_mode & _S_IFCHR) != 0);
+#else
+    struct stat stat_in;
+    if (fstat(fileno(fp_in), &stat_in) != 0) return false;
+    return S_ISFIFO(stat_in.st_mode) || S_ISCHR(stat_in.st_mode) || S_ISSOCK(stat_in.st_mode);
+#endif
+}
+
+static void print_scraper_writer_stats(BasicScraper& scraper) {
+    const auto stats = scraper.GetWriter().GetStats();
+    fprintf(stderr,
+        "scraper writer: written=%zu queued=%zu/%zu dropped=%zu bytes in %zu files, %zu stalls, %zu errors\n",
+        stats.nb_bytes_written, stats.nb_queue_bytes, stats.nb_peak_queue_bytes,
+        stats.nb_bytes_dropped, stats.nb_jobs_dropped, stats.nb_stalls, stats.nb_errors
+    );
+}
+
 int main(int argc, char** argv) {
 #if !BUILD_COMMAND_LINE
     const char* PROGRAM_NAME = "basic_radio_app";
@@ -240,6 +338,7 @@ int main(int argc, char** argv) {
     _setmode(_fileno(fp_in), _O_BINARY);
     _setmode(_fileno(fp_ofdm_out), _O_BINARY);
 #endif
+    const bool is_realtime_input = get_is_realtime_input(args, fp_in);
     setup_easylogging(false, args.radio_enable_logging, !args.scraper_disable_logging); 
 
     const auto dab_params = get_dab_parameters(args.transmission_mode);
@@ -260,12 +359,30 @@ int main(int argc, char** argv) {
     }
     // setup input
     std::shared_ptr<FileWrapper> file_in = nullptr;
+    std::shared_ptr<PacedInputBuffer<RawIQ>> paced_iq_in = nullptr;
     if (args.is_ofdm_used) {
-        auto raw_iq_in = std::make_shared<InputFile<RawIQ>>(fp_in);
+        std::shared_ptr<InputBuffer<RawIQ>> iq_in = nullptr;
+        if (args.is_input_compressed) {
+            auto compressed_in = std::make_shared<InputFile<uint8_t>>(fp_in);
+            auto iq_decompressor = std::make_shared<IQ_Decompressor<RawIQ>>();
+            iq_decompressor->set_input_stream(compressed_in);
+            iq_in = iq_decompressor;
+            file_in = compressed_in;
+        } else {
+            auto raw_iq_in = std::make_shared<InputFile<RawIQ>>(fp_in);
+            iq_in = raw_iq_in;
+            file_in = raw_iq_in;
+        }
+        if (args.input_realtime_speed > 0.0f) {
+            ReplayPacerConfig pacer_config;
+            pacer_config.speed = double(args.input_realtime_speed);
+            paced_iq_in = std::make_shared<PacedInputBuffer<RawIQ>>(pacer_config);
+            paced_iq_in->set_input_stream(iq_in);
+            iq_in = paced_iq_in;
+        }
         auto ofdm_convert_raw_iq = std::make_shared<OFDM_Convert_RawIQ>();
-        ofdm_convert_raw_iq->set_input_stream(raw_iq_in);
+        ofdm_convert_raw_iq->set_input_stream(iq_in);
         ofdm_block->set_input_stream(ofdm_convert_raw_iq);
-        file_in = raw_iq_in;
     } else {
         if (args.radio_input_hard_bytes) {
             auto hard_bytes_in = std::make_shared<InputFile<uint8_t>>(fp_in);
@@ -300,10 +417,14 @@ int main(int argc, char** argv) {
         ofdm_to_radio_buffer = std::make_shared<ThreadedRingBuffer<viterbi_bit_t>>(dab_params.nb_frame_bits*2);
         ofdm_output_splitter->add_output_stream(ofdm_to_radio_buffer);
         radio_block->set_input_stream(ofdm_to_radio_buffer);
+        auto ofdm_to_radio_timestamps = std::make_shared<FrameTimestampQueue>();
+        ofdm_block->set_timestamp_output(ofdm_to_radio_timestamps);
+        radio_block->set_timestamp_input(ofdm_to_radio_timestamps);
     }
     // scraper
+    std::shared_ptr<BasicScraper> basic_scraper = nullptr;
     if (args.is_dab_used && args.scraper_enable) {
-        auto basic_scraper = std::make_shared<BasicScraper>(args.scraper_output);
+        basic_scraper = std::make_shared<BasicScraper>(args.scraper_output);
         fprintf(stderr, "basic scraper is writing to folder '%s'\n", args.scraper_output.c_str()); 
         BasicScraper::attach_to_radio(basic_scraper, radio_block->get_basic_radio());
         radio_block->get_basic_radio().On_Audio_Channel().Attach(
@@ -328,6 +449,56 @@ int main(int argc, char** argv) {
             }
         );
     }
+    // steady state allocations
+    struct AllocationCheck {
+        size_t total_frames = 0;
+        size_t total_frames_with_allocations = 0;
+        uint64_t total_allocations = 0;
+        uint64_t last_total_allocations = 0;
+    };
+    auto allocation_check = std::make_shared<AllocationCheck>();
+    if (args.is_dab_used && args.radio_check_allocations) {
+        radio_block->get_basic_radio().On_Audio_Channel().Attach(
+            [](subchannel_id_t subchannel_id, Basic_Audio_Channel& channel) {
+                auto& controls = channel.GetControls();
+                controls.SetIsDecodeAudio(true);
+                controls.SetIsDecodeData(true);
+                controls.SetIsPlayAudio(true);
+            }
+        );
+        // counter is process wide so other threads also count, use "--configuration dab" to only run the radio
+        const size_t warmup_frames = args.radio_warmup_frames;
+        radio_block->set_frame_callback([allocation_check, warmup_frames]() {
+            auto& check = *allocation_check;
+            const uint64_t total_allocations = AllocationTracker::get_global_stats().total_allocations;
+            if (check.total_frames >= warmup_frames) {
+                const uint64_t delta = total_allocations - check.last_total_allocations;
+                check.total_allocations += delta;
+                if (delta > 0) check.total_frames_with_allocations++;
+            }
+            check.last_total_allocations = total_allocations;
+            check.total_frames++;
+        });
+    }
+    // offline audio
+    std::shared_ptr<AudioPipeline> audio_pipeline = nullptr;
+    NullAudioSink* null_audio_sink = nullptr;
+    if (args.is_dab_used && args.audio_null_sink) {
+        NullAudioSinkConfig null_sink_config;
+        null_sink_config.speed = args.audio_null_speed;
+        auto sink = std::make_unique<NullAudioSink>(null_sink_config);
+        null_audio_sink = sink.get();
+        audio_pipeline = std::make_shared<AudioPipeline>();
+        audio_pipeline->set_sink(std::move(sink));
+        attach_audio_pipeline_to_radio(audio_pipeline, radio_block->get_basic_radio(), is_realtime_input);
+        radio_block->get_basic_radio().On_Audio_Channel().Attach(
+            [](subchannel_id_t subchannel_id, Basic_Audio_Channel& channel) {
+                auto& controls = channel.GetControls();
+                controls.SetIsDecodeAudio(true);
+                controls.SetIsPlayAudio(true);
+            }
+        );
+    }
 #else
     // audio
     std::unique_ptr<PortAudioGlobalHandler> portaudio_global_handler = nullptr;
@@ -336,7 +507,7 @@ int main(int argc, char** argv) {
     if (args.is_dab_used) {
         portaudio_global_handler = std::make_unique<PortAudioGlobalHandler>();
         audio_pipeline = std::make_shared<AudioPipeline>();
-        attach_audio_pipeline_to_radio(audio_pipeline, radio_block->get_basic_radio());
+        attach_audio_pipeline_to_radio(audio_pipeline, radio_block->get_basic_radio(), is_realtime_input);
         portaudio_threaded_actions = std::make_shared<PortAudioThreadedActions>();
         portaudio_threaded_actions->refresh();
     }
@@ -381,6 +552,10 @@ int main(int argc, char** argv) {
     };
 #endif
     // threads
+    const auto time_start = std::chrono::steady_clock::now();
+#if BUILD_COMMAND_LINE
+    const auto start_allocation_stats = AllocationTracker::get_global_stats();
+#endif
     std::unique_ptr<std::thread> thread_ofdm = nullptr;
     if (args.is_ofdm_used) {
         const size_t block_size = args.ofdm_block_size;
@@ -415,6 +590,11 @@ int main(int argc, char** argv) {
     if (thread_ofdm != nullptr) thread_ofdm->join();
     if (ofdm_to_radio_buffer != nullptr) ofdm_to_radio_buffer->close();
     if (thread_radio != nullptr) thread_radio->join();
+    if (args.is_dab_used && args.is_print_latency) {
+        radio_block->get_basic_radio().GetLatencyTracer().print(stderr);
+    }
+    if (basic_scraper != nullptr) print_scraper_writer_stats(*basic_scraper);
+    basic_scraper = nullptr;
     ofdm_block = nullptr;
     radio_block = nullptr;
     portaudio_threaded_actions = nullptr;
@@ -426,11 +606,85 @@ int main(int argc, char** argv) {
     if (thread_ofdm != nullptr) thread_ofdm->join();
     if (ofdm_to_radio_buffer != nullptr) ofdm_to_radio_buffer->close();
     if (thread_radio != nullptr) thread_radio->join();
+    const auto time_end = std::chrono::steady_clock::now();
     if (file_in != nullptr) file_in->close();
     if (file_out != nullptr) file_out->close();
+    if (!args.benchmark_report.empty()) {
+        BenchmarkConfig benchmark_config;
+        benchmark_config.program_name = PROGRAM_NAME;
+        benchmark_config.input_filename = args.input_file;
+        benchmark_config.transmission_mode = args.transmission_mode;
+        benchmark_config.ofdm_total_threads = args.ofdm_total_threads;
+        benchmark_config.radio_total_threads = args.radio_total_threads;
+        BenchmarkMemoryStats memory_stats;
+        memory_stats.is_allocations_counted = true;
+        const auto end_allocation_stats = AllocationTracker::get_global_stats();
+        memory_stats.total_allocations = end_allocation_stats.total_allocations - start_allocation_stats.total_allocations;
+        memory_stats.total_allocated_bytes = end_allocation_stats.total_allocated_bytes - start_allocation_stats.total_allocated_bytes;
+        memory_stats.peak_heap_bytes = uint64_t(end_allocation_stats.peak_bytes);
+        auto report = BenchmarkReport(benchmark_config, std::chrono::duration<double>(time_end - time_start).count());
+        if (ofdm_block != nullptr) report.set_ofdm_demod(&ofdm_block->get_ofdm_demod());
+        if (radio_block != nullptr) report.set_radio(&radio_block->get_basic_radio());
+        report.set_memory_stats(memory_stats);
+        FILE* fp_report = fopen(args.benchmark_report.c_str(), "w");
+        if (fp_report == nullptr) {
+            fprintf(stderr, "Failed to open benchmark report file: '%s'\n", args.benchmark_report.c_str());
+        } else {
+            report.write(fp_report);
+            fclose(fp_report);
+            fprintf(stderr, "wrote benchmark report to '%s'\n", args.benchmark_report.c_str());
+        }
+    }
+    if (args.radio_enable_benchmark && (ofdm_to_radio_buffer != nullptr)) {
+        ofdm_to_radio_buffer->get_reader_waits().print(stderr, "ofdm->radio reader waits");
+        ofdm_to_radio_buffer->get_writer_waits().print(stderr, "ofdm->radio writer waits");
+    }
+    if (paced_iq_in != nullptr) {
+        paced_iq_in->get_pacer().print_stats(stderr);
+    }
+    if (args.is_dab_used && args.is_print_latency) {
+        radio_block->get_basic_radio().GetLatencyTracer().print(stderr);
+    }
+    if (basic_scraper != nullptr) print_scraper_writer_stats(*basic_scraper);
+    if (null_audio_sink != nullptr) {
+        // the radio thread has finished writing so play out what is left before reading the stats
+        null_audio_sink->drain_and_stop();
+        const auto stats = null_audio_sink->get_stats();
+        fprintf(stderr,
+            "null audio sink: frames=%" PRIu64 " underruns=%" PRIu64 " peak=(%.4f,%.4f) rms=(%.4f,%.4f)\n",
+            stats.total_frames, stats.total_underruns,
+            stats.peak[0], stats.peak[1], stats.rms[0], stats.rms[1]
+        );
+        const auto sources = audio_pipeline->get_sources();
+        for (size_t i = 0; i < sources.size(); i++) {
+            fprintf(stderr,
+                "null audio source[%zu]: frames=%" PRIu64 " checksum=%016" PRIx64 "\n",
+                i, sources[i]->get_total_decoded_frames(), sources[i]->get_checksum()
+            );
+        }
+    }
+    int retval = 0;
+    if (args.is_dab_used && args.radio_check_allocations) {
+        const auto& check = *allocation_check;
+        const size_t total_steady_frames = (check.total_frames > args.radio_warmup_frames) ? 
+            (check.total_frames - args.radio_warmup_frames) : 0;
+        fprintf(stderr, 
+            "steady state allocations: %" PRIu64 " in %zu/%zu frames after %zu warmup frames\n",
+            check.total_allocations, check.total_frames_with_allocations, total_steady_frames, args.radio_warmup_frames
+        );
+        if (total_steady_frames == 0) {
+            fprintf(stderr, "no frames were decoded after warming up\n");
+            retval = 1;
+        } else if (check.total_allocations > 0) {
+            retval = 1;
+        }
+    }
+    null_audio_sink = nullptr;
+    audio_pipeline = nullptr;
+    basic_scraper = nullptr;
     ofdm_block = nullptr;
     radio_block = nullptr;
-    return 0;
+    return retval;
 #endif
 }
 
@@ -0,0 +1,173 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include <argparse/argparse.hpp>
+#include "utility/span.h"
+#include "./app_helpers/app_async_file_writer.h"
+#include "./app_helpers/app_io_buffers.h"
+#include "./app_helpers/app_iq_codec.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("-d", "--decompress")
+        .default_value(false).implicit_value(true)
+        .help("Decompress instead of compress");
+    parser.add_argument("-i", "--input")
+        .default_value(std::string(""))
+        .metavar("INPUT_FILENAME")
+        .nargs(1).required()
+        .help("Filename of input to converter (defaults to stdin)");
+    parser.add_argument("-o", "--output")
+        .default_value(std::string(""))
+        .metavar("OUTPUT_FILENAME")
+        .nargs(1).required()
+        .help("Filename of output from converter (defaults to stdout)");
+    parser.add_argument("-n", "--block-size")
+        .default_value(size_t(1) << 20).scan<'u', size_t>()
+        .metavar("BLOCK_SIZE")
+        .nargs(1).required()
+        .help("Number of raw bytes in each compressed block");
+    parser.add_argument("-q", "--near-lossless-bits")
+        .default_value(int(0)).scan<'i', int>()
+        .choices(0,1,2,3,4)
+        .metavar("BITS")
+        .nargs(1).required()
+        .help("Discard this many low bits for better compression with maximum error of 2^(bits-1) (0 is lossless)");
+    parser.add_argument("--print-stats")
+        .default_value(false).implicit_value(true)
+        .help("Print compression ratio and throughput on exit");
+}
+
+struct Args {
+    bool is_decompress;
+    std::string input_filename;
+    std::string output_filename;
+    size_t block_size;
+    int quantise_bits;
+    bool is_print_stats;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.is_decompress = parser.get<bool>("--decompress");
+    args.input_filename = parser.get<std::string>("--input");
+    args.output_filename = parser.get<std::string>("--output");
+    args.block_size = parser.get<size_t>("--block-size");
+    args.quantise_bits = parser.get<int>("--near-lossless-bits");
+    args.is_print_stats = parser.get<bool>("--print-stats");
+    return args;
+}
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("compress_iq", "0.1.0");
+    parser.add_description("Compresses and decompresses 8bit IQ recordings");
+    parser.add_epilog(
+        "Use this to archive raw IQ from rtl_sdr.\n"
+        "Compressed files can be read directly by basic_radio_app with --input-compressed."
+    );
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+
+    if (args.block_size < 2) {
+        fprintf(stderr, "Block size must be atleast one IQ sample\n");
+        return 1;
+    }
+    if (args.block_size > IQ_CODEC_MAX_BLOCK_SIZE) {
+        fprintf(stderr, "Block size cannot be larger than %zu bytes\n", IQ_CODEC_MAX_BLOCK_SIZE);
+        return 1;
+    }
+
+    FILE* fp_in = stdin;
+    if (!args.input_filename.empty()) {
+        fp_in = fopen(args.input_filename.c_str(), "rb");
+        if (fp_in == nullptr) {
+            fprintf(stderr, "Failed to open input file: '%s'\n", args.input_filename.c_str());
+            return 1;
+        }
+    }
+
+    FILE* fp_out = stdout;
+    if (!args.output_filename.empty()) {
+        fp_out = fopen(args.output_filename.c_str(), "wb+");
+        if (fp_out == nullptr) {
+            fprintf(stderr, "Failed to open output file: '%s'\n", args.output_filename.c_str());
+            return 1;
+        }
+    }
+
+#if _WIN32
+    _setmode(_fileno(fp_in), _O_BINARY);
+    _setmode(_fileno(fp_out), _O_BINARY);
+#endif
+
+    const auto time_start = std::chrono::steady_clock::now();
+    auto file_in = std::make_shared<InputFile<uint8_t>>(fp_in);
+    auto file_out = std::make_shared<AsyncOutputFile<uint8_t>>(fp_out);
+    uint64_t total_raw_bytes = 0;
+    uint64_t total_compressed_bytes = 0;
+    bool is_error = false;
+    if (!args.is_decompress) {
+        auto compressor = std::make_shared<IQ_Compressor<uint8_t>>(args.block_size, uint8_t(args.quantise_bits));
+        compressor->set_output_stream(file_out);
+        auto buf = std::vector<uint8_t>(args.block_size);
+        while (true) {
+            const size_t total_read = file_in->read(buf);
+            const auto write_buf = tcb::span(buf).first(total_read);
+            if (compressor->write(write_buf) != total_read) {
+                is_error = true;
+                break;
+            }
+            if (total_read != buf.size()) break;
+        }
+        is_error = !compressor->flush() || is_error;
+        total_raw_bytes = compressor->get_total_raw_bytes();
+        total_compressed_bytes = compressor->get_total_compressed_bytes();
+    } else {
+        auto decompressor = std::make_shared<IQ_Decompressor<uint8_t>>();
+        decompressor->set_input_stream(file_in);
+        while (true) {
+            const auto buf = decompressor->read_view(args.block_size);
+            if (!buf.has_value() || buf->empty()) break;
+            if (file_out->write(buf.value()) != buf->size()) {
+                is_error = true;
+                break;
+            }
+            total_raw_bytes += buf->size();
+        }
+        is_error = decompressor->get_is_error() || is_error;
+        total_compressed_bytes = decompressor->get_total_compressed_bytes();
+    }
+    file_out->close();
+    is_error = (file_out->get_writer().get_stats().total_errors > 0) || is_error;
+
+    if (is_error) {
+        fprintf(stderr, "Failed to %s stream\n", args.is_decompress ? "decompress" : "compress");
+    }
+    if (args.is_print_stats) {
+        const auto time_end = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(time_end - time_start).count();
+        const double ratio = (total_compressed_bytes > 0) ? double(total_raw_bytes) / double(total_compressed_bytes) : 0.0;
+        fprintf(stderr, "raw=%" PRIu64 "B compressed=%" PRIu64 "B ratio=%.3f throughput=%.1fMB/s\n",
+            total_raw_bytes, total_compressed_bytes, ratio, double(total_raw_bytes)*1e-6/elapsed);
+    }
+    return is_error ? 1 : 0;
+}
@@ -0,0 +1,537 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+#include <easylogging++.h>
+#include <fftw3.h>
+#include "dab/algorithms/additive_scrambler.h"
+#include "dab/algorithms/crc.h"
+#include "dab/algorithms/dab_viterbi_decoder.h"
+#include "dab/algorithms/reed_solomon_decoder.h"
+#include "dab/audio/aac_audio_decoder.h"
+#include "dab/audio/aac_frame_processor.h"
+#include "dab/audio/mp2_audio_decoder.h"
+#include "dab/constants/dab_parameters.h"
+#include "dab/constants/puncture_codes.h"
+#include "dab/dab_logging.h"
+#include "dab/database/dab_database_entities.h"
+#include "dab/msc/cif_deinterleaver.h"
+#include "dab/msc/msc_decoder.h"
+#include "ensemble/dab_plus_source.h"
+#include "ensemble/mp2_source.h"
+#include "ofdm/dsp/apply_pll.h"
+#include "ofdm/dsp/complex_conj_mul_sum.h"
+#include "ofdm/ofdm_demodulator.h"
+#include "ofdm/ofdm_helpers.h"
+#include "ofdm/ofdm_modulator.h"
+#include "utility/aligned_allocator.hpp"
+#include "utility/span.h"
+#include "utility/stage_timer.h"
+#include "viterbi_config.h"
+#include "./app_helpers/app_microbenchmark.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("-f", "--filter")
+        .default_value(std::string(""))
+        .metavar("FILTER")
+        .nargs(1).required()
+        .help("Only run benchmarks where \"name/variant\" contains this");
+    parser.add_argument("-o", "--output")
+        .default_value(std::string(""))
+        .metavar("OUTPUT_FILENAME")
+        .nargs(1).required()
+        .help("Filename of json results (defaults to stdout)");
+    parser.add_argument("--min-time")
+        .default_value(float(0.1f)).scan<'g', float>()
+        .metavar("SECONDS")
+        .nargs(1).required()
+        .help("Minimum time each repetition of a benchmark runs for");
+    parser.add_argument("--repetitions")
+        .default_value(int(5)).scan<'i', int>()
+        .metavar("TOTAL_REPETITIONS")
+        .nargs(1).required()
+        .help("Number of repetitions used to get min/median/mean timings");
+    parser.add_argument("--ofdm-total-threads")
+        .default_value(int(0)).scan<'i', int>()
+        .metavar("TOTAL_THREADS")
+        .nargs(1).required()
+        .help("Number of OFDM pipeline threads for the demodulator benchmark (0 for auto)");
+}
+
+struct Args {
+    MicroBenchmarkConfig config;
+    std::string output_filename;
+    int ofdm_total_threads;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.config.filter = parser.get<std::string>("--filter");
+    args.config.min_time_seconds = double(parser.get<float>("--min-time"));
+    args.config.total_repetitions = parser.get<int>("--repetitions");
+    args.output_filename = parser.get<std::string>("--output");
+    args.ofdm_total_threads = parser.get<int>("--ofdm-total-threads");
+    return args;
+}
+
+// Inputs are random but seeded so runs are repeatable
+static std::mt19937 g_rng(0xDAB);
+
+static std::vector<std::complex<float>> create_random_samples(const size_t N) {
+    auto dist = std::normal_distribution<float>(0.0f, 1.0f);
+    auto buf = std::vector<std::complex<float>>(N);
+    for (auto& x: buf) x = { dist(g_rng), dist(g_rng) };
+    return buf;
+}
+
+static std::vector<viterbi_bit_t> create_random_soft_bits(const size_t N) {
+    auto dist = std::uniform_int_distribution<int>(0, 1);
+    auto buf = std::vector<viterbi_bit_t>(N);
+    for (auto& x: buf) x = dist(g_rng) ? viterbi_bit_t(SOFT_DECISION_VITERBI_HIGH) : viterbi_bit_t(SOFT_DECISION_VITERBI_LOW);
+    return buf;
+}
+
+static std::vector<uint8_t> create_random_bytes(const size_t N) {
+    auto dist = std::uniform_int_distribution<int>(0, 255);
+    auto buf = std::vector<uint8_t>(N);
+    for (auto& x: buf) x = uint8_t(dist(g_rng));
+    return buf;
+}
+
+static void run_dsp_benchmarks(MicroBenchmarkRunner& runner) {
+    const auto params = get_DAB_OFDM_params(1);
+    // pll is applied to each symbol including its cyclic prefix
+    {
+        const size_t N = params.nb_symbol_period;
+        auto x = create_random_samples(N);
+        auto y = std::vector<std::complex<float>>(N);
+        for (const auto& variant: get_apply_pll_variants()) {
+            runner.run("apply_pll", variant.name, "samples", N, [&]() {
+                variant.func(x, y, 0.01f, 0.0f);
+                microbenchmark_keep(y[N-1].real());
+            });
+        }
+    }
+    // phase error is measured between the cyclic prefix and the end of the symbol
+    {
+        const size_t N = params.nb_cyclic_prefix;
+        auto x0 = create_random_samples(N);
+        auto x1 = create_random_samples(N);
+        for (const auto& variant: get_complex_conj_mul_sum_variants()) {
+            runner.run("complex_conj_mul_sum", variant.name, "samples", N, [&]() {
+                const auto y = variant.func(x0, x1);
+                microbenchmark_keep(y.real());
+            });
+        }
+    }
+}
+
+static void run_fft_benchmarks(MicroBenchmarkRunner& runner) {
+    for (int transmission_mode = 1; transmission_mode <= 4; transmission_mode++) {
+        const auto params = get_DAB_OFDM_params(transmission_mode);
+        const size_t N = params.nb_fft;
+        const std::string name = "fft_" + std::to_string(N);
+        if (!runner.is_selected(name.c_str(), "fftw")) continue;
+        // same planner flags and alignment as the demodulator
+        auto plan = fftwf_plan_dft_1d(int(N), nullptr, nullptr, FFTW_FORWARD, FFTW_ESTIMATE);
+        const auto samples = create_random_samples(N);
+        auto x = std::vector<std::complex<float>, AlignedAllocator<std::complex<float>>>(samples.begin(), samples.end());
+        auto y = std::vector<std::complex<float>, AlignedAllocator<std::complex<float>>>(N);
+        runner.run(name.c_str(), "fftw", "samples", N, [&]() {
+            fftwf_execute_dft(plan, (fftwf_complex*)x.data(), (fftwf_complex*)y.data());
+            microbenchmark_keep(y[N-1].real());
+        });
+        fftwf_destroy_plan(plan);
+    }
+}
+
+// DQPSK and soft bit conversion are internal to the demodulator's pipeline threads
+// So the whole demodulator runs on a modulated frame and its stage timers give the per kernel breakdown
+static void run_ofdm_demod_benchmark(MicroBenchmarkRunner& runner, const MicroBenchmarkConfig& config, const int total_threads) {
+    const char* VARIANT = "auto";
+    const bool is_selected =
+        runner.is_selected("ofdm_demod_frame", VARIANT) ||
+        runner.is_selected("ofdm_sync", VARIANT) ||
+        runner.is_selected("ofdm_fft", VARIANT) ||
+        runner.is_selected("ofdm_dqpsk_soft_bits", VARIANT);
+    if (!is_selected) return;
+
+    const int transmission_mode = 1;
+    const auto params = get_DAB_OFDM_params(transmission_mode);
+    auto prs_fft_ref = std::vector<std::complex<float>>(params.nb_fft);
+    get_DAB_PRS_reference(transmission_mode, prs_fft_ref);
+    const size_t nb_frame_samples = params.nb_null_period + params.nb_symbol_period*params.nb_frame_symbols;
+    const size_t nb_frame_bytes = (params.nb_frame_symbols-1)*params.nb_data_carriers*2/8;
+    auto frame_buf = std::vector<std::complex<float>>(nb_frame_samples);
+    const auto frame_bytes = create_random_bytes(nb_frame_bytes);
+    auto ofdm_mod = OFDM_Modulator(params, prs_fft_ref);
+    if (!ofdm_mod.ProcessBlock(frame_buf, frame_bytes)) {
+        fprintf(stderr, "Failed to create OFDM frame for demodulator benchmark\n");
+        return;
+    }
+
+    auto ofdm_demod = Create_OFDM_Demodulator(transmission_mode, total_threads);
+    uint64_t total_frames = 0;
+    ofdm_demod->On_OFDM_Frame().Attach([&total_frames](tcb::span<const viterbi_bit_t>, FrameTimestamp) {
+        total_frames++;
+    });
+
+    // lock onto the frame before measuring
+    const uint64_t nb_warmup_frames = 8;
+    for (uint64_t i = 0; (i < 100) && (total_frames < nb_warmup_frames); i++) {
+        ofdm_demod->Process(frame_buf);
+    }
+    if (total_frames < nb_warmup_frames) {
+        fprintf(stderr, "OFDM demodulator didn't synchronise to the benchmark frame\n");
+        return;
+    }
+
+    struct StageSnapshot { uint64_t sync_ns, fft_ns, dqpsk_ns; };
+    const auto get_snapshot = [&ofdm_demod]() {
+        const auto& timers = ofdm_demod->GetStageTimers();
+        return StageSnapshot { timers.sync.get_total_ns(), timers.fft.get_total_ns(), timers.dqpsk.get_total_ns() };
+    };
+
+    using clock = std::chrono::steady_clock;
+    std::vector<double> frame_ns;
+    StageSnapshot stage_total { 0, 0, 0 };
+    uint64_t stage_total_frames = 0;
+    for (int i = 0; i < config.total_repetitions; i++) {
+        const uint64_t start_frames = total_frames;
+        const auto start_stages = get_snapshot();
+        const auto start = clock::now();
+        auto elapsed = clock::duration(0);
+        while (elapsed < std::chrono::duration<double>(config.min_time_seconds)) {
+            ofdm_demod->Process(frame_buf);
+            elapsed = clock::now() - start;
+        }
+        const uint64_t frames = total_frames - start_frames;
+        if (frames == 0) continue;
+        const auto end_stages = get_snapshot();
+        const double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        frame_ns.push_back(ns / double(frames));
+        stage_total.sync_ns += end_stages.sync_ns - start_stages.sync_ns;
+        stage_total.fft_ns += end_stages.fft_ns - start_stages.fft_ns;
+        stage_total.dqpsk_ns += end_stages.dqpsk_ns - start_stages.dqpsk_ns;
+        stage_total_frames += frames;
+    }
+    if (frame_ns.empty()) return;
+    std::sort(frame_ns.begin(), frame_ns.end());
+    double sum_ns = 0.0;
+    for (const double ns: frame_ns) sum_ns += ns;
+
+    MicroBenchmarkResult result;
+    result.name = "ofdm_demod_frame";
+    result.variant = VARIANT;
+    result.item_type = "frames";
+    result.items_per_iteration = 1;
+    result.total_iterations = stage_total_frames;
+    result.min_ns = frame_ns.front();
+    result.median_ns = frame_ns[frame_ns.size()/2];
+    result.mean_ns = sum_ns / double(frame_ns.size());
+    runner.add_result(result);
+
+    // stage timers are summed across pipeline threads so these are cpu time per frame
+    const auto add_stage = [&](const char* name, const uint64_t total_ns) {
+        MicroBenchmarkResult stage;
+        stage.name = name;
+        stage.variant = VARIANT;
+        stage.item_type = "frames";
+        stage.items_per_iteration = 1;
+        stage.total_iterations = stage_total_frames;
+        const double ns = double(total_ns) / double(stage_total_frames);
+        stage.min_ns = stage.median_ns = stage.mean_ns = ns;
+        runner.add_result(stage);
+    };
+    add_stage("ofdm_sync", stage_total.sync_ns);
+    add_stage("ofdm_fft", stage_total.fft_ns);
+    add_stage("ofdm_dqpsk_soft_bits", stage_total.dqpsk_ns);
+}
+
+// Depuncturing happens inside the viterbi decoder update so it is included in these timings
+static void run_viterbi_benchmarks(MicroBenchmarkRunner& runner) {
+    const auto dab_params = get_dab_parameters(1);
+    // DOC: ETSI EN 300 401
+    // Clause 11.2 - Coding in the fast information channel
+    {
+        const size_t nb_encoded_bits = size_t(dab_params.nb_fib_cif_bits);
+        const size_t nb_decoded_bits = nb_encoded_bits/3;
+        const auto encoded_bits = create_random_soft_bits(nb_encoded_bits);
+        auto decoded_bytes = std::vector<uint8_t>(nb_decoded_bits/8);
+        auto vitdec = DAB_Viterbi_Decoder();
+        vitdec.set_traceback_length(nb_decoded_bits);
+        const auto PI_16 = GetPunctureCode(16);
+        const auto PI_15 = GetPunctureCode(15);
+        runner.run("viterbi_fic", "auto", "bits", nb_decoded_bits, [&]() {
+            vitdec.reset();
+            auto buf = tcb::span<const viterbi_bit_t>(encoded_bits);
+            buf = buf.subspan(vitdec.update(buf, PI_16, 128*21));
+            buf = buf.subspan(vitdec.update(buf, PI_15, 128*3));
+            vitdec.update(buf, PI_X, 24);
+            const uint64_t error = vitdec.chainback(decoded_bytes);
+            microbenchmark_keep(float(error));
+        });
+    }
+
+    // A 96kbps subchannel for each protection profile
+    // Includes time deinterleaving and descrambling since these run on every decoded CIF
+    struct Profile {
+        const char* name;
+        subchannel_size_t length;
+        bool is_uep;
+        EEP_Type eep_type;
+        eep_protection_level_t eep_prot_level;
+        uep_protection_index_t uep_prot_index;
+    };
+    const Profile profiles[] = {
+        { "msc_decode_eep_1a", 144, false, EEP_Type::TYPE_A, 0, 0 },
+        { "msc_decode_eep_2a",  96, false, EEP_Type::TYPE_A, 1, 0 },
+        { "msc_decode_eep_3a",  72, false, EEP_Type::TYPE_A, 2, 0 },
+        { "msc_decode_eep_4a",  48, false, EEP_Type::TYPE_A, 3, 0 },
+        { "msc_decode_eep_3b",  54, false, EEP_Type::TYPE_B, 2, 0 },
+        { "msc_decode_uep_3",   70, true,  EEP_Type::UNDEFINED, 0, 26 },
+    };
+    for (const auto& profile: profiles) {
+        if (!runner.is_selected(profile.name, "auto")) continue;
+        auto subchannel = Subchannel(0);
+        subchannel.start_address = 0;
+        subchannel.length = profile.length;
+        subchannel.is_uep = profile.is_uep;
+        subchannel.eep_type = profile.eep_type;
+        subchannel.eep_prot_level = profile.eep_prot_level;
+        subchannel.uep_prot_index = profile.uep_prot_index;
+        subchannel.is_complete = true;
+        auto msc_decoder = MSC_Decoder(subchannel);
+        const auto cif_bits = create_random_soft_bits(size_t(dab_params.nb_cif_bits));
+        // fill the time deinterleaver so every call decodes
+        for (int i = 0; i < 16; i++) msc_decoder.DecodeCIF(cif_bits);
+        const uint64_t nb_decoded_bits = uint64_t(msc_decoder.DecodeCIF(cif_bits).size())*8;
+        runner.run(profile.name, "auto", "bits", nb_decoded_bits, [&]() {
+            const auto decoded_bytes = msc_decoder.DecodeCIF(cif_bits);
+            microbenchmark_keep(float(decoded_bytes.size()));
+        });
+    }
+}
+
+static void run_block_benchmarks(MicroBenchmarkRunner& runner) {
+    // DOC: ETSI TS 102 563
+    // Clause 6.1 - RS(120,110) shortened from RS(255,245) used for DAB+ superframes
+    {
+        const int NB_MESSAGE_BYTES = 120;
+        const int NB_PARITY_BYTES = 10;
+        const int NB_PADDING_BYTES = 255-NB_MESSAGE_BYTES;
+        auto rs_decoder = Reed_Solomon_Decoder(8, 0b100011101, 0, 1, NB_PARITY_BYTES, NB_PADDING_BYTES);
+        auto error_positions = std::vector<int>(NB_PARITY_BYTES);
+        // all zeros is a valid codeword so errors can be added at known positions
+        const auto clean_codeword = std::vector<uint8_t>(NB_MESSAGE_BYTES, 0);
+        auto corrupt_codeword = clean_codeword;
+        const int max_correctable_errors = NB_PARITY_BYTES/2;
+        for (int i = 0; i < max_correctable_errors; i++) {
+            corrupt_codeword[i*23] = uint8_t(0xA5 + i);
+        }
+        auto codeword = clean_codeword;
+        runner.run("reed_solomon_no_errors", "scalar", "bytes", NB_MESSAGE_BYTES, [&]() {
+            codeword = clean_codeword;
+            const int res = rs_decoder.Decode(codeword.data(), error_positions.data(), 0);
+            microbenchmark_keep(float(res));
+        });
+        runner.run("reed_solomon_max_errors", "scalar", "bytes", NB_MESSAGE_BYTES, [&]() {
+            codeword = corrupt_codeword;
+            const int res = rs_decoder.Decode(codeword.data(), error_positions.data(), 0);
+            microbenchmark_keep(float(res));
+        });
+    }
+
+    // DOC: ETSI EN 300 401
+    // Clause 5.2.1 - Fast Information Block (FIB) crc over its 30 data bytes
+    {
+        auto crc16_calc = CRC_Calculator<uint16_t>(0x1021);
+        crc16_calc.SetInitialValue(0xFFFF);
+        crc16_calc.SetFinalXORValue(0xFFFF);
+        const auto fib_data = create_random_bytes(30);
+        runner.run("crc16_fib", "scalar", "bytes", fib_data.size(), [&]() {
+            microbenchmark_keep(float(crc16_calc.Process(fib_data)));
+        });
+    }
+
+    // DOC: ETSI TS 102 563
+    // Clause 5.2 - Firecode over the first 9 bytes of a DAB+ logical frame
+    {
+        auto firecode_calc = CRC_Calculator<uint16_t>(0b0111100000101111);
+        firecode_calc.SetInitialValue(0x0000);
+        firecode_calc.SetFinalXORValue(0x0000);
+        const auto frame_data = create_random_bytes(9);
+        runner.run("firecode", "scalar", "bytes", frame_data.size(), [&]() {
+            microbenchmark_keep(float(firecode_calc.Process(frame_data)));
+        });
+    }
+
+    // DOC: ETSI EN 300 401
+    // Clause 10 - Energy dispersal over a 96kbps subchannel's 24ms frame
+    {
+        const size_t N = 288;
+        auto scrambler = AdditiveScrambler();
+        scrambler.SetSyncword(0xFFFF);
+        auto bytes = create_random_bytes(N);
+        runner.run("descrambler", "scalar", "bytes", N, [&]() {
+            scrambler.Reset();
+            for (size_t i = 0; i < N; i++) {
+                bytes[i] ^= scrambler.Process();
+            }
+            microbenchmark_keep(float(bytes[N-1]));
+        });
+    }
+
+    // DOC: ETSI EN 300 401
+    // Clause 12 - Time interleaving of a 96kbps subchannel with EEP 3-A protection (72 capacity units)
+    {
+        const int nb_bytes = 72*8;
+        const size_t nb_bits = size_t(nb_bytes)*8;
+        auto deinterleaver = CIF_Deinterleaver(nb_bytes);
+        const auto in_bits = create_random_soft_bits(nb_bits);
+        auto out_bits = std::vector<viterbi_bit_t>(nb_bits);
+        for (int i = 0; i < 16; i++) deinterleaver.Consume(in_bits);
+        runner.run("cif_deinterleaver", "scalar", "bits", nb_bits, [&]() {
+            deinterleaver.Consume(in_bits);
+            deinterleaver.Deinterleave(out_bits);
+            microbenchmark_keep(float(out_bits[nb_bits-1]));
+        });
+    }
+}
+
+// Audio frames come from the ensemble generator's sources so they are valid and decode without errors
+static void run_audio_benchmarks(MicroBenchmarkRunner& runner) {
+    // 96kbps subchannel where each 24ms logical frame is 3 bytes per kbps
+    const int bitrate_kbps = 96;
+    const size_t nb_frame_bytes = size_t(bitrate_kbps)*3;
+    const int total_frames = 4;
+    auto frame_buf = std::vector<uint8_t>(nb_frame_bytes);
+
+    // DOC: ETSI TS 102 563
+    // Each superframe of 5 logical frames carries 6 AAC access units
+    if (runner.is_selected("aac_decode_frame", "faad2")) {
+        auto source = DAB_Plus_Source(bitrate_kbps);
+        auto frame_processor = AAC_Frame_Processor();
+        std::unique_ptr<AAC_Audio_Decoder> decoder = nullptr;
+        std::vector<std::vector<uint8_t>> access_units;
+        int total_errors = 0;
+        frame_processor.OnSuperFrameHeader().Attach([&decoder](const SuperFrameHeader& header) {
+            if (decoder != nullptr) return;
+            AAC_Audio_Decoder::Params params;
+            params.sampling_frequency = header.sampling_rate;
+            params.is_PS = header.PS_flag;
+            params.is_SBR = header.SBR_flag;
+            params.is_stereo = header.is_stereo;
+            decoder = std::make_unique<AAC_Audio_Decoder>(params);
+        });
+        frame_processor.OnAccessUnit().Attach([&access_units](const int, const int, tcb::span<uint8_t> buf) {
+            access_units.emplace_back(buf.begin(), buf.end());
+        });
+        frame_processor.OnFirecodeError().Attach([&total_errors](const int, const uint16_t, const uint16_t) { total_errors++; });
+        frame_processor.OnRSError().Attach([&total_errors](const int, const int) { total_errors++; });
+        frame_processor.OnAccessUnitCRCError().Attach([&total_errors](const int, const int, const uint16_t, const uint16_t) { total_errors++; });
+        for (int i = 0; i < total_frames*5; i++) {
+            source.fill_cif(frame_buf);
+            frame_processor.Process(frame_buf);
+        }
+
+        if ((decoder == nullptr) || access_units.empty() || (total_errors > 0)) {
+            fprintf(stderr, "Failed to create AAC access units for decoder benchmark (errors=%d)\n", total_errors);
+        } else {
+            size_t curr_au = 0;
+            runner.run("aac_decode_frame", "faad2", "frames", 1, [&]() {
+                auto& au = access_units[curr_au];
+                curr_au = (curr_au+1) % access_units.size();
+                const auto res = decoder->DecodeFrame(au);
+                microbenchmark_keep(float(res.audio_buf.size()));
+            });
+        }
+    }
+
+    // DOC: ETSI EN 300 401
+    // Clause 7.2 - One MPEG-1 Layer II frame is carried in each logical frame
+    if (runner.is_selected("mp2_decode_frame", "plmpeg")) {
+        auto source = MP2_Source(bitrate_kbps);
+        std::vector<std::vector<uint8_t>> frames;
+        for (int i = 0; i < total_frames; i++) {
+            source.fill_cif(frame_buf);
+            frames.push_back(frame_buf);
+        }
+        // same buffer setup as the audio channel
+        auto* plm_buffer = plm_buffer_create_with_capacity(32);
+        auto* plm_audio = plm_audio_create_with_buffer(plm_buffer);
+        size_t curr_frame = 0;
+        int total_errors = 0;
+        runner.run("mp2_decode_frame", "plmpeg", "frames", 1, [&]() {
+            const auto& frame = frames[curr_frame];
+            curr_frame = (curr_frame+1) % frames.size();
+            plm_buffer_rewind(plm_buffer);
+            plm_buffer_write(plm_buffer, frame.data(), frame.size());
+            const int total_data_bytes = plm_audio_decode_header(plm_audio);
+            const plm_samples_t* samples = (total_data_bytes > 0) ? plm_audio_decode(plm_audio, total_data_bytes) : nullptr;
+            if (samples == nullptr) {
+                total_errors++;
+                return;
+            }
+            microbenchmark_keep(samples->interleaved[PLM_AUDIO_SAMPLES_PER_FRAME-1]);
+        });
+        if (total_errors > 0) {
+            fprintf(stderr, "MP2 decoder failed on %d benchmark frames\n", total_errors);
+        }
+        plm_audio_destroy(plm_audio);
+        plm_buffer_destroy(plm_buffer);
+    }
+}
+
+INITIALIZE_EASYLOGGINGPP
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("dab_benchmarks", "0.1.0");
+    parser.add_description("Microbenchmarks for the DSP, FEC and audio kernels used to decode DAB");
+    parser.add_epilog(
+        "Results are written as json. A summary is printed to stderr while running.\n"
+        "Each simd variant compiled for the target is benchmarked separately.\n"
+        "Build with a different preset to benchmark the instruction sets selected at compile time."
+    );
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+    // decoders log on every frame which would be included in the timings
+    get_dab_logging_enabled() = false;
+
+    FILE* fp_out = stdout;
+    if (!args.output_filename.empty()) {
+        fp_out = fopen(args.output_filename.c_str(), "w");
+        if (fp_out == nullptr) {
+            fprintf(stderr, "Failed to open output file: '%s'\n", args.output_filename.c_str());
+            return 1;
+        }
+    }
+
+    auto runner = MicroBenchmarkRunner(args.config);
+    run_dsp_benchmarks(runner);
+    run_fft_benchmarks(runner);
+    run_ofdm_demod_benchmark(runner, args.config, args.ofdm_total_threads);
+    run_viterbi_benchmarks(runner);
+    run_block_benchmarks(runner);
+    run_audio_benchmarks(runner);
+    runner.write_json(fp_out, "dab_benchmarks");
+    if (fp_out != stdout) fclose(fp_out);
+    return 0;
+}
@@ -2,11 +2,10 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <atomic>
 #include <functional>
 #include <list>
-#include <memory>
 #include <string>
-#include <thread>
 #include <vector>
 #include "utility/span.h"
 
@@ -16,57 +15,62 @@ struct DeviceDescriptor {
     std::string serial;
 };
 
-class Device 
+// Tuner that delivers 8bit IQ samples through an asynchronous data callback
+// Derived classes implement the hardware specific Apply...(...) operations
+class Device
 {
-private:
+protected:
     DeviceDescriptor m_descriptor;
-    struct rtlsdr_dev* m_device;
     const int m_block_size;
-    bool m_is_running;
-    std::unique_ptr<std::thread> m_runner_thread;
+    std::atomic<bool> m_is_running{false};
 
     std::vector<float> m_gain_list;
     bool m_is_gain_manual;
     float m_selected_gain;
+    uint32_t m_selected_sampling_frequency;
     uint32_t m_selected_frequency;
     std::string m_selected_frequency_label;
     std::list<std::string> m_error_list;
     std::function<size_t(tcb::span<const uint8_t>)> m_callback_on_data = nullptr;
     std::function<void(const std::string&, const uint32_t)> m_callback_on_center_frequency = nullptr;
 public:
-    explicit Device(struct rtlsdr_dev* device, const DeviceDescriptor& descriptor, const int block_size=8192);
-    ~Device();
-    // we are holding a pointer to rtlsdr_dev_t, so we cant move/copy this class
+    explicit Device(const DeviceDescriptor& descriptor, const int block_size);
+    virtual ~Device() {}
+    // the data callback is called from a thread holding a pointer to us, so we cant move/copy this class
     Device(Device&) = delete;
     Device(Device&&) = delete;
     Device& operator=(Device&) = delete;
     Device& operator=(Device&&) = delete;
-    void Close();
+    virtual void Close() = 0;
     bool IsRunning() const { return m_is_running; }
     const auto& GetDescriptor() { return m_descriptor; }
     int GetBlockSize(void) { return m_block_size; }
     const auto& GetGainList(void) { return m_gain_list; }
     bool GetIsGainManual(void) { return m_is_gain_manual; }
     float GetSelectedGain(void) { return m_selected_gain; }
+    uint32_t GetSelectedSamplingFrequency(void) { return m_selected_sampling_frequency; }
     uint32_t GetSelectedFrequency(void) { return m_selected_frequency; }
     const auto& GetSelectedFrequencyLabel(void) { return m_selected_frequency_label; }
     auto& GetErrorList(void) { return m_error_list; }
-    void SetAutoGain(void); 
+    void SetAutoGain(void);
     void SetNearestGain(const float target_gain);
     void SetGain(const float gain);
-    void SetSamplingFrequency(const uint32_t freq); 
-    void SetCenterFrequency(const uint32_t freq); 
-    void SetCenterFrequency(const std::string& label, const uint32_t freq); 
-    template <typename F> 
-    void SetDataCallback(F&& func) { 
-        m_callback_on_data = std::move(func); 
+    void SetSamplingFrequency(const uint32_t freq);
+    void SetCenterFrequency(const uint32_t freq);
+    void SetCenterFrequency(const std::string& label, const uint32_t freq);
+    template <typename F>
+    void SetDataCallback(F&& func) {
+        m_callback_on_data = std::move(func);
     }
-    template <typename F> 
-    void SetFrequencyChangeCallback(F&& func) { 
-        m_callback_on_center_frequency = std::move(func); 
+    template <typename F>
+    void SetFrequencyChangeCallback(F&& func) {
+        m_callback_on_center_frequency = std::move(func);
     }
-private:
-    void SearchGains(void);
+protected:
+    // return false and add to the error list on failure
+    virtual bool ApplyAutoGain(void) = 0;
+    virtual bool ApplyGain(const float gain) = 0;
+    virtual bool ApplySamplingFrequency(const uint32_t freq) = 0;
+    virtual bool ApplyCenterFrequency(const std::string& label, const uint32_t freq) = 0;
     void OnData(tcb::span<const uint8_t> buf);
-    static void rtlsdr_callback(uint8_t* buf, uint32_t len, void* ctx); 
-};
\ No newline at end of file
+};
@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include "./device.h"
+#include "./device_rtlsdr.h"
 
 extern "C" {
 #include <rtl-sdr.h>
@@ -16,22 +17,21 @@ extern "C" {
 
 #define LOG_ERROR(...) fprintf(stderr, "[device-list] " __VA_ARGS__)
 
+void DeviceList::add_virtual_device(const DeviceDescriptor& descriptor, std::function<std::shared_ptr<Device>()> create_device) {
+    auto lock = std::unique_lock(m_mutex_descriptors);
+    m_virtual_devices.push_back({ descriptor, std::move(create_device) });
+}
+
 void DeviceList::refresh() {
-    const int total_devices = rtlsdr_get_device_count();
+    int total_devices = rtlsdr_get_device_count();
     if (total_devices <= 0) {
-        {
-            auto lock = std::unique_lock(m_mutex_descriptors);
-            m_descriptors.clear();
-        }
-        {
-            auto lock = std::unique_lock(m_mutex_errors);
-            if (total_devices == 0) {
-                LOG_ERROR("No devices were found");
-            } else {
-                LOG_ERROR("Failed to fetch devices (%d)", total_devices);
-            }
+        auto lock = std::unique_lock(m_mutex_errors);
+        if (total_devices == 0) {
+            LOG_ERROR("No devices were found");
+        } else {
+            LOG_ERROR("Failed to fetch devices (%d)", total_devices);
         }
-        return;
+        total_devices = 0;
     }
 
     auto descriptors = std::vector<DeviceDescriptor>(size_t(total_devices));
@@ -49,6 +49,10 @@ void DeviceList::refresh() {
     }
 
     auto lock = std::unique_lock(m_mutex_descriptors);
+    m_total_rtlsdr_devices = descriptors.size();
+    for (const auto& entry: m_virtual_devices) {
+        descriptors.push_back(entry.descriptor);
+    }
     m_descriptors = descriptors;
 }
 
@@ -61,6 +65,11 @@ std::shared_ptr<Device> DeviceList::get_device(size_t index) {
  
     auto lock_descriptors = std::unique_lock(m_mutex_descriptors);
     const auto descriptor = m_descriptors[index];
+    if (index >= m_total_rtlsdr_devices) {
+        auto create_device = m_virtual_devices[index-m_total_rtlsdr_devices].create_device;
+        lock_descriptors.unlock();
+        return create_device();
+    }
     lock_descriptors.unlock();
 
     rtlsdr_dev_t* device = nullptr;
@@ -70,5 +79,5 @@ std::shared_ptr<Device> DeviceList::get_device(size_t index) {
         LOG_ERROR("Failed to open device at index %zu (%d)", index, status);
         return nullptr;
     }
-    return std::make_shared<Device>(device, descriptor, 4);
+    return std::make_shared<RtlsdrDevice>(device, descriptor, 4);
 }
\ No newline at end of file
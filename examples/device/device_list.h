@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -10,12 +11,20 @@
 class DeviceList 
 {
 private:
+    struct VirtualDeviceEntry {
+        DeviceDescriptor descriptor;
+        std::function<std::shared_ptr<Device>()> create_device;
+    };
     std::mutex m_mutex_descriptors;
     std::mutex m_mutex_errors;
     std::vector<DeviceDescriptor> m_descriptors;
+    size_t m_total_rtlsdr_devices = 0;
+    std::vector<VirtualDeviceEntry> m_virtual_devices;
 public:
     auto& get_mutex_descriptors() { return m_mutex_descriptors; }
     tcb::span<const DeviceDescriptor> get_descriptors() const { return m_descriptors; }
+    // Virtual devices are listed after the rtlsdr devices on the next refresh
+    void add_virtual_device(const DeviceDescriptor& descriptor, std::function<std::shared_ptr<Device>()> create_device);
     void refresh(); 
     std::shared_ptr<Device> get_device(size_t index);
-};
\ No newline at end of file
+};
@@ -0,0 +1,119 @@
+#include "./device_rtlsdr.h"
+
+extern "C" {
+#include <rtl-sdr.h>
+}
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "utility/span.h"
+
+RtlsdrDevice::RtlsdrDevice(rtlsdr_dev_t* device, const DeviceDescriptor& descriptor, const int block_size)
+:  Device(descriptor, block_size), m_device(device)
+{
+    SearchGains();
+    SetNearestGain(19.0f);
+    SetSamplingFrequency(2048000);
+
+    int status = 0;
+    status = rtlsdr_set_bias_tee(m_device, 0);
+    if (status < 0) m_error_list.push_back(fmt::format("Failed to disable bias tee ({})", status));
+    status = rtlsdr_reset_buffer(m_device);
+    if (status < 0) m_error_list.push_back(fmt::format("Failed to reset buffer ({})", status));
+
+    m_runner_thread = std::make_unique<std::thread>([this]() {
+        const int status_read = rtlsdr_read_async(
+            m_device,
+            &RtlsdrDevice::rtlsdr_callback, reinterpret_cast<void*>(this),
+            0, m_block_size
+        );
+        fprintf(stderr, "[device] rtlsdr_read_sync exited with %d\n", status_read);
+    });
+}
+
+RtlsdrDevice::~RtlsdrDevice() {
+    Close();
+    // FIXME: Depending on the USB driver installed the following may occur
+    //        1. Segmentation fault in driver
+    //        2. Driver goes into an infinite loop
+    //        3. runner_thread doesn't exit and destructor is stuck at thread join
+    //        4. It works but rtlsdr_read_async returns a negative status code
+    m_runner_thread->join();
+    rtlsdr_close(m_device);
+    m_device = nullptr;
+}
+
+void RtlsdrDevice::Close() {
+    m_is_running = false;
+    rtlsdr_cancel_async(m_device);
+}
+
+bool RtlsdrDevice::ApplyAutoGain(void) {
+    const int status = rtlsdr_set_tuner_gain_mode(m_device, 0);
+    if (status < 0) {
+        m_error_list.push_back(fmt::format("Failed to set tuner gain mode to automatic ({})", status));
+        return false;
+    }
+    return true;
+}
+
+bool RtlsdrDevice::ApplyGain(const float gain) {
+    const int qgain = static_cast<int>(gain*10.0f);
+    int status = 0;
+    status = rtlsdr_set_tuner_gain_mode(m_device, 1);
+    if (status < 0) {
+        m_error_list.push_back(fmt::format("Failed to set tuner gain mode to manual ({})", status));
+        return false;
+    }
+    status = rtlsdr_set_tuner_gain(m_device, qgain);
+    if (status < 0) {
+        m_error_list.push_back(fmt::format("Failed to set manual gain to {:.1f}dB ({})", gain, status));
+        return false;
+    }
+    return true;
+}
+
+bool RtlsdrDevice::ApplySamplingFrequency(const uint32_t freq) {
+    const int status = rtlsdr_set_sample_rate(m_device, freq);
+    if (status < 0) {
+        m_error_list.push_back(fmt::format("Failed to set sampling frequency to {} Hz ({})", freq, status));
+        return false;
+    }
+    return true;
+}
+
+bool RtlsdrDevice::ApplyCenterFrequency(const std::string& label, const uint32_t freq) {
+    const int status = rtlsdr_set_center_freq(m_device, freq);
+    if (status < 0) {
+        m_error_list.push_back(fmt::format("Failed to set center frequency to {}@{}Hz ({})", label, freq, status));
+        return false;
+    }
+    return true;
+}
+
+void RtlsdrDevice::SearchGains(void) {
+    const int total_gains = rtlsdr_get_tuner_gains(m_device, NULL);
+    if (total_gains <= 0) {
+        return;
+    }
+    auto qgains = std::vector<int>(size_t(total_gains));
+    m_gain_list.resize(size_t(total_gains));
+    rtlsdr_get_tuner_gains(m_device, qgains.data());
+    for (size_t i = 0; i < size_t(total_gains); i++) {
+        const int qgain = qgains[i];
+        const float gain = static_cast<float>(qgain) * 0.1f;
+        m_gain_list[i] = gain;
+    }
+}
+
+void RtlsdrDevice::rtlsdr_callback(uint8_t* buf, uint32_t len, void* ctx) {
+    auto* device = reinterpret_cast<RtlsdrDevice*>(ctx);
+    auto data = tcb::span<const uint8_t>(buf, size_t(len));
+    device->OnData(data);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include "utility/span.h"
+#include "./device.h"
+
+class RtlsdrDevice: public Device
+{
+private:
+    struct rtlsdr_dev* m_device;
+    std::unique_ptr<std::thread> m_runner_thread;
+public:
+    explicit RtlsdrDevice(struct rtlsdr_dev* device, const DeviceDescriptor& descriptor, const int block_size=8192);
+    ~RtlsdrDevice() override;
+    RtlsdrDevice(RtlsdrDevice&) = delete;
+    RtlsdrDevice(RtlsdrDevice&&) = delete;
+    RtlsdrDevice& operator=(RtlsdrDevice&) = delete;
+    RtlsdrDevice& operator=(RtlsdrDevice&&) = delete;
+    void Close() override;
+protected:
+    bool ApplyAutoGain(void) override;
+    bool ApplyGain(const float gain) override;
+    bool ApplySamplingFrequency(const uint32_t freq) override;
+    bool ApplyCenterFrequency(const std::string& label, const uint32_t freq) override;
+private:
+    void SearchGains(void);
+    static void rtlsdr_callback(uint8_t* buf, uint32_t len, void* ctx);
+};
@@ -0,0 +1,231 @@
+#include "./device_virtual.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "utility/span.h"
+
+// Gains of the R820T tuner found in most rtlsdr dongles
+static const float VIRTUAL_GAIN_LIST[] = {
+    0.0f, 0.9f, 1.4f, 2.7f, 3.7f, 7.7f, 8.7f, 12.5f, 14.4f, 15.7f,
+    16.6f, 19.7f, 20.7f, 22.9f, 25.4f, 28.0f, 29.7f, 32.8f, 33.8f, 36.4f,
+    37.2f, 38.6f, 40.2f, 42.1f, 43.4f, 43.9f, 44.5f, 48.0f, 49.6f,
+};
+
+constexpr float SAMPLE_MIDPOINT = 127.5f;
+
+static uint8_t clamp_sample(const float x) {
+    return uint8_t(std::clamp(std::round(x), 0.0f, 255.0f));
+}
+
+VirtualRecordingSource::VirtualRecordingSource(FILE* file, const uint32_t sampling_frequency)
+: m_file(file), m_sampling_frequency(sampling_frequency) {}
+
+VirtualRecordingSource::~VirtualRecordingSource() {
+    if (m_file != nullptr) fclose(m_file);
+    m_file = nullptr;
+}
+
+void VirtualRecordingSource::Read(tcb::span<uint8_t> dest) {
+    bool is_rewound = false;
+    while (!dest.empty()) {
+        const size_t length = fread(dest.data(), sizeof(uint8_t), dest.size(), m_file);
+        dest = dest.subspan(length);
+        if (length > 0) {
+            is_rewound = false;
+            continue;
+        }
+        // empty file or read error
+        if (is_rewound) break;
+        fseek(m_file, 0, SEEK_SET);
+        is_rewound = true;
+    }
+    memset(dest.data(), uint8_t(SAMPLE_MIDPOINT), dest.size());
+}
+
+VirtualNoiseSource::VirtualNoiseSource(const float standard_deviation, const uint32_t seed)
+: m_random_state((seed == 0) ? 1 : seed)
+{
+    constexpr size_t TABLE_SIZE = size_t(1) << 18;
+    auto rng = std::mt19937(seed);
+    auto dist = std::normal_distribution<float>(SAMPLE_MIDPOINT, standard_deviation);
+    m_table.resize(TABLE_SIZE);
+    for (auto& x: m_table) {
+        x = clamp_sample(dist(rng));
+    }
+}
+
+void VirtualNoiseSource::Read(tcb::span<uint8_t> dest) {
+    const size_t N = m_table.size();
+    while (!dest.empty()) {
+        // xorshift32
+        m_random_state ^= m_random_state << 13;
+        m_random_state ^= m_random_state >> 17;
+        m_random_state ^= m_random_state << 5;
+        // keep I/Q ordering by starting at an even offset
+        const size_t offset = size_t(m_random_state % N) & ~size_t(1);
+        const size_t length = std::min(dest.size(), N-offset);
+        memcpy(dest.data(), m_table.data() + offset, length);
+        dest = dest.subspan(length);
+    }
+}
+
+VirtualDevice::VirtualDevice(const DeviceDescriptor& descriptor, const VirtualDeviceConfig& config)
+: Device(descriptor, config.block_size & ~1), m_config(config)
+{
+    m_noise_source = std::make_shared<VirtualNoiseSource>(m_config.noise_level);
+    m_current_source = m_noise_source;
+    m_sampling_frequency = 0;
+    m_total_settle_bytes_remaining = 0;
+    m_is_gain_unity = true;
+    UpdateGainTable(1.0f);
+
+    m_gain_list.assign(std::begin(VIRTUAL_GAIN_LIST), std::end(VIRTUAL_GAIN_LIST));
+    SetNearestGain(19.0f);
+    SetSamplingFrequency(2048000);
+
+    m_runner_thread = std::make_unique<std::thread>([this]() {
+        RunnerThread();
+    });
+}
+
+VirtualDevice::~VirtualDevice() {
+    Close();
+    m_runner_thread->join();
+}
+
+void VirtualDevice::Close() {
+    m_is_running = false;
+}
+
+void VirtualDevice::SetSource(const uint32_t freq, std::shared_ptr<VirtualSignalSource> source) {
+    auto lock = std::unique_lock(m_mutex_source);
+    if (source == nullptr) {
+        m_sources.erase(freq);
+    } else {
+        m_sources[freq] = source;
+    }
+}
+
+bool VirtualDevice::ApplyAutoGain(void) {
+    auto lock = std::unique_lock(m_mutex_source);
+    UpdateGainTable(1.0f);
+    return true;
+}
+
+bool VirtualDevice::ApplyGain(const float gain) {
+    const float scale = std::pow(10.0f, (gain - m_config.reference_gain)/20.0f);
+    auto lock = std::unique_lock(m_mutex_source);
+    UpdateGainTable(scale);
+    return true;
+}
+
+bool VirtualDevice::ApplySamplingFrequency(const uint32_t freq) {
+    // same ranges as the rtl2832u
+    const bool is_valid =
+        ((freq > 225000) && (freq <= 300000)) ||
+        ((freq > 900000) && (freq <= 3200000));
+    if (!is_valid) {
+        m_error_list.push_back(fmt::format("Failed to set sampling frequency to {} Hz (invalid rate)", freq));
+        return false;
+    }
+    {
+        auto lock = std::unique_lock(m_mutex_source);
+        m_sampling_frequency = freq;
+    }
+    CheckSourceSamplingFrequency();
+    return true;
+}
+
+bool VirtualDevice::ApplyCenterFrequency(const std::string& /*label*/, const uint32_t freq) {
+    {
+        auto lock = std::unique_lock(m_mutex_source);
+        auto res = m_sources.find(freq);
+        m_current_source = (res != m_sources.end()) ? res->second : m_noise_source;
+        const double total_settle_samples = double(m_config.retune_settle_seconds) * double(m_sampling_frequency);
+        m_total_settle_bytes_remaining = uint64_t(total_settle_samples)*2;
+    }
+    m_total_retunes.fetch_add(1, std::memory_order_relaxed);
+    CheckSourceSamplingFrequency();
+    return true;
+}
+
+void VirtualDevice::UpdateGainTable(const float scale) {
+    m_is_gain_unity = (scale == 1.0f);
+    for (size_t i = 0; i < m_gain_table.size(); i++) {
+        m_gain_table[i] = clamp_sample(SAMPLE_MIDPOINT + (float(i)-SAMPLE_MIDPOINT)*scale);
+    }
+}
+
+void VirtualDevice::CheckSourceSamplingFrequency(void) {
+    uint32_t source_frequency = 0;
+    uint32_t device_frequency = 0;
+    {
+        auto lock = std::unique_lock(m_mutex_source);
+        source_frequency = m_current_source->GetSamplingFrequency();
+        device_frequency = m_sampling_frequency;
+    }
+    if ((source_frequency == 0) || (source_frequency == device_frequency)) return;
+    m_error_list.push_back(fmt::format(
+        "Source is sampled at {} Hz but the sampling frequency is {} Hz",
+        source_frequency, device_frequency));
+}
+
+void VirtualDevice::RunnerThread(void) {
+    using clock = std::chrono::steady_clock;
+    auto buf = std::vector<uint8_t>(size_t(m_block_size));
+    auto gain_table = std::array<uint8_t, 256>{};
+    bool is_gain_unity = true;
+    uint32_t paced_frequency = 0;
+    uint64_t total_paced_bytes = 0;
+    auto time_origin = clock::now();
+    while (m_is_running) {
+        std::shared_ptr<VirtualSignalSource> source = nullptr;
+        size_t total_settle_bytes = 0;
+        uint32_t sampling_frequency = 0;
+        {
+            auto lock = std::unique_lock(m_mutex_source);
+            source = m_current_source;
+            total_settle_bytes = size_t(std::min(uint64_t(buf.size()), m_total_settle_bytes_remaining));
+            m_total_settle_bytes_remaining -= uint64_t(total_settle_bytes);
+            sampling_frequency = m_sampling_frequency;
+            is_gain_unity = m_is_gain_unity;
+            if (!is_gain_unity) gain_table = m_gain_table;
+        }
+
+        // a retune during the read still delivers the old source like the in flight usb transfers of a real tuner
+        auto data = tcb::span(buf);
+        m_noise_source->Read(data.first(total_settle_bytes));
+        source->Read(data.subspan(total_settle_bytes));
+        if (!is_gain_unity) {
+            for (auto& x: buf) x = gain_table[x];
+        }
+
+        if ((m_config.speed > 0.0f) && (sampling_frequency > 0)) {
+            if (sampling_frequency != paced_frequency) {
+                paced_frequency = sampling_frequency;
+                total_paced_bytes = 0;
+                time_origin = clock::now();
+            }
+            total_paced_bytes += uint64_t(buf.size());
+            const double total_samples = double(total_paced_bytes/2);
+            const auto delay = std::chrono::duration<double>(total_samples / (double(paced_frequency)*double(m_config.speed)));
+            std::this_thread::sleep_until(time_origin + std::chrono::duration_cast<clock::duration>(delay));
+            if (!m_is_running) break;
+        }
+
+        OnData(buf);
+        m_total_bytes_delivered.fetch_add(uint64_t(buf.size()), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utility/span.h"
+#include "./device.h"
+
+// Provides 8bit IQ samples for a frequency tuned by the virtual device
+// Only read from the virtual device's runner thread
+class VirtualSignalSource
+{
+public:
+    virtual ~VirtualSignalSource() {}
+    // Sampling rate the samples were captured at or 0 if they are valid at any rate
+    virtual uint32_t GetSamplingFrequency() const { return 0; }
+    // Fill with interleaved 8bit IQ samples
+    virtual void Read(tcb::span<uint8_t> dest) = 0;
+};
+
+// Loops a raw 8bit IQ recording
+class VirtualRecordingSource: public VirtualSignalSource
+{
+private:
+    FILE* m_file;
+    const uint32_t m_sampling_frequency;
+public:
+    // takes ownership of the file
+    explicit VirtualRecordingSource(FILE* file, const uint32_t sampling_frequency=2048000);
+    ~VirtualRecordingSource() override;
+    VirtualRecordingSource(VirtualRecordingSource&) = delete;
+    VirtualRecordingSource(VirtualRecordingSource&&) = delete;
+    VirtualRecordingSource& operator=(VirtualRecordingSource&) = delete;
+    VirtualRecordingSource& operator=(VirtualRecordingSource&&) = delete;
+    uint32_t GetSamplingFrequency() const override { return m_sampling_frequency; }
+    void Read(tcb::span<uint8_t> dest) override;
+};
+
+// Gaussian noise around the 8bit midpoint like an empty channel
+// Samples come from a precomputed table at random offsets so empty channels are cheap at accelerated speeds
+class VirtualNoiseSource: public VirtualSignalSource
+{
+private:
+    std::vector<uint8_t> m_table;
+    uint32_t m_random_state;
+public:
+    explicit VirtualNoiseSource(const float standard_deviation=4.0f, const uint32_t seed=1);
+    void Read(tcb::span<uint8_t> dest) override;
+};
+
+struct VirtualDeviceConfig {
+    int block_size = 16*16384;              // bytes per data callback like a usb transfer
+    float speed = 1.0f;                     // multiple of the sampling rate, 0 = as fast as possible
+    float retune_settle_seconds = 0.0f;     // noise is delivered after retuning while the pll "settles"
+    float reference_gain = 19.7f;           // manual gain at which sources are delivered unscaled
+    float noise_level = 4.0f;               // standard deviation of noise on frequencies without a source
+};
+
+// Tuner without hardware that maps center frequencies to recordings or generators
+// Samples are delivered through the data callback from a runner thread like the rtlsdr device
+// Gain scales the samples and the sampling rate sets the pace they are delivered at
+class VirtualDevice: public Device
+{
+private:
+    const VirtualDeviceConfig m_config;
+    std::mutex m_mutex_source;
+    std::map<uint32_t, std::shared_ptr<VirtualSignalSource>> m_sources;
+    std::shared_ptr<VirtualSignalSource> m_noise_source;
+    std::shared_ptr<VirtualSignalSource> m_current_source;
+    uint32_t m_sampling_frequency;
+    uint64_t m_total_settle_bytes_remaining;
+    std::array<uint8_t, 256> m_gain_table;
+    bool m_is_gain_unity;
+    std::atomic<uint64_t> m_total_bytes_delivered{0};
+    std::atomic<uint64_t> m_total_retunes{0};
+    std::unique_ptr<std::thread> m_runner_thread;
+public:
+    explicit VirtualDevice(const DeviceDescriptor& descriptor, const VirtualDeviceConfig& config={});
+    ~VirtualDevice() override;
+    VirtualDevice(VirtualDevice&) = delete;
+    VirtualDevice(VirtualDevice&&) = delete;
+    VirtualDevice& operator=(VirtualDevice&) = delete;
+    VirtualDevice& operator=(VirtualDevice&&) = delete;
+    void Close() override;
+    void SetSource(const uint32_t freq, std::shared_ptr<VirtualSignalSource> source);
+    uint64_t GetTotalBytesDelivered() const { return m_total_bytes_delivered.load(std::memory_order_relaxed); }
+    uint64_t GetTotalRetunes() const { return m_total_retunes.load(std::memory_order_relaxed); }
+protected:
+    bool ApplyAutoGain(void) override;
+    bool ApplyGain(const float gain) override;
+    bool ApplySamplingFrequency(const uint32_t freq) override;
+    bool ApplyCenterFrequency(const std::string& label, const uint32_t freq) override;
+private:
+    void UpdateGainTable(const float scale);
+    void CheckSourceSamplingFrequency(void);
+    void RunnerThread(void);
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "utility/span.h"
+
+// Writes msb first bit fields into a zero initialised byte buffer
+class BitWriter
+{
+private:
+    tcb::span<uint8_t> m_buf;
+    size_t m_curr_bit = 0;
+public:
+    explicit BitWriter(tcb::span<uint8_t> buf): m_buf(buf) {}
+    void write(const uint32_t value, const int nb_bits) {
+        assert(get_remaining_bits() >= size_t(nb_bits));
+        for (int i = nb_bits-1; i >= 0; i--) {
+            const uint8_t bit = uint8_t((value >> i) & 0b1);
+            const size_t byte_index = m_curr_bit/8;
+            const size_t bit_shift = 7 - (m_curr_bit % 8);
+            m_buf[byte_index] = uint8_t(m_buf[byte_index] | (bit << bit_shift));
+            m_curr_bit++;
+        }
+    }
+    void align_to_byte() {
+        m_curr_bit = ((m_curr_bit+7)/8)*8;
+    }
+    size_t get_curr_bit() const { return m_curr_bit; }
+    size_t get_remaining_bits() const { return m_buf.size()*8 - m_curr_bit; }
+};
+
+// Unpacks msb first bytes into an array of single bits
+static inline void unpack_bits(tcb::span<const uint8_t> bytes, tcb::span<uint8_t> bits) {
+    assert(bits.size() >= bytes.size()*8);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        const uint8_t b = bytes[i];
+        for (size_t j = 0; j < 8; j++) {
+            bits[i*8+j] = uint8_t((b >> (7-j)) & 0b1);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#include "./cif_interleaver.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "utility/span.h"
+
+// DOC: ETSI EN 300 401
+// Clause 12 - Time interleaving
+// Bit i of a logical CIF is delayed by this many CIFs
+constexpr size_t TOTAL_CIF_INTERLEAVE = 16;
+const size_t CIF_INDICES_OFFSETS[TOTAL_CIF_INTERLEAVE] = {
+    0,8,4,12, 2,10,6,14, 1,9,5,13, 3,11,7,15
+};
+
+CIF_Interleaver::CIF_Interleaver(const size_t nb_bits)
+: m_nb_bits(nb_bits)
+{
+    m_bits_buffer.resize(m_nb_bits*TOTAL_CIF_INTERLEAVE, 0);
+}
+
+void CIF_Interleaver::process(tcb::span<const uint8_t> in_bits, tcb::span<uint8_t> out_bits) {
+    assert(in_bits.size() == m_nb_bits);
+    assert(out_bits.size() == m_nb_bits);
+
+    auto* curr_bits_buf = &m_bits_buffer[m_nb_bits*m_curr_cif];
+    for (size_t i = 0; i < m_nb_bits; i++) {
+        curr_bits_buf[i] = in_bits[i];
+    }
+
+    const uint8_t* CIF_LOOKUP[TOTAL_CIF_INTERLEAVE];
+    for (size_t i = 0; i < TOTAL_CIF_INTERLEAVE; i++) {
+        const size_t delay = CIF_INDICES_OFFSETS[i];
+        const size_t cif_index = (m_curr_cif + TOTAL_CIF_INTERLEAVE - delay) % TOTAL_CIF_INTERLEAVE;
+        CIF_LOOKUP[i] = &m_bits_buffer[cif_index*m_nb_bits];
+    }
+
+    for (size_t i = 0; i < m_nb_bits; i++) {
+        out_bits[i] = CIF_LOOKUP[i % TOTAL_CIF_INTERLEAVE][i];
+    }
+
+    m_curr_cif = (m_curr_cif+1) % TOTAL_CIF_INTERLEAVE;
+}
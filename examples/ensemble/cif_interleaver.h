@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+
+// DOC: ETSI EN 300 401
+// Clause 12 - Time interleaving
+// Inverse of CIF_Deinterleaver applied to an entire CIF at once
+// This is valid since every subchannel starts on a capacity unit which is a multiple of 16 bits
+class CIF_Interleaver
+{
+private:
+    const size_t m_nb_bits;
+    size_t m_curr_cif = 0;
+    // circular buffer of the last 16 logical CIFs
+    std::vector<uint8_t> m_bits_buffer;
+public:
+    explicit CIF_Interleaver(const size_t nb_bits);
+    // Bits from the first 15 CIFs are mixed with zeros from before the start of the transmission
+    void process(tcb::span<const uint8_t> in_bits, tcb::span<uint8_t> out_bits);
+};
@@ -0,0 +1,59 @@
+#include "./dab_convolutional_encoder.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "dab/constants/puncture_codes.h"
+#include "utility/span.h"
+
+constexpr size_t K = DAB_Convolutional_Encoder::m_constraint_length;
+constexpr size_t R = DAB_Convolutional_Encoder::m_code_rate;
+constexpr size_t TOTAL_STATES = size_t(1) << K;
+
+// DOC: ETSI EN 300 401
+// Clause 11.1.1 - Mother code
+// Same reversed binary form as the decoder where the newest bit is the lsb of the state
+const uint8_t code_polynomial[R] = { 109, 79, 83, 109 };
+
+// Lookup of the 4 output bits for each 7bit encoder state
+static const auto OUTPUT_TABLE = []() {
+    struct Table { uint8_t bits[TOTAL_STATES][R]; } table;
+    for (size_t state = 0; state < TOTAL_STATES; state++) {
+        for (size_t i = 0; i < R; i++) {
+            uint8_t parity = 0;
+            const uint8_t v = uint8_t(state & code_polynomial[i]);
+            for (size_t j = 0; j < K; j++) {
+                parity ^= uint8_t((v >> j) & 0b1);
+            }
+            table.bits[state][i] = parity;
+        }
+    }
+    return table;
+} ();
+
+size_t DAB_Convolutional_Encoder::encode(
+    tcb::span<const uint8_t> input_bits,
+    tcb::span<const uint8_t> puncture_code,
+    tcb::span<uint8_t> encoded_bits)
+{
+    const size_t total_puncture_code = puncture_code.size();
+    size_t index_puncture_code = 0;
+    size_t index_encoded_bit = 0;
+    for (const uint8_t bit: input_bits) {
+        m_state = uint8_t(((m_state << 1) | (bit & 0b1)) & (TOTAL_STATES-1));
+        const auto& outputs = OUTPUT_TABLE.bits[m_state];
+        // Clause 11.1.2 - Puncturing procedure
+        // The first N bits of each group of 4 mother code bits are kept
+        const size_t total_kept = size_t(puncture_code[index_puncture_code]);
+        assert(index_encoded_bit+total_kept <= encoded_bits.size());
+        for (size_t i = 0; i < total_kept; i++) {
+            encoded_bits[index_encoded_bit++] = outputs[i];
+        }
+        index_puncture_code = (index_puncture_code+1) % total_puncture_code;
+    }
+    return index_encoded_bit;
+}
+
+size_t DAB_Convolutional_Encoder::encode_tail(tcb::span<uint8_t> encoded_bits) {
+    const uint8_t tail_bits[m_total_tail_bits] = {0};
+    return encode(tail_bits, PI_X, encoded_bits);
+}
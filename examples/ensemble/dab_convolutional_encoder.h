@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utility/span.h"
+
+// DOC: ETSI EN 300 401
+// Clause 11.1 - Convolutional code
+// Rate 1/4 mother code with puncturing that is the inverse of DAB_Viterbi_Decoder
+// Bits are stored one per byte with values of 0 or 1
+class DAB_Convolutional_Encoder
+{
+public:
+    static constexpr size_t m_constraint_length = 7;
+    static constexpr size_t m_code_rate = 4;
+    static constexpr size_t m_total_tail_bits = m_constraint_length-1;
+private:
+    uint8_t m_state = 0;
+public:
+    void reset() { m_state = 0; }
+    // The puncture code is a count table (refer to puncture_codes.h) and restarts on each call
+    // This matches the depuncturing done for each update of the decoder
+    // Returns the number of encoded bits written
+    size_t encode(
+        tcb::span<const uint8_t> input_bits,
+        tcb::span<const uint8_t> puncture_code,
+        tcb::span<uint8_t> encoded_bits);
+    // Flushes the encoder back to the zero state with PI_X puncturing
+    size_t encode_tail(tcb::span<uint8_t> encoded_bits);
+};
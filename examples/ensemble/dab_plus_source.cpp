@@ -0,0 +1,174 @@
+#include "./dab_plus_source.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "utility/span.h"
+#include "dab/algorithms/crc.h"
+#include "./bit_writer.h"
+
+constexpr size_t NB_FIRECODE_CRC16_BYTES = 2;
+constexpr size_t NB_RS_DATA_BYTES = 110;
+constexpr size_t NB_RS_PARITY_BYTES = 10;
+constexpr size_t NB_AU_CRC16_BYTES = 2;
+// dac_rate=48kHz and sbr=0 gives 6 access units
+constexpr size_t TOTAL_ACCESS_UNITS = 6;
+// 3 bytes of header then 5 access unit start addresses with 12bits each rounded up to a byte
+constexpr size_t NB_SUPER_FRAME_HEADER_BYTES = 3 + ((TOTAL_ACCESS_UNITS-1)*12 + 7)/8;
+
+// Same CRC calculators as AAC_Frame_Processor
+static auto FIRECODE_CRC_CALC = []() {
+    const uint16_t firecode_poly = 0b0111100000101111;
+    auto calc = new CRC_Calculator<uint16_t>(firecode_poly);
+    calc->SetInitialValue(0x0000);
+    calc->SetFinalXORValue(0x0000);
+    return calc;
+} ();
+
+static auto ACCESS_UNIT_CRC_CALC = []() {
+    const uint16_t au_crc_poly = 0b0001000000100001;
+    auto calc = new CRC_Calculator<uint16_t>(au_crc_poly);
+    calc->SetInitialValue(0xFFFF);
+    calc->SetFinalXORValue(0xFFFF);
+    return calc;
+} ();
+
+// DOC: ISO/IEC 14496-3
+// Table 4.3 - Syntax of raw_data_block()
+// A single channel element with no scalefactor bands decodes to silence
+// The remaining space is taken up by fill elements so the bitrate is used up
+static void write_silent_aac_frame(tcb::span<uint8_t> buf) {
+    constexpr uint32_t ID_SCE = 0;
+    constexpr uint32_t ID_FIL = 6;
+    constexpr uint32_t ID_END = 7;
+    constexpr size_t NB_SCE_BITS = 29;
+    constexpr size_t NB_END_BITS = 3;
+    constexpr size_t NB_FIL_HEADER_BITS = 3+4;
+    constexpr size_t NB_FIL_ESCAPE_BITS = 8;
+    constexpr size_t MAX_FIL_COUNT = 14;
+    constexpr size_t MAX_FIL_ESCAPE_COUNT = 15+255-1;
+
+    std::fill(buf.begin(), buf.end(), uint8_t(0));
+    auto writer = BitWriter(buf);
+
+    // single_channel_element()
+    writer.write(ID_SCE, 3);
+    writer.write(0, 4);         // element_instance_tag
+    writer.write(100, 8);       // global_gain
+    // ics_info()
+    writer.write(0, 1);         // ics_reserved_bit
+    writer.write(0, 2);         // window_sequence = ONLY_LONG_SEQUENCE
+    writer.write(0, 1);         // window_shape
+    writer.write(0, 6);         // max_sfb
+    writer.write(0, 1);         // predictor_data_present
+    // section_data() and scale_factor_data() are empty without any scalefactor bands
+    writer.write(0, 1);         // pulse_data_present
+    writer.write(0, 1);         // tns_data_present
+    writer.write(0, 1);         // gain_control_data_present
+    assert(writer.get_curr_bit() == NB_SCE_BITS);
+
+    // fill_element() with EXT_FILL payloads of zeros
+    size_t nb_remain_bits = writer.get_remaining_bits() - NB_END_BITS;
+    while (nb_remain_bits >= NB_FIL_HEADER_BITS) {
+        const size_t nb_escape_min_bits = NB_FIL_HEADER_BITS + NB_FIL_ESCAPE_BITS + (MAX_FIL_COUNT+1)*8;
+        if (nb_remain_bits >= nb_escape_min_bits) {
+            const size_t count = std::min(MAX_FIL_ESCAPE_COUNT, (nb_remain_bits-NB_FIL_HEADER_BITS-NB_FIL_ESCAPE_BITS)/8);
+            writer.write(ID_FIL, 3);
+            writer.write(15, 4);
+            writer.write(uint32_t(count-15+1), 8);
+            for (size_t i = 0; i < count; i++) writer.write(0, 8);
+            nb_remain_bits -= NB_FIL_HEADER_BITS + NB_FIL_ESCAPE_BITS + count*8;
+        } else {
+            const size_t count = std::min(MAX_FIL_COUNT, (nb_remain_bits-NB_FIL_HEADER_BITS)/8);
+            writer.write(ID_FIL, 3);
+            writer.write(uint32_t(count), 4);
+            for (size_t i = 0; i < count; i++) writer.write(0, 8);
+            nb_remain_bits -= NB_FIL_HEADER_BITS + count*8;
+        }
+    }
+    writer.write(ID_END, 3);
+}
+
+DAB_Plus_Source::DAB_Plus_Source(const int bitrate_kbps)
+// DOC: ETSI TS 102 563
+// Clause 6.1 - Reed Solomon coding
+// Same parameters as the decoder which uses P(x) = x^8 + x^4 + x^3 + x^2 + 1
+: m_nb_frame_bytes(size_t(bitrate_kbps)*3),
+  m_rs_encoder(0b100011101, 0, 1, int(NB_RS_PARITY_BYTES))
+{
+    assert((bitrate_kbps > 0) && (bitrate_kbps % 8 == 0));
+    m_super_frame_buf.resize(m_nb_frame_bytes*m_total_dab_frames, 0);
+}
+
+void DAB_Plus_Source::fill_cif(tcb::span<uint8_t> buf) {
+    assert(buf.size() == m_nb_frame_bytes);
+    if (m_curr_frame == 0) {
+        create_super_frame();
+    }
+    auto frame = tcb::span(m_super_frame_buf).subspan(m_curr_frame*m_nb_frame_bytes, m_nb_frame_bytes);
+    std::copy(frame.begin(), frame.end(), buf.begin());
+    m_curr_frame = (m_curr_frame+1) % m_total_dab_frames;
+}
+
+void DAB_Plus_Source::create_super_frame() {
+    auto& buf = m_super_frame_buf;
+    std::fill(buf.begin(), buf.end(), uint8_t(0));
+    // Number of reed solomon codewords
+    const size_t N = buf.size()/(NB_RS_DATA_BYTES+NB_RS_PARITY_BYTES);
+    const size_t nb_data_bytes = NB_RS_DATA_BYTES*N;
+
+    // DOC: ETSI TS 102 563
+    // Clause 5.2 - Audio super framing syntax
+    // Spread the access units evenly over the data bytes after the header
+    const size_t nb_au_bytes_total = nb_data_bytes - NB_SUPER_FRAME_HEADER_BYTES;
+    size_t au_start[TOTAL_ACCESS_UNITS+1] = {0};
+    au_start[0] = NB_SUPER_FRAME_HEADER_BYTES;
+    for (size_t i = 0; i < TOTAL_ACCESS_UNITS; i++) {
+        const size_t nb_au_bytes = nb_au_bytes_total/TOTAL_ACCESS_UNITS + ((i < nb_au_bytes_total % TOTAL_ACCESS_UNITS) ? 1 : 0);
+        au_start[i+1] = au_start[i] + nb_au_bytes;
+    }
+    assert(au_start[TOTAL_ACCESS_UNITS] == nb_data_bytes);
+
+    {
+        auto writer = BitWriter(tcb::span(buf).subspan(NB_FIRECODE_CRC16_BYTES, NB_SUPER_FRAME_HEADER_BYTES-NB_FIRECODE_CRC16_BYTES));
+        writer.write(0, 1);     // rfa
+        writer.write(1, 1);     // dac_rate = 48kHz
+        writer.write(0, 1);     // sbr_flag
+        writer.write(0, 1);     // aac_channel_mode = mono
+        writer.write(0, 1);     // ps_flag
+        writer.write(0, 3);     // mpeg_surround_config
+        for (size_t i = 1; i < TOTAL_ACCESS_UNITS; i++) {
+            writer.write(uint32_t(au_start[i]), 12);
+        }
+    }
+
+    for (size_t i = 0; i < TOTAL_ACCESS_UNITS; i++) {
+        auto au_buf = tcb::span(buf).subspan(au_start[i], au_start[i+1]-au_start[i]);
+        auto data_buf = au_buf.first(au_buf.size()-NB_AU_CRC16_BYTES);
+        write_silent_aac_frame(data_buf);
+        const uint16_t crc16 = ACCESS_UNIT_CRC_CALC->Process(data_buf);
+        au_buf[data_buf.size()+0] = uint8_t(crc16 >> 8);
+        au_buf[data_buf.size()+1] = uint8_t(crc16 & 0xFF);
+    }
+
+    // Firecode covers the 9 bytes after it
+    const uint16_t firecode = FIRECODE_CRC_CALC->Process(tcb::span(buf).subspan(NB_FIRECODE_CRC16_BYTES, 9));
+    buf[0] = uint8_t(firecode >> 8);
+    buf[1] = uint8_t(firecode & 0xFF);
+
+    // DOC: ETSI TS 102 563
+    // Clause 6 - Transport error coding and interleaving
+    // Codewords are interleaved across the superframe with a stride of N
+    uint8_t rs_data[NB_RS_DATA_BYTES];
+    uint8_t rs_parity[NB_RS_PARITY_BYTES];
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j < NB_RS_DATA_BYTES; j++) {
+            rs_data[j] = buf[i + j*N];
+        }
+        m_rs_encoder.encode(rs_data, rs_parity);
+        for (size_t j = 0; j < NB_RS_PARITY_BYTES; j++) {
+            buf[i + (NB_RS_DATA_BYTES+j)*N] = rs_parity[j];
+        }
+    }
+}
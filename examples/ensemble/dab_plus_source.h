@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+#include "./reed_solomon_encoder.h"
+#include "./subchannel_source.h"
+
+// DOC: ETSI TS 102 563
+// Creates valid DAB+ audio superframes which are spread over 5 logical frames
+// Each access unit is a silent mono AAC-LC frame at 48kHz padded with fill elements
+// This exercises the firecode, reed solomon, access unit crc and AAC decoder on the receiver
+class DAB_Plus_Source: public SubchannelSource
+{
+private:
+    static constexpr size_t m_total_dab_frames = 5;
+    const size_t m_nb_frame_bytes;
+    Reed_Solomon_Encoder m_rs_encoder;
+    std::vector<uint8_t> m_super_frame_buf;
+    size_t m_curr_frame = 0;
+public:
+    explicit DAB_Plus_Source(const int bitrate_kbps);
+    void fill_cif(tcb::span<uint8_t> buf) override;
+private:
+    void create_super_frame();
+};
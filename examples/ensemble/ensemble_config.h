@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "dab/database/dab_database_entities.h"
+#include "dab/database/dab_database_types.h"
+
+enum class EnsembleServiceType {
+    DAB_PLUS,   // HE-AAC superframes in an EEP subchannel
+    DAB,        // MPEG-1 layer II in a UEP subchannel
+    DATA,       // MOT slideshow in an EEP packet mode subchannel
+};
+
+struct EnsembleServiceConfig {
+    EnsembleServiceType type = EnsembleServiceType::DAB_PLUS;
+    int bitrate_kbps = 64;
+    std::string label;      // truncated to 16 characters
+};
+
+struct EnsembleConfig {
+    int transmission_mode = 1;
+    // defaults to Germany
+    country_id_t country_id = 0x1;
+    extended_country_id_t extended_country_code = 0xE0;
+    uint16_t ensemble_reference = 0x0FFF;
+    std::string label = "Load Test";
+    // protection used by DAB+ and data subchannels
+    EEP_Type eep_type = EEP_Type::TYPE_A;
+    eep_protection_level_t eep_prot_level = 2;  // 0 to 3 for 1-A to 4-A or 1-B to 4-B
+    // protection used by DAB subchannels
+    int uep_prot_level = 3;                     // 1 to 5
+    std::vector<EnsembleServiceConfig> services;
+};
@@ -0,0 +1,366 @@
+#include "./ensemble_generator.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include "utility/span.h"
+#include "dab/constants/subchannel_protection_tables.h"
+#include "./cif_interleaver.h"
+#include "./dab_plus_source.h"
+#include "./fic_encoder.h"
+#include "./mot_slideshow_source.h"
+#include "./mp2_source.h"
+#include "./msc_encoder.h"
+
+// DOC: ETSI EN 300 401
+// Clause 6.2.1 - Basic sub-channel organization
+constexpr size_t TOTAL_CIF_CAPACITY_UNITS = 864;
+constexpr size_t TOTAL_CAPACITY_UNIT_BITS = 64;
+constexpr size_t TOTAL_SUBCHANNEL_IDS = 64;
+constexpr size_t TOTAL_LABEL_CHARS = 16;
+// CIF counter is a modulo 20 and modulo 250 counter
+constexpr uint32_t TOTAL_CIF_COUNTER = 5000;
+
+// DOC: ETSI EN 300 401
+// Table 2: List of FIG types
+constexpr uint8_t FIG_TYPE_0 = 0;
+constexpr uint8_t FIG_TYPE_1 = 1;
+
+static uint8_t get_fig_0_descriptor(const uint8_t extension, const bool is_long_id=false) {
+    // cn=0, oe=0, pd=is_long_id
+    return uint8_t((uint8_t(is_long_id) << 5) | (extension & 0b11111));
+}
+
+static uint8_t get_fig_1_descriptor(const uint8_t extension) {
+    // charset=0 is the EBU Latin based repertoire
+    return uint8_t(extension & 0b111);
+}
+
+static std::vector<uint8_t> get_label_entry(const uint16_t id, const std::string& label) {
+    std::vector<uint8_t> entry;
+    entry.push_back(uint8_t(id >> 8));
+    entry.push_back(uint8_t(id & 0xFF));
+    for (size_t i = 0; i < TOTAL_LABEL_CHARS; i++) {
+        entry.push_back((i < label.size()) ? uint8_t(label[i]) : uint8_t(' '));
+    }
+    // Abbreviated label uses the first 8 characters
+    entry.push_back(0xFF);
+    entry.push_back(0x00);
+    return entry;
+}
+
+static int find_uep_table_index(const int bitrate_kbps, const int protection_level) {
+    for (int i = 0; i < UEP_PROTECTION_TABLE_SIZE; i++) {
+        const auto& descriptor = UEP_PROTECTION_TABLE[i];
+        if ((int(descriptor.bitrate) == bitrate_kbps) && (int(descriptor.protection_level) == protection_level)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+EnsembleGenerator::EnsembleGenerator(const EnsembleConfig& config)
+: m_config(config),
+  m_params(get_dab_parameters(config.transmission_mode))
+{
+    // DOC: docs/DAB_parameters.pdf
+    // Transmission mode III has 4 FIBs per CIF with a different code rate
+    // FIC_Decoder only supports the FIB groups used by the other transmission modes
+    if (size_t(m_params.nb_fib_cif_bits) != FIC_Encoder::m_nb_encoded_bits) {
+        throw std::runtime_error(fmt::format("Transmission mode {} is not supported", config.transmission_mode));
+    }
+    assert(size_t(m_params.nb_cif_bits) == TOTAL_CIF_CAPACITY_UNITS*TOTAL_CAPACITY_UNIT_BITS);
+
+    m_fic_encoder = std::make_unique<FIC_Encoder>();
+    m_cif_interleaver = std::make_unique<CIF_Interleaver>(size_t(m_params.nb_cif_bits));
+    m_cif_bits.resize(size_t(m_params.nb_cif_bits), 0);
+    create_channels();
+    create_figs();
+}
+
+EnsembleGenerator::~EnsembleGenerator() = default;
+
+EnsembleGenerator::Channel::Channel(const Subchannel& _subchannel)
+: subchannel(_subchannel) {}
+
+void EnsembleGenerator::create_channels() {
+    const auto& services = m_config.services;
+    if (services.size() > TOTAL_SUBCHANNEL_IDS) {
+        throw std::runtime_error(fmt::format("Ensemble can only have {} subchannels but got {} services",
+            TOTAL_SUBCHANNEL_IDS, services.size()));
+    }
+    if (m_config.eep_prot_level >= EEP_PROTECTION_TABLE_SIZE) {
+        throw std::runtime_error(fmt::format("EEP protection level must be between 0 and {}", EEP_PROTECTION_TABLE_SIZE-1));
+    }
+
+    m_channels.reserve(services.size());
+    size_t curr_capacity_unit = 0;
+    for (size_t i = 0; i < services.size(); i++) {
+        const auto& service = services[i];
+        const int bitrate = service.bitrate_kbps;
+        auto subchannel = Subchannel(subchannel_id_t(i));
+        subchannel.start_address = subchannel_addr_t(curr_capacity_unit);
+
+        if (service.type == EnsembleServiceType::DAB) {
+            // DOC: ETSI EN 300 401
+            // Clause 6.2.1 - Table 8: UEP is only defined for MPEG audio bitrates
+            const int index = find_uep_table_index(bitrate, m_config.uep_prot_level);
+            if ((index < 0) || !MP2_Source::is_bitrate_supported(bitrate)) {
+                throw std::runtime_error(fmt::format("Service {} has no UEP profile for {}kbps at protection level {}",
+                    i, bitrate, m_config.uep_prot_level));
+            }
+            subchannel.is_uep = true;
+            subchannel.uep_prot_index = uep_protection_index_t(index);
+            subchannel.length = subchannel_size_t(UEP_PROTECTION_TABLE[index].subchannel_size);
+        } else {
+            // DOC: ETSI EN 300 401
+            // Clause 6.2.1 - Table 9 and Table 10: EEP bitrates are a multiple of 8 or 32kbps
+            const bool is_type_a = (m_config.eep_type == EEP_Type::TYPE_A);
+            const auto& descriptor = is_type_a ?
+                EEP_PROTECTION_TABLE_TYPE_A[m_config.eep_prot_level] :
+                EEP_PROTECTION_TABLE_TYPE_B[m_config.eep_prot_level];
+            const int bitrate_multiple = int(descriptor.bitrate_multiple);
+            // DOC: ETSI TS 102 563
+            // Superframes have 12bit access unit addresses which the mono AAC decoder limits to 192kbps
+            const int max_bitrate = 192;
+            if ((bitrate <= 0) || (bitrate > max_bitrate) || (bitrate % bitrate_multiple != 0)) {
+                throw std::runtime_error(fmt::format("Service {} has bitrate {}kbps which isn't a multiple of {}kbps up to {}kbps",
+                    i, bitrate, bitrate_multiple, max_bitrate));
+            }
+            const int n = bitrate / bitrate_multiple;
+            subchannel.is_uep = false;
+            subchannel.eep_type = m_config.eep_type;
+            subchannel.eep_prot_level = m_config.eep_prot_level;
+            subchannel.length = subchannel_size_t(int(descriptor.capacity_unit_multiple)*n);
+            if (service.type == EnsembleServiceType::DATA) {
+                subchannel.fec_scheme = FEC_Scheme::NONE;
+            }
+        }
+        subchannel.is_complete = true;
+
+        curr_capacity_unit += size_t(subchannel.length);
+        if (curr_capacity_unit > TOTAL_CIF_CAPACITY_UNITS) {
+            throw std::runtime_error(fmt::format("Services use more than the {} capacity units in a CIF after service {}",
+                TOTAL_CIF_CAPACITY_UNITS, i));
+        }
+
+        auto& channel = m_channels.emplace_back(subchannel);
+        channel.encoder = std::make_unique<MSC_Encoder>(subchannel);
+        const size_t nb_bytes = channel.encoder->get_nb_input_bytes();
+        channel.bytes_buf.resize(nb_bytes, 0);
+        switch (service.type) {
+        case EnsembleServiceType::DAB_PLUS:
+            channel.source = std::make_unique<DAB_Plus_Source>(bitrate);
+            break;
+        case EnsembleServiceType::DAB:
+            channel.source = std::make_unique<MP2_Source>(bitrate);
+            break;
+        case EnsembleServiceType::DATA:
+            channel.source = std::make_unique<MOT_Slideshow_Source>(nb_bytes, uint16_t(i+1));
+            break;
+        }
+    }
+    m_total_capacity_units = curr_capacity_unit;
+}
+
+void EnsembleGenerator::create_figs() {
+    const auto& services = m_config.services;
+    const uint16_t ensemble_id = uint16_t((m_config.country_id << 12) | (m_config.ensemble_reference & 0x0FFF));
+    auto get_service_id = [&](const size_t i) {
+        return uint16_t((m_config.country_id << 12) | ((i+1) & 0x0FFF));
+    };
+    auto get_packet_component_id = [](const size_t i) {
+        return uint16_t((i+1) & 0x0FFF);
+    };
+
+    std::vector<std::vector<uint8_t>> figs;
+    auto add_figs = [&](const uint8_t type, const uint8_t descriptor, const std::vector<std::vector<uint8_t>>& entries) {
+        if (entries.empty()) return;
+        auto new_figs = ::create_figs(type, descriptor, entries);
+        figs.insert(figs.end(), new_figs.begin(), new_figs.end());
+    };
+
+    // DOC: ETSI EN 300 401
+    // Clause 6.2.1 - Basic sub-channel organization (FIG 0/1)
+    {
+        std::vector<std::vector<uint8_t>> entries;
+        for (const auto& channel: m_channels) {
+            const auto& subchannel = channel.subchannel;
+            const uint8_t b0 = uint8_t((subchannel.id << 2) | (subchannel.start_address >> 8));
+            const uint8_t b1 = uint8_t(subchannel.start_address & 0xFF);
+            if (subchannel.is_uep) {
+                // short form with table switch=0
+                entries.push_back({ b0, b1, uint8_t(subchannel.uep_prot_index & 0b111111) });
+            } else {
+                // long form where option=0 is type A and option=1 is type B
+                const uint8_t option = (subchannel.eep_type == EEP_Type::TYPE_A) ? 0b000 : 0b001;
+                entries.push_back({
+                    b0, b1,
+                    uint8_t((1 << 7) | (option << 4) | (subchannel.eep_prot_level << 2) | (subchannel.length >> 8)),
+                    uint8_t(subchannel.length & 0xFF),
+                });
+            }
+        }
+        add_figs(FIG_TYPE_0, get_fig_0_descriptor(1), entries);
+    }
+
+    // Clause 6.3.1 - Basic service and service component definition (FIG 0/2)
+    // Clause 6.3.2 - Service component in packet mode (FIG 0/3)
+    // Clause 6.2.2 - FEC sub-channel organization (FIG 0/14)
+    {
+        std::vector<std::vector<uint8_t>> service_entries;
+        std::vector<std::vector<uint8_t>> packet_entries;
+        std::vector<std::vector<uint8_t>> fec_entries;
+        for (size_t i = 0; i < services.size(); i++) {
+            const uint16_t service_id = get_service_id(i);
+            const uint8_t subchannel_id = uint8_t(m_channels[i].subchannel.id);
+            std::vector<uint8_t> entry = {
+                uint8_t(service_id >> 8), uint8_t(service_id & 0xFF),
+                0x01,   // rfa=0, CAId=0, 1 service component
+            };
+            // primary component without conditional access
+            const uint8_t is_primary = 1;
+            switch (services[i].type) {
+            case EnsembleServiceType::DAB_PLUS:
+            case EnsembleServiceType::DAB:
+                {
+                    const auto ASTCy = (services[i].type == EnsembleServiceType::DAB) ? AudioServiceType::DAB : AudioServiceType::DAB_PLUS;
+                    entry.push_back(uint8_t((uint8_t(TransportMode::STREAM_MODE_AUDIO) << 6) | uint8_t(ASTCy)));
+                    entry.push_back(uint8_t((subchannel_id << 2) | (is_primary << 1)));
+                }
+                break;
+            case EnsembleServiceType::DATA:
+                {
+                    const uint16_t SCId = get_packet_component_id(i);
+                    entry.push_back(uint8_t((uint8_t(TransportMode::PACKET_MODE_DATA) << 6) | (SCId >> 6)));
+                    entry.push_back(uint8_t(((SCId & 0b111111) << 2) | (is_primary << 1)));
+                    const uint16_t packet_address = uint16_t(i+1);
+                    packet_entries.push_back({
+                        uint8_t(SCId >> 4),
+                        uint8_t((SCId & 0xF) << 4),             // rfa=0, CAOrg flag=0
+                        uint8_t(DataServiceType::MOT),          // data groups are used
+                        uint8_t((subchannel_id << 2) | (packet_address >> 8)),
+                        uint8_t(packet_address & 0xFF),
+                    });
+                    fec_entries.push_back({ uint8_t((subchannel_id << 2) | uint8_t(FEC_Scheme::NONE)) });
+                }
+                break;
+            }
+            service_entries.push_back(std::move(entry));
+        }
+        add_figs(FIG_TYPE_0, get_fig_0_descriptor(2), service_entries);
+        add_figs(FIG_TYPE_0, get_fig_0_descriptor(3), packet_entries);
+        add_figs(FIG_TYPE_0, get_fig_0_descriptor(14), fec_entries);
+    }
+
+    // Clause 8.1.3.2 - Country, LTO and International table (FIG 0/9)
+    {
+        const uint8_t inter_table_id = 0x01;
+        add_figs(FIG_TYPE_0, get_fig_0_descriptor(9), {{
+            0x00,       // ext=0, rfa=0, LTO=0
+            uint8_t(m_config.extended_country_code),
+            inter_table_id,
+        }});
+    }
+
+    // Clause 8.1.13 - Ensemble label (FIG 1/0)
+    add_figs(FIG_TYPE_1, get_fig_1_descriptor(0), { get_label_entry(ensemble_id, m_config.label) });
+
+    // Clause 8.1.14.1 - Programme service label (FIG 1/1)
+    for (size_t i = 0; i < services.size(); i++) {
+        add_figs(FIG_TYPE_1, get_fig_1_descriptor(1), { get_label_entry(get_service_id(i), services[i].label) });
+    }
+
+    for (auto& fig: figs) {
+        m_fic_encoder->add_fig(std::move(fig));
+    }
+}
+
+void EnsembleGenerator::generate_frame(tcb::span<uint8_t> frame_bits) {
+    assert(frame_bits.size() == get_nb_frame_bits());
+    const size_t nb_fic_bits = size_t(m_params.nb_fic_bits);
+    const size_t nb_cif_bits = size_t(m_params.nb_cif_bits);
+    const size_t nb_cifs = size_t(m_params.nb_cifs);
+
+    // DOC: ETSI EN 300 401
+    // Clause 6.4 - Ensemble information (FIG 0/0)
+    // This is sent once per transmission frame with the count of its first CIF
+    uint8_t fig_0_0[6] = {0};
+    {
+        const uint16_t ensemble_id = uint16_t((m_config.country_id << 12) | (m_config.ensemble_reference & 0x0FFF));
+        const uint8_t data_field[5] = {
+            get_fig_0_descriptor(0),
+            uint8_t(ensemble_id >> 8), uint8_t(ensemble_id & 0xFF),
+            uint8_t(m_cif_counter / 250),   // change=0, alarm=0, modulo 20 counter
+            uint8_t(m_cif_counter % 250),
+        };
+        const auto fig = create_fig(FIG_TYPE_0, data_field);
+        std::copy(fig.begin(), fig.end(), fig_0_0);
+    }
+
+    // DOC: ETSI EN 300 401
+    // Clause 5.1 - Fast Information Channel (FIC)
+    for (size_t i = 0; i < nb_cifs; i++) {
+        m_fic_encoder->encode_fib_group(
+            (i == 0) ? tcb::span<const uint8_t>(fig_0_0) : tcb::span<const uint8_t>{},
+            frame_bits.subspan(i*FIC_Encoder::m_nb_encoded_bits, FIC_Encoder::m_nb_encoded_bits));
+    }
+
+    // Clause 5.3 - Main Service Channel (MSC)
+    for (size_t i = 0; i < nb_cifs; i++) {
+        std::fill(m_cif_bits.begin(), m_cif_bits.end(), uint8_t(0));
+        for (auto& channel: m_channels) {
+            const auto& subchannel = channel.subchannel;
+            channel.source->fill_cif(channel.bytes_buf);
+            channel.encoder->encode(
+                channel.bytes_buf,
+                tcb::span(m_cif_bits).subspan(
+                    size_t(subchannel.start_address)*TOTAL_CAPACITY_UNIT_BITS,
+                    size_t(subchannel.length)*TOTAL_CAPACITY_UNIT_BITS));
+        }
+        m_cif_interleaver->process(m_cif_bits, frame_bits.subspan(nb_fic_bits + i*nb_cif_bits, nb_cif_bits));
+        m_cif_counter = (m_cif_counter+1) % TOTAL_CIF_COUNTER;
+    }
+}
+
+void pack_ofdm_frame_bytes(
+    tcb::span<const int> carrier_mapper,
+    tcb::span<const uint8_t> frame_bits,
+    tcb::span<uint8_t> frame_bytes)
+{
+    const size_t N = carrier_mapper.size();
+    const size_t nb_symbol_bits = 2*N;
+    const size_t nb_symbol_bytes = nb_symbol_bits/8;
+    const size_t nb_symbols = frame_bits.size()/nb_symbol_bits;
+    assert(frame_bits.size() == nb_symbols*nb_symbol_bits);
+    assert(frame_bytes.size() == nb_symbols*nb_symbol_bytes);
+
+    // DOC: ETSI EN 300 401
+    // Clause 14.5 - QPSK symbol mapper
+    // Phase index used by OFDM_Modulator for the logical bits (b0,b1) of a carrier
+    // Index: 0=(-1,-1), 1=(+1,-1), 2=(+1,+1), 3=(-1,+1)
+    // OFDM_Demod reads b0=1 from a negative real part and b1=1 from a positive imaginary part
+    const uint8_t PHASE_INDEX[2][2] = {
+        { 1, 2 },   // b0=0
+        { 0, 3 },   // b0=1
+    };
+
+    std::fill(frame_bytes.begin(), frame_bytes.end(), uint8_t(0));
+    for (size_t s = 0; s < nb_symbols; s++) {
+        const auto symbol_bits = frame_bits.subspan(s*nb_symbol_bits, nb_symbol_bits);
+        auto symbol_bytes = frame_bytes.subspan(s*nb_symbol_bytes, nb_symbol_bytes);
+        // Clause 14.6 - Frequency interleaving
+        for (size_t i = 0; i < N; i++) {
+            const size_t carrier = size_t(carrier_mapper[i]);
+            const uint8_t b0 = symbol_bits[i] & 0b1;
+            const uint8_t b1 = symbol_bits[N+i] & 0b1;
+            const uint8_t phase = PHASE_INDEX[b0][b1];
+            symbol_bytes[carrier/4] |= uint8_t(phase << (2*(carrier%4)));
+        }
+    }
+}
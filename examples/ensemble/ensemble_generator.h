@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "utility/span.h"
+#include "dab/constants/dab_parameters.h"
+#include "dab/database/dab_database_entities.h"
+#include "./ensemble_config.h"
+
+class FIC_Encoder;
+class MSC_Encoder;
+class CIF_Interleaver;
+class SubchannelSource;
+
+// Generates the transmission frames of a complete DAB ensemble
+// The FIC describes every service and the MSC carries a valid payload for each of them
+// These are convolutionally encoded, time interleaved and mapped onto the OFDM carriers
+class EnsembleGenerator
+{
+private:
+    struct Channel {
+        Subchannel subchannel;
+        std::unique_ptr<MSC_Encoder> encoder;
+        std::unique_ptr<SubchannelSource> source;
+        std::vector<uint8_t> bytes_buf;
+        explicit Channel(const Subchannel& _subchannel);
+    };
+    const EnsembleConfig m_config;
+    const DAB_Parameters m_params;
+    uint32_t m_cif_counter = 0;
+    std::unique_ptr<FIC_Encoder> m_fic_encoder;
+    std::unique_ptr<CIF_Interleaver> m_cif_interleaver;
+    std::vector<Channel> m_channels;
+    std::vector<uint8_t> m_cif_bits;
+    size_t m_total_capacity_units = 0;
+public:
+    // Throws std::runtime_error if the configuration can't fit into a valid ensemble
+    explicit EnsembleGenerator(const EnsembleConfig& config);
+    ~EnsembleGenerator();
+    EnsembleGenerator(EnsembleGenerator&) = delete;
+    EnsembleGenerator(EnsembleGenerator&&) = delete;
+    EnsembleGenerator& operator=(EnsembleGenerator&) = delete;
+    EnsembleGenerator& operator=(EnsembleGenerator&&) = delete;
+    size_t get_nb_frame_bits() const { return size_t(m_params.nb_frame_bits); }
+    size_t get_total_capacity_units() const { return m_total_capacity_units; }
+    // Bits of the FIC followed by the MSC with one bit per byte
+    // This is the same order as the soft decision bits from the OFDM demodulator
+    void generate_frame(tcb::span<uint8_t> frame_bits);
+private:
+    void create_channels();
+    void create_figs();
+};
+
+// Frequency interleaves the frame bits into the QPSK symbols for each carrier
+// The output is the packed format used by OFDM_Modulator::ProcessBlock
+void pack_ofdm_frame_bytes(
+    tcb::span<const int> carrier_mapper,
+    tcb::span<const uint8_t> frame_bits,
+    tcb::span<uint8_t> frame_bytes);
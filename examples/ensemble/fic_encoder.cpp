@@ -0,0 +1,133 @@
+#include "./fic_encoder.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+#include "dab/algorithms/crc.h"
+#include "dab/constants/puncture_codes.h"
+#include "./bit_writer.h"
+
+// DOC: ETSI EN 300 401
+// Clause 5.2.1 - Fast Information Block (FIB)
+// Same CRC16 as the FIC decoder
+static auto Generate_CRC_Calc() {
+    static const uint16_t crc16_poly = 0x1021;
+    static auto crc16_calc = new CRC_Calculator<uint16_t>(crc16_poly);
+    crc16_calc->SetInitialValue(0xFFFF);
+    crc16_calc->SetFinalXORValue(0xFFFF);
+    return crc16_calc;
+}
+
+static auto CRC16_CALC = Generate_CRC_Calc();
+
+// The length field of the FIG header has 5 bits but can't exceed the FIB
+constexpr size_t MAX_FIG_DATA_BYTES = FIC_Encoder::m_nb_fib_data_bytes-1;
+constexpr uint8_t FIB_END_MARKER = 0xFF;
+
+std::vector<uint8_t> create_fig(const uint8_t type, tcb::span<const uint8_t> data_field) {
+    assert(data_field.size() <= MAX_FIG_DATA_BYTES);
+    std::vector<uint8_t> fig;
+    fig.reserve(data_field.size()+1);
+    fig.push_back(uint8_t((type << 5) | uint8_t(data_field.size())));
+    fig.insert(fig.end(), data_field.begin(), data_field.end());
+    return fig;
+}
+
+std::vector<std::vector<uint8_t>> create_figs(
+    const uint8_t type, const uint8_t descriptor,
+    const std::vector<std::vector<uint8_t>>& entries)
+{
+    std::vector<std::vector<uint8_t>> figs;
+    std::vector<uint8_t> data_field;
+    for (const auto& entry: entries) {
+        assert(entry.size()+1 <= MAX_FIG_DATA_BYTES);
+        if (!data_field.empty() && (data_field.size()+entry.size() > MAX_FIG_DATA_BYTES)) {
+            figs.push_back(create_fig(type, data_field));
+            data_field.clear();
+        }
+        if (data_field.empty()) {
+            data_field.push_back(descriptor);
+        }
+        data_field.insert(data_field.end(), entry.begin(), entry.end());
+    }
+    if (!data_field.empty()) {
+        figs.push_back(create_fig(type, data_field));
+    }
+    return figs;
+}
+
+FIC_Encoder::FIC_Encoder() {
+    m_group_bytes.resize(m_nb_group_bytes);
+    m_group_bits.resize(m_nb_group_bytes*8);
+    m_scrambler.SetSyncword(0xFFFF);
+}
+
+void FIC_Encoder::add_fig(std::vector<uint8_t> fig) {
+    assert(fig.size() <= m_nb_fib_data_bytes);
+    m_carousel.push_back(std::move(fig));
+}
+
+void FIC_Encoder::encode_fib_group(tcb::span<const uint8_t> priority_fig, tcb::span<uint8_t> encoded_bits) {
+    assert(encoded_bits.size() == m_nb_encoded_bits);
+
+    for (size_t i = 0; i < m_nb_fibs_per_group; i++) {
+        auto fib_buf = tcb::span(m_group_bytes).subspan(i*m_nb_fib_bytes, m_nb_fib_bytes);
+        auto data_buf = fib_buf.first(m_nb_fib_data_bytes);
+        fill_fib(data_buf, (i == 0) ? priority_fig : tcb::span<const uint8_t>{});
+        const uint16_t crc16 = CRC16_CALC->Process(data_buf);
+        fib_buf[m_nb_fib_data_bytes+0] = uint8_t(crc16 >> 8);
+        fib_buf[m_nb_fib_data_bytes+1] = uint8_t(crc16 & 0xFF);
+    }
+
+    // DOC: ETSI EN 300 401
+    // Clause 10 - Energy dispersal
+    m_scrambler.Reset();
+    for (auto& b: m_group_bytes) {
+        b ^= m_scrambler.Process();
+    }
+    unpack_bits(m_group_bytes, m_group_bits);
+
+    // DOC: ETSI EN 300 401
+    // Clause 11.2 - Coding in the fast information channel
+    // PI_16 for the first 21 blocks, PI_15 for the last 3 blocks then PI_X for the tail
+    constexpr size_t nb_block_bits = 128/DAB_Convolutional_Encoder::m_code_rate;
+    auto input_bits = tcb::span<const uint8_t>(m_group_bits);
+    m_encoder.reset();
+    size_t N = 0;
+    N += m_encoder.encode(input_bits.first(21*nb_block_bits), GetPunctureCode(16), encoded_bits.subspan(N));
+    N += m_encoder.encode(input_bits.subspan(21*nb_block_bits), GetPunctureCode(15), encoded_bits.subspan(N));
+    N += m_encoder.encode_tail(encoded_bits.subspan(N));
+    assert(N == m_nb_encoded_bits);
+}
+
+void FIC_Encoder::fill_fib(tcb::span<uint8_t> fib_data, tcb::span<const uint8_t> priority_fig) {
+    size_t curr_byte = 0;
+    auto push_fig = [&](tcb::span<const uint8_t> fig) {
+        for (const uint8_t b: fig) fib_data[curr_byte++] = b;
+    };
+
+    if (!priority_fig.empty()) {
+        assert(priority_fig.size() <= fib_data.size());
+        push_fig(priority_fig);
+    }
+
+    // Keep the carousel order and move onto the next FIB when the next FIG can't fit
+    const size_t nb_figs = m_carousel.size();
+    for (size_t i = 0; i < nb_figs; i++) {
+        const auto& fig = m_carousel[m_curr_fig];
+        if (curr_byte+fig.size() > fib_data.size()) break;
+        push_fig(fig);
+        m_curr_fig = (m_curr_fig+1) % nb_figs;
+    }
+
+    // DOC: ETSI EN 300 401
+    // Clause 5.2.1 - Fast Information Block (FIB)
+    // An end marker is followed by zero padding if the FIB isn't full
+    if (curr_byte < fib_data.size()) {
+        fib_data[curr_byte++] = FIB_END_MARKER;
+    }
+    for (; curr_byte < fib_data.size(); curr_byte++) {
+        fib_data[curr_byte] = 0x00;
+    }
+}
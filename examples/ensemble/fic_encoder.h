@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+#include "dab/algorithms/additive_scrambler.h"
+#include "./dab_convolutional_encoder.h"
+
+// DOC: ETSI EN 300 401
+// Clause 5.2.2.0 - Introduction
+// Creates a FIG with its header given the type and data field
+// The data field of a FIG type 0 or 1 starts with its descriptor byte
+std::vector<uint8_t> create_fig(const uint8_t type, tcb::span<const uint8_t> data_field);
+
+// Splits a list of FIG entries across as many FIGs as required so that each one fits in a FIB
+// All FIGs share the same type and descriptor byte
+std::vector<std::vector<uint8_t>> create_figs(
+    const uint8_t type, const uint8_t descriptor,
+    const std::vector<std::vector<uint8_t>>& entries);
+
+// Inverse of FIC_Decoder for a single group of FIBs
+// FIGs are sent in a repeating carousel which is spread over every FIB
+class FIC_Encoder
+{
+public:
+    static constexpr size_t m_nb_fibs_per_group = 3;
+    static constexpr size_t m_nb_fib_data_bytes = 30;
+    static constexpr size_t m_nb_fib_bytes = m_nb_fib_data_bytes+2;
+    static constexpr size_t m_nb_group_bytes = m_nb_fibs_per_group*m_nb_fib_bytes;
+    static constexpr size_t m_nb_encoded_bits = 2304;
+private:
+    std::vector<std::vector<uint8_t>> m_carousel;
+    size_t m_curr_fig = 0;
+    AdditiveScrambler m_scrambler;
+    DAB_Convolutional_Encoder m_encoder;
+    std::vector<uint8_t> m_group_bytes;
+    std::vector<uint8_t> m_group_bits;
+public:
+    FIC_Encoder();
+    void add_fig(std::vector<uint8_t> fig);
+    // The priority FIG is placed at the start of the group, e.g. FIG 0/0 at the start of a frame
+    void encode_fib_group(tcb::span<const uint8_t> priority_fig, tcb::span<uint8_t> encoded_bits);
+private:
+    void fill_fib(tcb::span<uint8_t> fib_data, tcb::span<const uint8_t> priority_fig);
+};
@@ -0,0 +1,214 @@
+#include "./mot_slideshow_source.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "utility/span.h"
+#include "dab/algorithms/crc.h"
+#include "./bit_writer.h"
+#include "./test_image.h"
+
+// Same CRC16 for packets and data groups
+static auto CRC16_CALC = []() {
+    const uint16_t crc16_poly = 0b0001000000100001;
+    auto calc = new CRC_Calculator<uint16_t>(crc16_poly);
+    calc->SetInitialValue(0xFFFF);
+    calc->SetFinalXORValue(0xFFFF);
+    return calc;
+} ();
+
+// DOC: ETSI EN 300 401
+// Table 6: Packet length
+constexpr size_t TOTAL_PACKET_LENGTHS = 4;
+const size_t PACKET_LENGTH[TOTAL_PACKET_LENGTHS] = { 24, 48, 72, 96 };
+constexpr size_t NB_PACKET_HEADER_BYTES = 3;
+constexpr size_t NB_CRC16_BYTES = 2;
+
+// Table 7: First/Last flags for packet mode
+constexpr uint8_t PACKET_INTERMEDIATE = 0b00;
+constexpr uint8_t PACKET_LAST = 0b01;
+constexpr uint8_t PACKET_FIRST = 0b10;
+constexpr uint8_t PACKET_SINGLE = 0b11;
+
+// DOC: ETSI EN 301 234
+// Clause 5.1 - Segmentation of MOT entities
+constexpr uint8_t MOT_DATA_GROUP_HEADER = 3;
+constexpr uint8_t MOT_DATA_GROUP_BODY = 4;
+constexpr size_t MOT_MAX_BODY_SEGMENT_SIZE = 2048;
+
+// DOC: ETSI TS 101 756
+// Table 17 - Content type and content subtypes
+constexpr uint8_t MOT_CONTENT_TYPE_IMAGE = 2;
+constexpr uint16_t MOT_CONTENT_SUBTYPE_PNG = 3;
+
+constexpr uint32_t SLIDE_WIDTH = 64;
+constexpr uint32_t SLIDE_HEIGHT = 48;
+constexpr uint32_t TOTAL_CAROUSEL_IMAGES = 8;
+
+// Use the largest packet size that evenly divides the subchannel
+// Packets then never cross CIF boundaries and don't need padding packets
+static size_t get_packet_length(const size_t nb_cif_bytes) {
+    for (size_t i = TOTAL_PACKET_LENGTHS; i > 0; i--) {
+        const size_t length = PACKET_LENGTH[i-1];
+        if (nb_cif_bytes % length == 0) return length;
+    }
+    assert(false && "Subchannel size must be a multiple of the minimum packet length");
+    return PACKET_LENGTH[0];
+}
+
+MOT_Slideshow_Source::MOT_Slideshow_Source(const size_t nb_cif_bytes, const uint16_t packet_address)
+: m_nb_cif_bytes(nb_cif_bytes),
+  m_packet_address(packet_address),
+  m_packet_length(get_packet_length(nb_cif_bytes))
+{
+    assert(packet_address < (1u << 10));
+}
+
+void MOT_Slideshow_Source::fill_cif(tcb::span<uint8_t> buf) {
+    assert(buf.size() == m_nb_cif_bytes);
+    const size_t nb_packets = m_nb_cif_bytes/m_packet_length;
+    for (size_t i = 0; i < nb_packets; i++) {
+        write_packet(buf.subspan(i*m_packet_length, m_packet_length));
+    }
+}
+
+void MOT_Slideshow_Source::write_packet(tcb::span<uint8_t> packet) {
+    if (m_data_groups.empty()) {
+        push_next_slide();
+    }
+    const auto& data_group = m_data_groups.front();
+
+    const size_t nb_data_field_bytes = m_packet_length - NB_PACKET_HEADER_BYTES - NB_CRC16_BYTES;
+    const size_t nb_remain_bytes = data_group.size() - m_curr_data_group_byte;
+    const size_t nb_useful_bytes = std::min(nb_data_field_bytes, nb_remain_bytes);
+    const bool is_first = (m_curr_data_group_byte == 0);
+    const bool is_last = (nb_useful_bytes == nb_remain_bytes);
+    uint8_t location = PACKET_INTERMEDIATE;
+    if (is_first && is_last) {
+        location = PACKET_SINGLE;
+    } else if (is_first) {
+        location = PACKET_FIRST;
+    } else if (is_last) {
+        location = PACKET_LAST;
+    }
+
+    // DOC: ETSI EN 300 401
+    // Clause 5.3.2.1 - Packet header
+    std::fill(packet.begin(), packet.end(), uint8_t(0));
+    size_t length_id = 0;
+    while (PACKET_LENGTH[length_id] != m_packet_length) length_id++;
+    auto writer = BitWriter(packet);
+    writer.write(uint32_t(length_id), 2);
+    writer.write(m_packet_continuity_index, 2);
+    writer.write(location, 2);
+    writer.write(m_packet_address, 10);
+    writer.write(0, 1);         // command flag = data
+    writer.write(uint32_t(nb_useful_bytes), 7);
+
+    // Clause 5.3.2.2 - Packet data field with zero padding
+    auto data_field = packet.subspan(NB_PACKET_HEADER_BYTES, nb_data_field_bytes);
+    std::copy_n(data_group.begin()+ptrdiff_t(m_curr_data_group_byte), nb_useful_bytes, data_field.begin());
+
+    // Clause 5.3.2.3 - Packet CRC
+    const uint16_t crc16 = CRC16_CALC->Process(packet.first(m_packet_length-NB_CRC16_BYTES));
+    packet[m_packet_length-2] = uint8_t(crc16 >> 8);
+    packet[m_packet_length-1] = uint8_t(crc16 & 0xFF);
+
+    // The receiver checks continuity across all packets in the subchannel
+    m_packet_continuity_index = uint8_t((m_packet_continuity_index+1) % 4);
+    m_curr_data_group_byte += nb_useful_bytes;
+    if (is_last) {
+        m_data_groups.pop_front();
+        m_curr_data_group_byte = 0;
+    }
+}
+
+void MOT_Slideshow_Source::push_next_slide() {
+    const uint32_t image_index = m_slide_index % TOTAL_CAROUSEL_IMAGES;
+    const auto body = create_test_png(SLIDE_WIDTH, SLIDE_HEIGHT, image_index);
+    const std::string name = "slide_" + std::to_string(image_index) + ".png";
+
+    // DOC: ETSI EN 301 234
+    // Clause 6.1 - Header core
+    // Clause 6.2 - Header extension with the ContentName parameter
+    constexpr size_t NB_HEADER_CORE_BYTES = 7;
+    const size_t nb_content_name_bytes = 3 + name.size();
+    const size_t nb_header_bytes = NB_HEADER_CORE_BYTES + nb_content_name_bytes;
+    std::vector<uint8_t> header(nb_header_bytes, 0);
+    {
+        auto writer = BitWriter(header);
+        writer.write(uint32_t(body.size()), 28);
+        writer.write(uint32_t(nb_header_bytes), 13);
+        writer.write(MOT_CONTENT_TYPE_IMAGE, 6);
+        writer.write(MOT_CONTENT_SUBTYPE_PNG, 9);
+        // pli=0b11 with param_id=0x0C for ContentName
+        writer.write(0b11, 2);
+        writer.write(0x0C, 6);
+        writer.write(0, 1);     // data field length indicator extension
+        writer.write(uint32_t(1 + name.size()), 7);
+        writer.write(0, 4);     // charset = EBU Latin based repertoire
+        writer.write(0, 4);     // rfa
+        for (const char c: name) writer.write(uint8_t(c), 8);
+    }
+    push_data_group(MOT_DATA_GROUP_HEADER, 0, true, header);
+
+    const size_t nb_segments = (body.size() + MOT_MAX_BODY_SEGMENT_SIZE-1) / MOT_MAX_BODY_SEGMENT_SIZE;
+    for (size_t i = 0; i < nb_segments; i++) {
+        const size_t start = i*MOT_MAX_BODY_SEGMENT_SIZE;
+        const size_t length = std::min(MOT_MAX_BODY_SEGMENT_SIZE, body.size()-start);
+        const bool is_last = (i == nb_segments-1);
+        push_data_group(MOT_DATA_GROUP_BODY, uint16_t(i), is_last, tcb::span(body).subspan(start, length));
+    }
+
+    m_slide_index++;
+    m_transport_id++;
+}
+
+void MOT_Slideshow_Source::push_data_group(
+    const uint8_t type, const uint16_t segment_number, const bool is_last,
+    tcb::span<const uint8_t> segment)
+{
+    constexpr size_t NB_DATA_GROUP_HEADER_BYTES = 2;
+    constexpr size_t NB_SEGMENT_FIELD_BYTES = 2;
+    constexpr size_t NB_USER_ACCESS_BYTES = 3;
+    constexpr size_t NB_SEGMENT_HEADER_BYTES = 2;
+    const size_t nb_bytes =
+        NB_DATA_GROUP_HEADER_BYTES + NB_SEGMENT_FIELD_BYTES + NB_USER_ACCESS_BYTES +
+        NB_SEGMENT_HEADER_BYTES + segment.size() + NB_CRC16_BYTES;
+
+    uint8_t& continuity_index = (type == MOT_DATA_GROUP_HEADER) ? m_header_continuity_index : m_body_continuity_index;
+
+    std::vector<uint8_t> data_group(nb_bytes, 0);
+    auto writer = BitWriter(data_group);
+    // DOC: ETSI EN 300 401
+    // Clause 5.3.3.1 - MSC data group header
+    writer.write(0, 1);         // extension flag
+    writer.write(1, 1);         // crc flag
+    writer.write(1, 1);         // segment flag
+    writer.write(1, 1);         // user access flag
+    writer.write(type, 4);
+    writer.write(continuity_index, 4);
+    writer.write(0, 4);         // repetition index
+    // Clause 5.3.3.2 - Session header
+    writer.write(is_last ? 1 : 0, 1);
+    writer.write(segment_number, 15);
+    writer.write(0, 3);         // rfa
+    writer.write(1, 1);         // transport id flag
+    writer.write(2, 4);         // length indicator
+    writer.write(m_transport_id, 16);
+    // DOC: ETSI EN 301 234
+    // Clause 5.1.1 - Segmentation header
+    writer.write(0, 3);         // repetition count
+    writer.write(uint32_t(segment.size()), 13);
+    for (const uint8_t b: segment) writer.write(b, 8);
+
+    // Clause 5.3.3.4 - MSC data group CRC
+    const uint16_t crc16 = CRC16_CALC->Process(tcb::span(data_group).first(nb_bytes-NB_CRC16_BYTES));
+    data_group[nb_bytes-2] = uint8_t(crc16 >> 8);
+    data_group[nb_bytes-1] = uint8_t(crc16 & 0xFF);
+
+    continuity_index = uint8_t((continuity_index+1) % 16);
+    m_data_groups.push_back(std::move(data_group));
+}
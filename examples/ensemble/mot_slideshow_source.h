@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "utility/span.h"
+#include "./subchannel_source.h"
+
+// DOC: ETSI EN 300 401
+// Clause 5.3.2 - Packet mode - network level
+// Clause 5.3.3 - Packet mode - data group level
+// DOC: ETSI EN 301 234
+// Clause 5.3.1 - Single object transmission (MOT header mode)
+// Sends a carousel of PNG slides as MOT objects in packet mode
+// Every slide gets a new transport id so the receiver reassembles each one
+// The images repeat after a few slides like a station's carousel
+class MOT_Slideshow_Source: public SubchannelSource
+{
+private:
+    const size_t m_nb_cif_bytes;
+    const uint16_t m_packet_address;
+    const size_t m_packet_length;
+    uint16_t m_transport_id = 0;
+    uint32_t m_slide_index = 0;
+    uint8_t m_packet_continuity_index = 0;
+    uint8_t m_header_continuity_index = 0;
+    uint8_t m_body_continuity_index = 0;
+    // data groups that are waiting to be packetised
+    std::deque<std::vector<uint8_t>> m_data_groups;
+    size_t m_curr_data_group_byte = 0;
+public:
+    MOT_Slideshow_Source(const size_t nb_cif_bytes, const uint16_t packet_address);
+    void fill_cif(tcb::span<uint8_t> buf) override;
+private:
+    void push_next_slide();
+    void push_data_group(const uint8_t type, const uint16_t segment_number, const bool is_last, tcb::span<const uint8_t> segment);
+    void write_packet(tcb::span<uint8_t> packet);
+};
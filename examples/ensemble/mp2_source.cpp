@@ -0,0 +1,124 @@
+#include "./mp2_source.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include "utility/span.h"
+#include "./bit_writer.h"
+
+// DOC: ISO/IEC 11172-3
+// Clause 2.4.2.3 - Header
+// Bitrates for layer II where mono is limited to 192kbps
+constexpr int TOTAL_BITRATES = 10;
+const int MONO_BITRATES_KBPS[TOTAL_BITRATES] = { 32, 48, 56, 64, 80, 96, 112, 128, 160, 192 };
+
+// Number of bits for the allocation of each subband
+// Table 3-B.2c (low rate, 32 to 48kbps) and Table 3-B.2a (high rate, 56kbps+) at 48kHz
+static int get_nb_allocation_bits(const bool is_low_rate, const int subband) {
+    if (is_low_rate) {
+        return (subband < 2) ? 4 : 3;
+    }
+    if (subband < 11) return 4;
+    if (subband < 23) return 3;
+    return 2;
+}
+
+// DOC: ISO/IEC 11172-3
+// Clause 2.4.3.1 - CRC check
+// G(x) = x^16 + x^15 + x^2 + 1 with an initial value of all 1s
+static uint16_t update_crc16(uint16_t crc, tcb::span<const uint8_t> buf, const size_t start_bit, const size_t end_bit) {
+    for (size_t i = start_bit; i < end_bit; i++) {
+        const uint8_t bit = (buf[i/8] >> (7 - (i % 8))) & 0b1;
+        const bool is_feedback = ((crc >> 15) & 0b1) != bit;
+        crc = uint16_t(crc << 1);
+        if (is_feedback) crc ^= 0x8005;
+    }
+    return crc;
+}
+
+bool MP2_Source::is_bitrate_supported(const int bitrate_kbps) {
+    for (int i = 0; i < TOTAL_BITRATES; i++) {
+        if (MONO_BITRATES_KBPS[i] == bitrate_kbps) return true;
+    }
+    return false;
+}
+
+MP2_Source::MP2_Source(const int bitrate_kbps)
+// 1152 samples at 48kHz is 24ms which is the length of a CIF
+: m_bitrate_kbps(bitrate_kbps),
+  m_nb_frame_bytes(size_t(bitrate_kbps)*3)
+{
+    m_bitrate_index = -1;
+    for (int i = 0; i < TOTAL_BITRATES; i++) {
+        if (MONO_BITRATES_KBPS[i] == bitrate_kbps) m_bitrate_index = i;
+    }
+    assert(m_bitrate_index >= 0);
+}
+
+uint32_t MP2_Source::get_random() {
+    // xorshift32
+    m_rng_state ^= m_rng_state << 13;
+    m_rng_state ^= m_rng_state >> 17;
+    m_rng_state ^= m_rng_state << 5;
+    return m_rng_state;
+}
+
+void MP2_Source::fill_cif(tcb::span<uint8_t> buf) {
+    assert(buf.size() == m_nb_frame_bytes);
+    std::fill(buf.begin(), buf.end(), uint8_t(0));
+    auto writer = BitWriter(buf);
+
+    // DOC: ISO/IEC 11172-3
+    // Clause 2.4.1.3 - Header
+    writer.write(0xFFF, 12);    // syncword
+    writer.write(1, 1);         // id = MPEG-1
+    writer.write(0b10, 2);      // layer = II
+    writer.write(0, 1);         // protection_bit = crc present
+    writer.write(uint32_t(m_bitrate_index+1), 4);
+    writer.write(0b01, 2);      // sampling_frequency = 48kHz
+    writer.write(0, 1);         // padding_bit
+    writer.write(0, 1);         // private_bit
+    writer.write(0b11, 2);      // mode = single channel
+    writer.write(0, 2);         // mode_extension
+    writer.write(0, 1);         // copyright
+    writer.write(0, 1);         // original
+    writer.write(0, 2);         // emphasis
+    const size_t crc_bit = writer.get_curr_bit();
+    writer.write(0, 16);        // crc_check is filled in afterwards
+
+    // Clause 2.4.3.3 - Audio data, layer II
+    // 32 and 48kbps use the low rate table with 8 subbands
+    const bool is_low_rate = m_bitrate_kbps <= 48;
+    const int sblimit = is_low_rate ? 8 : 27;
+    const int nb_noise_subbands = std::min(sblimit, 8);
+
+    // allocation of 1 selects 3 level grouped quantisation in all tables
+    for (int sb = 0; sb < sblimit; sb++) {
+        const uint32_t allocation = (sb < nb_noise_subbands) ? 1 : 0;
+        writer.write(allocation, get_nb_allocation_bits(is_low_rate, sb));
+    }
+    // scfsi=2 sends one scalefactor for all 3 parts
+    for (int sb = 0; sb < nb_noise_subbands; sb++) {
+        writer.write(2, 2);
+    }
+    const size_t crc_end_bit = writer.get_curr_bit();
+    for (int sb = 0; sb < nb_noise_subbands; sb++) {
+        writer.write(30, 6);
+    }
+    // 3 parts with 4 granules of grouped samples
+    constexpr uint32_t TOTAL_GROUPED_CODES = 3*3*3;
+    for (int i = 0; i < 3*4; i++) {
+        for (int sb = 0; sb < nb_noise_subbands; sb++) {
+            writer.write(get_random() % TOTAL_GROUPED_CODES, 5);
+        }
+    }
+    // Remaining bytes are ancillary data which includes the ScF-CRC and F-PAD
+    // These are left as zero which signals no PAD to the receiver
+
+    // Clause 2.4.3.1 - CRC check covers the last 16bits of the header and the side information
+    uint16_t crc16 = 0xFFFF;
+    crc16 = update_crc16(crc16, buf, 16, 32);
+    crc16 = update_crc16(crc16, buf, crc_bit+16, crc_end_bit);
+    buf[crc_bit/8+0] = uint8_t(crc16 >> 8);
+    buf[crc_bit/8+1] = uint8_t(crc16 & 0xFF);
+}
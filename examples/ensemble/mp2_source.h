@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utility/span.h"
+#include "./subchannel_source.h"
+
+// DOC: ETSI EN 300 401
+// Clause 7.2 - Audio coding
+// Creates MPEG-1 Layer II mono frames at 48kHz with one frame per CIF
+// The lower subbands carry low level noise so the synthesis filterbank does real work
+class MP2_Source: public SubchannelSource
+{
+private:
+    const int m_bitrate_kbps;
+    const size_t m_nb_frame_bytes;
+    int m_bitrate_index;
+    uint32_t m_rng_state = 0x12345678;
+public:
+    explicit MP2_Source(const int bitrate_kbps);
+    void fill_cif(tcb::span<uint8_t> buf) override;
+    static bool is_bitrate_supported(const int bitrate_kbps);
+private:
+    uint32_t get_random();
+};
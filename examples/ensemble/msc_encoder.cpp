@@ -0,0 +1,103 @@
+#include "./msc_encoder.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "utility/span.h"
+#include "dab/constants/puncture_codes.h"
+#include "dab/constants/subchannel_protection_tables.h"
+#include "./bit_writer.h"
+
+constexpr size_t TOTAL_CAPACITY_UNIT_BITS = 64;
+// Each puncture code is applied over blocks of 128 encoded bits from the mother code
+constexpr size_t TOTAL_BLOCK_INPUT_BITS = 128/DAB_Convolutional_Encoder::m_code_rate;
+
+MSC_Encoder::MSC_Encoder(const Subchannel& subchannel)
+: m_subchannel(subchannel),
+  m_nb_encoded_bits(size_t(subchannel.length)*TOTAL_CAPACITY_UNIT_BITS)
+{
+    size_t nb_input_bits = 0;
+    if (!m_subchannel.is_uep) {
+        const auto descriptor = GetEEPDescriptor(m_subchannel);
+        const int n = m_subchannel.length / descriptor.capacity_unit_multiple;
+        for (int i = 0; i < EEP_Descriptor::TOTAL_PUNCTURE_CODES; i++) {
+            nb_input_bits += size_t(descriptor.Lx[i].GetLx(n))*TOTAL_BLOCK_INPUT_BITS;
+        }
+    } else {
+        const auto descriptor = GetUEPDescriptor(m_subchannel);
+        for (int i = 0; i < UEP_Descriptor::TOTAL_PUNCTURE_CODES; i++) {
+            nb_input_bits += size_t(descriptor.Lx[i])*TOTAL_BLOCK_INPUT_BITS;
+        }
+    }
+    assert(nb_input_bits % 8 == 0);
+    m_nb_input_bytes = nb_input_bits/8;
+    m_input_bits.resize(nb_input_bits);
+    m_scrambler.SetSyncword(0xFFFF);
+}
+
+void MSC_Encoder::encode(tcb::span<const uint8_t> input_bytes, tcb::span<uint8_t> encoded_bits) {
+    assert(input_bytes.size() == m_nb_input_bytes);
+    assert(encoded_bits.size() == m_nb_encoded_bits);
+
+    // DOC: ETSI EN 300 401
+    // Clause 10 - Energy dispersal
+    m_scrambler.Reset();
+    for (size_t i = 0; i < m_nb_input_bytes; i++) {
+        const uint8_t b = input_bytes[i] ^ m_scrambler.Process();
+        unpack_bits({&b, 1}, tcb::span(m_input_bits).subspan(i*8, 8));
+    }
+
+    m_encoder.reset();
+    size_t nb_written = 0;
+    if (!m_subchannel.is_uep) {
+        nb_written = encode_eep(encoded_bits);
+    } else {
+        nb_written = encode_uep(encoded_bits);
+    }
+    nb_written += m_encoder.encode_tail(encoded_bits.subspan(nb_written));
+
+    // UEP profiles can have padding bits after the tail which the decoder ignores
+    assert(nb_written <= m_nb_encoded_bits);
+    for (size_t i = nb_written; i < m_nb_encoded_bits; i++) {
+        encoded_bits[i] = 0;
+    }
+}
+
+size_t MSC_Encoder::encode_eep(tcb::span<uint8_t> encoded_bits) {
+    const auto descriptor = GetEEPDescriptor(m_subchannel);
+    const int n = m_subchannel.length / descriptor.capacity_unit_multiple;
+
+    // DOC: ETSI EN 300 401
+    // Clause 11.3.2 - Equal Error Protection (EEP) coding
+    size_t curr_input_bit = 0;
+    size_t curr_encoded_bit = 0;
+    for (int i = 0; i < EEP_Descriptor::TOTAL_PUNCTURE_CODES; i++) {
+        const size_t nb_input_bits = size_t(descriptor.Lx[i].GetLx(n))*TOTAL_BLOCK_INPUT_BITS;
+        const auto puncture_code = GetPunctureCode(descriptor.PIx[i]);
+        curr_encoded_bit += m_encoder.encode(
+            tcb::span(m_input_bits).subspan(curr_input_bit, nb_input_bits),
+            puncture_code, encoded_bits.subspan(curr_encoded_bit)
+        );
+        curr_input_bit += nb_input_bits;
+    }
+    return curr_encoded_bit;
+}
+
+size_t MSC_Encoder::encode_uep(tcb::span<uint8_t> encoded_bits) {
+    const auto descriptor = GetUEPDescriptor(m_subchannel);
+
+    // DOC: ETSI EN 300 401
+    // Clause 11.3.1 - Unequal Error Protection (UEP) coding
+    size_t curr_input_bit = 0;
+    size_t curr_encoded_bit = 0;
+    for (int i = 0; i < UEP_Descriptor::TOTAL_PUNCTURE_CODES; i++) {
+        const size_t nb_input_bits = size_t(descriptor.Lx[i])*TOTAL_BLOCK_INPUT_BITS;
+        if (nb_input_bits == 0) continue;
+        const auto puncture_code = GetPunctureCode(descriptor.PIx[i]);
+        curr_encoded_bit += m_encoder.encode(
+            tcb::span(m_input_bits).subspan(curr_input_bit, nb_input_bits),
+            puncture_code, encoded_bits.subspan(curr_encoded_bit)
+        );
+        curr_input_bit += nb_input_bits;
+    }
+    return curr_encoded_bit;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+#include "dab/algorithms/additive_scrambler.h"
+#include "dab/database/dab_database_entities.h"
+#include "./dab_convolutional_encoder.h"
+
+// Inverse of MSC_Decoder without the time interleaving
+// Time interleaving is done over the entire CIF by CIF_Interleaver
+class MSC_Encoder
+{
+private:
+    const Subchannel m_subchannel;
+    const size_t m_nb_encoded_bits;
+    size_t m_nb_input_bytes;
+    AdditiveScrambler m_scrambler;
+    DAB_Convolutional_Encoder m_encoder;
+    std::vector<uint8_t> m_input_bits;
+public:
+    explicit MSC_Encoder(const Subchannel& subchannel);
+    // Number of bytes the subchannel carries in each CIF
+    size_t get_nb_input_bytes() const { return m_nb_input_bytes; }
+    size_t get_nb_encoded_bits() const { return m_nb_encoded_bits; }
+    void encode(tcb::span<const uint8_t> input_bytes, tcb::span<uint8_t> encoded_bits);
+private:
+    size_t encode_eep(tcb::span<uint8_t> encoded_bits);
+    size_t encode_uep(tcb::span<uint8_t> encoded_bits);
+};
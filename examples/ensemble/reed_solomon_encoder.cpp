@@ -0,0 +1,78 @@
+#include "./reed_solomon_encoder.h"
+#include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+#include "utility/span.h"
+
+// Follows Phil Karn's encode_rs_char which is what the decoder is taken from
+// Refer to reed_solomon_decoder.cpp for a link to the original code
+constexpr int MM = 8;
+constexpr int NN = (1 << MM)-1;
+constexpr int A0 = NN;
+
+static inline int modnn(int x) {
+    while (x >= NN) {
+        x -= NN;
+        x = (x >> MM) + (x & NN);
+    }
+    return x;
+}
+
+Reed_Solomon_Encoder::Reed_Solomon_Encoder(
+    const int galois_field_polynomial,
+    const int fcr, const int prim, const int nb_roots)
+: m_nb_roots(nb_roots)
+{
+    assert((nb_roots > 0) && (nb_roots < NN));
+    m_alpha_to.resize(NN+1, 0);
+    m_index_of.resize(NN+1, 0);
+    m_genpoly.resize(size_t(nb_roots)+1, 0);
+
+    // Galois field lookup tables
+    m_index_of[0] = A0;
+    m_alpha_to[A0] = 0;
+    int sr = 1;
+    for (int i = 0; i < NN; i++) {
+        m_index_of[sr] = uint8_t(i);
+        m_alpha_to[i] = uint8_t(sr);
+        sr <<= 1;
+        if (sr & (1 << MM)) sr ^= galois_field_polynomial;
+        sr &= NN;
+    }
+    assert(sr == 1 && "Field generator polynomial is not primitive");
+
+    // Generator polynomial from the product of (x + alpha^root)
+    auto& genpoly = m_genpoly;
+    genpoly[0] = 1;
+    for (int i = 0, root = fcr*prim; i < nb_roots; i++, root += prim) {
+        genpoly[i+1] = 1;
+        for (int j = i; j > 0; j--) {
+            if (genpoly[j] != 0) {
+                genpoly[j] = genpoly[j-1] ^ m_alpha_to[modnn(m_index_of[genpoly[j]] + root)];
+            } else {
+                genpoly[j] = genpoly[j-1];
+            }
+        }
+        genpoly[0] = m_alpha_to[modnn(m_index_of[genpoly[0]] + root)];
+    }
+    // Convert to index form for quicker encoding
+    for (auto& v: genpoly) {
+        v = m_index_of[v];
+    }
+}
+
+void Reed_Solomon_Encoder::encode(tcb::span<const uint8_t> data, tcb::span<uint8_t> parity) const {
+    assert(parity.size() == size_t(m_nb_roots));
+    assert(data.size()+parity.size() <= size_t(NN));
+    std::fill(parity.begin(), parity.end(), uint8_t(0));
+    for (const uint8_t x: data) {
+        const int feedback = m_index_of[x ^ parity[0]];
+        if (feedback != A0) {
+            for (int j = 1; j < m_nb_roots; j++) {
+                parity[j] ^= m_alpha_to[modnn(feedback + m_genpoly[m_nb_roots-j])];
+            }
+        }
+        std::copy(parity.begin()+1, parity.end(), parity.begin());
+        parity[m_nb_roots-1] = (feedback != A0) ? m_alpha_to[modnn(feedback + m_genpoly[0])] : uint8_t(0);
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+
+// Systematic Reed Solomon encoder over GF(2^8) 
+// This produces parity bytes that Reed_Solomon_Decoder accepts for the same parameters
+// Shortened codes are supported since leading zero padding doesn't change the parity
+class Reed_Solomon_Encoder
+{
+private:
+    const int m_nb_roots;
+    std::vector<uint8_t> m_alpha_to;
+    std::vector<uint8_t> m_index_of;
+    std::vector<uint8_t> m_genpoly;
+public:
+    Reed_Solomon_Encoder(
+        const int galois_field_polynomial,
+        const int fcr, const int prim, const int nb_roots);
+    int get_nb_roots() const { return m_nb_roots; }
+    void encode(tcb::span<const uint8_t> data, tcb::span<uint8_t> parity) const;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+#include "utility/span.h"
+
+// Produces the logical frames that a subchannel carries in each CIF
+class SubchannelSource
+{
+public:
+    virtual ~SubchannelSource() = default;
+    virtual void fill_cif(tcb::span<uint8_t> buf) = 0;
+};
@@ -0,0 +1,115 @@
+#include "./test_image.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+static uint32_t calculate_crc32(const uint8_t* buf, const size_t N) {
+    // DOC: ISO/IEC 15948
+    // Annex D - Sample CRC implementation
+    static const auto CRC32_TABLE = []() {
+        struct Table { uint32_t values[256]; } table;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int j = 0; j < 8; j++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            table.values[i] = c;
+        }
+        return table;
+    } ();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < N; i++) {
+        crc = CRC32_TABLE.values[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static uint32_t calculate_adler32(const uint8_t* buf, const size_t N) {
+    constexpr uint32_t MOD_ADLER = 65521;
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < N; i++) {
+        a = (a + buf[i]) % MOD_ADLER;
+        b = (b + a) % MOD_ADLER;
+    }
+    return (b << 16) | a;
+}
+
+static void push_u32_be(std::vector<uint8_t>& buf, const uint32_t x) {
+    buf.push_back(uint8_t(x >> 24));
+    buf.push_back(uint8_t(x >> 16));
+    buf.push_back(uint8_t(x >> 8));
+    buf.push_back(uint8_t(x >> 0));
+}
+
+static void push_chunk(std::vector<uint8_t>& png, const char type[4], const std::vector<uint8_t>& data) {
+    push_u32_be(png, uint32_t(data.size()));
+    const size_t crc_start = png.size();
+    png.insert(png.end(), type, type+4);
+    png.insert(png.end(), data.begin(), data.end());
+    push_u32_be(png, calculate_crc32(&png[crc_start], png.size()-crc_start));
+}
+
+std::vector<uint8_t> create_test_png(const uint32_t width, const uint32_t height, const uint32_t index) {
+    assert((width > 0) && (height > 0));
+
+    // Each scanline starts with the filter type which is none
+    std::vector<uint8_t> raw;
+    raw.reserve(size_t(height)*(size_t(width)*3+1));
+    const uint32_t nb_index_bits = 16;
+    const uint32_t bar_width = (width >= nb_index_bits) ? width/nb_index_bits : 1;
+    for (uint32_t y = 0; y < height; y++) {
+        raw.push_back(0);
+        for (uint32_t x = 0; x < width; x++) {
+            // gradient that moves with the index and a row of bars with the bits of the index
+            uint8_t r = uint8_t((x*255)/width + index*7);
+            uint8_t g = uint8_t((y*255)/height + index*13);
+            uint8_t b = uint8_t(index*29);
+            if (y < height/4) {
+                const uint32_t bit = x/bar_width;
+                const bool is_set = (bit < nb_index_bits) && ((index >> bit) & 0b1);
+                r = g = b = is_set ? 255 : 0;
+            }
+            raw.push_back(r);
+            raw.push_back(g);
+            raw.push_back(b);
+        }
+    }
+
+    // DOC: RFC 1950 and RFC 1951
+    // zlib stream with deflate stored blocks
+    std::vector<uint8_t> zlib;
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    constexpr size_t MAX_STORED_BLOCK_SIZE = 65535;
+    size_t curr_byte = 0;
+    do {
+        const size_t N = std::min(MAX_STORED_BLOCK_SIZE, raw.size()-curr_byte);
+        const bool is_final = (curr_byte+N) == raw.size();
+        zlib.push_back(is_final ? 0x01 : 0x00);
+        zlib.push_back(uint8_t(N & 0xFF));
+        zlib.push_back(uint8_t(N >> 8));
+        zlib.push_back(uint8_t(~N & 0xFF));
+        zlib.push_back(uint8_t((~N >> 8) & 0xFF));
+        zlib.insert(zlib.end(), raw.begin()+ptrdiff_t(curr_byte), raw.begin()+ptrdiff_t(curr_byte+N));
+        curr_byte += N;
+    } while (curr_byte < raw.size());
+    push_u32_be(zlib, calculate_adler32(raw.data(), raw.size()));
+
+    // DOC: ISO/IEC 15948
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> ihdr;
+    push_u32_be(ihdr, width);
+    push_u32_be(ihdr, height);
+    ihdr.push_back(8);  // bit depth
+    ihdr.push_back(2);  // colour type = truecolour
+    ihdr.push_back(0);  // compression method
+    ihdr.push_back(0);  // filter method
+    ihdr.push_back(0);  // interlace method
+    push_chunk(png, "IHDR", ihdr);
+    push_chunk(png, "IDAT", zlib);
+    push_chunk(png, "IEND", {});
+    return png;
+}
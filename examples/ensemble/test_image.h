@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Creates an uncompressed RGB PNG with a pattern that is unique for each index
+// This lets a slideshow carousel send distinct images without an image encoder
+std::vector<uint8_t> create_test_png(const uint32_t width, const uint32_t height, const uint32_t index);
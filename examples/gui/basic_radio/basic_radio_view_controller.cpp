@@ -5,12 +5,15 @@
 #include <stdint.h>
 #include <memory>
 #include "dab/database/dab_database_types.h"
+#include "basic_radio/basic_slideshow.h"
 #include "dab/mot/MOT_entities.h"
-#include "utility/span.h"
+#include "./decoded_image_cache.h"
 #include "./texture.h"
 
-BasicRadioViewController::BasicRadioViewController(const size_t _max_textures) {
-    textures.set_max_size(_max_textures);
+BasicRadioViewController::BasicRadioViewController(const size_t _max_textures, const size_t _max_decoded_images)
+: textures(_max_textures)
+{
+    image_cache = std::make_unique<DecodedImageCache>(_max_decoded_images);
     services_filter = std::make_unique<ImGuiTextFilter>();
 }
 
@@ -20,14 +23,24 @@ static uint32_t get_key(subchannel_id_t subchannel_id, mot_transport_id_t transp
     return (subchannel_id << 16) | transport_id;
 }
 
-Texture& BasicRadioViewController::GetTexture(
-    subchannel_id_t subchannel_id, mot_transport_id_t transport_id, tcb::span<const uint8_t> data
-) {
-    const auto key = get_key(subchannel_id, transport_id);
-    auto res = textures.find(key);
-    if (res == nullptr) {
-        auto& texture = textures.emplace(key, std::make_unique<Texture>(data));
-        return *(texture.get());
+Texture* BasicRadioViewController::GetTexture(subchannel_id_t subchannel_id, const Basic_Slideshow& slideshow) {
+    const auto key = get_key(subchannel_id, slideshow.transport_id);
+    auto* res = textures.find(key);
+    if ((res != nullptr) && (res->image_hash == slideshow.image_hash)) {
+        return res->texture.get();
     }
-    return *(res->get());
+
+    // only upload once the background decode has finished
+    auto image = image_cache->Get(key, slideshow.image_hash, slideshow.image_data);
+    if (image == nullptr) {
+        return nullptr;
+    }
+    // failed decodes stay cached so they aren't retried but have no bitmap to upload
+    if (!image->is_success) {
+        return nullptr;
+    }
+    auto& entry = textures.emplace(key);
+    entry.image_hash = slideshow.image_hash;
+    entry.texture = std::make_unique<Texture>(image->width, image->height, image->rgba);
+    return entry.texture.get();
 }
\ No newline at end of file
@@ -5,9 +5,8 @@
 #include <memory>
 #include <optional>
 #include "dab/database/dab_database_types.h"
-#include "dab/mot/MOT_entities.h"
 #include "utility/lru_cache.h"
-#include "utility/span.h"
+#include "./decoded_image_cache.h"
 #include "./texture.h"
 
 struct Basic_Slideshow;
@@ -22,13 +21,19 @@ struct SlideshowView {
 class BasicRadioViewController
 {
 private:
-    LRU_Cache<uint32_t, std::unique_ptr<Texture>> textures;
+    struct TextureEntry {
+        uint64_t image_hash = 0;
+        std::unique_ptr<Texture> texture = nullptr;
+    };
+    LRU_Cache<uint32_t, TextureEntry> textures;
+    std::unique_ptr<DecodedImageCache> image_cache;
 public:
     std::optional<SlideshowView> selected_slideshow = std::nullopt;
     service_id_t selected_service = 0;
     std::unique_ptr<ImGuiTextFilter> services_filter;
 public:
-    explicit BasicRadioViewController(const size_t _max_textures=100);
+    explicit BasicRadioViewController(const size_t _max_textures=100, const size_t _max_decoded_images=200);
     ~BasicRadioViewController();
-    Texture& GetTexture(subchannel_id_t subchannel_id, mot_transport_id_t transport_id, tcb::span<const uint8_t> data);
+    // returns nullptr while the image is being decoded in the background
+    Texture* GetTexture(subchannel_id_t subchannel_id, const Basic_Slideshow& slideshow);
 };
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "./decoded_image_cache.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "utility/span.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#include <stb_image.h>
+
+DecodedImageCache::DecodedImageCache(const size_t max_images)
+: m_images(max_images)
+{
+    m_is_running = true;
+    m_thread = std::thread(&DecodedImageCache::RunnerThread, this);
+}
+
+DecodedImageCache::~DecodedImageCache() {
+    {
+        auto lock = std::scoped_lock(m_mutex);
+        m_is_running = false;
+    }
+    m_cv_job.notify_one();
+    m_thread.join();
+}
+
+std::shared_ptr<const DecodedImage> DecodedImageCache::Get(
+    const uint32_t key, const uint64_t hash, std::shared_ptr<const std::vector<uint8_t>> data
+) {
+    auto lock = std::scoped_lock(m_mutex);
+    auto* entry = m_images.find(key);
+    if ((entry != nullptr) && (entry->hash == hash)) {
+        return entry->image;
+    }
+
+    // entry is left empty until the decode is finished so we only queue it once
+    auto& new_entry = m_images.emplace(key);
+    new_entry.hash = hash;
+    new_entry.image = nullptr;
+    m_jobs.push_back({ key, hash, std::move(data) });
+    m_cv_job.notify_one();
+    return nullptr;
+}
+
+DecodedImage DecodedImageCache::Decode(tcb::span<const uint8_t> data) {
+    DecodedImage image;
+    int bpp = 0;
+    uint8_t* buf = stbi_load_from_memory(
+        data.data(), int(data.size()), 
+        &image.width, &image.height, &bpp, 4);
+    if (buf == nullptr) {
+        image.width = 0;
+        image.height = 0;
+        return image;
+    }
+    const size_t total_bytes = size_t(image.width) * size_t(image.height) * 4;
+    image.rgba.resize(total_bytes);
+    std::copy_n(buf, total_bytes, image.rgba.begin());
+    stbi_image_free(buf);
+    image.is_success = true;
+    return image;
+}
+
+void DecodedImageCache::RunnerThread() {
+    auto lock = std::unique_lock(m_mutex);
+    while (true) {
+        m_cv_job.wait(lock, [this] {
+            return !m_jobs.empty() || !m_is_running;
+        });
+        if (!m_is_running) {
+            break;
+        }
+
+        auto job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        lock.unlock();
+        auto image = std::make_shared<const DecodedImage>(Decode(*(job.data)));
+        lock.lock();
+
+        // discard result if a newer image was requested under the same key
+        auto* entry = m_images.find(job.key);
+        if (entry == nullptr) {
+            entry = &m_images.emplace(job.key);
+            entry->hash = job.hash;
+        }
+        if (entry->hash == job.hash) {
+            entry->image = std::move(image);
+        }
+    }
+}
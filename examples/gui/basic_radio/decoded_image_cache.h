@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utility/lru_cache.h"
+#include "utility/span.h"
+
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    bool is_success = false;
+    std::vector<uint8_t> rgba; // 4 bytes per pixel
+};
+
+// Decodes jpeg/png images on a background thread and keeps a bounded cache of the RGBA bitmaps
+// This has no dependency on the graphics context so the render thread only has to upload finished bitmaps
+class DecodedImageCache
+{
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        std::shared_ptr<const DecodedImage> image = nullptr;
+    };
+    struct Job {
+        uint32_t key;
+        uint64_t hash;
+        std::shared_ptr<const std::vector<uint8_t>> data;
+    };
+    bool m_is_running;
+    std::mutex m_mutex;
+    std::condition_variable m_cv_job;
+    std::deque<Job> m_jobs;
+    LRU_Cache<uint32_t, Entry> m_images;
+    std::thread m_thread;
+public:
+    explicit DecodedImageCache(const size_t max_images=64);
+    ~DecodedImageCache();
+    DecodedImageCache(DecodedImageCache&) = delete;
+    DecodedImageCache(DecodedImageCache&&) = delete;
+    DecodedImageCache& operator=(DecodedImageCache&) = delete;
+    DecodedImageCache& operator=(DecodedImageCache&&) = delete;
+    // returns nullptr and queues a decode if the image isn't ready yet
+    // hash is used to detect if the image under the same key has changed
+    std::shared_ptr<const DecodedImage> Get(const uint32_t key, const uint64_t hash, std::shared_ptr<const std::vector<uint8_t>> data);
+    static DecodedImage Decode(tcb::span<const uint8_t> data);
+private:
+    void RunnerThread();
+};
@@ -314,7 +314,10 @@ static void RenderSimple_Slideshow_Manager(BasicRadioViewController& controller,
         float curr_x = 0.0f;
         int slideshow_id = 0;
         for (auto& slideshow: slideshows) {
-            const auto& texture = controller.GetTexture(subchannel_id, slideshow->transport_id, slideshow->image_data);
+            const auto* texture_ptr = controller.GetTexture(subchannel_id, *slideshow);
+            // Skip thumbnail until it has been decoded or if it failed to decode
+            if (texture_ptr == nullptr) continue;
+            const auto& texture = *texture_ptr;
             // Determine size of thumbnail
             const auto texture_id = reinterpret_cast<ImTextureID>(texture.GetTextureID());
             const float target_height = 200.0f;
@@ -467,7 +470,7 @@ void RenderSimple_BasicSlideshowSelected(BasicRadio& radio, BasicRadioViewContro
     }
     auto& selection = controller.selected_slideshow.value();
     auto& slideshow = selection.slideshow;
-    auto& texture = controller.GetTexture(selection.subchannel_id, slideshow->transport_id, slideshow->image_data);
+    const auto* texture = controller.GetTexture(selection.subchannel_id, *slideshow);
 
     bool is_open = true;
     if (ImGui::Begin("Slideshow Viewer", &is_open)) {
@@ -476,12 +479,16 @@ void RenderSimple_BasicSlideshowSelected(BasicRadio& radio, BasicRadioViewContro
 
         ImGuiWindowFlags image_flags = ImGuiWindowFlags_HorizontalScrollbar;
         if (ImGui::Begin("Image Viewer", nullptr, image_flags)) {
-            const auto texture_id = reinterpret_cast<ImTextureID>(texture.GetTextureID());
-            const auto texture_size = ImVec2(
-                static_cast<float>(texture.GetWidth()), 
-                static_cast<float>(texture.GetHeight())
-            );
-            ImGui::Image(texture_id, texture_size);
+            if (texture != nullptr) {
+                const auto texture_id = reinterpret_cast<ImTextureID>(texture->GetTextureID());
+                const auto texture_size = ImVec2(
+                    static_cast<float>(texture->GetWidth()), 
+                    static_cast<float>(texture->GetHeight())
+                );
+                ImGui::Image(texture_id, texture_size);
+            } else {
+                ImGui::Text("Decoding image...");
+            }
         }
         ImGui::End();
 
@@ -513,10 +520,13 @@ void RenderSimple_BasicSlideshowSelected(BasicRadio& radio, BasicRadioViewContro
                 FIELD_MACRO("Category title", "%.*s", int(slideshow->category_title.length()), slideshow->category_title.c_str());
                 FIELD_MACRO("Click Through URL", "%.*s", int(slideshow->click_through_url.length()), slideshow->click_through_url.c_str());
                 FIELD_MACRO("Alt Location URL", "%.*s", int(slideshow->alt_location_url.length()), slideshow->alt_location_url.c_str());
-                FIELD_MACRO("Size", "%zu Bytes", slideshow->image_data.size());
+                FIELD_MACRO("Size", "%zu Bytes", slideshow->image_data->size());
+                FIELD_MACRO("Repeats", "%u", uint32_t(slideshow->total_repeats));
 
-                FIELD_MACRO("Resolution", "%u x %u", texture.GetWidth(), texture.GetHeight());
-                FIELD_MACRO("Internal Texture ID", "%" PRIuPTR, uintptr_t(texture.GetTextureID()));
+                if (texture != nullptr) {
+                    FIELD_MACRO("Resolution", "%u x %u", texture->GetWidth(), texture->GetHeight());
+                    FIELD_MACRO("Internal Texture ID", "%" PRIuPTR, uintptr_t(texture->GetTextureID()));
+                }
 
                 #undef FIELD_MACRO
                 ImGui::EndTable();
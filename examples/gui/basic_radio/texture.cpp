@@ -14,11 +14,6 @@
 #include <GL/gl.h>
 #endif
 
-#define STB_IMAGE_IMPLEMENTATION
-#define STBI_ONLY_PNG
-#define STBI_ONLY_JPEG
-#include <stb_image.h>
-
 #define GLCall(func) GLClearErrors(#func, __FILE__, __LINE__); func; assert(GLCheckErrors(#func, __FILE__, __LINE__))
 
 void GLClearErrors(const char *funcName, const char *file, int line) {
@@ -50,9 +45,9 @@ bool GLCheckErrors(const char *funcName, const char *file, int line) {
     return true; 
 }
 
-Texture::Texture(tcb::span<const uint8_t> image_buffer)
+Texture::Texture(int width, int height, tcb::span<const uint8_t> rgba_buffer)
     : m_RendererID(0),
-      m_Width(0), m_Height(0), m_BPP(0),
+      m_Width(width), m_Height(height), m_BPP(32),
       m_is_success(false)
 {
     GLCall(glGenTextures(1, &m_RendererID));
@@ -70,13 +65,9 @@ Texture::Texture(tcb::span<const uint8_t> image_buffer)
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 
     // give image buffer to opengl
-    // stbi_set_flip_vertically_on_load(1);
-    uint8_t* m_LocalBuffer = stbi_load_from_memory(
-        image_buffer.data(), (int)image_buffer.size(), 
-        &m_Width, &m_Height, &m_BPP, 4);
-    if (m_LocalBuffer != nullptr) {
-        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
-        stbi_image_free(m_LocalBuffer);
+    const size_t total_bytes = size_t(m_Width) * size_t(m_Height) * 4;
+    if ((total_bytes > 0) && (rgba_buffer.size() >= total_bytes)) {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba_buffer.data()));
         m_is_success = true;
     }
 }
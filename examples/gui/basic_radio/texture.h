@@ -10,7 +10,8 @@ private:
     int m_Width, m_Height, m_BPP; // BPP = bits per pixel
     bool m_is_success;
 public:
-    explicit Texture(tcb::span<const uint8_t> image_buffer);
+    // upload a decoded RGBA8 bitmap
+    Texture(int width, int height, tcb::span<const uint8_t> rgba_buffer);
     ~Texture();
     Texture(Texture&) = delete;
     Texture(Texture&&) = delete;
@@ -1,5 +1,6 @@
 #include "./render_profiler.h"
 #include "ofdm/profiler.h"
+#include "utility/allocation_tracker.h"
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include <imgui.h>
 #include <inttypes.h>
@@ -21,11 +22,17 @@ void RenderProfiler() {
         static std::hash<std::thread::id> thread_id_hasher;
 
         const ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_NoBordersInBody;
-        if (ImGui::BeginTable("Threads", 3, flags)) {
+        const bool is_allocations_tracked = AllocationTracker::is_enabled();
+        if (ImGui::BeginTable("Threads", is_allocations_tracked ? 6 : 3, flags)) {
             // The first column will use the default _WidthStretch when ScrollX is Off and _WidthFixed when ScrollX is On
             ImGui::TableSetupColumn("ID", ImGuiTableColumnFlags_NoHide);
             ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_NoHide);
             ImGui::TableSetupColumn("Description", ImGuiTableColumnFlags_NoHide);
+            if (is_allocations_tracked) {
+                ImGui::TableSetupColumn("Allocations", ImGuiTableColumnFlags_NoHide);
+                ImGui::TableSetupColumn("Allocated (bytes)", ImGuiTableColumnFlags_NoHide);
+                ImGui::TableSetupColumn("Peak (bytes)", ImGuiTableColumnFlags_NoHide);
+            }
             ImGui::TableHeadersRow();
 
             int row_id = 0;
@@ -53,6 +60,19 @@ void RenderProfiler() {
                     const size_t total_symbols = data.symbol_end-data.symbol_start;
                     ImGui::Text("Start=%-2zu End=%-2zu Total=%-2zu", data.symbol_start, data.symbol_end, total_symbols);
                 }
+                if (is_allocations_tracked) {
+                    AllocationStats stats;
+                    {
+                        auto lock_trace = std::scoped_lock(instrumentor_thread.GetPrevTraceMutex());
+                        stats = instrumentor_thread.GetPrevAllocationStats();
+                    }
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%" PRIu64, stats.total_allocations);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%" PRIu64, stats.total_allocated_bytes);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%" PRIi64, stats.peak_bytes);
+                }
                 ImGui::PopID();
             }
 
@@ -132,12 +152,18 @@ void RenderLoggedTraces(const InstrumentorThread::profile_trace_logger_t& traces
 void RenderTrace(const InstrumentorThread::profile_trace_t& trace) {
     const int N = (int)trace.size();
     static ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_NoBordersInBody;
-    if (ImGui::BeginTable("Results", 4, flags)) {
+    const bool is_allocations_tracked = AllocationTracker::is_enabled();
+    if (ImGui::BeginTable("Results", is_allocations_tracked ? 7 : 4, flags)) {
         // The first column will use the default _WidthStretch when ScrollX is Off and _WidthFixed when ScrollX is On
         ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_NoHide);
         ImGui::TableSetupColumn("Duration (us)", ImGuiTableColumnFlags_NoHide);
         ImGui::TableSetupColumn("Start (us)", ImGuiTableColumnFlags_NoHide);
         ImGui::TableSetupColumn("End (us)", ImGuiTableColumnFlags_NoHide);
+        if (is_allocations_tracked) {
+            ImGui::TableSetupColumn("Allocations", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("Allocated (bytes)", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("Peak (bytes)", ImGuiTableColumnFlags_NoHide);
+        }
         ImGui::TableHeadersRow();
 
         // Keep track of position in tree 
@@ -174,6 +200,14 @@ void RenderTrace(const InstrumentorThread::profile_trace_t& trace) {
             ImGui::Text("%" PRIi64, result.start);
             ImGui::TableNextColumn();
             ImGui::Text("%" PRIi64, result.end);
+            if (is_allocations_tracked) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%" PRIu64, result.total_allocations);
+                ImGui::TableNextColumn();
+                ImGui::Text("%" PRIu64, result.total_allocated_bytes);
+                ImGui::TableNextColumn();
+                ImGui::Text("%" PRIi64, result.peak_bytes);
+            }
         }
 
         while (prev_stack_index > 0) {
@@ -1,7 +1,9 @@
 #include <stdint.h>
 #include <stdio.h>
+#include <algorithm>
 #include <exception>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -11,6 +13,7 @@
 #endif
 
 #include <argparse/argparse.hpp>
+#include "./app_helpers/app_replay_pacer.h"
 
 void init_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("input")
@@ -27,12 +30,52 @@ void init_parser(argparse::ArgumentParser& parser) {
         .metavar("BLOCK_SIZE")
         .nargs(1).required()
         .help("Number of bytes to read from the wav file in chunks");
+    parser.add_argument("--realtime")
+        .default_value(false).implicit_value(true)
+        .help("Pace output at the sampling rate like a receiver instead of as fast as possible");
+    parser.add_argument("-s", "--sampling-rate")
+        .default_value(float(2'048'000)).scan<'g', float>()
+        .metavar("SAMPLING_RATE")
+        .nargs(1).required()
+        .help("Sampling rate of the recording in Hz");
+    parser.add_argument("--bytes-per-sample")
+        .default_value(size_t(2)).scan<'u', size_t>()
+        .metavar("BYTES")
+        .nargs(1).required()
+        .help("Size of each sample in the recording (8bit IQ is 2 bytes)");
+    parser.add_argument("--speed")
+        .default_value(float(1.0f)).scan<'g', float>()
+        .metavar("SPEED")
+        .nargs(1).required()
+        .help("Multiple of the sampling rate to replay at");
+    parser.add_argument("--burst-size")
+        .default_value(size_t(16*16384)).scan<'u', size_t>()
+        .metavar("BURST_SIZE")
+        .nargs(1).required()
+        .help("Number of bytes released at once like a usb transfer");
+    parser.add_argument("--jitter-us")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("MICROSECONDS")
+        .nargs(1).required()
+        .help("Delay each burst by a random amount up to this");
+    parser.add_argument("--timing-file")
+        .default_value(std::string(""))
+        .metavar("TIMING_FILENAME")
+        .nargs(1).required()
+        .help("Replay burst sizes and jitter recorded with rtl_sdr --timing-output");
 }
 
 struct Args {
     std::string input_filename;
     std::string output_filename;
     size_t block_size;
+    bool is_realtime;
+    float sampling_rate;
+    size_t bytes_per_sample;
+    float speed;
+    size_t burst_size;
+    float jitter_us;
+    std::string timing_filename;
 };
 
 Args get_args_from_parser(const argparse::ArgumentParser& parser) {
@@ -40,6 +83,13 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     args.input_filename = parser.get<std::string>("input");
     args.output_filename = parser.get<std::string>("--output");
     args.block_size = parser.get<size_t>("--block-size");
+    args.is_realtime = parser.get<bool>("--realtime");
+    args.sampling_rate = parser.get<float>("--sampling-rate");
+    args.bytes_per_sample = parser.get<size_t>("--bytes-per-sample");
+    args.speed = parser.get<float>("--speed");
+    args.burst_size = parser.get<size_t>("--burst-size");
+    args.jitter_us = parser.get<float>("--jitter-us");
+    args.timing_filename = parser.get<std::string>("--timing-file");
     return args;
 }
 
@@ -61,6 +111,30 @@ int main(int argc, char** argv) {
         fprintf(stderr, "Block size cannot be zero\n");
         return 1;
     }
+    if (args.sampling_rate <= 0.0f || args.bytes_per_sample == 0 || args.speed <= 0.0f) {
+        fprintf(stderr, "Sampling rate, bytes per sample and speed must be positive\n");
+        return 1;
+    }
+    if (args.burst_size == 0) {
+        fprintf(stderr, "Burst size cannot be zero\n");
+        return 1;
+    }
+
+    std::unique_ptr<ReplayPacer> pacer = nullptr;
+    if (args.is_realtime) {
+        ReplayPacerConfig pacer_config;
+        pacer_config.bytes_per_second = double(args.sampling_rate)*double(args.bytes_per_sample);
+        pacer_config.speed = double(args.speed);
+        pacer_config.burst_size = args.burst_size;
+        pacer_config.random_jitter_us = double(args.jitter_us);
+        if (!args.timing_filename.empty()) {
+            if (!load_replay_bursts(args.timing_filename.c_str(), pacer_config.bytes_per_second, pacer_config.recorded_bursts)) {
+                fprintf(stderr, "Failed to load timing file: '%s'\n", args.timing_filename.c_str());
+                return 1;
+            }
+        }
+        pacer = std::make_unique<ReplayPacer>(pacer_config);
+    }
 
     FILE* fp_in = fopen(args.input_filename.c_str(), "rb");
     if (fp_in == nullptr) {
@@ -85,16 +159,41 @@ int main(int argc, char** argv) {
     const size_t N = args.block_size;
     auto block = std::vector<uint8_t>(N);
 
+    // without pacing every block is written immediately
+    size_t burst_remain = 0;
     while (true) {
-        const size_t nb_read = fread(block.data(), sizeof(uint8_t), N, fp_in);
+        size_t total_read = N;
+        if (pacer != nullptr) {
+            if (burst_remain == 0) {
+                fflush(fp_out);
+                const uint64_t total_resyncs = pacer->get_stats().total_resyncs;
+                burst_remain = pacer->wait_next_burst();
+                if (pacer->get_stats().total_resyncs != total_resyncs) {
+                    fprintf(stderr, "Output fell behind by over %.1fs, a receiver would have dropped samples\n",
+                        pacer->get_config().max_backlog_seconds);
+                }
+            }
+            total_read = std::min(N, burst_remain);
+        }
+        const size_t nb_read = fread(block.data(), sizeof(uint8_t), total_read, fp_in);
         const size_t nb_write = fwrite(block.data(), sizeof(uint8_t), nb_read, fp_out);
         if (nb_write != nb_read) {
             fprintf(stderr, "Failed to write out block %zu/%zu bytes. Exiting...\n", nb_write, nb_read);
             break;
         }
-        if (nb_read != N) {
+        if (nb_read != total_read) {
+            if (nb_read == 0 && ftell(fp_in) == 0) {
+                fprintf(stderr, "Input file is empty. Exiting...\n");
+                break;
+            }
             fseek(fp_in, 0, SEEK_SET);
         }
+        if (pacer != nullptr) {
+            burst_remain -= nb_read;
+        }
+    }
+    if (pacer != nullptr) {
+        pacer->print_stats(stderr);
     }
     return 0;
 }
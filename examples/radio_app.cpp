@@ -24,6 +24,7 @@
 #include "basic_scraper/basic_scraper.h"
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_types.h"
+#include "utility/allocation_tracker.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 #include "./app_helpers/app_audio.h"
@@ -31,6 +32,7 @@
 #include "./app_helpers/app_io_buffers.h"
 #include "./app_helpers/app_logging.h"
 #include "./app_helpers/app_ofdm_blocks.h"
+#include "./app_helpers/app_virtual_tuner.h"
 #include "./audio/audio_pipeline.h"
 #include "./audio/portaudio_sink.h"
 #include "./block_frequencies.h"
@@ -73,6 +75,11 @@ void init_parser(argparse::ArgumentParser& parser) {
         .metavar("DEVICE_INDEX")
         .nargs(1).required()
         .help("Index of tuner to select from list automatically");
+    parser.add_argument("--tuner-virtual-recordings")
+        .default_value(std::string(""))
+        .metavar("DIRECTORY")
+        .nargs(1).required()
+        .help("Add a virtual tuner to the device list that plays [BLOCK].raw recordings from this directory");
     parser.add_argument("--tuner-no-auto-select")
         .default_value(false).implicit_value(true)
         .help("Do not automatically select tuner on startup");
@@ -126,6 +133,7 @@ struct Args {
     float tuner_manual_gain;
     bool tuner_auto_gain;
     size_t tuner_device_index;
+    std::string tuner_virtual_recordings;
     bool tuner_no_auto_select;
     size_t ofdm_block_size;
     size_t ofdm_total_threads;
@@ -148,6 +156,7 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     args.tuner_manual_gain = parser.get<float>("--tuner-manual-gain");
     args.tuner_auto_gain = parser.get<bool>("--tuner-auto-gain");
     args.tuner_device_index = parser.get<size_t>("--tuner-device-index");
+    args.tuner_virtual_recordings = parser.get<std::string>("--tuner-virtual-recordings");
     args.tuner_no_auto_select = parser.get<bool>("--tuner-no-auto-select");
     args.ofdm_block_size = parser.get<size_t>("--ofdm-block-size");
     args.ofdm_total_threads = parser.get<size_t>("--ofdm-total-threads");
@@ -181,6 +190,7 @@ class Basic_Radio_Switcher
 private:
     DAB_Parameters m_dab_params;
     std::shared_ptr<InputBuffer<viterbi_bit_t>> m_input_stream = nullptr;
+    std::shared_ptr<FrameTimestampQueue> m_timestamp_input = nullptr;
     std::vector<viterbi_bit_t> m_bits_buffer;
     std::map<std::string, std::shared_ptr<Radio_Instance>> m_instances;
     std::shared_ptr<Radio_Instance> m_selected_instance = nullptr;
@@ -198,6 +208,9 @@ public:
     void set_input_stream(std::shared_ptr<InputBuffer<viterbi_bit_t>> stream) { 
         m_input_stream = stream; 
     }
+    void set_timestamp_input(std::shared_ptr<FrameTimestampQueue> timestamps) {
+        m_timestamp_input = timestamps;
+    }
     void flush_input_stream() {
         m_flush_reads = 5;
     }
@@ -225,6 +238,10 @@ public:
         while (true) {
             const size_t length = m_input_stream->read(m_bits_buffer);
             if (length != m_bits_buffer.size()) return;
+            FrameTimestamp timestamp;
+            if (m_timestamp_input != nullptr) {
+                timestamp = m_timestamp_input->pop().value_or(FrameTimestamp{});
+            }
 
             auto lock = std::unique_lock(m_mutex_selected_instance);
             if (m_flush_reads > 0) {
@@ -232,7 +249,7 @@ public:
                 continue;
             }
             if (m_selected_instance == nullptr) continue;
-            m_selected_instance->get_radio().Process(m_bits_buffer);
+            m_selected_instance->get_radio().Process(m_bits_buffer, timestamp);
         }
     }
 };
@@ -279,6 +296,9 @@ static void list_channels() {
 }
 
 INITIALIZE_EASYLOGGINGPP
+#if ALLOCATION_TRACKING
+INITIALIZE_ALLOCATION_TRACKER
+#endif
 int main(int argc, char** argv) {
     const char* PROGRAM_NAME = "radio_app";
     const char* PROGRAM_DESCRIPTION = "Radio app that connects to tuner";
@@ -327,7 +347,7 @@ int main(int argc, char** argv) {
         [args, audio_pipeline](const DAB_Parameters& params, std::string_view channel_name) -> auto {
             auto instance = std::make_shared<Radio_Instance>(channel_name, params, args.radio_total_threads);
             auto& radio = instance->get_radio(); 
-            attach_audio_pipeline_to_radio(audio_pipeline, radio);
+            attach_audio_pipeline_to_radio(audio_pipeline, radio, true);
             if (args.scraper_enable) {
                 auto dir = fmt::format("{}/{}", args.scraper_output, channel_name);
                 auto scraper = std::make_shared<BasicScraper>(dir);
@@ -356,8 +376,20 @@ int main(int argc, char** argv) {
     auto ofdm_to_radio_buffer = std::make_shared<ThreadedRingBuffer<viterbi_bit_t>>(dab_params.nb_frame_bits*2);
     ofdm_block->set_output_stream(ofdm_to_radio_buffer);
     radio_switcher->set_input_stream(ofdm_to_radio_buffer);
+    auto ofdm_to_radio_timestamps = std::make_shared<FrameTimestampQueue>();
+    ofdm_block->set_timestamp_output(ofdm_to_radio_timestamps);
+    radio_switcher->set_timestamp_input(ofdm_to_radio_timestamps);
     // device to ofdm
     auto device_list = std::make_shared<DeviceList>();
+    if (!args.tuner_virtual_recordings.empty()) {
+        const auto directory = args.tuner_virtual_recordings;
+        device_list->add_virtual_device(
+            DeviceDescriptor{ "Virtual", "Recordings", directory },
+            [directory]() -> std::shared_ptr<Device> {
+                return create_virtual_tuner_from_recordings(directory, VirtualDeviceConfig{});
+            }
+        );
+    }
     auto device_source = std::make_shared<DeviceSource>(
         [device_output_buffer, radio_switcher, args]
         (std::shared_ptr<Device> device) {
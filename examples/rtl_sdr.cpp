@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,6 +25,7 @@
 #include <exception>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -39,6 +41,9 @@
 #endif
 
 #include <argparse/argparse.hpp>
+#include "utility/span.h"
+#include "./app_helpers/app_async_file_writer.h"
+#include "./app_helpers/app_replay_pacer.h"
 #include "./block_frequencies.h"
 
 extern "C" {
@@ -48,11 +53,12 @@ extern "C" {
 struct GlobalContext {
     bool is_user_exit = false;
     rtlsdr_dev_t *device = nullptr;
+    ReplayTimingRecorder *timing_recorder = nullptr;
 };
 
 static GlobalContext global_context {};
-static int read_sync(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read);
-static int read_async(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read);
+static int read_sync(AsyncFileWriter& writer, const uint32_t out_block_size, uint32_t bytes_to_read);
+static int read_async(AsyncFileWriter& writer, const uint32_t out_block_size, uint32_t bytes_to_read);
 static int find_nearest_gain(rtlsdr_dev_t *dev, int target_gain);
 static int verbose_set_frequency(rtlsdr_dev_t *dev, uint32_t frequency);
 static int verbose_set_sample_rate(rtlsdr_dev_t *dev, uint32_t samp_rate);
@@ -149,6 +155,22 @@ void init_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("--enable-bias-tee")
         .default_value(false).implicit_value(true)
         .help("Enable bias-T which supplies DC voltage usually to an active antenna");
+    parser.add_argument("--write-queue-size")
+        .default_value(size_t(64)).scan<'u', size_t>()
+        .metavar("MEGABYTES")
+        .nargs(1).required()
+        .help("Amount of samples in MB that can be queued for writing before the reader blocks");
+    parser.add_argument("--disable-direct-io")
+        .default_value(false).implicit_value(true)
+        .help("Write output through the page cache instead of using direct I/O");
+    parser.add_argument("--print-write-stats")
+        .default_value(false).implicit_value(true)
+        .help("Print write queue depth and latency on exit");
+    parser.add_argument("--timing-output")
+        .default_value(std::string(""))
+        .metavar("TIMING_FILENAME")
+        .nargs(1).required()
+        .help("Record arrival time and size of each usb transfer so it can be replayed with loop_file --timing-file");
 }
 
 enum class SamplingMode: uint32_t {
@@ -173,6 +195,10 @@ struct Args {
     SamplingMode sampling_mode;
     bool is_offset_tuning;
     bool is_enable_bias_tee;
+    size_t write_queue_size;
+    bool is_disable_direct_io;
+    bool is_print_write_stats;
+    std::string timing_output_filename;
 };
 
 Args get_args_from_parser(const argparse::ArgumentParser& parser) {
@@ -210,6 +236,10 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     }
     args.is_offset_tuning = parser.get<bool>("--offset-tuning");
     args.is_enable_bias_tee = parser.get<bool>("--enable-bias-tee");
+    args.write_queue_size = parser.get<size_t>("--write-queue-size");
+    args.is_disable_direct_io = parser.get<bool>("--disable-direct-io");
+    args.is_print_write_stats = parser.get<bool>("--print-write-stats");
+    args.timing_output_filename = parser.get<std::string>("--timing-output");
     return args;
 }
 
@@ -296,6 +326,17 @@ int main(int argc, char **argv) {
     _setmode(_fileno(fp_out), _O_BINARY);
 #endif
 
+    std::unique_ptr<ReplayTimingRecorder> timing_recorder = nullptr;
+    if (!args.timing_output_filename.empty()) {
+        FILE* fp_timing = fopen(args.timing_output_filename.c_str(), "w");
+        if (fp_timing == nullptr) {
+            fprintf(stderr, "Failed to open timing output file: '%s'\n", args.timing_output_filename.c_str());
+            return 1;
+        }
+        timing_recorder = std::make_unique<ReplayTimingRecorder>(fp_timing);
+        global_context.timing_recorder = timing_recorder.get();
+    }
+
     int device_index = 0;
     if (args.device_index.has_value()) {
         device_index = args.device_index.value();
@@ -357,14 +398,31 @@ int main(int argc, char **argv) {
 
     verbose_reset_buffer(device);
 
+    // write from background threads so disk stalls don't cause usb samples to be dropped
+    AsyncFileWriterConfig writer_config;
+    writer_config.total_blocks = std::max(args.write_queue_size*(size_t(1) << 20) / writer_config.block_size, size_t(2));
+    writer_config.is_direct_io = !args.is_disable_direct_io;
+    auto writer = std::make_unique<AsyncFileWriter>(fp_out, writer_config);
+    if (writer->is_direct_io()) {
+        fprintf(stderr, "Writing output with direct I/O.\n");
+    }
+
     int read_result = 0;
     if (args.is_sync) {
         fprintf(stderr, "Reading samples in sync mode...\n");
-        read_result = read_sync(fp_out, uint32_t(args.block_size), uint32_t(args.bytes_to_read));
+        read_result = read_sync(*writer, uint32_t(args.block_size), uint32_t(args.bytes_to_read));
     } else {
         fprintf(stderr, "Reading samples in async mode...\n");
-        read_result = read_async(fp_out, uint32_t(args.block_size), uint32_t(args.bytes_to_read));
+        read_result = read_async(*writer, uint32_t(args.block_size), uint32_t(args.bytes_to_read));
+    }
+    writer->close();
+    if (args.is_print_write_stats) {
+        const auto stats = writer->get_stats();
+        fprintf(stderr, "Wrote %" PRIu64 " bytes with %" PRIu64 " errors, peak queue depth %zu/%zu blocks, %" PRIu64 " stalls.\n",
+            stats.total_bytes_written, stats.total_errors, stats.peak_queue_depth, writer_config.total_blocks, stats.total_stalls);
+        writer->get_write_latency().print(stderr, "Write latency");
     }
+    writer = nullptr;
 
     if (global_context.is_user_exit) {
         fprintf(stderr, "\nUser cancel, exiting...\n");
@@ -377,7 +435,7 @@ int main(int argc, char **argv) {
     return (read_result >= 0) ? read_result : -read_result;
 }
 
-int read_sync(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read) {
+int read_sync(AsyncFileWriter& writer, const uint32_t out_block_size, uint32_t bytes_to_read) {
     std::vector<uint8_t> buffer(out_block_size);
 
     while (!global_context.is_user_exit) {
@@ -387,13 +445,16 @@ int read_sync(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read)
             fprintf(stderr, "WARNING: sync read failed (%d).\n", res);
             return res;
         }
+        if (global_context.timing_recorder != nullptr) {
+            global_context.timing_recorder->record(size_t(n_read));
+        }
 
         if ((bytes_to_read > 0) && (uint32_t(n_read) > bytes_to_read)) {
             n_read = int(bytes_to_read);
             global_context.is_user_exit = true;
         }
 
-        if (fwrite(buffer.data(), 1, n_read, file) != size_t(n_read)) {
+        if (writer.write(tcb::span(buffer).first(size_t(n_read))) != size_t(n_read)) {
             fprintf(stderr, "Short write, samples lost, exiting!\n");
             break;
         }
@@ -411,14 +472,14 @@ int read_sync(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read)
     return 0;
 }
 
-int read_async(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read) {
+int read_async(AsyncFileWriter& writer, const uint32_t out_block_size, uint32_t bytes_to_read) {
     struct context_t {
         uint32_t bytes_to_read;
-        FILE *file_out;
+        AsyncFileWriter *writer;
     } context;
 
     context.bytes_to_read = bytes_to_read;
-    context.file_out = file;
+    context.writer = &writer;
 
     auto rtlsdr_callback = [](unsigned char *buf, uint32_t len, void *user_data) {
         if (user_data == nullptr) {
@@ -426,7 +487,7 @@ int read_async(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read
         }
 
         auto &local_context = *reinterpret_cast<context_t*>(user_data);
-        if (local_context.file_out == nullptr) {
+        if (local_context.writer == nullptr) {
             return;
         }
 
@@ -434,13 +495,17 @@ int read_async(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read
             return;
         }
 
+        if (global_context.timing_recorder != nullptr) {
+            global_context.timing_recorder->record(size_t(len));
+        }
+
         if ((local_context.bytes_to_read > 0) && (len > local_context.bytes_to_read)) {
             len = local_context.bytes_to_read;
             global_context.is_user_exit = true;
             rtlsdr_cancel_async(global_context.device);
         }
 
-        if (fwrite(buf, 1, len, local_context.file_out) != len) {
+        if (local_context.writer->write({ buf, size_t(len) }) != len) {
             fprintf(stderr, "Short write, samples lost, exiting!\n");
             global_context.is_user_exit = true;
             rtlsdr_cancel_async(global_context.device);
@@ -0,0 +1,258 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <complex>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "utility/span.h"
+
+#if _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include <argparse/argparse.hpp>
+#include "ofdm/dab_mapper_ref.h"
+#include "ofdm/dab_ofdm_params_ref.h"
+#include "ofdm/dab_prs_ref.h"
+#include "ofdm/dsp/apply_pll.h"
+#include "ofdm/ofdm_modulator.h"
+#include "ofdm/ofdm_params.h"
+#include "ensemble/ensemble_config.h"
+#include "ensemble/ensemble_generator.h"
+#include "viterbi_config.h"
+
+template <typename T>
+T clamp(T x, const T min, const T max) {
+    T y = x;
+    y = (y > min) ? y : min;
+    y = (y > max) ? max : y;
+    return y;
+}
+
+struct RawIQ {
+    uint8_t I;
+    uint8_t Q;
+};
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("-m", "--transmission-mode")
+        .default_value(int(1)).scan<'i', int>()
+        .choices(1,2,4)
+        .metavar("MODE")
+        .nargs(1).required()
+        .help("Dab transmission mode");
+    parser.add_argument("--dab-plus-services")
+        .default_value(int(4)).scan<'i', int>()
+        .metavar("TOTAL_SERVICES")
+        .nargs(1).required()
+        .help("Number of DAB+ audio services");
+    parser.add_argument("--dab-plus-bitrate")
+        .default_value(int(64)).scan<'i', int>()
+        .metavar("KBPS")
+        .nargs(1).required()
+        .help("Bitrate of each DAB+ subchannel");
+    parser.add_argument("--dab-services")
+        .default_value(int(2)).scan<'i', int>()
+        .metavar("TOTAL_SERVICES")
+        .nargs(1).required()
+        .help("Number of DAB (MP2) audio services");
+    parser.add_argument("--dab-bitrate")
+        .default_value(int(128)).scan<'i', int>()
+        .metavar("KBPS")
+        .nargs(1).required()
+        .help("Bitrate of each DAB (MP2) subchannel");
+    parser.add_argument("--data-services")
+        .default_value(int(1)).scan<'i', int>()
+        .metavar("TOTAL_SERVICES")
+        .nargs(1).required()
+        .help("Number of packet mode MOT slideshow services");
+    parser.add_argument("--data-bitrate")
+        .default_value(int(32)).scan<'i', int>()
+        .metavar("KBPS")
+        .nargs(1).required()
+        .help("Bitrate of each packet mode subchannel");
+    parser.add_argument("--eep-protection")
+        .default_value(std::string("3A"))
+        .choices("1A", "2A", "3A", "4A", "1B", "2B", "3B", "4B")
+        .metavar("PROTECTION")
+        .nargs(1).required()
+        .help("EEP protection profile of DAB+ and data subchannels (type B bitrates are multiples of 32kbps)");
+    parser.add_argument("--uep-protection")
+        .default_value(int(3)).scan<'i', int>()
+        .choices(1,2,3,4,5)
+        .metavar("LEVEL")
+        .nargs(1).required()
+        .help("UEP protection level of DAB (MP2) subchannels");
+    parser.add_argument("--output-type")
+        .default_value(std::string("iq"))
+        .choices("iq", "soft")
+        .metavar("TYPE")
+        .nargs(1).required()
+        .help("Output 8bit IQ samples or the soft decision bits from the OFDM demodulator (iq, soft)");
+    parser.add_argument("--total-frames")
+        .default_value(int(0)).scan<'i', int>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Number of transmission frames to generate (0 = run forever)");
+    parser.add_argument("-f", "--frequency")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("FREQUENCY")
+        .nargs(1).required()
+        .help("Amount of Hz to shift 8bit IQ signal");
+    parser.add_argument("-o", "--output")
+        .default_value(std::string(""))
+        .metavar("OUTPUT_FILENAME")
+        .nargs(1).required()
+        .help("Filename of output from simulator (defaults to stdout)");
+}
+
+struct Args {
+    EnsembleConfig config;
+    bool is_output_iq;
+    int total_frames;
+    float frequency;
+    std::string output_filename;
+};
+
+static void add_services(
+    EnsembleConfig& config, const EnsembleServiceType type,
+    const int total_services, const int bitrate_kbps, const char* name
+) {
+    for (int i = 0; i < total_services; i++) {
+        auto& service = config.services.emplace_back();
+        service.type = type;
+        service.bitrate_kbps = bitrate_kbps;
+        service.label = std::string(name) + " " + std::to_string(i+1);
+    }
+}
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    auto& config = args.config;
+    config.transmission_mode = parser.get<int>("--transmission-mode");
+    // protection profile is given as the level followed by the type, e.g. 3A
+    const auto eep_protection = parser.get<std::string>("--eep-protection");
+    config.eep_prot_level = eep_protection_level_t(eep_protection[0] - '1');
+    config.eep_type = (eep_protection[1] == 'A') ? EEP_Type::TYPE_A : EEP_Type::TYPE_B;
+    config.uep_prot_level = parser.get<int>("--uep-protection");
+    add_services(
+        config, EnsembleServiceType::DAB_PLUS,
+        parser.get<int>("--dab-plus-services"), parser.get<int>("--dab-plus-bitrate"), "DAB+");
+    add_services(
+        config, EnsembleServiceType::DAB,
+        parser.get<int>("--dab-services"), parser.get<int>("--dab-bitrate"), "DAB");
+    add_services(
+        config, EnsembleServiceType::DATA,
+        parser.get<int>("--data-services"), parser.get<int>("--data-bitrate"), "Data");
+    args.is_output_iq = parser.get<std::string>("--output-type").compare("iq") == 0;
+    args.total_frames = parser.get<int>("--total-frames");
+    args.frequency = parser.get<float>("--frequency");
+    args.output_filename = parser.get<std::string>("--output");
+    return args;
+}
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("simulate_ensemble", "0.1.0");
+    parser.add_description("Simulates a transmitter sending a valid DAB ensemble for load testing");
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+
+    std::unique_ptr<EnsembleGenerator> generator = nullptr;
+    try {
+        generator = std::make_unique<EnsembleGenerator>(args.config);
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "Invalid ensemble: %s\n", ex.what());
+        return 1;
+    }
+    fprintf(stderr, "Generating %zu services using %zu/864 capacity units\n",
+        args.config.services.size(), generator->get_total_capacity_units());
+
+    FILE* fp_out = stdout;
+    if (!args.output_filename.empty()) {
+        fp_out = fopen(args.output_filename.c_str(), "wb+");
+        if (fp_out == nullptr) {
+            fprintf(stderr, "Failed to open output file: '%s'\n", args.output_filename.c_str());
+            return 1;
+        }
+    }
+
+#if _WIN32
+    _setmode(_fileno(fp_out), _O_BINARY);
+#endif
+
+    const auto params = get_DAB_OFDM_params(args.config.transmission_mode);
+    auto prs_fft_ref = std::vector<std::complex<float>>(params.nb_fft);
+    auto carrier_mapper = std::vector<int>(params.nb_data_carriers);
+    get_DAB_PRS_reference(args.config.transmission_mode, prs_fft_ref);
+    get_DAB_mapper_ref(carrier_mapper, params.nb_fft);
+
+    const size_t nb_frame_bits = generator->get_nb_frame_bits();
+    auto frame_bits_buf = std::vector<uint8_t>(nb_frame_bits);
+    auto frame_soft_buf = std::vector<viterbi_bit_t>(nb_frame_bits);
+    auto frame_bytes_buf = std::vector<uint8_t>(nb_frame_bits/8);
+
+    const size_t frame_size = params.nb_null_period + params.nb_symbol_period*params.nb_frame_symbols;
+    auto frame_out_buf = std::vector<std::complex<float>>(frame_size);
+    auto frame_tx_buf = std::vector<RawIQ>(frame_size);
+    auto ofdm_mod = OFDM_Modulator(params, prs_fft_ref);
+
+    for (int frame_index = 0; (args.total_frames == 0) || (frame_index < args.total_frames); frame_index++) {
+        generator->generate_frame(frame_bits_buf);
+
+        if (!args.is_output_iq) {
+            for (size_t i = 0; i < nb_frame_bits; i++) {
+                frame_soft_buf[i] = frame_bits_buf[i] ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+            }
+            const size_t nb_write = fwrite(frame_soft_buf.data(), sizeof(viterbi_bit_t), nb_frame_bits, fp_out);
+            if (nb_write != nb_frame_bits) {
+                fprintf(stderr, "Failed to write out frame %zu/%zu\n", nb_write, nb_frame_bits);
+                break;
+            }
+            continue;
+        }
+
+        // perform OFDM modulation
+        pack_ofdm_frame_bytes(carrier_mapper, frame_bits_buf, frame_bytes_buf);
+        const bool res = ofdm_mod.ProcessBlock(frame_out_buf, frame_bytes_buf);
+        if (!res) {
+            fprintf(stderr, "Failed to create the OFDM frame\n");
+            break;
+        }
+
+        if (args.frequency != 0.0f) {
+            const float Fs = 2.048e6f; // DAB sampling frequency
+            const float frequency_norm = args.frequency / Fs;
+            apply_pll_auto(frame_out_buf, frame_out_buf, frequency_norm);
+        }
+
+        for (size_t i = 0; i < frame_size; i++) {
+            const float I = frame_out_buf[i].real();
+            const float Q = frame_out_buf[i].imag();
+            const float A = 1.0f/(float)params.nb_data_carriers * 200.0f * 2.0f;
+            const float I0 = clamp(I*A + 128.0f, 0.0f, 255.0f);
+            const float Q0 = clamp(Q*A + 128.0f, 0.0f, 255.0f);
+            const uint8_t I1 = static_cast<uint8_t>(I0);
+            const uint8_t Q1 = static_cast<uint8_t>(Q0);
+            frame_tx_buf[i] = RawIQ{ I1, Q1 };
+        }
+
+        const size_t N = frame_tx_buf.size();
+        const size_t nb_write = fwrite(frame_tx_buf.data(), sizeof(RawIQ), N, fp_out);
+        if (nb_write != N) {
+            fprintf(stderr, "Failed to write out frame %zu/%zu\n", nb_write, N);
+            break;
+        }
+    }
+    fclose(fp_out);
+    return 0;
+}
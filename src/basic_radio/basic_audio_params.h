@@ -1,11 +1,14 @@
 #pragma once
 
 #include <stdint.h>
+#include "utility/latency_tracer.h"
 
 struct BasicAudioParams {
     uint32_t frequency;
     uint8_t bytes_per_sample;
     bool is_stereo;
+    // frame the audio was decoded from which isn't part of the audio format
+    FrameTimestamp timestamp;
     bool operator==(const BasicAudioParams& other) const {
         return (frequency == other.frequency) &&
                (bytes_per_sample == other.bytes_per_sample) &&
@@ -13,6 +13,7 @@
 #include "dab/msc/msc_decoder.h"
 #include "dab/pad/pad_processor.h"
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "viterbi_config.h"
 #include "./basic_audio_channel.h"
 #include "./basic_audio_params.h"
@@ -56,7 +57,9 @@ void Basic_DAB_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf) {
         const auto cif_buf = msc_bits_buf.subspan(
             i*m_params.nb_cif_bits, 
               m_params.nb_cif_bits);
+        const auto time_viterbi_start = StageTimer::clock::now();
         const auto decoded_bytes = m_msc_decoder->DecodeCIF(cif_buf);
+        m_stage_timers.viterbi.add(StageTimer::clock::now() - time_viterbi_start);
         // The MSC decoder can have 0 bytes if the deinterleaver is still collecting frames
         if (decoded_bytes.empty()) {
             continue;
@@ -68,15 +71,18 @@ void Basic_DAB_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf) {
             continue;
         }
  
+        const auto time_mp2_start = StageTimer::clock::now();
         plm_buffer_rewind(m_plm_buffer); // we can assume full frames are decoded each time
         plm_buffer_write(m_plm_buffer, decoded_bytes.data(), decoded_bytes.size());
         const int total_data_bytes = plm_audio_decode_header(m_plm_audio);
         if (total_data_bytes == 0) {
+            m_stage_timers.mp2_decode.add(StageTimer::clock::now() - time_mp2_start);
             m_is_error = true;
             continue;
         }
 
         plm_samples_t* samples = plm_audio_decode(m_plm_audio, total_data_bytes);
+        m_stage_timers.mp2_decode.add(StageTimer::clock::now() - time_mp2_start);
         if (samples == nullptr) {
             m_is_error = true;
             continue;
@@ -127,6 +133,7 @@ void Basic_DAB_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf) {
             params.frequency = uint32_t(sample_rate);
             params.bytes_per_sample = 2;
             params.is_stereo = true;
+            params.timestamp = m_frame_timestamp;
             m_obs_audio_data.Notify(params, data);
         }
     }
@@ -134,12 +141,12 @@ void Basic_DAB_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf) {
 
 void Basic_DAB_Channel::SetupCallbacks(void) {
     m_pad_processor->OnLabelUpdate().Attach([this](std::string_view label_str, const uint8_t charset) {
-        m_dynamic_label = std::string(label_str);
+        m_dynamic_label.assign(label_str);
         m_obs_dynamic_label.Notify(m_dynamic_label);
         LOG_MESSAGE("dynamic_label[{}]={} | charset={}", label_str.size(), label_str, charset);
     });
 
-    m_pad_processor->OnMOTUpdate().Attach([this](MOT_Entity entity) {
+    m_pad_processor->OnMOTUpdate().Attach([this](const MOT_Entity& entity) {
         auto slideshow = m_slideshow_manager->Process_MOT_Entity(entity);
         if (slideshow == nullptr) {
             m_obs_MOT_entity.Notify(entity);
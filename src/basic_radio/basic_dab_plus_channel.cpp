@@ -12,6 +12,7 @@
 #include "dab/mot/MOT_entities.h"
 #include "dab/msc/msc_decoder.h"
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "viterbi_config.h"
 #include "./basic_audio_channel.h"
 #include "./basic_audio_params.h"
@@ -24,6 +25,7 @@ Basic_DAB_Plus_Channel::Basic_DAB_Plus_Channel(const DAB_Parameters& params, con
 : Basic_Audio_Channel(params, subchannel, audio_service_type)
 {
     m_aac_frame_processor = std::make_unique<AAC_Frame_Processor>();
+    m_aac_frame_processor->SetReedSolomonTimer(&m_stage_timers.reed_solomon);
     m_aac_audio_decoder = nullptr;
     m_aac_data_decoder = std::make_unique<AAC_Data_Decoder>();
     SetupCallbacks();
@@ -48,7 +50,9 @@ void Basic_DAB_Plus_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf
         const auto cif_buf = msc_bits_buf.subspan(
             i*m_params.nb_cif_bits, 
               m_params.nb_cif_bits);
+        const auto time_viterbi_start = StageTimer::clock::now();
         const auto decoded_bytes = m_msc_decoder->DecodeCIF(cif_buf);
+        m_stage_timers.viterbi.add(StageTimer::clock::now() - time_viterbi_start);
         // The MSC decoder can have 0 bytes if the deinterleaver is still collecting frames
         if (decoded_bytes.empty()) {
             continue;
@@ -59,7 +63,7 @@ void Basic_DAB_Plus_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf
 
 void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
     // Decode audio
-    m_aac_frame_processor->OnSuperFrameHeader().Attach([this](SuperFrameHeader header) {
+    m_aac_frame_processor->OnSuperFrameHeader().Attach([this](const SuperFrameHeader& header) {
         m_super_frame_header = header;
 
         AAC_Audio_Decoder::Params audio_params;
@@ -92,7 +96,9 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
             m_obs_aac_data.Notify(m_super_frame_header, header, buf);
         }
 
+        const auto time_aac_start = StageTimer::clock::now();
         const auto res = m_aac_audio_decoder->DecodeFrame(buf);
+        m_stage_timers.aac_decode.add(StageTimer::clock::now() - time_aac_start);
         // reset error flag on new superframe
         if (au_index == 0) {
             m_is_codec_error = res.is_error;
@@ -109,6 +115,7 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
         params.frequency = audio_params.sampling_frequency;
         params.is_stereo = true;
         params.bytes_per_sample = 2;
+        params.timestamp = m_frame_timestamp;
         m_obs_audio_data.Notify(params, res.audio_buf);
     });
 
@@ -122,12 +129,12 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
 
     auto& pad_processor = m_aac_data_decoder->Get_PAD_Processor();
     pad_processor.OnLabelUpdate().Attach([this](std::string_view label_str, const uint8_t charset) {
-        m_dynamic_label = std::string(label_str);
+        m_dynamic_label.assign(label_str);
         m_obs_dynamic_label.Notify(m_dynamic_label);
         LOG_MESSAGE("dynamic_label[{}]={} | charset={}", label_str.size(), label_str, charset);
     });
 
-    pad_processor.OnMOTUpdate().Attach([this](MOT_Entity entity) {
+    pad_processor.OnMOTUpdate().Attach([this](const MOT_Entity& entity) {
         auto slideshow = m_slideshow_manager->Process_MOT_Entity(entity);
         if (slideshow == nullptr) {
             m_obs_MOT_entity.Notify(entity);
@@ -143,7 +150,7 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
         m_is_rs_error = true;
     });
 
-    m_aac_frame_processor->OnSuperFrameHeader().Attach([this](SuperFrameHeader header) {
+    m_aac_frame_processor->OnSuperFrameHeader().Attach([this](const SuperFrameHeader& header) {
         m_is_firecode_error = false;
         m_is_rs_error = false;
     });
@@ -11,6 +11,7 @@
 #include "dab/msc/msc_decoder.h"
 #include "dab/msc/msc_reed_solomon_data_packet_processor.h"
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "viterbi_config.h"
 #include "./basic_radio_logging.h"
 #include "./basic_slideshow.h"
@@ -32,7 +33,7 @@ Basic_Data_Packet_Channel::Basic_Data_Packet_Channel(const DAB_Parameters& param
             ProcessNonFECPackets(buf);
         });
     }
-    m_msc_data_packet_processor->Get_MOT_Processor().OnEntityComplete().Attach([this](MOT_Entity entity) {
+    m_msc_data_packet_processor->Get_MOT_Processor().OnEntityComplete().Attach([this](const MOT_Entity& entity) {
         auto slideshow = m_slideshow_manager->Process_MOT_Entity(entity);
         if (slideshow == nullptr) {
             m_obs_MOT_entity.Notify(entity);
@@ -57,7 +58,9 @@ void Basic_Data_Packet_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_
 
     for (int i = 0; i < m_params.nb_cifs; i++) {
         const auto cif_buf = msc_bits_buf.subspan(i*m_params.nb_cif_bits, m_params.nb_cif_bits);
+        const auto time_viterbi_start = StageTimer::clock::now();
         auto buf = m_msc_decoder->DecodeCIF(cif_buf);
+        m_stage_timers.viterbi.add(StageTimer::clock::now() - time_viterbi_start);
         // The MSC decoder can have 0 bytes if the deinterleaver is still collecting frames
         if (buf.empty()) {
             continue;
@@ -1,10 +1,27 @@
 #pragma once
 
+#include "utility/latency_tracer.h"
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "viterbi_config.h"
 
+// Time spent in each decoding stage of a subchannel
+struct Basic_MSC_Stage_Timers {
+    StageTimer viterbi;         // deinterleaving, depuncturing, viterbi decoding and descrambling of each CIF
+    StageTimer reed_solomon;    // outer code of DAB+ superframes
+    StageTimer aac_decode;
+    StageTimer mp2_decode;
+};
+
 class Basic_MSC_Runner {
+protected:
+    FrameTimestamp m_frame_timestamp;
+    Basic_MSC_Stage_Timers m_stage_timers;
 public:
     virtual ~Basic_MSC_Runner() {};
     virtual void Process(tcb::span<const viterbi_bit_t> msc_bits_buf) = 0;
+    // Frame currently being decoded so its outputs can be traced back to the IQ samples they came from
+    void SetFrameTimestamp(const FrameTimestamp& timestamp) { m_frame_timestamp = timestamp; }
+    const FrameTimestamp& GetFrameTimestamp() const { return m_frame_timestamp; }
+    const auto& GetStageTimers() const { return m_stage_timers; }
 };
@@ -2,6 +2,7 @@
 #include <stddef.h>
 #include <memory>
 #include <mutex>
+#include <string_view>
 #include <fmt/format.h>
 #include "dab/constants/dab_parameters.h"
 #include "dab/dab_misc_info.h"
@@ -9,7 +10,10 @@
 #include "dab/database/dab_database_entities.h"
 #include "dab/database/dab_database_types.h"
 #include "dab/database/dab_database_updater.h"
+#include "dab/mot/MOT_entities.h"
+#include "utility/latency_tracer.h"
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "viterbi_config.h"
 #include "./basic_audio_channel.h"
 #include "./basic_dab_channel.h"
@@ -18,6 +22,7 @@
 #include "./basic_fic_runner.h"
 #include "./basic_msc_runner.h"
 #include "./basic_radio_logging.h"
+#include "./basic_slideshow.h"
 #include "./basic_thread_pool.h"
 #define LOG_MESSAGE(...) BASIC_RADIO_LOG_MESSAGE(fmt::format(__VA_ARGS__))
 #define LOG_ERROR(...) BASIC_RADIO_LOG_ERROR(fmt::format(__VA_ARGS__))
@@ -38,28 +43,42 @@ size_t BasicRadio::GetTotalThreads() const {
     return m_thread_pool->GetTotalThreads();
 }
 
-void BasicRadio::Process(tcb::span<const viterbi_bit_t> buf) {
+void BasicRadio::Process(tcb::span<const viterbi_bit_t> buf, const FrameTimestamp& timestamp) {
     const int N = (int)buf.size();
     if (N != m_params.nb_frame_bits) {
         LOG_ERROR("Got incorrect number of frame bits {}/{}", N, m_params.nb_frame_bits);
         return;
     }
 
-    auto fic_buf = buf.subspan(0, m_params.nb_fic_bits);
-    auto msc_buf = buf.subspan(m_params.nb_fic_bits, m_params.nb_msc_bits);
+    auto frame_timestamp = timestamp;
+    frame_timestamp.time_radio_start = FrameTimestamp::clock::now();
+    if (frame_timestamp.is_valid()) {
+        m_latency_tracer.add(LatencyStage::OFDM_DEMOD, frame_timestamp.time_received, frame_timestamp.time_demodulated);
+        m_latency_tracer.add(LatencyStage::RADIO_QUEUE, frame_timestamp.time_demodulated, frame_timestamp.time_radio_start);
+    } else {
+        frame_timestamp.time_received = frame_timestamp.time_radio_start;
+        frame_timestamp.time_demodulated = frame_timestamp.time_radio_start;
+    }
+
+    m_frame_fic_buf = buf.subspan(0, m_params.nb_fic_bits);
+    m_frame_msc_buf = buf.subspan(m_params.nb_fic_bits, m_params.nb_msc_bits);
 
-    m_thread_pool->PushTask([this, fic_buf] {
-        m_fic_runner->Process(fic_buf);
+    m_thread_pool->PushTask([this] {
+        ScopedStageTimer fic_timer(m_fic_timer);
+        m_fic_runner->Process(m_frame_fic_buf);
     });
 
+    // runners are idle until their task is pushed so the timestamp can be set from here
     for (const auto& [_, msc_runner]: m_msc_runners) {
-        const auto runner = msc_runner;
-        m_thread_pool->PushTask([runner, msc_buf]() {
-            runner->Process(msc_buf);
+        auto* runner = msc_runner.get();
+        runner->SetFrameTimestamp(frame_timestamp);
+        m_thread_pool->PushTask([this, runner]() {
+            runner->Process(m_frame_msc_buf);
         });
     }
 
     m_thread_pool->WaitAll();
+    m_latency_tracer.add(LatencyStage::TOTAL_FRAME, frame_timestamp.time_received, FrameTimestamp::clock::now());
 
     UpdateAfterProcessing();
 }
@@ -125,6 +144,7 @@ void BasicRadio::UpdateAfterProcessing() {
             auto channel = std::make_shared<Basic_DAB_Plus_Channel>(m_params, subchannel, audio_type);
             m_msc_runners.insert({ subchannel.id, channel });
             m_audio_channels.insert({ subchannel.id, channel });
+            AttachLatencyTracing(*channel);
             m_obs_audio_channel.Notify(subchannel.id, *channel);
             continue;
         }
@@ -134,6 +154,7 @@ void BasicRadio::UpdateAfterProcessing() {
             auto channel = std::make_shared<Basic_DAB_Channel>(m_params, subchannel, audio_type);
             m_msc_runners.insert({ subchannel.id, channel });
             m_audio_channels.insert({ subchannel.id, channel });
+            AttachLatencyTracing(*channel);
             m_obs_audio_channel.Notify(subchannel.id, *channel);
             continue;
         } 
@@ -146,8 +167,37 @@ void BasicRadio::UpdateAfterProcessing() {
             auto channel = std::make_shared<Basic_Data_Packet_Channel>(m_params, subchannel, data_type);
             m_msc_runners.insert({ subchannel.id, channel });
             m_data_packet_channels.insert({ subchannel.id, channel });
+            AttachLatencyTracing(*channel);
             m_obs_data_packet_channel.Notify(subchannel.id, *channel);
             continue;
         }
     }
-}
\ No newline at end of file
+}
+// Listeners run on the channel's MSC thread while it is decoding the frame given by GetFrameTimestamp()
+void BasicRadio::AttachLatencyTracing(Basic_Audio_Channel& channel) {
+    auto* tracer = &m_latency_tracer;
+    const auto on_data = [tracer, &channel]() {
+        const auto now = FrameTimestamp::clock::now();
+        const auto& timestamp = channel.GetFrameTimestamp();
+        tracer->add(LatencyStage::DATA_DECODE, timestamp.time_radio_start, now);
+        tracer->add(LatencyStage::TOTAL_DATA, timestamp.time_received, now);
+    };
+    channel.OnAudioData().Attach([tracer](const BasicAudioParams& params, tcb::span<const uint8_t> /*buf*/) {
+        tracer->add(LatencyStage::AUDIO_DECODE, params.timestamp.time_radio_start, FrameTimestamp::clock::now());
+    });
+    channel.OnDynamicLabel().Attach([on_data](std::string_view /*label*/) { on_data(); });
+    channel.OnMOTEntity().Attach([on_data](const MOT_Entity& /*entity*/) { on_data(); });
+    channel.GetSlideshowManager().OnNewSlideshow().Attach([on_data](const std::shared_ptr<Basic_Slideshow>& /*slideshow*/) { on_data(); });
+}
+
+void BasicRadio::AttachLatencyTracing(Basic_Data_Packet_Channel& channel) {
+    auto* tracer = &m_latency_tracer;
+    const auto on_data = [tracer, &channel]() {
+        const auto now = FrameTimestamp::clock::now();
+        const auto& timestamp = channel.GetFrameTimestamp();
+        tracer->add(LatencyStage::DATA_DECODE, timestamp.time_radio_start, now);
+        tracer->add(LatencyStage::TOTAL_DATA, timestamp.time_received, now);
+    };
+    channel.OnMOTEntity().Attach([on_data](const MOT_Entity& /*entity*/) { on_data(); });
+    channel.GetSlideshowManager().OnNewSlideshow().Attach([on_data](const std::shared_ptr<Basic_Slideshow>& /*slideshow*/) { on_data(); });
+}
@@ -6,8 +6,10 @@
 #include <unordered_map>
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_types.h"
+#include "utility/latency_tracer.h"
 #include "utility/observable.h"
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "viterbi_config.h"
 
 struct DAB_Database;
@@ -35,10 +37,17 @@ private:
     std::unordered_map<subchannel_id_t, std::shared_ptr<Basic_Data_Packet_Channel>> m_data_packet_channels;
     Observable<subchannel_id_t, Basic_Audio_Channel&> m_obs_audio_channel;
     Observable<subchannel_id_t, Basic_Data_Packet_Channel&> m_obs_data_packet_channel;
+    LatencyTracer m_latency_tracer;
+    StageTimer m_fic_timer;
+    // frame being decoded by the thread pool
+    // tasks only capture pointers so they fit inside std::function without allocating
+    tcb::span<const viterbi_bit_t> m_frame_fic_buf;
+    tcb::span<const viterbi_bit_t> m_frame_msc_buf;
 public:
     explicit BasicRadio(const DAB_Parameters& params, const size_t nb_threads=0);
     ~BasicRadio();
-    void Process(tcb::span<const viterbi_bit_t> buf);
+    // timestamp identifies the OFDM frame the bits came from, otherwise the frame is timed from when it is processed
+    void Process(tcb::span<const viterbi_bit_t> buf, const FrameTimestamp& timestamp={});
     Basic_Audio_Channel* Get_Audio_Channel(const subchannel_id_t id);
     Basic_Data_Packet_Channel* Get_Data_Packet_Channel(const subchannel_id_t id);
     auto& GetMutex() { return m_mutex_data; }
@@ -47,7 +56,11 @@ public:
     auto& GetDatabaseStatistics() { return *(m_dab_database_stats.get()); }
     auto& On_Audio_Channel() { return m_obs_audio_channel; }
     auto& On_Data_Packet_Channel() { return m_obs_data_packet_channel; }
+    auto& GetLatencyTracer() { return m_latency_tracer; }
+    const auto& GetFICTimer() const { return m_fic_timer; }
     size_t GetTotalThreads() const;
 private:
     void UpdateAfterProcessing();
+    void AttachLatencyTracing(Basic_Audio_Channel& channel);
+    void AttachLatencyTracing(Basic_Data_Packet_Channel& channel);
 };
\ No newline at end of file
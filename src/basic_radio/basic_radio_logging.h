@@ -3,13 +3,20 @@
 #if BASIC_RADIO_LOGGING_USE_EASYLOGGING
 
 #include <easylogging++.h>
+#include <atomic>
 #include <string>
 
 static const char* BASIC_RADIO_LOGGER = "basic-radio";
-static void BASIC_RADIO_LOG_MESSAGE(const std::string&& message) { CLOG(INFO, BASIC_RADIO_LOGGER) << message; }
-static void BASIC_RADIO_LOG_WARN(const std::string&& message) { CLOG(WARNING, BASIC_RADIO_LOGGER) << message; }
-static void BASIC_RADIO_LOG_ERROR(const std::string&& message) { CLOG(ERROR, BASIC_RADIO_LOGGER) << message; }
-static void BASIC_RADIO_SET_THREAD_NAME(const std::string&& name) { el::Helpers::setThreadName(name); }
+// Checked before a message or thread name is formatted so disabled logging doesn't allocate on every frame
+inline std::atomic<bool>& get_basic_radio_logging_enabled() {
+    static std::atomic<bool> is_enabled{true};
+    return is_enabled;
+}
+#define BASIC_RADIO_LOG_IS_ENABLED() get_basic_radio_logging_enabled().load(std::memory_order_relaxed)
+#define BASIC_RADIO_LOG_MESSAGE(message) do { if (BASIC_RADIO_LOG_IS_ENABLED()) { CLOG(INFO, BASIC_RADIO_LOGGER) << (message); } } while (0)
+#define BASIC_RADIO_LOG_WARN(message) do { if (BASIC_RADIO_LOG_IS_ENABLED()) { CLOG(WARNING, BASIC_RADIO_LOGGER) << (message); } } while (0)
+#define BASIC_RADIO_LOG_ERROR(message) do { if (BASIC_RADIO_LOG_IS_ENABLED()) { CLOG(ERROR, BASIC_RADIO_LOGGER) << (message); } } while (0)
+#define BASIC_RADIO_SET_THREAD_NAME(name) do { if (BASIC_RADIO_LOG_IS_ENABLED()) { el::Helpers::setThreadName(name); } } while (0)
 
 #else
 
@@ -1,15 +1,20 @@
 #include "./basic_slideshow.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <algorithm>
+#include <atomic>
 #include <ctime>
 #include <iterator>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <fmt/format.h>
 #include "dab/constants/MOT_content_types.h"
 #include "dab/mot/MOT_entities.h"
 #include "dab/mot/MOT_slideshow_processor.h"
+#include "utility/hash.h"
+#include "utility/span.h"
 #include "./basic_radio_logging.h"
 #define LOG_MESSAGE(...) BASIC_RADIO_LOG_MESSAGE(fmt::format(__VA_ARGS__))
 #define LOG_ERROR(...) BASIC_RADIO_LOG_ERROR(fmt::format(__VA_ARGS__))
@@ -25,95 +30,153 @@ static std::time_t Convert_MOT_Time(const MOT_UTC_Time& time) {
     return std::mktime(&t);
 }
 
-Basic_Slideshow_Manager::Basic_Slideshow_Manager(size_t max_slideshows) {
-    m_max_size = max_slideshows;
-}
-
-std::shared_ptr<Basic_Slideshow> Basic_Slideshow_Manager::Process_MOT_Entity(MOT_Entity& entity) {
-    // DOC: ETSI TS 101 499
-    // Clause 6.2.3 MOT ContentTypes and ContentSubTypes 
-    // For specific types used for slideshows
-    const auto type = entity.header.content_type;
-    const auto sub_type = entity.header.content_sub_type;
-    const auto mot_type = GetMOTContentType(type, sub_type);
-
-    Basic_Image_Type image_type = Basic_Image_Type::NONE;
-    switch (mot_type) {
-    case MOT_Content_Subtype::IMAGE_JPEG:
-        image_type = Basic_Image_Type::JPEG;
-        break;
-    case MOT_Content_Subtype::IMAGE_PNG:
-        image_type = Basic_Image_Type::PNG;
-        break;
-    default:
-        return nullptr;
-    }
+// Strings are assigned so a slideshow that is updated in place reuses their capacity
+static void Update_Slideshow(Basic_Slideshow& slideshow, const MOT_Entity& entity) {
+    slideshow.transport_id = entity.transport_id;
+    slideshow.last_received_time = std::time(nullptr);
 
     // User application header extension parameters
-    auto slideshow = std::make_shared<Basic_Slideshow>();
-    slideshow->transport_id = entity.transport_id;
-    slideshow->image_type = image_type;
-
     MOT_Slideshow slideshow_header;
     for (const auto& p: entity.header.user_app_params) {
         MOT_Slideshow_Processor::ProcessHeaderExtension(slideshow_header, p.type, p.data);
     }
 
-    const size_t total_bytes = entity.body_buf.size();
-    slideshow->image_data.resize(total_bytes);
-    std::copy_n(entity.body_buf.begin(), total_bytes, slideshow->image_data.begin());
-
     // Core MOT header parameters
     auto& content_name = entity.header.content_name;
+    slideshow.name_charset = content_name.exists ? content_name.charset : 0;
     if (content_name.exists) {
-        slideshow->name_charset = content_name.charset;
-        slideshow->name = std::string(content_name.name);
+        slideshow.name.assign(content_name.name);
+    } else {
+        slideshow.name.clear();
     }
     auto& expire_time = entity.header.expire_time;
-    if (expire_time.exists) {
-        slideshow->expire_time = Convert_MOT_Time(expire_time);
-    }
+    slideshow.expire_time = expire_time.exists ? Convert_MOT_Time(expire_time) : 0;
     auto& trigger_time = entity.header.trigger_time;
-    if (trigger_time.exists) {
-        slideshow->trigger_time = Convert_MOT_Time(trigger_time);
-    }
+    slideshow.trigger_time = trigger_time.exists ? Convert_MOT_Time(trigger_time) : 0;
 
     // Slideshow MOT header parameters
-    slideshow->category_id = slideshow_header.category_id;
-    slideshow->slide_id = slideshow_header.slide_id;
-
-    auto& category_title = slideshow_header.category_title;
-    slideshow->category_title = std::string(category_title);
+    slideshow.category_id = slideshow_header.category_id;
+    slideshow.slide_id = slideshow_header.slide_id;
+    slideshow.category_title.assign(slideshow_header.category_title);
+    slideshow.alt_location_url.assign(slideshow_header.alt_location_url);
+    slideshow.click_through_url.assign(slideshow_header.click_through_url);
 
-    auto& alt_location_url = slideshow_header.alt_location_url;
-    slideshow->alt_location_url = std::string(alt_location_url);
-
-    auto& click_through_url = slideshow_header.click_through_url;
-    slideshow->click_through_url = std::string(click_through_url);
-
-    auto& alert = slideshow_header.alert;
-    switch (alert) {
+    switch (slideshow_header.alert) {
     case MOT_Slideshow_Alert::EMERGENCY:
-        slideshow->is_emergency_alert = true;
+        slideshow.is_emergency_alert = true;
         break;
     case MOT_Slideshow_Alert::NOT_USED:
     case MOT_Slideshow_Alert::RESERVED_FUTURE_USE:
     default:
-        slideshow->is_emergency_alert = false;
+        slideshow.is_emergency_alert = false;
         break;
     }
- 
+}
+
+Basic_Slideshow_Manager::Basic_Slideshow_Manager(size_t max_slideshows, size_t max_image_history)
+: m_image_history(max_image_history)
+{
+    m_max_size = max_slideshows;
+}
+
+std::shared_ptr<Basic_Slideshow> Basic_Slideshow_Manager::Process_MOT_Entity(const MOT_Entity& entity) {
+    // DOC: ETSI TS 101 499
+    // Clause 6.2.3 MOT ContentTypes and ContentSubTypes 
+    // For specific types used for slideshows
+    const auto type = entity.header.content_type;
+    const auto sub_type = entity.header.content_sub_type;
+    const auto mot_type = GetMOTContentType(type, sub_type);
+
+    Basic_Image_Type image_type = Basic_Image_Type::NONE;
+    switch (mot_type) {
+    case MOT_Content_Subtype::IMAGE_JPEG:
+        image_type = Basic_Image_Type::JPEG;
+        break;
+    case MOT_Content_Subtype::IMAGE_PNG:
+        image_type = Basic_Image_Type::PNG;
+        break;
+    default:
+        return nullptr;
+    }
+
+    const uint64_t image_hash = fnv1a_hash(entity.body_buf);
+    std::shared_ptr<Basic_Slideshow> slideshow = nullptr;
+    bool is_seen_before = false;
+    bool is_repeat = false;
     {
         auto lock = std::unique_lock(m_mutex_slideshows);
-        m_slideshows.push_front(slideshow);
+        auto repeat = FindRepeat(image_hash, entity.body_buf);
+        auto* history = m_image_history.find(image_hash);
+        if (repeat != m_slideshows.end()) {
+            // carousels resend the same image with a new trigger time, expiry or name
+            // readers copy slideshows out while holding the lock and then use them without locking
+            // so an existing slideshow is only updated in place if nothing else holds onto it
+            m_slideshows.splice(m_slideshows.begin(), m_slideshows, repeat);
+            auto& prev_slideshow = m_slideshows.front();
+            if (prev_slideshow.use_count() == 1) {
+                // pairs with the release when the last reader dropped its reference
+                std::atomic_thread_fence(std::memory_order_acquire);
+                slideshow = prev_slideshow;
+            } else {
+                slideshow = std::make_shared<Basic_Slideshow>();
+                slideshow->image_data = prev_slideshow->image_data;
+                slideshow->total_repeats = prev_slideshow->total_repeats.load();
+                prev_slideshow = slideshow;
+            }
+            slideshow->total_repeats++;
+            is_seen_before = true;
+            is_repeat = true;
+        } else {
+            slideshow = std::make_shared<Basic_Slideshow>();
+            if (history != nullptr) {
+                auto image_data = history->image_data.lock();
+                // guard against hash collisions
+                const bool is_same = (image_data == nullptr) || (
+                    (image_data->size() == entity.body_buf.size()) &&
+                    std::equal(entity.body_buf.begin(), entity.body_buf.end(), image_data->begin())
+                );
+                if (is_same) {
+                    slideshow->image_data = image_data;
+                    is_seen_before = true;
+                }
+            }
+            if (slideshow->image_data == nullptr) {
+                slideshow->image_data = std::make_shared<const std::vector<uint8_t>>(entity.body_buf.begin(), entity.body_buf.end());
+            }
+            m_slideshows.push_front(slideshow);
+        }
+        slideshow->image_hash = image_hash;
+        slideshow->image_type = image_type;
+        Update_Slideshow(*slideshow, entity);
+        m_image_history.emplace(image_hash).image_data = slideshow->image_data;
         RestrictSize();
     }
 
-    LOG_MESSAGE("Added slideshow tid={} name={}", slideshow->transport_id, slideshow->name);
-    m_obs_on_new_slideshow.Notify(slideshow);
+    if (is_repeat) {
+        LOG_MESSAGE("Repeated slideshow tid={} name={} hash={:016x}", slideshow->transport_id, slideshow->name, image_hash);
+        return slideshow;
+    }
+    LOG_MESSAGE("Added slideshow tid={} name={} hash={:016x}", slideshow->transport_id, slideshow->name, image_hash);
+    if (!is_seen_before) {
+        m_obs_on_new_slideshow.Notify(slideshow);
+    }
     return slideshow;
 }
 
+// Caller must hold m_mutex_slideshows
+std::list<std::shared_ptr<Basic_Slideshow>>::iterator Basic_Slideshow_Manager::FindRepeat(const uint64_t hash, tcb::span<const uint8_t> data) {
+    for (auto it = m_slideshows.begin(); it != m_slideshows.end(); it++) {
+        auto& slideshow = *it;
+        if (slideshow->image_hash != hash) continue;
+        // guard against hash collisions
+        const auto& image_data = *(slideshow->image_data);
+        if (image_data.size() != data.size()) continue;
+        if (!std::equal(data.begin(), data.end(), image_data.begin())) continue;
+        return it;
+    }
+    return m_slideshows.end();
+}
+
 void Basic_Slideshow_Manager::SetMaxSize(const size_t max_size) {
     auto lock = std::unique_lock(m_mutex_slideshows);
     m_max_size = max_size;
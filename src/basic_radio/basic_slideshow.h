@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 #include <string>
 #include <list>
 #include <vector>
@@ -9,7 +10,9 @@
 #include <mutex>
 
 #include "dab/mot/MOT_entities.h"
+#include "utility/lru_cache.h"
 #include "utility/observable.h"
+#include "utility/span.h"
 
 enum class Basic_Image_Type {
     NONE, JPEG, PNG
@@ -28,20 +31,33 @@ struct Basic_Slideshow {
     std::string click_through_url = "";
     std::string alt_location_url = "";
     bool is_emergency_alert = false;
-    std::vector<uint8_t> image_data;
+    // Stations repeat the same images in a carousel so the image body is shared between repeats
+    uint64_t image_hash = 0;
+    std::shared_ptr<const std::vector<uint8_t>> image_data;
+    std::atomic<std::time_t> last_received_time = 0;
+    std::atomic<uint32_t> total_repeats = 0;
 };
 
 class Basic_Slideshow_Manager 
 {
 private:
+    // weak so the history doesn't keep every evicted image alive
+    // but an image still held elsewhere (gui, scraper) is shared instead of copied when it comes back
+    struct Image_History_Entry {
+        std::weak_ptr<const std::vector<uint8_t>> image_data;
+    };
     std::list<std::shared_ptr<Basic_Slideshow>> m_slideshows;
+    // content hashes of recently received images so evicted images aren't reported as new
+    LRU_Cache<uint64_t, Image_History_Entry> m_image_history;
     Observable<std::shared_ptr<Basic_Slideshow>> m_obs_on_new_slideshow;
     size_t m_max_size;
     std::mutex m_mutex_slideshows;
 public:
-    explicit Basic_Slideshow_Manager(size_t max_slideshows=25);
+    explicit Basic_Slideshow_Manager(size_t max_slideshows=25, size_t max_image_history=1000);
     // returns nullptr if MOT entity wasn't a slideshow
-    std::shared_ptr<Basic_Slideshow> Process_MOT_Entity(MOT_Entity& entity);
+    // repeated images take the latest header, share the existing image body and aren't notified as new
+    // the existing slideshow is updated in place unless a reader still holds it, in which case it is replaced
+    std::shared_ptr<Basic_Slideshow> Process_MOT_Entity(const MOT_Entity& entity);
     auto& GetSlideshowsMutex(void) { return m_mutex_slideshows; }
     auto& GetSlideshows(void) { return m_slideshows; }
     auto& OnNewSlideshow(void) { return m_obs_on_new_slideshow; }
@@ -49,4 +65,5 @@ public:
     size_t GetMaxSize(void) const { return m_max_size; };
 private:
     void RestrictSize(void);
+    std::list<std::shared_ptr<Basic_Slideshow>>::iterator FindRepeat(const uint64_t hash, tcb::span<const uint8_t> data);
 };
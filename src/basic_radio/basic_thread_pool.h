@@ -4,7 +4,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <thread>
-#include <queue>
+#include <utility>
 #include <vector>
 #include <stddef.h>
 
@@ -21,13 +21,16 @@ private:
     int m_total_tasks;
     std::mutex m_mutex_total_tasks;
     std::condition_variable m_cv_wait_task;
-    std::queue<Task> m_task_queue;
+    // queue is reset once drained so its capacity is reused every frame instead of reallocated
+    std::vector<Task> m_task_queue;
+    size_t m_task_queue_head;
     // wait all tasks
     bool m_is_wait_all;
     std::condition_variable m_cv_wait_done;
 public:
     explicit BasicThreadPool(size_t nb_threads=0) {
         m_total_tasks = 0;
+        m_task_queue_head = 0;
         m_is_running = true;
         m_is_wait_all = false;
         m_nb_threads = nb_threads ? nb_threads : std::thread::hardware_concurrency();
@@ -54,7 +57,7 @@ public:
     }
     void PushTask(const Task& task) {
         auto lock = std::scoped_lock(m_mutex_total_tasks);
-        m_task_queue.push(task);
+        m_task_queue.push_back(task);
         m_total_tasks++;
         m_cv_wait_task.notify_one();
     }
@@ -74,15 +77,19 @@ private:
         while (m_is_running) {
             auto lock = std::unique_lock(m_mutex_total_tasks);
             m_cv_wait_task.wait(lock, [this] {
-                return !m_task_queue.empty() || !m_is_running;
+                return (m_task_queue_head < m_task_queue.size()) || !m_is_running;
             });
 
             if (!m_is_running) {
                 break;
             }
 
-            auto task = m_task_queue.front();
-            m_task_queue.pop();
+            auto task = std::move(m_task_queue[m_task_queue_head]);
+            m_task_queue_head++;
+            if (m_task_queue_head == m_task_queue.size()) {
+                m_task_queue.clear();
+                m_task_queue_head = 0;
+            }
 
             lock.unlock();
             task();
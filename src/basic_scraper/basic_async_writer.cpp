@@ -0,0 +1,244 @@
+#include "./basic_async_writer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+#include "utility/span.h"
+
+namespace fs = std::filesystem;
+
+#include "./basic_scraper_logging.h"
+#define LOG_MESSAGE(...) BASIC_SCRAPER_LOG_MESSAGE(fmt::format(__VA_ARGS__))
+#define LOG_ERROR(...) BASIC_SCRAPER_LOG_ERROR(fmt::format(__VA_ARGS__))
+
+// keep a handful of batch buffers around so steady state writing doesn't allocate
+constexpr size_t MAX_FREE_BUFFERS = 16;
+
+BasicAsyncWriter::BasicAsyncWriter(const BasicAsyncWriterConfig& config)
+: m_config(config)
+{
+    m_is_running = true;
+    m_thread = std::thread(&BasicAsyncWriter::RunnerThread, this);
+}
+
+BasicAsyncWriter::~BasicAsyncWriter() {
+    {
+        auto lock = std::scoped_lock(m_mutex_queue);
+        m_is_running = false;
+    }
+    m_cv_job.notify_one();
+    m_thread.join();
+}
+
+std::unique_ptr<BasicAsyncFile> BasicAsyncWriter::OpenFile(const fs::path& path) {
+    auto file = std::make_shared<File>();
+    file->path = path;
+    Job job;
+    job.type = JobType::OPEN;
+    job.file = file;
+    PushJob(std::move(job));
+    return std::make_unique<BasicAsyncFile>(shared_from_this(), file);
+}
+
+bool BasicAsyncWriter::WriteFile(const fs::path& path, std::vector<uint8_t>&& data) {
+    auto file = std::make_shared<File>();
+    file->path = path;
+    Job job;
+    job.type = JobType::WRITE_WHOLE_FILE;
+    job.file = file;
+    job.data = std::move(data);
+    return PushJob(std::move(job));
+}
+
+BasicAsyncWriterStats BasicAsyncWriter::GetStats() {
+    auto lock = std::scoped_lock(m_mutex_queue);
+    return m_stats;
+}
+
+bool BasicAsyncWriter::PushJob(Job&& job) {
+    const size_t nb_bytes = job.data.size();
+    // open/patch/close jobs are tiny and must never be dropped otherwise files are left in a bad state
+    const bool is_control = (job.type == JobType::OPEN) || (job.type == JobType::PATCH) || (job.type == JobType::CLOSE);
+
+    auto lock = std::unique_lock(m_mutex_queue);
+    const auto is_full = [this, nb_bytes]() {
+        return (m_stats.nb_queue_bytes != 0) && ((m_stats.nb_queue_bytes + nb_bytes) > m_config.max_queue_bytes);
+    };
+    if (!is_control && is_full()) {
+        if (m_config.is_drop_on_full) {
+            m_stats.nb_jobs_dropped++;
+            m_stats.nb_bytes_dropped += nb_bytes;
+            return false;
+        }
+        m_stats.nb_stalls++;
+        m_cv_space.wait(lock, [&is_full]() { return !is_full(); });
+    }
+
+    if (!is_control) {
+        m_stats.nb_queue_bytes += nb_bytes;
+        m_stats.nb_peak_queue_bytes = std::max(m_stats.nb_peak_queue_bytes, m_stats.nb_queue_bytes);
+    }
+    m_queue.push_back(std::move(job));
+    lock.unlock();
+    m_cv_job.notify_one();
+    return true;
+}
+
+std::vector<uint8_t> BasicAsyncWriter::AcquireBuffer() {
+    std::vector<uint8_t> buf;
+    {
+        auto lock = std::scoped_lock(m_mutex_queue);
+        if (!m_free_buffers.empty()) {
+            buf = std::move(m_free_buffers.back());
+            m_free_buffers.pop_back();
+        }
+    }
+    buf.clear();
+    buf.reserve(m_config.batch_size);
+    return buf;
+}
+
+void BasicAsyncWriter::RunnerThread() {
+    auto lock = std::unique_lock(m_mutex_queue);
+    while (true) {
+        m_cv_job.wait(lock, [this] {
+            return !m_queue.empty() || !m_is_running;
+        });
+        // drain all pending jobs before exiting
+        if (m_queue.empty()) {
+            break;
+        }
+
+        auto job = std::move(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+        RunJob(job);
+        lock.lock();
+
+        const bool is_control = (job.type == JobType::OPEN) || (job.type == JobType::PATCH) || (job.type == JobType::CLOSE);
+        if (!is_control) {
+            m_stats.nb_queue_bytes -= job.data.size();
+        }
+        if ((job.type == JobType::WRITE) && (m_free_buffers.size() < MAX_FREE_BUFFERS)) {
+            m_free_buffers.push_back(std::move(job.data));
+        }
+        m_cv_space.notify_all();
+    }
+}
+
+void BasicAsyncWriter::RunJob(Job& job) {
+    auto& file = *(job.file.get());
+    const auto open_file = [this, &file]() {
+        std::error_code ec;
+        fs::create_directories(file.path.parent_path(), ec);
+        auto filepath_str = file.path.string();
+        file.fp = fopen(filepath_str.c_str(), "wb+");
+        if (file.fp == nullptr) {
+            LOG_ERROR("Failed to open file {}", filepath_str);
+            auto lock = std::scoped_lock(m_mutex_queue);
+            m_stats.nb_errors++;
+        }
+    };
+    const auto write_file = [this, &file](tcb::span<const uint8_t> data) {
+        if (file.fp == nullptr) return;
+        const size_t nb_written = fwrite(data.data(), sizeof(uint8_t), data.size(), file.fp);
+        auto lock = std::scoped_lock(m_mutex_queue);
+        m_stats.nb_bytes_written += nb_written;
+        if (nb_written != data.size()) {
+            LOG_ERROR("Failed to write bytes {}/{} to {}", nb_written, data.size(), file.path.string());
+            m_stats.nb_errors++;
+        }
+    };
+    const auto close_file = [&file]() {
+        if (file.fp == nullptr) return;
+        fclose(file.fp);
+        file.fp = nullptr;
+    };
+
+    switch (job.type) {
+    case JobType::OPEN:
+        open_file();
+        if (file.fp != nullptr) LOG_MESSAGE("Opened file {}", file.path.string());
+        break;
+    case JobType::WRITE:
+        write_file(job.data);
+        break;
+    case JobType::PATCH:
+        if (file.fp == nullptr) break;
+        fseek(file.fp, job.offset, SEEK_SET);
+        write_file(job.data);
+        fseek(file.fp, 0, SEEK_END);
+        break;
+    case JobType::CLOSE:
+        close_file();
+        break;
+    case JobType::WRITE_WHOLE_FILE:
+        open_file();
+        write_file(job.data);
+        close_file();
+        LOG_MESSAGE("Wrote file {}", file.path.string());
+        break;
+    }
+}
+
+BasicAsyncFile::BasicAsyncFile(std::shared_ptr<BasicAsyncWriter> writer, std::shared_ptr<BasicAsyncWriter::File> file)
+: m_writer(writer), m_file(file)
+{}
+
+BasicAsyncFile::~BasicAsyncFile() {
+    Flush();
+    BasicAsyncWriter::Job job;
+    job.type = BasicAsyncWriter::JobType::CLOSE;
+    job.file = m_file;
+    m_writer->PushJob(std::move(job));
+}
+
+void BasicAsyncFile::Write(tcb::span<const uint8_t> data) {
+    const size_t batch_size = m_writer->GetConfig().batch_size;
+    while (!data.empty()) {
+        if (m_batch.capacity() == 0) {
+            m_batch = m_writer->AcquireBuffer();
+        }
+        const size_t nb_free = batch_size - std::min(m_batch.size(), batch_size);
+        const size_t nb_copy = std::min(nb_free, data.size());
+        m_batch.insert(m_batch.end(), data.begin(), data.begin() + nb_copy);
+        data = data.subspan(nb_copy);
+        if (m_batch.size() >= batch_size) {
+            Flush();
+        }
+    }
+}
+
+void BasicAsyncFile::Patch(long offset, tcb::span<const uint8_t> data) {
+    BasicAsyncWriter::Job job;
+    job.type = BasicAsyncWriter::JobType::PATCH;
+    job.file = m_file;
+    job.data.assign(data.begin(), data.end());
+    job.offset = offset;
+    m_writer->PushJob(std::move(job));
+}
+
+bool BasicAsyncFile::Flush() {
+    if (m_batch.empty()) {
+        return true;
+    }
+    const size_t nb_bytes = m_batch.size();
+    BasicAsyncWriter::Job job;
+    job.type = BasicAsyncWriter::JobType::WRITE;
+    job.file = m_file;
+    job.data = std::move(m_batch);
+    m_batch = std::vector<uint8_t>();
+    const bool is_accepted = m_writer->PushJob(std::move(job));
+    if (is_accepted) {
+        m_nb_bytes_flushed += nb_bytes;
+    }
+    return is_accepted;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utility/span.h"
+
+namespace fs = std::filesystem;
+
+struct BasicAsyncWriterConfig {
+    // bytes accumulated by a file handle before it is pushed to the writer thread
+    size_t batch_size = 256*1024;
+    // upper limit on data bytes waiting in the queue
+    size_t max_queue_bytes = 64*1024*1024;
+    // when the queue is full either drop the data or stall the producer until there is space
+    bool is_drop_on_full = true;
+};
+
+struct BasicAsyncWriterStats {
+    size_t nb_bytes_written = 0;
+    size_t nb_bytes_dropped = 0;
+    size_t nb_jobs_dropped = 0;
+    size_t nb_stalls = 0;
+    size_t nb_errors = 0;
+    size_t nb_queue_bytes = 0;
+    size_t nb_peak_queue_bytes = 0;
+};
+
+class BasicAsyncFile;
+
+// All disk I/O for the scraper runs on a dedicated thread so slow disks cannot stall the decoders
+// Jobs are executed in submission order, so a file is always opened before it is written/patched/closed
+class BasicAsyncWriter: public std::enable_shared_from_this<BasicAsyncWriter>
+{
+private:
+    struct File {
+        fs::path path;
+        FILE* fp = nullptr;
+    };
+    enum class JobType { OPEN, WRITE, PATCH, CLOSE, WRITE_WHOLE_FILE };
+    struct Job {
+        JobType type;
+        std::shared_ptr<File> file;
+        std::vector<uint8_t> data;
+        long offset = 0;
+    };
+private:
+    const BasicAsyncWriterConfig m_config;
+    bool m_is_running;
+    std::mutex m_mutex_queue;
+    std::condition_variable m_cv_job;
+    std::condition_variable m_cv_space;
+    std::deque<Job> m_queue;
+    std::vector<std::vector<uint8_t>> m_free_buffers;
+    BasicAsyncWriterStats m_stats;
+    std::thread m_thread;
+public:
+    explicit BasicAsyncWriter(const BasicAsyncWriterConfig& config = {});
+    // drains all pending jobs before returning
+    ~BasicAsyncWriter();
+    BasicAsyncWriter(BasicAsyncWriter&) = delete;
+    BasicAsyncWriter(BasicAsyncWriter&&) = delete;
+    BasicAsyncWriter& operator=(BasicAsyncWriter&) = delete;
+    BasicAsyncWriter& operator=(BasicAsyncWriter&&) = delete;
+    // file is opened lazily on the writer thread
+    std::unique_ptr<BasicAsyncFile> OpenFile(const fs::path& path);
+    // open, write and close a file in a single job
+    bool WriteFile(const fs::path& path, std::vector<uint8_t>&& data);
+    BasicAsyncWriterStats GetStats();
+    const auto& GetConfig() const { return m_config; }
+private:
+    friend class BasicAsyncFile;
+    bool PushJob(Job&& job);
+    std::vector<uint8_t> AcquireBuffer();
+    void RunnerThread();
+    void RunJob(Job& job);
+};
+
+// Producer side handle that batches small writes into large buffers
+// Not thread safe, each handle should only be used by a single producer
+class BasicAsyncFile
+{
+private:
+    std::shared_ptr<BasicAsyncWriter> m_writer;
+    std::shared_ptr<BasicAsyncWriter::File> m_file;
+    std::vector<uint8_t> m_batch;
+    size_t m_nb_bytes_flushed = 0;
+public:
+    BasicAsyncFile(std::shared_ptr<BasicAsyncWriter> writer, std::shared_ptr<BasicAsyncWriter::File> file);
+    // flushes remaining data and closes file
+    ~BasicAsyncFile();
+    BasicAsyncFile(BasicAsyncFile&) = delete;
+    BasicAsyncFile(BasicAsyncFile&&) = delete;
+    BasicAsyncFile& operator=(BasicAsyncFile&) = delete;
+    BasicAsyncFile& operator=(BasicAsyncFile&&) = delete;
+    void Write(tcb::span<const uint8_t> data);
+    // overwrite bytes at an absolute offset without moving the append position
+    void Patch(long offset, tcb::span<const uint8_t> data);
+    // returns false if the batch was dropped because the queue was full
+    bool Flush();
+    // number of bytes accepted by the writer thread
+    size_t GetTotalBytesFlushed() const { return m_nb_bytes_flushed; }
+};
@@ -1,12 +1,14 @@
 #include "./basic_scraper.h"
 #include <stdint.h>
-#include <stdio.h>
+#include <stddef.h>
 #include <cstring>
 #include <ctime>
 #include <filesystem>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 #include <fmt/format.h>
 #include "basic_radio/basic_audio_channel.h"
 #include "basic_radio/basic_audio_params.h"
@@ -19,6 +21,7 @@
 #include "dab/database/dab_database.h"
 #include "dab/database/dab_database_entities.h"
 #include "dab/database/dab_database_types.h"
+#include "utility/latency_tracer.h"
 #include "utility/span.h"
 
 namespace fs = std::filesystem;
@@ -64,9 +67,9 @@ void BasicScraper::attach_to_radio(std::shared_ptr<BasicScraper> scraper, BasicR
             auto base_path = fs::path(root_folder) / fs::path(child_folder);
             auto abs_path = fs::absolute(base_path);
 
-            auto dab_plus_scraper = std::make_shared<Basic_Audio_Channel_Scraper>(abs_path);
+            auto dab_plus_scraper = std::make_shared<Basic_Audio_Channel_Scraper>(abs_path, scraper->m_writer);
             scraper->m_scrapers.push_back(dab_plus_scraper);
-            Basic_Audio_Channel_Scraper::attach_to_channel(dab_plus_scraper, channel);
+            Basic_Audio_Channel_Scraper::attach_to_channel(dab_plus_scraper, channel, &radio.GetLatencyTracer());
         }
     );
     radio.On_Data_Packet_Channel().Attach(
@@ -82,14 +85,14 @@ void BasicScraper::attach_to_radio(std::shared_ptr<BasicScraper> scraper, BasicR
             auto base_path = fs::path(root_folder) / fs::path(child_folder);
             auto abs_path = fs::absolute(base_path);
 
-            auto mot_scraper = std::make_shared<BasicMOTScraper>(abs_path / "MOT");
-            channel.OnMOTEntity().Attach([mot_scraper](MOT_Entity mot_entity) {
+            auto mot_scraper = std::make_shared<BasicMOTScraper>(abs_path / "MOT", scraper->m_writer);
+            channel.OnMOTEntity().Attach([mot_scraper](const MOT_Entity& mot_entity) {
                 mot_scraper->OnMOTEntity(mot_entity);
             });
 
-            auto slideshow_scraper = std::make_shared<BasicSlideshowScraper>(abs_path / "slideshow");
+            auto slideshow_scraper = std::make_shared<BasicSlideshowScraper>(abs_path / "slideshow", scraper->m_writer);
             channel.GetSlideshowManager().OnNewSlideshow().Attach(
-                [slideshow_scraper](std::shared_ptr<Basic_Slideshow> slideshow) {
+                [slideshow_scraper](const std::shared_ptr<Basic_Slideshow>& slideshow) {
                     slideshow_scraper->OnSlideshow(*slideshow);
                 }
             );
@@ -97,29 +100,34 @@ void BasicScraper::attach_to_radio(std::shared_ptr<BasicScraper> scraper, BasicR
     );
 }
 
-Basic_Audio_Channel_Scraper::Basic_Audio_Channel_Scraper(const fs::path& dir) 
+Basic_Audio_Channel_Scraper::Basic_Audio_Channel_Scraper(const fs::path& dir, std::shared_ptr<BasicAsyncWriter> writer) 
 : m_dir(dir), 
-  m_audio_scraper(dir / "audio"), 
-  m_slideshow_scraper(dir / "slideshow"),
-  m_mot_scraper(dir / "MOT")
+  m_writer(writer),
+  m_audio_scraper(dir / "audio", writer), 
+  m_slideshow_scraper(dir / "slideshow", writer),
+  m_mot_scraper(dir / "MOT", writer)
 {
     LOG_MESSAGE("[DAB+] Opened directory {}", m_dir.string());
 }
 
-void Basic_Audio_Channel_Scraper::attach_to_channel(std::shared_ptr<Basic_Audio_Channel_Scraper> scraper, Basic_Audio_Channel& channel) {
+void Basic_Audio_Channel_Scraper::attach_to_channel(std::shared_ptr<Basic_Audio_Channel_Scraper> scraper, Basic_Audio_Channel& channel, LatencyTracer* latency_tracer) {
     if (scraper == nullptr) return;
     channel.OnAudioData().Attach(
-        [scraper](BasicAudioParams params, tcb::span<const uint8_t> data) {
+        [scraper, latency_tracer](BasicAudioParams params, tcb::span<const uint8_t> data) {
+            const auto time_decoded = FrameTimestamp::clock::now();
             scraper->m_audio_scraper.OnAudioData(params, data);
+            if (latency_tracer != nullptr) {
+                latency_tracer->add(LatencyStage::SCRAPER_OUTPUT, time_decoded, FrameTimestamp::clock::now());
+            }
         }
     );
     channel.GetSlideshowManager().OnNewSlideshow().Attach(
-        [scraper](std::shared_ptr<Basic_Slideshow> slideshow) {
+        [scraper](const std::shared_ptr<Basic_Slideshow>& slideshow) {
             scraper->m_slideshow_scraper.OnSlideshow(*slideshow);
         }
     );
     channel.OnMOTEntity().Attach(
-        [scraper](MOT_Entity mot) {
+        [scraper](const MOT_Entity& mot) {
             scraper->m_mot_scraper.OnMOTEntity(mot);
         }
     );
@@ -130,29 +138,21 @@ void Basic_Audio_Channel_Scraper::attach_to_channel(std::shared_ptr<Basic_Audio_
         derived.OnMP2Data().Attach([scraper](tcb::span<const uint8_t> data) {
             auto& writer = scraper->m_audio_mp2_writer;
             if (writer == nullptr) {
-                auto dir = scraper->m_dir / "mp2";
-                fs::create_directories(dir);
-                auto filepath = dir / fmt::format("{}_audio.mp2", GetCurrentTime());
-                auto filepath_str = filepath.string();
-                FILE* fp = fopen(filepath_str.c_str(), "wb+");
-                if (fp != nullptr) LOG_MESSAGE("[mp2] Opened file {}", filepath_str);
-                writer = std::make_unique<BasicBinaryWriter>(fp);
+                auto filepath = scraper->m_dir / "mp2" / fmt::format("{}_audio.mp2", GetCurrentTime());
+                writer = scraper->m_writer->OpenFile(filepath);
             }
             writer->Write(data);
         });
     } else if (ascty == AudioServiceType::DAB_PLUS) {
         auto& derived = dynamic_cast<Basic_DAB_Plus_Channel&>(channel);
-        derived.OnAACData().Attach([scraper](auto superframe_header, auto mpeg4_header, auto buf) {
+        derived.OnAACData().Attach([scraper](const auto& superframe_header, auto mpeg4_header, auto buf) {
             auto& writer = scraper->m_audio_aac_writer;
             auto& old_header = scraper->m_old_aac_header;
             if ((writer == nullptr) || (old_header != superframe_header)) {
-                auto dir = scraper->m_dir / "aac";
-                fs::create_directories(dir);
-                auto filepath = dir / fmt::format("{}_audio.aac", GetCurrentTime());
-                auto filepath_str = filepath.string();
-                FILE* fp = fopen(filepath_str.c_str(), "wb+");
-                if (fp != nullptr) LOG_MESSAGE("[aac] Opened file {}", filepath_str);
-                writer = std::make_unique<BasicBinaryWriter>(fp);
+                // close previous file before opening the next one
+                writer = nullptr;
+                auto filepath = scraper->m_dir / "aac" / fmt::format("{}_audio.aac", GetCurrentTime());
+                writer = scraper->m_writer->OpenFile(filepath);
                 old_header = superframe_header;
             }
             writer->Write(mpeg4_header);
@@ -166,85 +166,50 @@ void Basic_Audio_Channel_Scraper::attach_to_channel(std::shared_ptr<Basic_Audio_
     controls.SetIsPlayAudio(false);
 }
 
-BasicBinaryWriter::~BasicBinaryWriter() {
-    if (m_fp != nullptr) {
-        fclose(m_fp);
-        m_fp = nullptr;
-    }
-}
-
-void BasicBinaryWriter::Write(tcb::span<const uint8_t> data) {
-    if (m_fp != nullptr) {
-        fwrite(data.data(), sizeof(uint8_t), data.size(), m_fp);
-    }
-}
+// Source: http://soundfile.sapp.org/doc/WaveFormat/
+struct WavHeader {
+    char     ChunkID[4];
+    int32_t  ChunkSize;
+    char     Format[4];
+    // Subchunk 1 = format information
+    char     Subchunk1ID[4];
+    int32_t  Subchunk1Size;
+    int16_t  AudioFormat;
+    int16_t  NumChannels;
+    int32_t  SampleRate;
+    int32_t  ByteRate;
+    int16_t  BlockAlign;
+    int16_t  BitsPerSample;
+    // Subchunk 2 = data 
+    char     Subchunk2ID[4];
+    int32_t  Subchunk2Size;
+};
 
 BasicAudioScraper::~BasicAudioScraper() {
-    if (m_fp_wav != nullptr) {
-        CloseWavFile(m_fp_wav, m_total_bytes_written);
-        m_fp_wav = nullptr;
-        m_total_bytes_written = 0;
-    }
+    CloseWavFile();
 }
 
 void BasicAudioScraper::OnAudioData(BasicAudioParams params, tcb::span<const uint8_t> data) {
     if (!m_old_params.has_value() || (m_old_params.value() != params)) {
-        if (m_fp_wav != nullptr) {
-            CloseWavFile(m_fp_wav, m_total_bytes_written);
-            m_fp_wav = nullptr;
-            m_total_bytes_written = 0;
-        }
-
-        m_fp_wav = CreateWavFile(params);
-        m_total_bytes_written = 0;
+        CloseWavFile();
+        CreateWavFile(params);
         m_old_params = std::optional(params);
     }
 
-    if (m_fp_wav == nullptr) {
-        return;
-    }
-
-    const size_t N = data.size(); 
-    const size_t nb_written = fwrite(data.data(), sizeof(uint8_t), N, m_fp_wav);
-    if (nb_written != N) {
-        LOG_ERROR("[audio] Failed to write bytes {}/{}", nb_written, N);
+    // writer thread only receives data in large batches so we only need to update the header then
+    const size_t nb_flushed = m_wav_file->GetTotalBytesFlushed();
+    m_wav_file->Write(data);
+    if (nb_flushed != m_wav_file->GetTotalBytesFlushed()) {
+        UpdateWavHeader();
     }
-    m_total_bytes_written += (int)nb_written;
-    UpdateWavHeader(m_fp_wav, m_total_bytes_written);
 }
 
-FILE* BasicAudioScraper::CreateWavFile(BasicAudioParams params) {
-    fs::create_directories(m_dir);
+void BasicAudioScraper::CreateWavFile(BasicAudioParams params) {
     auto filepath = m_dir / fmt::format("{}_audio.wav", GetCurrentTime());
-    auto filepath_str = filepath.string();
-
-    FILE* fp = fopen(filepath_str.c_str(), "wb+");
-    if (fp == nullptr) {
-        LOG_ERROR("[audio] Failed to open file {}", filepath_str);
-        return fp;
-    }
-
-    LOG_MESSAGE("[audio] Opened file {}", filepath_str);
-
-    // Source: http://soundfile.sapp.org/doc/WaveFormat/
-    struct WavHeader {
-        char     ChunkID[4];
-        int32_t  ChunkSize;
-        char     Format[4];
-        // Subchunk 1 = format information
-        char     Subchunk1ID[4];
-        int32_t  Subchunk1Size;
-        int16_t  AudioFormat;
-        int16_t  NumChannels;
-        int32_t  SampleRate;
-        int32_t  ByteRate;
-        int16_t  BlockAlign;
-        int16_t  BitsPerSample;
-        // Subchunk 2 = data 
-        char     Subchunk2ID[4];
-        int32_t  Subchunk2Size;
-    } header;
+    m_wav_file = m_writer->OpenFile(filepath);
+    m_header_bytes_written = 0;
 
+    WavHeader header;
     const int16_t NumChannels = params.is_stereo ? 2 : 1;
     const int32_t BitsPerSample = params.bytes_per_sample * 8;
     const int32_t SampleRate = static_cast<int32_t>(params.frequency);
@@ -262,59 +227,47 @@ FILE* BasicAudioScraper::CreateWavFile(BasicAudioParams params) {
     header.ByteRate = header.SampleRate * header.NumChannels * header.BitsPerSample / 8;
     header.BlockAlign = header.NumChannels * header.BitsPerSample / 8;
 
-    // We update these values when we close the file
+    // We update these values as data is flushed and when we close the file
     header.Subchunk2Size = 0;
     header.ChunkSize = 36 + header.Subchunk2Size; 
 
-    fwrite(&header, sizeof(WavHeader), 1, fp);
-
-    return fp;
+    // Patches are never dropped by the writer so the header is guaranteed to be at the start of the file
+    m_wav_file->Patch(0, { reinterpret_cast<const uint8_t*>(&header), sizeof(WavHeader) });
 }
 
-void BasicAudioScraper::UpdateWavHeader(FILE* fp, const int nb_data_bytes) {
-    const int32_t Subchunk2Size = nb_data_bytes;
-    const int32_t ChunkSize = 36 + Subchunk2Size;
+void BasicAudioScraper::UpdateWavHeader(void) {
+    const size_t nb_data_bytes = m_wav_file->GetTotalBytesFlushed();
+    if (nb_data_bytes == m_header_bytes_written) {
+        return;
+    }
+    m_header_bytes_written = nb_data_bytes;
 
-    // Source: http://soundfile.sapp.org/doc/WaveFormat/
+    const int32_t Subchunk2Size = static_cast<int32_t>(nb_data_bytes);
+    const int32_t ChunkSize = 36 + Subchunk2Size;
     // Refer to offset of each field
-    // ChunkSize
-    fseek(fp, 4, SEEK_SET);
-    fwrite(&ChunkSize, sizeof(int32_t), 1, fp);
-    // Subchunk2Size
-    fseek(fp, 40, SEEK_SET);
-    fwrite(&Subchunk2Size, sizeof(int32_t), 1, fp);
-
-    fseek(fp, 0, SEEK_END);
+    m_wav_file->Patch(offsetof(WavHeader, ChunkSize), { reinterpret_cast<const uint8_t*>(&ChunkSize), sizeof(int32_t) });
+    m_wav_file->Patch(offsetof(WavHeader, Subchunk2Size), { reinterpret_cast<const uint8_t*>(&Subchunk2Size), sizeof(int32_t) });
 }
 
-void BasicAudioScraper::CloseWavFile(FILE* fp, const int nb_data_bytes) {
-    UpdateWavHeader(fp, nb_data_bytes);
-    fclose(fp);
+void BasicAudioScraper::CloseWavFile(void) {
+    if (m_wav_file == nullptr) {
+        return;
+    }
+    m_wav_file->Flush();
+    UpdateWavHeader();
+    m_wav_file = nullptr;
 }
 
 void BasicSlideshowScraper::OnSlideshow(Basic_Slideshow& slideshow) {
-    fs::create_directories(m_dir);
     const auto id = slideshow.transport_id;
     auto filepath = m_dir / fmt::format("{}_{}_{}", GetCurrentTime(), id, slideshow.name);
-    auto filepath_str = filepath.string();
-
-    FILE* fp = fopen(filepath_str.c_str(), "wb+");
-    if (fp == nullptr) {
-        LOG_ERROR("[slideshow] Failed to open file {}", filepath_str);
-        return;
+    auto image_buffer = *(slideshow.image_data);
+    if (!m_writer->WriteFile(filepath, std::move(image_buffer))) {
+        LOG_ERROR("[slideshow] Dropped file {} since writer queue is full", filepath.string());
     }
-
-    const auto image_buffer = slideshow.image_data;
-    const size_t nb_written = fwrite(image_buffer.data(), sizeof(uint8_t), image_buffer.size(), fp);
-    if (nb_written != image_buffer.size()) {
-        LOG_ERROR("[slideshow] Failed to write bytes {}/{}", nb_written, image_buffer.size());
-    }
-    fclose(fp);
-
-    LOG_MESSAGE("[slideshow] Wrote file {}", filepath_str);
 }
 
-void BasicMOTScraper::OnMOTEntity(MOT_Entity mot) {
+void BasicMOTScraper::OnMOTEntity(const MOT_Entity& mot) {
     auto& content_name_str = mot.header.content_name;
     std::string content_name;
     if (content_name_str.exists) {
@@ -325,23 +278,9 @@ void BasicMOTScraper::OnMOTEntity(MOT_Entity mot) {
             header.content_type, header.content_sub_type);
     }
 
-    fs::create_directories(m_dir);
     auto filepath = m_dir / fmt::format("{}_{}_{}", GetCurrentTime(), mot.transport_id, content_name);
-    auto filepath_str = filepath.string();
-
-    FILE* fp = fopen(filepath_str.c_str(), "wb+");
-    if (fp == nullptr) {
-        LOG_ERROR("[MOT] Failed to open file {}", filepath_str);
-        return;
-    }
-    
-    auto body_buf = mot.body_buf;
-
-    const size_t nb_written = fwrite(body_buf.data(), sizeof(uint8_t), body_buf.size(), fp);
-    if (nb_written != body_buf.size()) {
-        LOG_ERROR("[MOT] Failed to write bytes {}/{}", nb_written, body_buf.size());
+    auto body_buf = std::vector<uint8_t>(mot.body_buf.begin(), mot.body_buf.end());
+    if (!m_writer->WriteFile(filepath, std::move(body_buf))) {
+        LOG_ERROR("[MOT] Dropped file {} since writer queue is full", filepath.string());
     }
-    fclose(fp);
-
-    LOG_MESSAGE("[MOT] Wrote file {}", filepath_str);
 }
\ No newline at end of file
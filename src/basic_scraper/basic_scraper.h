@@ -1,12 +1,12 @@
 #pragma once
 #include <stdint.h>
-#include <stdio.h>
 #include <filesystem>
 #include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 #include "basic_radio/basic_audio_params.h"
+#include "./basic_async_writer.h"
 #include "dab/audio/aac_frame_processor.h"
 #include "dab/mot/MOT_entities.h"
 #include "utility/span.h"
@@ -24,6 +24,7 @@ namespace fs = std::filesystem;
 //     └─MOT
 //       └─{date}_{transport_id}_{label}.{ext}
 class BasicRadio;
+class LatencyTracer;
 class Basic_Audio_Channel;
 struct Basic_Slideshow;
 
@@ -31,11 +32,12 @@ class BasicAudioScraper
 {
 private:
     std::optional<BasicAudioParams> m_old_params = std::nullopt;
-    FILE* m_fp_wav = nullptr;
-    int m_total_bytes_written = 0;
+    std::shared_ptr<BasicAsyncWriter> m_writer;
+    std::unique_ptr<BasicAsyncFile> m_wav_file;
+    size_t m_header_bytes_written = 0;
     const fs::path m_dir;    
 public:
-    explicit BasicAudioScraper(const fs::path& dir): m_dir(dir) {}
+    BasicAudioScraper(const fs::path& dir, std::shared_ptr<BasicAsyncWriter> writer): m_writer(writer), m_dir(dir) {}
     ~BasicAudioScraper();
     BasicAudioScraper(BasicAudioScraper&) = delete;
     BasicAudioScraper(BasicAudioScraper&&) = delete;
@@ -43,65 +45,58 @@ public:
     BasicAudioScraper& operator=(BasicAudioScraper&&) = delete;
     void OnAudioData(BasicAudioParams params, tcb::span<const uint8_t> data);
 private:
-    FILE* CreateWavFile(BasicAudioParams params);
-    void UpdateWavHeader(FILE* fp, const int nb_data_bytes);
-    void CloseWavFile(FILE* fp, const int nb_data_bytes);
+    void CreateWavFile(BasicAudioParams params);
+    // header is rewritten whenever a batch reaches the writer thread and when the file is closed
+    void UpdateWavHeader(void);
+    void CloseWavFile(void);
 };
 
 class BasicSlideshowScraper
 {
 private:
+    std::shared_ptr<BasicAsyncWriter> m_writer;
     const fs::path m_dir;
 public:
-    explicit BasicSlideshowScraper(const fs::path& dir): m_dir(dir) {}
+    BasicSlideshowScraper(const fs::path& dir, std::shared_ptr<BasicAsyncWriter> writer): m_writer(writer), m_dir(dir) {}
     void OnSlideshow(Basic_Slideshow& slideshow);
 };
 
 class BasicMOTScraper
 {
 private:
+    std::shared_ptr<BasicAsyncWriter> m_writer;
     const fs::path m_dir;
 public:
-    explicit BasicMOTScraper(const fs::path& dir): m_dir(dir) {}
-    void OnMOTEntity(MOT_Entity mot);
-};
-
-class BasicBinaryWriter
-{
-private:
-    FILE* m_fp = nullptr;
-public:
-    explicit BasicBinaryWriter(FILE* fp): m_fp(fp) {}
-    ~BasicBinaryWriter();
-    BasicBinaryWriter(BasicBinaryWriter&) = delete;
-    BasicBinaryWriter(BasicBinaryWriter&&) = delete;
-    BasicBinaryWriter& operator=(BasicBinaryWriter&) = delete;
-    BasicBinaryWriter& operator=(BasicBinaryWriter&&) = delete;
-    void Write(tcb::span<const uint8_t> data);
+    BasicMOTScraper(const fs::path& dir, std::shared_ptr<BasicAsyncWriter> writer): m_writer(writer), m_dir(dir) {}
+    void OnMOTEntity(const MOT_Entity& mot);
 };
 
 class Basic_Audio_Channel_Scraper
 {
 private:
     const fs::path m_dir;
+    std::shared_ptr<BasicAsyncWriter> m_writer;
     BasicAudioScraper m_audio_scraper;
     BasicSlideshowScraper m_slideshow_scraper;
     BasicMOTScraper m_mot_scraper;
-    std::unique_ptr<BasicBinaryWriter> m_audio_aac_writer;
-    std::unique_ptr<BasicBinaryWriter> m_audio_mp2_writer;
+    std::unique_ptr<BasicAsyncFile> m_audio_aac_writer;
+    std::unique_ptr<BasicAsyncFile> m_audio_mp2_writer;
     SuperFrameHeader m_old_aac_header;
 public:
-    explicit Basic_Audio_Channel_Scraper(const fs::path& dir);
-    static void attach_to_channel(std::shared_ptr<Basic_Audio_Channel_Scraper> scraper, Basic_Audio_Channel& channel);
+    Basic_Audio_Channel_Scraper(const fs::path& dir, std::shared_ptr<BasicAsyncWriter> writer);
+    static void attach_to_channel(std::shared_ptr<Basic_Audio_Channel_Scraper> scraper, Basic_Audio_Channel& channel, LatencyTracer* latency_tracer=nullptr);
 };
 
 class BasicScraper 
 {
 private:
     std::string m_root_directory;
+    std::shared_ptr<BasicAsyncWriter> m_writer;
     std::vector<std::shared_ptr<Basic_Audio_Channel_Scraper>> m_scrapers;
 public:
     template <typename T>
-    explicit BasicScraper(T root_directory): m_root_directory(root_directory) {}
+    explicit BasicScraper(T root_directory, const BasicAsyncWriterConfig& config = {})
+    : m_root_directory(root_directory), m_writer(std::make_shared<BasicAsyncWriter>(config)) {}
     static void attach_to_radio(std::shared_ptr<BasicScraper> scraper, BasicRadio& radio);
+    auto& GetWriter() { return *(m_writer.get()); }
 };
\ No newline at end of file
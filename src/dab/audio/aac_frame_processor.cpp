@@ -4,6 +4,7 @@
 #include <memory>
 #include <fmt/format.h>
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "../algorithms/crc.h"
 #include "../algorithms/reed_solomon_decoder.h"
 #include "../dab_logging.h"
@@ -202,7 +203,10 @@ void AAC_Frame_Processor::ProcessSuperFrame(const int nb_dab_frame_bytes) {
     const int nb_rs_super_frame_bytes = nb_dab_frame_bytes*m_TOTAL_DAB_FRAMES;
     const int N = nb_rs_super_frame_bytes/NB_RS_MESSAGE_BYTES;
 
-    if (!ReedSolomonDecode(nb_dab_frame_bytes)) {
+    const auto time_rs_start = StageTimer::clock::now();
+    const bool is_rs_decoded = ReedSolomonDecode(nb_dab_frame_bytes);
+    if (m_rs_timer != nullptr) m_rs_timer->add(StageTimer::clock::now() - time_rs_start);
+    if (!is_rs_decoded) {
         m_nb_desync_count++;
         return;
     }
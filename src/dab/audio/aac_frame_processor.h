@@ -6,6 +6,7 @@
 #include "utility/span.h"
 
 class Reed_Solomon_Decoder;
+class StageTimer;
 
 enum class MPEG_Surround {
     NOT_USED, SURROUND_51, SURROUND_OTHER, RFA
@@ -52,6 +53,7 @@ private:
     int m_prev_nb_dab_frame_bytes;
     bool m_is_synced_superframe;
     int m_nb_desync_count;
+    StageTimer* m_rs_timer = nullptr;
     // callback signatures
     // frame_index, crc_got, crc_calculated
     Observable<const int, const uint16_t, const uint16_t> m_obs_firecode_error;
@@ -73,6 +75,8 @@ public:
     auto& OnSuperFrameHeader(void) { return m_obs_superframe_header; }
     auto& OnAccessUnitCRCError(void) { return m_obs_au_crc_error; }
     auto& OnAccessUnit(void) { return m_obs_access_unit; }
+    // Optionally accumulate time spent reed solomon decoding superframes
+    void SetReedSolomonTimer(StageTimer* timer) { m_rs_timer = timer; }
 private:
     bool CalculateFirecode(tcb::span<const uint8_t> buf);
     void AccumulateFrame(tcb::span<const uint8_t> buf);
@@ -23,9 +23,11 @@ struct DAB_Parameters {
 // DOC: docs/DAB_parameters.pdf
 // Clause A1.1 - System parameters
 // Clause A1.3 - Coarse structure of the transmission frame
-static DAB_Parameters get_dab_parameters(const int transmission_mode) 
+// These are only used to split a frame into its FIC and CIFs so they aren't specialised per mode
+// The per bit loops get their sizes from the FIB group or subchannel instead
+static constexpr DAB_Parameters get_dab_parameters(const int transmission_mode) 
 {
-    DAB_Parameters p;
+    DAB_Parameters p {};
     switch (transmission_mode) 
     {
     case 1:
@@ -52,8 +52,8 @@ const UEP_Descriptor UEP_PROTECTION_TABLE[UEP_PROTECTION_TABLE_SIZE] = {
     {  70, 112, 4, {11, 21,  49, 3}, { 9,  6,  4,  8}, 0 },
     {  84, 112, 3, {11, 23,  47, 3}, {16,  8,  6,  9}, 0 },
     { 104, 112, 2, {11, 21,  49, 3}, {23, 12,  9, 14}, 4 },
-    {  84, 128, 5, {12, 19,  62, 3}, { 5,  3,  2,  4}, 0 },
-    {  64, 128, 4, {11, 21,  61, 3}, {11,  6,  5,  7}, 0 },
+    {  64, 128, 5, {12, 19,  62, 3}, { 5,  3,  2,  4}, 0 },
+    {  84, 128, 4, {11, 21,  61, 3}, {11,  6,  5,  7}, 0 },
     {  96, 128, 3, {11, 22,  60, 3}, {16,  9,  6, 10}, 4 },
     { 116, 128, 2, {11, 21,  61, 3}, {22, 12,  9, 14}, 0 },
     { 140, 128, 1, {11, 20,  62, 3}, {24, 17, 13, 19}, 8 },
@@ -1,4 +1,5 @@
 #include "./dab_logging.h"
+#include <atomic>
 #include <vector>
 
 #if DAB_LOGGING_USE_EASYLOGGING
@@ -8,4 +9,9 @@ std::vector<const char*>& get_dab_registered_loggers() {
     return loggers;
 }
 
+std::atomic<bool>& get_dab_logging_enabled() {
+    static std::atomic<bool> is_enabled{true};
+    return is_enabled;
+}
+
 #endif
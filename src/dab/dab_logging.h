@@ -3,9 +3,12 @@
 #if DAB_LOGGING_USE_EASYLOGGING
 
 #include <easylogging++.h>
+#include <atomic>
 #include <vector>
 #include <string>
 std::vector<const char*>& get_dab_registered_loggers();
+// Checked before a message is formatted so disabled logging doesn't allocate on every frame
+std::atomic<bool>& get_dab_logging_enabled();
 static bool DAB_LOG_REGISTER(const char* name) {
     auto& loggers = get_dab_registered_loggers();
     for (const char* other_logger: loggers) {
@@ -14,9 +17,10 @@ static bool DAB_LOG_REGISTER(const char* name) {
     loggers.push_back(name);
     return true;
 }
-static void DAB_LOG_MESSAGE(const char* name, const std::string&& message) { CLOG(INFO, name) << message; }
-static void DAB_LOG_WARN(const char* name, const std::string&& message) { CLOG(WARNING, name) << message; }
-static void DAB_LOG_ERROR(const char* name, const std::string&& message) { CLOG(ERROR, name) << message; }
+#define DAB_LOG_IS_ENABLED() get_dab_logging_enabled().load(std::memory_order_relaxed)
+#define DAB_LOG_MESSAGE(name, message) do { if (DAB_LOG_IS_ENABLED()) { CLOG(INFO, name) << (message); } } while (0)
+#define DAB_LOG_WARN(name, message) do { if (DAB_LOG_IS_ENABLED()) { CLOG(WARNING, name) << (message); } } while (0)
+#define DAB_LOG_ERROR(name, message) do { if (DAB_LOG_IS_ENABLED()) { CLOG(ERROR, name) << (message); } } while (0)
 
 #else
 
@@ -1,7 +1,9 @@
 #include "./MOT_assembler.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
 #include <optional>
+#include <vector>
 #include <fmt/format.h>
 #include "utility/span.h"
 #include "../dab_logging.h"
@@ -15,95 +17,164 @@ MOT_Assembler::MOT_Assembler() {
 }
 
 void MOT_Assembler::Reset(void) {
-    // We end up reusing this data
-    for (auto& segment: m_segments) {
-        segment.length = 0;
-        segment.unordered_index = 0;
-    }
+    // We end up reusing the body buffer so we don't clear it
+    m_segment_bitmap.clear();
+    m_total_received = 0;
     m_total_segments = std::nullopt;
-    m_unordered_buffer.clear();
-    m_ordered_buffer.clear();
-    m_segments.clear();
+    m_segment_size = std::nullopt;
+    m_last_segment_size = std::nullopt;
+    m_pending_last_segment.clear();
+    m_is_pending_last_segment = false;
 }
 
 void MOT_Assembler::SetTotalSegments(const size_t N) {
+    if (m_total_segments.has_value()) {
+        if (m_total_segments.value() == N) return;
+        LOG_ERROR("Total segments changed from {} to {}, resetting", m_total_segments.value(), N);
+        Reset();
+    }
+
+    // Discard segments that are out of bounds
+    for (size_t i = N/64; i < m_segment_bitmap.size(); i++) {
+        const uint64_t mask = (i == N/64) ? ~((uint64_t(1) << (N % 64)) - 1) : ~uint64_t(0);
+        if ((m_segment_bitmap[i] & mask) != 0) {
+            LOG_ERROR("Received segments past specified total segments ({}), resetting", N);
+            Reset();
+            break;
+        }
+    }
+
     m_total_segments = std::optional(N);
-    m_segments.resize(N);
+    m_segment_bitmap.resize((N+63)/64, 0);
+    if (N == 0) return;
+
+    // Last segment was received before we knew it was the last segment
+    if (IsSegmentPresent(N-1) && !m_last_segment_size.has_value()) {
+        m_last_segment_size = m_segment_size;
+    }
+    if (m_segment_size.has_value()) {
+        Reserve(N*m_segment_size.value());
+    }
 }
 
-bool MOT_Assembler::AddSegment(const size_t index, tcb::span<const uint8_t> buf) {
-    if (index >= m_segments.size()) {
-        m_segments.resize(index+1);
+void MOT_Assembler::Reserve(const size_t nb_bytes) {
+    if (nb_bytes > m_buffer.size()) {
+        m_buffer.resize(nb_bytes);
     }
+}
 
+bool MOT_Assembler::AddSegment(const size_t index, tcb::span<const uint8_t> buf) {
     if (m_total_segments.has_value() && (index >= m_total_segments.value())) {
         LOG_ERROR("Segment index overflow specified total segments ({}>={})", index, m_total_segments.value());
         return false;
     }
 
-    auto& segment = m_segments[index];
+    if (buf.empty()) {
+        LOG_ERROR("Segment {} is empty", index);
+        return false;
+    }
+
+    const bool is_last = m_total_segments.has_value() && (index == m_total_segments.value()-1);
+    const auto& expected_size = is_last ? m_last_segment_size : m_segment_size;
 
     // Segment already present
-    if (segment.length != 0) {
-        if (segment.length != buf.size()) {
-            LOG_ERROR("Segment {} has conflicting size {}!={}", index, segment.length, buf.size());
-            return false;
+    if (IsSegmentPresent(index)) {
+        if (expected_size.has_value() && (expected_size.value() != buf.size())) {
+            LOG_ERROR("Segment {} has conflicting size {}!={}", index, expected_size.value(), buf.size());
         }
         // TODO: do we check if each segment has matching contents?
         return false;
     }
 
-    // Add segment
     LOG_MESSAGE("Adding segment {} with length={}", index, buf.size());
-    const size_t old_size = m_unordered_buffer.size();
-    const size_t new_size = old_size + buf.size();
-    segment.length = buf.size();
-    segment.unordered_index = old_size;
-    m_unordered_buffer.resize(new_size);
-
-    auto dst_buf = tcb::span(m_unordered_buffer).subspan(old_size, buf.size());
-    for (size_t i = 0; i < buf.size(); i++) {
-        dst_buf[i] = buf[i];
+    if (is_last) {
+        m_last_segment_size = buf.size();
+        if (index == 0) {
+            WriteSegment(0, buf);
+        } else if (m_segment_size.has_value()) {
+            WriteSegment(index*m_segment_size.value(), buf);
+        } else {
+            // Position depends on the size of the other segments
+            m_pending_last_segment.assign(buf.begin(), buf.end());
+            m_is_pending_last_segment = true;
+        }
+    } else {
+        if (!m_segment_size.has_value()) {
+            m_segment_size = buf.size();
+            if (m_total_segments.has_value()) {
+                Reserve(m_total_segments.value()*buf.size());
+            }
+            if (m_is_pending_last_segment) {
+                WriteSegment((m_total_segments.value()-1)*buf.size(), m_pending_last_segment);
+                m_pending_last_segment.clear();
+                m_is_pending_last_segment = false;
+            }
+        } else if (m_segment_size.value() != buf.size()) {
+            LOG_ERROR("Segment {} has conflicting size with other segments {}!={}", index, m_segment_size.value(), buf.size());
+            return false;
+        }
+        WriteSegment(index*m_segment_size.value(), buf);
     }
-    const auto is_complete = CheckComplete();
-    if (is_complete) {
-        ReconstructOrderedBuffer();
+
+    MarkSegmentPresent(index);
+    m_total_received++;
+    return CheckComplete();
+}
+
+tcb::span<uint8_t> MOT_Assembler::GetData() {
+    if (!CheckComplete()) {
+        return {};
     }
-    return is_complete;
+    return tcb::span(m_buffer).first(GetTotalBytes());
 }
 
-bool MOT_Assembler::CheckComplete(void) {
+tcb::span<const uint8_t> MOT_Assembler::GetFirstSegment() {
+    if (!CheckComplete()) {
+        return {};
+    }
+    const size_t N = m_total_segments.value();
+    const size_t length = (N == 1) ? m_last_segment_size.value() : m_segment_size.value();
+    return tcb::span(m_buffer).first(length);
+}
+
+bool MOT_Assembler::CheckComplete(void) const {
     // undefined segment length
     if (!m_total_segments.has_value()) {
         return false;
     }
- 
-    size_t total_size = 0;
-    for (size_t i = 0; i < m_total_segments.value(); i++) {
-        const auto& segment = m_segments[i];
-        if (segment.length == 0) return false;
-        total_size += segment.length;
-    }
-    if (total_size != m_unordered_buffer.size()) {
+    const size_t N = m_total_segments.value();
+    return (N > 0) && (m_total_received == N) && !m_is_pending_last_segment;
+}
+
+bool MOT_Assembler::IsSegmentPresent(const size_t index) const {
+    const size_t word = index / 64;
+    if (word >= m_segment_bitmap.size()) {
         return false;
     }
-    return true;
+    return (m_segment_bitmap[word] >> (index % 64)) & 0b1;
 }
 
-void MOT_Assembler::ReconstructOrderedBuffer(void) {
-    if (!m_total_segments.has_value()) return;
-
-    LOG_MESSAGE("Reconstructing buffer with {} segments with length={}", m_total_segments.value(), m_unordered_buffer.size());
-    m_ordered_buffer.resize(m_unordered_buffer.size());
-    auto dst_buf = tcb::span(m_ordered_buffer);
+void MOT_Assembler::MarkSegmentPresent(const size_t index) {
+    const size_t word = index / 64;
+    if (word >= m_segment_bitmap.size()) {
+        m_segment_bitmap.resize(word+1, 0);
+    }
+    m_segment_bitmap[word] |= (uint64_t(1) << (index % 64));
+}
 
-    size_t curr_write_index = 0;
-    for (size_t i = 0; i < m_total_segments.value(); i++) {
-        auto& segment = m_segments[i];
-        auto src_buf = tcb::span(m_unordered_buffer).subspan(segment.unordered_index, segment.length);
-        for (size_t j = 0; j < segment.length; j++) {
-            dst_buf[curr_write_index+j] = src_buf[j];
-        }
-        curr_write_index += segment.length;
+void MOT_Assembler::WriteSegment(const size_t offset, tcb::span<const uint8_t> buf) {
+    // Grow geometrically if we don't know the total size ahead of time
+    const size_t end = offset + buf.size();
+    if (end > m_buffer.size()) {
+        m_buffer.resize(std::max(end, m_buffer.size()*2));
     }
-}
\ No newline at end of file
+    std::copy_n(buf.begin(), buf.size(), m_buffer.begin() + offset);
+}
+
+size_t MOT_Assembler::GetTotalBytes() const {
+    const size_t N = m_total_segments.value_or(0);
+    if (N == 0) return 0;
+    const size_t last_size = m_last_segment_size.value_or(0);
+    if (N == 1) return last_size;
+    return (N-1)*m_segment_size.value_or(0) + last_size;
+}
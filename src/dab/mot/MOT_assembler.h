@@ -7,29 +7,38 @@
 #include "utility/span.h"
 
 // Assembles MOT entity from segments
-class MOT_Assembler 
+// DOC: ETSI EN 301 234
+// Clause 5.1: Segmentation of MOT entities
+// All segments except the last one share the same size
+// This lets us write each segment directly into its final position in the body
+class MOT_Assembler
 {
 private:
-    struct Segment {
-        size_t unordered_index;
-        size_t length;
-        Segment() {
-            unordered_index = 0;
-            length = 0;
-        }
-    };
-private:
-    std::vector<uint8_t> m_unordered_buffer;
-    std::vector<uint8_t> m_ordered_buffer;
-    std::vector<Segment> m_segments;
+    std::vector<uint8_t> m_buffer;
+    std::vector<uint64_t> m_segment_bitmap;
+    size_t m_total_received = 0;
     std::optional<size_t> m_total_segments = std::nullopt;
+    std::optional<size_t> m_segment_size = std::nullopt;
+    std::optional<size_t> m_last_segment_size = std::nullopt;
+    // last segment can arrive before we know the size of the other segments
+    std::vector<uint8_t> m_pending_last_segment;
+    bool m_is_pending_last_segment = false;
 public:
     MOT_Assembler();
     void Reset(void);
     void SetTotalSegments(const size_t N);
+    // Hint for the expected total size so the body buffer is only allocated once
+    void Reserve(const size_t nb_bytes);
     bool AddSegment(const size_t index, tcb::span<const uint8_t> buf);
-    tcb::span<uint8_t> GetData() { return m_ordered_buffer; }
-    bool CheckComplete();
+    // Returns an empty buffer if the entity isn't complete
+    tcb::span<uint8_t> GetData();
+    // Returns an empty buffer if the entity isn't complete
+    tcb::span<const uint8_t> GetFirstSegment();
+    size_t GetTotalReceived() const { return m_total_received; }
+    bool CheckComplete() const;
 private:
-    void ReconstructOrderedBuffer();
-};
\ No newline at end of file
+    bool IsSegmentPresent(const size_t index) const;
+    void MarkSegmentPresent(const size_t index);
+    void WriteSegment(const size_t offset, tcb::span<const uint8_t> buf);
+    size_t GetTotalBytes() const;
+};
@@ -6,6 +6,7 @@
 #include <string_view>
 #include <utility>
 #include <fmt/format.h>
+#include "utility/hash.h"
 #include "utility/span.h"
 #include "./MOT_assembler.h"
 #include "./MOT_entities.h"
@@ -33,11 +34,55 @@ static bool ValidateDataType(const MOT_Data_Type type) {
     return false;
 }
 
-MOT_Processor::MOT_Processor(const size_t max_transport_entities, const size_t max_header_entities) {
-    m_assembler_tables.set_max_size(max_transport_entities);
-    m_body_headers.set_max_size(max_header_entities);
+static bool IsUTCTimeEqual(const MOT_UTC_Time& a, const MOT_UTC_Time& b) {
+    return 
+        (a.exists == b.exists) && (a.year == b.year) && (a.month == b.month) && (a.day == b.day) &&
+        (a.hours == b.hours) && (a.minutes == b.minutes) && (a.seconds == b.seconds) && 
+        (a.milliseconds == b.milliseconds);
 }
 
+static bool IsHeaderEqual(const MOT_Header_Entity& a, const MOT_Header_Entity& b) {
+    if ((a.body_size != b.body_size) || (a.header_size != b.header_size)) return false;
+    if ((a.content_type != b.content_type) || (a.content_sub_type != b.content_sub_type)) return false;
+    if (a.content_name.exists != b.content_name.exists) return false;
+    if (a.content_name.charset != b.content_name.charset) return false;
+    if (a.content_name.name != b.content_name.name) return false;
+    if (!IsUTCTimeEqual(a.trigger_time, b.trigger_time)) return false;
+    if (!IsUTCTimeEqual(a.expire_time, b.expire_time)) return false;
+    if (a.user_app_params.size() != b.user_app_params.size()) return false;
+    for (size_t i = 0; i < a.user_app_params.size(); i++) {
+        const auto& x = a.user_app_params[i];
+        const auto& y = b.user_app_params[i];
+        if ((x.type != y.type) || (x.data != y.data)) return false;
+    }
+    return true;
+}
+
+static void ResetAssemblers(MOT_Assembler_Table& table) {
+    for (auto& [_, assembler]: table) {
+        assembler.Reset();
+    }
+}
+
+// Clears the header without releasing the capacity of its buffers
+static void ResetHeader(MOT_Header_Entity& header) {
+    header.body_size = 0;
+    header.header_size = 0;
+    header.content_type = 0;
+    header.content_sub_type = 0;
+    header.content_name.exists = false;
+    header.content_name.charset = 0;
+    header.content_name.name.clear();
+    header.trigger_time = MOT_UTC_Time();
+    header.expire_time = MOT_UTC_Time();
+    header.user_app_params.clear();
+}
+
+MOT_Processor::MOT_Processor(const size_t max_transport_entities, const size_t max_header_entities)
+: m_assembler_tables(max_transport_entities), m_body_headers(max_header_entities), 
+  m_completed_entities(max_header_entities)
+{}
+
 void MOT_Processor::Process_MSC_Data_Group(const MOT_MSC_Data_Group_Header header, tcb::span<const uint8_t> buf) {
     // DOC: ETSI EN 301 234
     // Clause 5.1.1: Segmentation header 
@@ -67,17 +112,32 @@ void MOT_Processor::Process_MSC_Data_Group(const MOT_MSC_Data_Group_Header heade
         LOG_WARN("Mismatching repetition count in MSC header and segmentation header {}!={}", header.repetition_index, repetition_count);
     }
 
+    // Drop repeats of completed objects before doing any work on them
+    if (CheckAlreadyComplete(header, data)) {
+        m_total_skipped_segments++;
+        return;
+    }
+
     // TODO: For MOT body entities the time taken to assemble them can be quite long
     //       Signal the progress of the assembler to a listener for MOT body entities
     auto* assembler_table = m_assembler_tables.find(header.transport_id);
     if (assembler_table == nullptr) {
-        assembler_table = &m_assembler_tables.emplace(header.transport_id);
+        // Carousels keep sending new transport ids so the evicted entity's buffers are reused
+        assembler_table = &m_assembler_tables.emplace_recycled(header.transport_id);
+        ResetAssemblers(*assembler_table);
     }
 
     auto& assembler = GetAssembler(*assembler_table, header.data_group_type);
     if (header.is_last_segment) {
         assembler.SetTotalSegments(header.segment_number+1);
     }
+    // Size the body buffer up front if we already have its header
+    if ((header.data_group_type == MOT_Data_Type::UNSCRAMBLED_BODY) && (assembler.GetTotalReceived() == 0)) {
+        auto* body_header = m_body_headers.find(header.transport_id);
+        if (body_header != nullptr) {
+            assembler.Reserve(size_t(body_header->body_size));
+        }
+    }
     const bool is_updated = assembler.AddSegment(header.segment_number, data);
     if (!is_updated) {
         return;
@@ -92,16 +152,60 @@ void MOT_Processor::Process_MSC_Data_Group(const MOT_MSC_Data_Group_Header heade
         ProcessDirectory(header.transport_id);
     } else if (header.data_group_type == MOT_Data_Type::HEADER) {
         auto header_buf = assembler.GetData();
-        MOT_Header_Entity entity_header;
-        auto res = ProcessHeader(entity_header, header_buf);
+        ResetHeader(m_spare_header);
+        auto res = ProcessHeader(m_spare_header, header_buf);
         if (res == std::nullopt) return;
-        m_body_headers.insert(header.transport_id, std::move(entity_header)); 
+        std::swap(m_body_headers.emplace_recycled(header.transport_id), m_spare_header);
         CheckBodyComplete(header.transport_id);
     } else if (header.data_group_type == MOT_Data_Type::UNSCRAMBLED_BODY) {
         CheckBodyComplete(header.transport_id);
     }
 }
 
+bool MOT_Processor::CheckAlreadyComplete(const MOT_MSC_Data_Group_Header header, tcb::span<const uint8_t> data) {
+    const auto type = header.data_group_type;
+    const bool is_header = (type == MOT_Data_Type::HEADER);
+    const bool is_directory = (type == MOT_Data_Type::UNCOMPRESSED_DIRECTORY);
+    const bool is_body = (type == MOT_Data_Type::UNSCRAMBLED_BODY);
+    if (!is_header && !is_directory && !is_body) {
+        return false;
+    }
+
+    auto* completed = m_completed_entities.find(header.transport_id);
+    if (completed == nullptr) {
+        return false;
+    }
+
+    // Only the first header/directory segment is checked for a change in version
+    if (is_body || (header.segment_number != 0)) {
+        return true;
+    }
+    if (fnv1a_hash(data) == completed->header_hash) {
+        return true;
+    }
+
+    // DOC: ETSI EN 301 234
+    // Clause 5.3.2.1: Interleaving MOT entities in one MOT stream 
+    // A new directory can change any object in the carousel so we start from scratch
+    if (is_directory) {
+        LOG_MESSAGE("Directory changed tid={}, resetting all entities", header.transport_id);
+        m_completed_entities.clear();
+        m_assembler_tables.clear();
+    } else {
+        LOG_MESSAGE("Header changed tid={}, resetting entity", header.transport_id);
+        ResetEntity(header.transport_id);
+    }
+    return false;
+}
+
+void MOT_Processor::ResetEntity(const mot_transport_id_t transport_id) {
+    m_completed_entities.erase(transport_id);
+    auto* assembler_table = m_assembler_tables.find(transport_id);
+    if (assembler_table != nullptr) {
+        ResetAssemblers(*assembler_table);
+    }
+}
+
 MOT_Assembler& MOT_Processor::GetAssembler(MOT_Assembler_Table& table, const MOT_Data_Type type) {
     auto res = table.find(type);
     if (res == table.end()) {
@@ -133,13 +237,21 @@ bool MOT_Processor::CheckBodyComplete(const mot_transport_id_t transport_id) {
         return false;
     }
 
+    // The cached header is lent to the entity while listeners run instead of being copied
     MOT_Entity entity;
     entity.transport_id = transport_id;
     entity.body_buf = body_buf;
-    entity.header = *header;
+    std::swap(entity.header, *header);
+
+    // In directory mode the header assembler is empty and the version of the body is
+    // instead tracked by ProcessDirectory() which resets the entity if its entry changes
+    auto& header_assembler = GetAssembler(*assembler_table, MOT_Data_Type::HEADER);
+    auto& completed = m_completed_entities.emplace(transport_id);
+    completed.header_hash = fnv1a_hash(header_assembler.GetFirstSegment());
 
     LOG_MESSAGE("Completed a MOT header entity with header={} body={} tid={}", entity.header.header_size, entity.header.body_size, entity.transport_id);
     m_obs_on_entity_complete.Notify(entity);
+    std::swap(entity.header, *header);
     return true;
 }
 
@@ -193,6 +305,10 @@ bool MOT_Processor::ProcessDirectory(const mot_transport_id_t transport_id) {
     // auto dir_extension_parameters = buf.first(dir_ext_length);
     buf = buf.subspan(dir_ext_length);
  
+    // A directory under a new transport id can reuse body transport ids for different content
+    const bool is_new_directory = (m_directory_transport_id != transport_id);
+    m_directory_transport_id = transport_id;
+
     size_t current_directory_entity = 0;
     while (true) {
         constexpr size_t TRANSPORT_ID_SIZE = 2;
@@ -203,7 +319,8 @@ bool MOT_Processor::ProcessDirectory(const mot_transport_id_t transport_id) {
         const uint16_t body_transport_id = (buf[0] << 8) | buf[1];
         buf = buf.subspan(TRANSPORT_ID_SIZE);
 
-        MOT_Header_Entity body_header;
+        auto& body_header = m_spare_header;
+        ResetHeader(body_header);
         const auto total_read_opt = ProcessHeader(body_header, buf);
         // terminate reading of all directories entries if we encounter an intermittent error, this is not recoverable
         if (!total_read_opt.has_value()) {
@@ -211,8 +328,18 @@ bool MOT_Processor::ProcessDirectory(const mot_transport_id_t transport_id) {
             break;
         }
 
+        // Completed bodies are skipped on repeat so a changed entry has to invalidate them here
+        // Partially assembled bodies are kept unless their header changed underneath them
+        auto* prev_header = m_body_headers.find(body_transport_id);
+        const bool is_header_changed = (prev_header != nullptr) && !IsHeaderEqual(*prev_header, body_header);
+        const bool is_completed = (m_completed_entities.find(body_transport_id) != nullptr);
+        if (is_header_changed || (is_new_directory && is_completed)) {
+            LOG_MESSAGE("Directory entry changed tid={} body_tid={}, resetting entity", transport_id, body_transport_id);
+            ResetEntity(body_transport_id);
+        }
+
         // NOTE: Directory entries seem to be sent very rarely, so we want to be generous about which headers to cache
-        m_body_headers.insert(body_transport_id, std::move(body_header));
+        std::swap(m_body_headers.emplace_recycled(body_transport_id), body_header);
         auto* body_assembler_table = m_assembler_tables.find(body_transport_id);
         if (body_assembler_table != nullptr) {
             CheckBodyComplete(body_transport_id);
@@ -228,6 +355,9 @@ bool MOT_Processor::ProcessDirectory(const mot_transport_id_t transport_id) {
         LOG_ERROR("Some directory entries were missed ({} != {})", current_directory_entity, total_objects);
     }
 
+    auto& completed = m_completed_entities.emplace(transport_id);
+    completed.header_hash = fnv1a_hash(directory_assembler.GetFirstSegment());
+
     return true;
 }
 
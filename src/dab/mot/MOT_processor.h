@@ -40,6 +40,12 @@ struct MOT_MSC_Data_Group_Header {
 
 typedef std::unordered_map<MOT_Data_Type, MOT_Assembler> MOT_Assembler_Table;
 
+// Carousels repeat completed objects many times so we remember them to skip reassembly
+// The hash of the first header/directory segment identifies the version of the object
+struct MOT_Completed_Entity {
+    uint64_t header_hash = 0;
+};
+
 // Create MOT entities from MSC data groups
 class MOT_Processor
 {
@@ -48,13 +54,21 @@ private:
     // Clause 5.3.2.1: Interleaving MOT entities in one MOT stream 
     LRU_Cache<mot_transport_id_t, MOT_Assembler_Table> m_assembler_tables;
     LRU_Cache<mot_transport_id_t, MOT_Header_Entity> m_body_headers;
+    LRU_Cache<mot_transport_id_t, MOT_Completed_Entity> m_completed_entities;
+    std::optional<mot_transport_id_t> m_directory_transport_id = std::nullopt;
+    // Headers are parsed into this and swapped into the cache so their buffers are reused
+    MOT_Header_Entity m_spare_header;
+    size_t m_total_skipped_segments = 0;
     Observable<MOT_Entity> m_obs_on_entity_complete;
 public:
     // Header entities are quite small so we set a generous upper bound
     explicit MOT_Processor(const size_t max_transport_entities=20, const size_t max_header_entities=200);
     void Process_MSC_Data_Group(const MOT_MSC_Data_Group_Header header, tcb::span<const uint8_t> buf);
     auto& OnEntityComplete(void) { return m_obs_on_entity_complete; }
+    size_t GetTotalSkippedSegments(void) const { return m_total_skipped_segments; }
 private:
+    bool CheckAlreadyComplete(const MOT_MSC_Data_Group_Header header, tcb::span<const uint8_t> data);
+    void ResetEntity(const mot_transport_id_t transport_id);
     MOT_Assembler& GetAssembler(MOT_Assembler_Table& table, const MOT_Data_Type type);
     bool CheckBodyComplete(const mot_transport_id_t transport_id);
     bool ProcessDirectory(const mot_transport_id_t transport_id);
@@ -57,14 +57,27 @@ bool CIF_Deinterleaver::Deinterleave(tcb::span<viterbi_bit_t> out_bits_buf) {
     // TODO: The specification also states that on a multiplex reconfiguration occurs the deinterleaving changes
     //       Implement a way to handle this
 
-    // Deinterleave and store in output bits buffer
-    for (int i = 0; i < nb_bits; i++) {
-        const int i_mod = i % TOTAL_CIF_DEINTERLEAVE;
-        // To get the bits from the same CIF before interleaving
-        // We reconstruct the oldest frame since that has all of its bits stored in the buffer
-        const int frame_offset = CIF_INDICES_OFFSETS[i_mod];
+    // To get the bits from the same CIF before interleaving
+    // We reconstruct the oldest frame since that has all of its bits stored in the buffer
+    const viterbi_bit_t* FRAME_LOOKUP[TOTAL_CIF_DEINTERLEAVE];
+    for (int i = 0; i < TOTAL_CIF_DEINTERLEAVE; i++) {
+        const int frame_offset = CIF_INDICES_OFFSETS[i];
         const int frame_index = (TOTAL_CIF_DEINTERLEAVE-1) - frame_offset;
-        out_bits_buf[i] = BUFFER_LOOKUP[frame_index][i];
+        FRAME_LOOKUP[i] = BUFFER_LOOKUP[frame_index];
+    }
+
+    // Deinterleave and store in output bits buffer
+    // Done in blocks of 16 bits so the inner loop has a fixed trip count without a modulo per bit
+    const int nb_blocks = nb_bits / TOTAL_CIF_DEINTERLEAVE;
+    for (int i = 0; i < nb_blocks; i++) {
+        const int offset = i*TOTAL_CIF_DEINTERLEAVE;
+        for (int j = 0; j < TOTAL_CIF_DEINTERLEAVE; j++) {
+            out_bits_buf[offset+j] = FRAME_LOOKUP[j][offset+j];
+        }
+    }
+    // Subchannels with an odd number of bytes have a partial block
+    for (int i = nb_blocks*TOTAL_CIF_DEINTERLEAVE; i < nb_bits; i++) {
+        out_bits_buf[i] = FRAME_LOOKUP[i % TOTAL_CIF_DEINTERLEAVE][i];
     }
 
     return true;
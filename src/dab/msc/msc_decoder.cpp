@@ -126,6 +126,8 @@ int MSC_Decoder::DecodeUEP() {
         auto symbols_buf = tcb::span(m_encoded_bits_buf);
         for (int i = 0; i < UEP_Descriptor::TOTAL_PUNCTURE_CODES; i++) {
             const int Lx = descriptor.Lx[i];
+            // Some low bitrate profiles only use 3 puncture codes and have no valid PIx for the last one
+            if (Lx == 0) continue;
             const auto puncture_code = GetPunctureCode(descriptor.PIx[i]);
             N = m_vitdec->update(symbols_buf, puncture_code, 128*Lx);
             symbols_buf = symbols_buf.subspan(N);
@@ -1,4 +1,47 @@
 #pragma once
+#include <stddef.h>
 #include "./ofdm_params.h"
 
-OFDM_Params get_DAB_OFDM_params(const int transmission_mode);
\ No newline at end of file
+// DOC: doc/DAB_parameters.pdf
+// Clause A1.1 - System parameters
+// Each transmission mode has a set of known parameters
+// These parameters are always determined relative to a sampling frequency of 2.048MHz
+constexpr int TOTAL_DAB_TRANSMISSION_MODES = 4;
+constexpr OFDM_Params DAB_OFDM_PARAMS_TABLE[TOTAL_DAB_TRANSMISSION_MODES] = {
+    // nb_frame_symbols, nb_symbol_period, nb_null_period, nb_cyclic_prefix, nb_fft, nb_data_carriers
+    { 76,  2552, 2656, 2552-2048, 2048, 1536 },
+    { 76,   638,  664,   638-512,  512,  384 },
+    { 153,  319,  345,   319-256,  256,  192 },
+    { 76,  1276, 1328, 1276-1024, 1024,  768 },
+};
+
+OFDM_Params get_DAB_OFDM_params(const int transmission_mode);
+// Returns 0 if the parameters don't belong to a DAB transmission mode
+int get_DAB_transmission_mode(const OFDM_Params& params);
+
+// Parameters of a transmission mode as compile time constants with the same names as OFDM_Params
+// Kernels written against either type can be specialised for a transmission mode
+template <int transmission_mode>
+struct DAB_OFDM_Params_Mode {
+    static_assert(transmission_mode >= 1 && transmission_mode <= TOTAL_DAB_TRANSMISSION_MODES, "Invalid transmission mode");
+    static constexpr OFDM_Params params = DAB_OFDM_PARAMS_TABLE[transmission_mode-1];
+    static constexpr size_t nb_frame_symbols = params.nb_frame_symbols;
+    static constexpr size_t nb_symbol_period = params.nb_symbol_period;
+    static constexpr size_t nb_null_period = params.nb_null_period;
+    static constexpr size_t nb_cyclic_prefix = params.nb_cyclic_prefix;
+    static constexpr size_t nb_fft = params.nb_fft;
+    static constexpr size_t nb_data_carriers = params.nb_data_carriers;
+};
+
+// Calls func with DAB_OFDM_Params_Mode<transmission_mode> or with the runtime parameters if there is no match
+// Mode I is checked first since it is the mode in use for all current broadcasts
+template <typename F>
+static inline decltype(auto) dispatch_DAB_OFDM_params(const int transmission_mode, const OFDM_Params& params, F&& func) {
+    switch (transmission_mode) {
+    case 1:  return func(DAB_OFDM_Params_Mode<1>{});
+    case 2:  return func(DAB_OFDM_Params_Mode<2>{});
+    case 3:  return func(DAB_OFDM_Params_Mode<3>{});
+    case 4:  return func(DAB_OFDM_Params_Mode<4>{});
+    default: return func(params);
+    }
+}
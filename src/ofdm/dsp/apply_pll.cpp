@@ -135,3 +135,18 @@ void apply_pll_auto(
     #endif
 }
 
+static const apply_pll_variant_t APPLY_PLL_VARIANTS[] = {
+    { "scalar", apply_pll_scalar },
+#if defined(__ARCH_X86__)
+    #if defined(__SSE3__)
+    { "sse3", apply_pll_sse3 },
+    #endif
+    #if defined(__AVX__)
+    { "avx", apply_pll_avx },
+    #endif
+#endif
+};
+
+tcb::span<const apply_pll_variant_t> get_apply_pll_variants() {
+    return APPLY_PLL_VARIANTS;
+}
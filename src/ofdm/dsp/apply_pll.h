@@ -8,3 +8,14 @@ void apply_pll_auto(
     tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y,
     const float freq_norm, const float dt_norm=0.0f
 );
+
+typedef void (*apply_pll_func_t)(
+    tcb::span<const std::complex<float>>, tcb::span<std::complex<float>>,
+    const float, const float
+);
+struct apply_pll_variant_t {
+    const char* name;
+    apply_pll_func_t func;
+};
+// Every implementation compiled for this target so they can be benchmarked against each other
+tcb::span<const apply_pll_variant_t> get_apply_pll_variants();
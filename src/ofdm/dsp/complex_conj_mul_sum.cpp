@@ -116,4 +116,20 @@ std::complex<float> complex_conj_mul_sum_auto(
     #else
         return complex_conj_mul_sum_scalar(x0, x1);
     #endif
-}
\ No newline at end of file
+}
+
+static const complex_conj_mul_sum_variant_t COMPLEX_CONJ_MUL_SUM_VARIANTS[] = {
+    { "scalar", complex_conj_mul_sum_scalar },
+#if defined(__ARCH_X86__)
+    #if defined(__SSE3__)
+    { "sse3", complex_conj_mul_sum_sse3 },
+    #endif
+    #if defined(__AVX__)
+    { "avx", complex_conj_mul_sum_avx },
+    #endif
+#endif
+};
+
+tcb::span<const complex_conj_mul_sum_variant_t> get_complex_conj_mul_sum_variants() {
+    return COMPLEX_CONJ_MUL_SUM_VARIANTS;
+}
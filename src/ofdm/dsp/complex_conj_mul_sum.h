@@ -7,3 +7,14 @@ std::complex<float> complex_conj_mul_sum_auto(
     tcb::span<const std::complex<float>> x0,
     tcb::span<const std::complex<float>> x1
 );
+
+typedef std::complex<float> (*complex_conj_mul_sum_func_t)(
+    tcb::span<const std::complex<float>>,
+    tcb::span<const std::complex<float>>
+);
+struct complex_conj_mul_sum_variant_t {
+    const char* name;
+    complex_conj_mul_sum_func_t func;
+};
+// Every implementation compiled for this target so they can be benchmarked against each other
+tcb::span<const complex_conj_mul_sum_variant_t> get_complex_conj_mul_sum_variants();
@@ -13,9 +13,11 @@
 #include "simd_flags.h" // NOLINT
 #include "utility/joint_allocate.h"
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "viterbi_config.h"
 #include "./dsp/apply_pll.h"
 #include "./dsp/complex_conj_mul_sum.h"
+#include "./dab_ofdm_params_ref.h"
 #include "./ofdm_demodulator_threads.h"
 #include "./ofdm_params.h"
 
@@ -83,6 +85,7 @@ OFDM_Demod::OFDM_Demod(
     const tcb::span<const int> carrier_mapper,
     int nb_desired_threads)
 :   m_params(params), 
+    m_dab_transmission_mode(get_DAB_transmission_mode(params)),
     m_active_buffer(params, m_active_buffer_data, ALIGN_AMOUNT),
     m_inactive_buffer(params, m_inactive_buffer_data, ALIGN_AMOUNT),
     m_null_power_dip_buffer(m_null_power_dip_buffer_data),
@@ -116,7 +119,11 @@ OFDM_Demod::OFDM_Demod(
     // Initial state of demodulator
     m_state = State::FINDING_NULL_POWER_DIP;
     m_total_frames_desync = 0;
+    m_total_frames_synced = 0;
     m_total_frames_read = 0;
+    m_total_samples_read = 0;
+    m_block_sample_index = 0;
+    m_next_frame_index = 0;
     m_is_found_coarse_freq_offset = false;
     m_freq_coarse_offset = 0;
     m_freq_fine_offset = 0;
@@ -239,12 +246,14 @@ void OFDM_Demod::Process(tcb::span<const std::complex<float>> buf) {
     PROFILE_BEGIN_FUNC();
 
     UpdateSignalAverage(buf);
+    m_block_time_received = FrameTimestamp::clock::now();
 
     const size_t N = buf.size();
     size_t curr_index = 0;
     while (curr_index < N) {
         auto* block = &buf[curr_index];
         const size_t N_remain = N-curr_index;
+        m_block_sample_index = m_total_samples_read + curr_index;
 
         switch (m_state) {
 
@@ -272,6 +281,7 @@ void OFDM_Demod::Process(tcb::span<const std::complex<float>> buf) {
             break;
         }
     }
+    m_total_samples_read += N;
 }
 
 void OFDM_Demod::Reset() {
@@ -290,6 +300,7 @@ void OFDM_Demod::Reset() {
 
 size_t OFDM_Demod::FindNullPowerDip(tcb::span<const std::complex<float>> buf) {
     PROFILE_BEGIN_FUNC();
+    ScopedStageTimer sync_timer(m_stage_timers.sync);
     // Clause 3.12.2 - Frame synchronisation using power detection
     // we run this if we dont have an initial estimate for the prs index
     // This can occur if:
@@ -348,6 +359,7 @@ size_t OFDM_Demod::FindNullPowerDip(tcb::span<const std::complex<float>> buf) {
 
 size_t OFDM_Demod::ReadNullPRS(tcb::span<const std::complex<float>> buf) {
     PROFILE_BEGIN_FUNC();
+    ScopedStageTimer sync_timer(m_stage_timers.sync);
     const size_t nb_read = m_correlation_time_buffer.ConsumeBuffer(buf);
     if (!m_correlation_time_buffer.IsFull()) {
         return nb_read;
@@ -359,6 +371,7 @@ size_t OFDM_Demod::ReadNullPRS(tcb::span<const std::complex<float>> buf) {
 
 size_t OFDM_Demod::RunCoarseFreqSync(tcb::span<const std::complex<float>> buf) {
     PROFILE_BEGIN_FUNC();
+    ScopedStageTimer sync_timer(m_stage_timers.sync);
     // Clause: 3.13.2 Integral frequency offset estimation
     if (!m_cfg.sync.is_coarse_freq_correction) {
         m_freq_coarse_offset = 0;
@@ -472,6 +485,7 @@ size_t OFDM_Demod::RunCoarseFreqSync(tcb::span<const std::complex<float>> buf) {
 
 size_t OFDM_Demod::RunFineTimeSync(tcb::span<const std::complex<float>> buf) {
     PROFILE_BEGIN_FUNC();
+    ScopedStageTimer sync_timer(m_stage_timers.sync);
     // Clause 3.12.1 - Symbol timing synchronisation
     auto corr_time_buf = tcb::span(m_correlation_time_buffer);
     auto corr_prs_buf = corr_time_buf.subspan(m_params.nb_null_period, m_params.nb_symbol_period);
@@ -543,6 +557,7 @@ size_t OFDM_Demod::RunFineTimeSync(tcb::span<const std::complex<float>> buf) {
 
     m_correlation_time_buffer.SetLength(0);
     m_fine_time_offset = offset;
+    m_total_frames_synced++;
     m_state = State::READING_SYMBOLS;
     return 0;
 }
@@ -567,6 +582,10 @@ size_t OFDM_Demod::ReadSymbols(tcb::span<const std::complex<float>> buf) {
     // double buffer
     std::swap(m_inactive_buffer_data, m_active_buffer_data);
     m_inactive_buffer.Reset();
+    // the frame can't be demodulated any sooner than when its last sample arrived
+    m_active_timestamp.frame_index = m_next_frame_index++;
+    m_active_timestamp.sample_index = m_block_sample_index + nb_read;
+    m_active_timestamp.time_received = m_block_time_received;
     // launch all our worker threads
     PROFILE_BEGIN(coordinator_start);
     m_coordinator->SignalStart();
@@ -588,6 +607,8 @@ bool OFDM_Demod::CoordinatorThread() {
     if (m_coordinator->IsStopped()) {
         return false;
     }
+    // reader thread can overwrite this after we signal the end of the frame
+    auto timestamp = m_active_timestamp;
 
     PROFILE_BEGIN(pipeline_workers);
     {
@@ -630,9 +651,10 @@ bool OFDM_Demod::CoordinatorThread() {
     }
     PROFILE_END(pipeline_workers);
     m_total_frames_read++;
+    timestamp.time_demodulated = FrameTimestamp::clock::now();
 
     PROFILE_BEGIN(obs_on_ofdm_frame);
-    m_obs_on_ofdm_frame.Notify(m_pipeline_out_bits);
+    m_obs_on_ofdm_frame.Notify(m_pipeline_out_bits, timestamp);
     PROFILE_END(obs_on_ofdm_frame);
 
     return true;
@@ -667,6 +689,7 @@ bool OFDM_Demod::PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pip
 
     // Fine and coarse frequency correction with PLL
     PROFILE_BEGIN(apply_pll);
+    const auto time_sync_start = StageTimer::clock::now();
     // NOTE: We create a local copy of the frequency offset since it
     //       can be changed in the reader thread due to coarse frequency correction
     const float frequency_offset = m_freq_coarse_offset + m_freq_fine_offset;
@@ -689,6 +712,7 @@ bool OFDM_Demod::PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pip
         total_phase_error += cyclic_error;
     }
     thread_data.SetAveragePhaseError(total_phase_error);
+    m_stage_timers.sync.add(StageTimer::clock::now() - time_sync_start);
     PROFILE_END(calculate_phase_error);
 
     // Signal to the coordinator thread our phase error
@@ -699,6 +723,7 @@ bool OFDM_Demod::PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pip
     // Clause 3.14.2 - FFT
     // Calculate fft (include null symbol)
     const auto calculate_fft = [this](int start, int end) {
+        ScopedStageTimer fft_timer(m_stage_timers.fft);
         for (int i = start; i < end; i++) {
             auto sym_buf = m_active_buffer.GetDataSymbol(i);
             // Clause 3.14.1 - Cyclic prefix removal
@@ -726,6 +751,7 @@ bool OFDM_Demod::PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pip
     // Clause 3.15 - Differential demodulator
     // perform our differential QPSK decoding
     const auto calculate_dqpsk = [this](int start, int end) {
+        ScopedStageTimer dqpsk_timer(m_stage_timers.dqpsk);
         const size_t nb_viterbi_bits = m_params.nb_data_carriers*2;
         for (int i = start; i < end; i++) {
             PROFILE_BEGIN(calculate_dqpsk_symbol);
@@ -845,47 +871,53 @@ void OFDM_Demod::CalculateDQPSK(
     tcb::span<std::complex<float>> out_vec)
 {
     PROFILE_BEGIN_FUNC();
-    const int M = (int)m_params.nb_data_carriers/2;
-    const int N_fft = (int)m_params.nb_fft;
+    // Specialised for each transmission mode so the loops have known trip counts
+    dispatch_DAB_OFDM_params(m_dab_transmission_mode, m_params, [&](const auto& params) {
+        const size_t M = params.nb_data_carriers/2;
+        const size_t N_fft = params.nb_fft;
 
-    // Clause 3.14.3 - Zero padding removal
-    // We store the subcarriers that carry information
-    for (int i = -M, subcarrier_index = 0; i <= M; i++) {
+        // Clause 3.14.3 - Zero padding removal
+        // We store the subcarriers that carry information
+        // arg(z1*~z0) = arg(z1)+arg(~z0) = arg(z1)-arg(z0)
+        // Negative subcarriers are at the end of the fft
+        const auto* in0_neg = &in0[N_fft-M];
+        const auto* in1_neg = &in1[N_fft-M];
+        for (size_t i = 0; i < M; i++) {
+            out_vec[i] = in1_neg[i] * std::conj(in0_neg[i]);
+        }
         // The DC bin carries no information
-        if (i == 0) {
-            continue;
+        const auto* in0_pos = &in0[1];
+        const auto* in1_pos = &in1[1];
+        for (size_t i = 0; i < M; i++) {
+            out_vec[M+i] = in1_pos[i] * std::conj(in0_pos[i]);
         }
-        const int fft_index = (N_fft+i) % N_fft;
-
-        // arg(z1*~z0) = arg(z1)+arg(~z0) = arg(z1)-arg(z0)
-        const auto phase_delta_vec = in1[fft_index] * std::conj(in0[fft_index]);
-        out_vec[subcarrier_index] = phase_delta_vec;
-        subcarrier_index++;
-    }
+    });
 }
 
 void OFDM_Demod::CalculateViterbiBits(tcb::span<const std::complex<float>> vec_buf, tcb::span<viterbi_bit_t> bit_buf) {
     PROFILE_BEGIN_FUNC();
-    const size_t N = m_params.nb_data_carriers;
-
-    // Clause 3.16 - Data demapper
-    for (size_t i = 0; i < N; i++) {
-        // Clause 3.16.1 - Freuency deinterleaving
-        const size_t j = m_carrier_mapper[i];
-        const auto& vec = vec_buf[j];
-
-        // const float A = std::abs(vec);
-        // NOTE: Use the L1 norm since it doesn't truncate like L2 norm
-        //       I.e. When real=imag, then we expect b0=A, b1=A
-        //            But with L2 norm, we get b0=0.707*A, b1=0.707*A
-        //                with L1 norm, we get b0=A, b1=A as expected
-        const float A = std::max(std::abs(vec.real()), std::abs(vec.imag()));
-        const auto norm_vec = vec / A;
-
-        // Clause 3.16.2 - QPSK symbol demapper
-        bit_buf[i]   = convert_to_viterbi_bit(+norm_vec.real());
-        bit_buf[i+N] = convert_to_viterbi_bit(-norm_vec.imag());
-    }
+    dispatch_DAB_OFDM_params(m_dab_transmission_mode, m_params, [&](const auto& params) {
+        const size_t N = params.nb_data_carriers;
+
+        // Clause 3.16 - Data demapper
+        for (size_t i = 0; i < N; i++) {
+            // Clause 3.16.1 - Freuency deinterleaving
+            const size_t j = m_carrier_mapper[i];
+            const auto& vec = vec_buf[j];
+
+            // const float A = std::abs(vec);
+            // NOTE: Use the L1 norm since it doesn't truncate like L2 norm
+            //       I.e. When real=imag, then we expect b0=A, b1=A
+            //            But with L2 norm, we get b0=0.707*A, b1=0.707*A
+            //                with L1 norm, we get b0=A, b1=A as expected
+            const float A = std::max(std::abs(vec.real()), std::abs(vec.imag()));
+            const auto norm_vec = vec / A;
+
+            // Clause 3.16.2 - QPSK symbol demapper
+            bit_buf[i]   = convert_to_viterbi_bit(+norm_vec.real());
+            bit_buf[i+N] = convert_to_viterbi_bit(-norm_vec.imag());
+        }
+    });
 }
 
 void OFDM_Demod::CalculateFFT(tcb::span<const std::complex<float>> fft_in, tcb::span<std::complex<float>> fft_out) {
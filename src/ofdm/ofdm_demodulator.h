@@ -8,8 +8,10 @@
 #include <thread>
 #include <vector>
 #include "utility/aligned_allocator.hpp"
+#include "utility/latency_tracer.h"
 #include "utility/observable.h"
 #include "utility/span.h"
+#include "utility/stage_timer.h"
 #include "viterbi_config.h"
 #include "./circular_buffer.h"
 #include "./ofdm_frame_buffer.h"
@@ -44,6 +46,13 @@ struct OFDM_Demod_Config {
     } sync;
 };
 
+// Time spent in each stage of demodulation across the reader and pipeline threads
+struct OFDM_Demod_Stage_Timers {
+    StageTimer sync;    // null power dip, coarse frequency, fine time and fine frequency synchronisation
+    StageTimer fft;
+    StageTimer dqpsk;   // differential demodulation and conversion to soft bits
+};
+
 class OFDM_Demod 
 {
 public:
@@ -58,9 +67,19 @@ private:
     OFDM_Demod_Config m_cfg;
     State m_state;
     const OFDM_Params m_params;
+    // 0 if the parameters don't belong to a DAB transmission mode
+    const int m_dab_transmission_mode;
     // statistics
     int m_total_frames_read;
     int m_total_frames_desync;
+    int m_total_frames_synced;
+    OFDM_Demod_Stage_Timers m_stage_timers;
+    // latency tracing
+    uint64_t m_total_samples_read;
+    uint64_t m_block_sample_index;
+    FrameTimestamp::clock::time_point m_block_time_received;
+    uint64_t m_next_frame_index;
+    FrameTimestamp m_active_timestamp;
     // time and frequency correction
     std::mutex m_mutex_freq_fine_offset;
     bool m_is_found_coarse_freq_offset;
@@ -80,7 +99,7 @@ private:
     std::unique_ptr<std::thread> m_coordinator_thread;
     std::vector<std::unique_ptr<std::thread>> m_pipeline_threads;
     // callback for when ofdm is completed
-    Observable<tcb::span<const viterbi_bit_t>> m_obs_on_ofdm_frame;
+    Observable<tcb::span<const viterbi_bit_t>, FrameTimestamp> m_obs_on_ofdm_frame;
     // Joint memory allocation block
     std::vector<uint8_t, AlignedAllocator<uint8_t>> m_joint_data_block;
     // 1. pipeline reader double buffer
@@ -132,6 +151,10 @@ public:
     int GetFineTimeOffset() const { return m_fine_time_offset; }
     int GetTotalFramesRead() const { return m_total_frames_read; }
     int GetTotalFramesDesync() const { return m_total_frames_desync; }
+    // number of times the PRS correlation peak was found and the frame start was locked onto
+    int GetTotalFramesSynced() const { return m_total_frames_synced; }
+    uint64_t GetTotalSamplesRead() const { return m_total_samples_read; }
+    const auto& GetStageTimers() const { return m_stage_timers; }
     tcb::span<const std::complex<float>> GetFrameFFT() const { return m_pipeline_fft_buffer; }
     tcb::span<const std::complex<float>> GetFrameDataVec() const { return m_pipeline_dqpsk_vec_buffer; }
     tcb::span<const viterbi_bit_t> GetFrameDataBits() const { return m_pipeline_out_bits; }
@@ -9,6 +9,7 @@
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include "utility/allocation_tracker.h"
 
 // Crossplatform pretty function
 #ifdef _MSC_VER
@@ -37,6 +38,10 @@ struct ProfileResult
     const char* name;
     int stack_index;
     int64_t start, end;
+    // heap usage inside the scope including its children, zero unless the allocation tracker is initialised
+    uint64_t total_allocations;
+    uint64_t total_allocated_bytes;
+    int64_t peak_bytes;
 };
 
 // Store stack trace for each thread
@@ -66,6 +71,7 @@ private:
     int m_results_length = 0;
     profile_trace_t m_results;
     profile_trace_t m_prev_results;
+    AllocationStats m_prev_allocation_stats;
 
     // Log all unique stack traces
     // This is useful if the stack trace varies each call and we are interested 
@@ -94,6 +100,8 @@ public:
 
     auto& GetPrevTrace() { return m_prev_results; }
     auto& GetPrevTraceMutex() { return m_mutex_prev_results; }
+    // guarded by the previous trace mutex
+    const auto& GetPrevAllocationStats() const { return m_prev_allocation_stats; }
     auto& GetTraceLogs() { return m_profiler_logger; }
     auto& GetTraceLogsMutex() { return m_mutex_profiler_logger; }
 
@@ -135,6 +143,7 @@ private:
         {
             auto lock = std::scoped_lock(m_mutex_prev_results);
             std::swap(m_results, m_prev_results);
+            m_prev_allocation_stats = AllocationTracker::get_thread_stats();
             m_results_length = 0;
         }
     }
@@ -199,6 +208,8 @@ private:
     int m_stack_index;
     int m_result_index;
     std::chrono::time_point<std::chrono::high_resolution_clock> m_time_start;
+    AllocationStats m_allocation_start;
+    int64_t m_parent_peak_bytes;
     InstrumentorThread* m_thread_ptr;
     std::thread::id m_thread_id;
 public:
@@ -211,6 +222,8 @@ public:
         auto res = m_thread_ptr->PushStackIndex();
         m_stack_index = res.first;
         m_result_index = res.second;
+        m_parent_peak_bytes = AllocationTracker::begin_thread_peak();
+        m_allocation_start = AllocationTracker::get_thread_stats();
         m_time_start = GetNow();
     }
 
@@ -225,7 +238,14 @@ public:
         auto time_end = GetNow();
         auto dt_start = ConvertMicros(m_time_start) - Instrumentor::Get().GetBase();
         auto dt_end = ConvertMicros(time_end) - Instrumentor::Get().GetBase();
-        m_thread_ptr->WriteProfile({ m_name, m_stack_index, dt_start, dt_end }, m_result_index);
+        const auto allocation_end = AllocationTracker::get_thread_stats();
+        AllocationTracker::restore_thread_peak(m_parent_peak_bytes);
+        m_thread_ptr->WriteProfile({ 
+            m_name, m_stack_index, dt_start, dt_end,
+            allocation_end.total_allocations - m_allocation_start.total_allocations,
+            allocation_end.total_allocated_bytes - m_allocation_start.total_allocated_bytes,
+            allocation_end.peak_bytes - m_allocation_start.curr_bytes,
+        }, m_result_index);
     }
 };
 
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+#if _WIN32
+#include <malloc.h>
+#endif
+
+struct AllocationStats {
+    uint64_t total_allocations = 0;
+    uint64_t total_frees = 0;
+    uint64_t total_allocated_bytes = 0;
+    // bytes allocated by the thread that haven't been freed yet, including blocks freed by other threads
+    // the peak is updated when the thread allocates
+    int64_t curr_bytes = 0;
+    int64_t peak_bytes = 0;
+};
+
+// Counts heap allocations made through global operator new/delete for the process and for each thread
+// INITIALIZE_ALLOCATION_TRACKER must be placed in exactly one translation unit of the executable
+// Without it nothing is interposed and all counts stay at zero
+class AllocationTracker
+{
+private:
+    // bytes still in use for each thread are updated by whichever thread frees the block
+    struct ThreadHeap {
+        std::atomic<int64_t> curr_bytes{0};
+        ThreadHeap* next = nullptr;
+    };
+    // block size and owning thread are stored in front of each allocation so frees can be counted in bytes
+    struct BlockHeader {
+        size_t size;
+        size_t offset;
+        ThreadHeap* owner;
+    };
+    // alignment has to be a power of two which also fits the header
+    static constexpr size_t MIN_ALIGNMENT =
+        (sizeof(BlockHeader) <= alignof(std::max_align_t)) ? alignof(std::max_align_t) : 2*alignof(std::max_align_t);
+    static_assert(sizeof(BlockHeader) <= MIN_ALIGNMENT);
+    // trivially constructible so operator new can use it during thread startup and teardown
+    static inline thread_local AllocationStats m_thread_stats;
+    static inline thread_local ThreadHeap* m_thread_heap = nullptr;
+    static inline std::atomic<ThreadHeap*> m_thread_heaps{nullptr};
+    static inline std::atomic<uint64_t> m_total_allocations{0};
+    static inline std::atomic<uint64_t> m_total_frees{0};
+    static inline std::atomic<uint64_t> m_total_allocated_bytes{0};
+    static inline std::atomic<int64_t> m_curr_bytes{0};
+    static inline std::atomic<int64_t> m_peak_bytes{0};
+    static inline std::atomic<bool> m_is_enabled{false};
+public:
+    static void set_enabled() { m_is_enabled.store(true, std::memory_order_relaxed); }
+    static bool is_enabled() { return m_is_enabled.load(std::memory_order_relaxed); }
+    static AllocationStats get_thread_stats() {
+        AllocationStats stats = m_thread_stats;
+        stats.curr_bytes = get_thread_heap().curr_bytes.load(std::memory_order_relaxed);
+        return stats;
+    }
+    static AllocationStats get_global_stats() {
+        AllocationStats stats;
+        stats.total_allocations = m_total_allocations.load(std::memory_order_relaxed);
+        stats.total_frees = m_total_frees.load(std::memory_order_relaxed);
+        stats.total_allocated_bytes = m_total_allocated_bytes.load(std::memory_order_relaxed);
+        stats.curr_bytes = m_curr_bytes.load(std::memory_order_relaxed);
+        stats.peak_bytes = m_peak_bytes.load(std::memory_order_relaxed);
+        return stats;
+    }
+    // Nested scopes measure their own peak by lowering the thread's peak to its current usage on entry
+    // The previous peak is returned so it can be restored with restore_thread_peak on exit
+    static int64_t begin_thread_peak() {
+        const int64_t prev_peak = m_thread_stats.peak_bytes;
+        m_thread_stats.peak_bytes = get_thread_heap().curr_bytes.load(std::memory_order_relaxed);
+        return prev_peak;
+    }
+    static void restore_thread_peak(int64_t prev_peak) {
+        m_thread_stats.peak_bytes = std::max(m_thread_stats.peak_bytes, prev_peak);
+    }
+    // returns nullptr if out of memory
+    static void* try_allocate(size_t size, size_t alignment=MIN_ALIGNMENT) noexcept {
+        alignment = std::max(alignment, MIN_ALIGNMENT);
+        // offset is a multiple of the alignment so the returned block stays aligned
+        const size_t offset = alignment;
+        if (size > (SIZE_MAX - offset)) return nullptr;
+        void* block = aligned_malloc(size + offset, alignment);
+        if (block == nullptr) return nullptr;
+        uint8_t* ptr = reinterpret_cast<uint8_t*>(block) + offset;
+        auto* header = reinterpret_cast<BlockHeader*>(ptr) - 1;
+        auto& heap = get_thread_heap();
+        header->size = size;
+        header->offset = offset;
+        header->owner = &heap;
+        on_allocate(heap, size);
+        return ptr;
+    }
+    static void* allocate(size_t size, size_t alignment=MIN_ALIGNMENT) {
+        void* ptr = try_allocate(size, alignment);
+        if (ptr == nullptr) throw std::bad_alloc();
+        return ptr;
+    }
+    static void deallocate(void* ptr) noexcept {
+        if (ptr == nullptr) return;
+        const auto* header = reinterpret_cast<const BlockHeader*>(ptr) - 1;
+        const size_t size = header->size;
+        ThreadHeap& owner = *header->owner;
+        void* block = reinterpret_cast<uint8_t*>(ptr) - header->offset;
+        aligned_free(block);
+        on_free(owner, size);
+    }
+private:
+    static ThreadHeap& get_thread_heap() noexcept {
+        if (m_thread_heap != nullptr) return *m_thread_heap;
+        // allocated with malloc so it isn't tracked and never freed since blocks can outlive their thread
+        // every heap is kept in a list so they stay reachable and aren't reported as leaks
+        static ThreadHeap fallback_heap;
+        void* buf = malloc(sizeof(ThreadHeap));
+        if (buf == nullptr) return fallback_heap;
+        auto* heap = new (buf) ThreadHeap();
+        heap->next = m_thread_heaps.load(std::memory_order_relaxed);
+        while (!m_thread_heaps.compare_exchange_weak(heap->next, heap, std::memory_order_release, std::memory_order_relaxed)) {}
+        m_thread_heap = heap;
+        return *heap;
+    }
+    static void on_allocate(ThreadHeap& heap, size_t size) {
+        const auto bytes = int64_t(size);
+        auto& thread = m_thread_stats;
+        thread.total_allocations++;
+        thread.total_allocated_bytes += uint64_t(size);
+        const int64_t thread_curr_bytes = heap.curr_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        thread.peak_bytes = std::max(thread.peak_bytes, thread_curr_bytes);
+        m_total_allocations.fetch_add(1, std::memory_order_relaxed);
+        m_total_allocated_bytes.fetch_add(uint64_t(size), std::memory_order_relaxed);
+        const int64_t curr_bytes = m_curr_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        int64_t peak_bytes = m_peak_bytes.load(std::memory_order_relaxed);
+        while (curr_bytes > peak_bytes) {
+            if (m_peak_bytes.compare_exchange_weak(peak_bytes, curr_bytes, std::memory_order_relaxed)) break;
+        }
+    }
+    // frees are counted for the thread that frees the block and bytes are returned to the thread that allocated it
+    static void on_free(ThreadHeap& owner, size_t size) {
+        m_thread_stats.total_frees++;
+        owner.curr_bytes.fetch_sub(int64_t(size), std::memory_order_relaxed);
+        m_total_frees.fetch_add(1, std::memory_order_relaxed);
+        m_curr_bytes.fetch_sub(int64_t(size), std::memory_order_relaxed);
+    }
+    static void* aligned_malloc(size_t size, size_t alignment) noexcept {
+#if _WIN32
+        return _aligned_malloc(size, alignment);
+#else
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, alignment, size) != 0) return nullptr;
+        return ptr;
+#endif
+    }
+    static void aligned_free(void* ptr) noexcept {
+#if _WIN32
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+};
+
+// Every variant is replaced, including nothrow, since their defaults aren't guaranteed to forward to the others
+// e.g. sanitizers interpose them separately and would free a tracked block without its header
+#define INITIALIZE_ALLOCATION_TRACKER \
+    static const bool g_allocation_tracker_is_initialised = (AllocationTracker::set_enabled(), true); \
+    void* operator new(size_t size) { return AllocationTracker::allocate(size); } \
+    void* operator new[](size_t size) { return AllocationTracker::allocate(size); } \
+    void* operator new(size_t size, std::align_val_t align) { return AllocationTracker::allocate(size, size_t(align)); } \
+    void* operator new[](size_t size, std::align_val_t align) { return AllocationTracker::allocate(size, size_t(align)); } \
+    void* operator new(size_t size, const std::nothrow_t&) noexcept { return AllocationTracker::try_allocate(size); } \
+    void* operator new[](size_t size, const std::nothrow_t&) noexcept { return AllocationTracker::try_allocate(size); } \
+    void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return AllocationTracker::try_allocate(size, size_t(align)); } \
+    void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return AllocationTracker::try_allocate(size, size_t(align)); } \
+    void operator delete(void* ptr) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete[](void* ptr) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete(void* ptr, size_t) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete[](void* ptr, size_t) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete(void* ptr, std::align_val_t) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete[](void* ptr, std::align_val_t) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete(void* ptr, size_t, std::align_val_t) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete(void* ptr, const std::nothrow_t&) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete[](void* ptr, const std::nothrow_t&) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { AllocationTracker::deallocate(ptr); } \
+    void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { AllocationTracker::deallocate(ptr); }
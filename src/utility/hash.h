@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+#include "utility/span.h"
+
+// 64bit FNV-1a hash for identifying repeated content
+inline uint64_t fnv1a_hash(tcb::span<const uint8_t> data, uint64_t hash=0xcbf29ce484222325ull) {
+    for (const uint8_t x: data) {
+        hash ^= uint64_t(x);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
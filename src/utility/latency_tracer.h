@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+
+// Histogram of durations such as time spent waiting on a buffer or processing latency
+// Bucket i counts durations in [2^i, 2^(i+1)) microseconds, the last bucket holds everything longer
+// Can be updated from multiple threads without locking
+class LatencyHistogram
+{
+public:
+    static constexpr size_t TOTAL_BUCKETS = 24;
+private:
+    std::array<std::atomic<uint64_t>, TOTAL_BUCKETS> m_buckets;
+    std::atomic<uint64_t> m_total_count{0};
+    std::atomic<uint64_t> m_total_ns{0};
+    std::atomic<uint64_t> m_max_ns{0};
+public:
+    LatencyHistogram() {
+        for (auto& bucket: m_buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+    void add(std::chrono::nanoseconds duration) {
+        const uint64_t ns = (duration.count() > 0) ? uint64_t(duration.count()) : 0;
+        uint64_t us = ns / 1000;
+        size_t index = 0;
+        while ((us > 1) && (index < TOTAL_BUCKETS-1)) {
+            us >>= 1;
+            index++;
+        }
+        m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+        m_total_count.fetch_add(1, std::memory_order_relaxed);
+        m_total_ns.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t max_ns = m_max_ns.load(std::memory_order_relaxed);
+        while ((ns > max_ns) && !m_max_ns.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed)) {}
+    }
+    uint64_t get_bucket(size_t index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    uint64_t get_total_count() const { return m_total_count.load(std::memory_order_relaxed); }
+    uint64_t get_total_ns() const { return m_total_ns.load(std::memory_order_relaxed); }
+    uint64_t get_max_ns() const { return m_max_ns.load(std::memory_order_relaxed); }
+    // upper bound of the bucket containing the given fraction of all durations
+    uint64_t get_percentile_us(double fraction) const {
+        const uint64_t total = get_total_count();
+        const uint64_t target = uint64_t(double(total)*fraction);
+        uint64_t count = 0;
+        for (size_t i = 0; i < TOTAL_BUCKETS; i++) {
+            count += get_bucket(i);
+            if (count > target) return uint64_t(1) << (i+1);
+        }
+        return uint64_t(1) << TOTAL_BUCKETS;
+    }
+    void print(FILE* fp, const char* name) const {
+        const uint64_t count = get_total_count();
+        const double mean_ms = (count > 0) ? double(get_total_ns())*1e-6/double(count) : 0.0;
+        fprintf(fp, "%s: count=%" PRIu64 " total=%.3fms mean=%.3fms max=%.3fms\n",
+            name, count, double(get_total_ns())*1e-6, mean_ms, double(get_max_ns())*1e-6);
+        for (size_t i = 0; i < TOTAL_BUCKETS; i++) {
+            const uint64_t bucket = get_bucket(i);
+            if (bucket == 0) continue;
+            const char* suffix = (i == TOTAL_BUCKETS-1) ? "+" : "";
+            fprintf(fp, "  >=%8zuus%s: %" PRIu64 "\n", (i == 0) ? size_t(0) : (size_t(1) << i), suffix, bucket);
+        }
+    }
+};
+
+// Identifies which IQ samples an OFDM frame came from and when each stage finished with it
+// This is carried along with the frame so latency can be measured where its data leaves the radio
+struct FrameTimestamp {
+    using clock = std::chrono::steady_clock;
+    uint64_t frame_index = 0;
+    uint64_t sample_index = 0;              // total IQ samples read up to the end of the frame
+    clock::time_point time_received{};      // last sample of the frame was given to the demodulator
+    clock::time_point time_demodulated{};   // soft bits of the frame were produced
+    clock::time_point time_radio_start{};   // radio started decoding the frame
+    bool is_valid() const { return time_received != clock::time_point{}; }
+};
+
+enum class LatencyStage: size_t {
+    OFDM_DEMOD = 0,     // received -> demodulated
+    RADIO_QUEUE,        // demodulated -> radio start
+    AUDIO_DECODE,       // radio start -> audio decoded
+    DATA_DECODE,        // radio start -> data decoded (labels, MOT objects, slideshows)
+    AUDIO_OUTPUT,       // audio decoded -> audio played out of the audio pipeline
+    SCRAPER_OUTPUT,     // audio decoded -> audio handed to the scraper writer
+    TOTAL_AUDIO,        // received -> audio played
+    TOTAL_DATA,         // received -> data decoded
+    TOTAL_FRAME,        // received -> radio finished decoding all channels in the frame
+    COUNT
+};
+
+// Per stage and end to end latency histograms for frames tagged with a FrameTimestamp
+class LatencyTracer
+{
+public:
+    using clock = FrameTimestamp::clock;
+    static constexpr size_t TOTAL_STAGES = size_t(LatencyStage::COUNT);
+private:
+    std::array<LatencyHistogram, TOTAL_STAGES> m_histograms;
+public:
+    void add(LatencyStage stage, clock::duration duration) {
+        m_histograms[size_t(stage)].add(duration);
+    }
+    void add(LatencyStage stage, clock::time_point start, clock::time_point end) {
+        add(stage, end-start);
+    }
+    const LatencyHistogram& get(LatencyStage stage) const { return m_histograms[size_t(stage)]; }
+    static const char* get_stage_name(LatencyStage stage) {
+        switch (stage) {
+        case LatencyStage::OFDM_DEMOD:      return "ofdm_demod";
+        case LatencyStage::RADIO_QUEUE:     return "radio_queue";
+        case LatencyStage::AUDIO_DECODE:    return "audio_decode";
+        case LatencyStage::DATA_DECODE:     return "data_decode";
+        case LatencyStage::AUDIO_OUTPUT:    return "audio_output";
+        case LatencyStage::SCRAPER_OUTPUT:  return "scraper_output";
+        case LatencyStage::TOTAL_AUDIO:     return "total_audio";
+        case LatencyStage::TOTAL_DATA:      return "total_data";
+        case LatencyStage::TOTAL_FRAME:     return "total_frame";
+        default:                            return "unknown";
+        }
+    }
+    void print(FILE* fp) const {
+        for (size_t i = 0; i < TOTAL_STAGES; i++) {
+            const auto stage = LatencyStage(i);
+            if (get(stage).get_total_count() == 0) continue;
+            get(stage).print(fp, get_stage_name(stage));
+        }
+    }
+};
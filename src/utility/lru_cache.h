@@ -1,98 +1,264 @@
 #pragma once
 
 #include <stddef.h>
-#include <list>
-#include <unordered_map>
+#include <stdint.h>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <tuple>
 #include <utility>
+#include <vector>
 
-template <typename K, typename T>
-class LRU_Cache 
+// Fixed capacity least recently used cache
+// Entries live in a contiguous slot array and are linked in recency order by index
+// Keys are located through an open addressing hash table (linear probing with backward shift deletion)
+// No allocations occur after construction or set_max_size(...)
+// References to values remain valid until the entry is evicted
+template <typename K, typename T, typename Hash = std::hash<K>>
+class LRU_Cache
 {
+public:
+    using value_type = std::pair<const K,T>;
 private:
-    typedef std::list<std::pair<const K,T>> list_t;
-    list_t m_lru_list;
-    std::unordered_map<K, typename list_t::iterator> m_cache;
+    using index_t = uint32_t;
+    static constexpr index_t NONE = ~index_t(0);
+    struct Slot {
+        std::optional<value_type> entry;
+        size_t hash = 0;
+        index_t prev = NONE;
+        index_t next = NONE;
+    };
+    std::vector<Slot> m_slots;
+    std::vector<index_t> m_buckets;
+    size_t m_bucket_mask = 0;
+    index_t m_head = NONE; // most recently used
+    index_t m_tail = NONE; // least recently used
+    index_t m_free = NONE;
+    size_t m_size = 0;
     size_t m_max_size;
+    Hash m_hasher;
+public:
+    template <typename U>
+    class Iterator
+    {
+    private:
+        U* m_slots;
+        index_t m_index;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = LRU_Cache::value_type;
+        using pointer = value_type*;
+        using reference = value_type&;
+        Iterator(U* slots, index_t index): m_slots(slots), m_index(index) {}
+        reference operator*() const { return *((*m_slots)[m_index].entry); }
+        pointer operator->() const { return &(*((*m_slots)[m_index].entry)); }
+        Iterator& operator++() { m_index = (*m_slots)[m_index].next; return *this; }
+        Iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+        bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+    };
 public:
     explicit LRU_Cache(size_t max_size=10) {
-       m_max_size = max_size; 
+        m_max_size = max_size;
+        allocate(max_size);
     }
 
     size_t get_max_size(void) const {
         return m_max_size;
     }
 
+    size_t size(void) const {
+        return m_size;
+    }
+
+    // reallocates storage and keeps the most recently used entries
     void set_max_size(const size_t max_size) {
+        std::vector<std::pair<K,T>> entries;
+        entries.reserve(m_size);
+        for (index_t i = m_head; i != NONE; i = m_slots[i].next) {
+            if (entries.size() >= max_size) break;
+            auto& entry = *(m_slots[i].entry);
+            entries.emplace_back(entry.first, std::move(entry.second));
+        }
         m_max_size = max_size;
-        remove_lru();
+        allocate(max_size);
+        // insert least recently used first to preserve ordering
+        for (auto it = entries.rbegin(); it != entries.rend(); it++) {
+            emplace(it->first, std::move(it->second));
+        }
     }
 
     T* find(const K& key) {
-        auto res = m_cache.find(key);
-        if (res == m_cache.end()) {
+        const index_t i = lookup(key, m_hasher(key));
+        if (i == NONE) {
             return nullptr;
         }
-
-        auto it = res->second;
-        promote(it);
-        return &it->second;
+        promote(i);
+        return &(m_slots[i].entry->second);
     }
 
     T& insert(K key, T&& val) {
-        auto res = m_cache.find(key);
-        if (res == m_cache.end()) {
-            remove_lru();
-            m_lru_list.push_front({key, val});
-            res = m_cache.insert({key, m_lru_list.begin()}).first; 
-        }
-        auto it = res->second;
-        promote(it);
-        return it->second;
+        return emplace(std::move(key), std::move(val));
     }
 
     template <typename ... U>
     T& emplace(K key, U&& ... args) {
-        auto res = m_cache.find(key);
-        if (res == m_cache.end()) {
-            remove_lru();
+        const size_t hash = m_hasher(key);
+        index_t i = lookup(key, hash);
+        if (i == NONE) {
+            i = acquire_slot();
+            auto& slot = m_slots[i];
             // std::pair has the following constructor signature
-            m_lru_list.emplace_front(
-                std::piecewise_construct, 
-                std::forward_as_tuple(key), 
+            slot.entry.emplace(
+                std::piecewise_construct,
+                std::forward_as_tuple(std::move(key)),
                 std::forward_as_tuple(std::forward<U>(args)...));
-            res = m_cache.insert({key, m_lru_list.begin()}).first; 
+            slot.hash = hash;
+            insert_bucket(i);
+            link_front(i);
+            m_size++;
+        } else {
+            promote(i);
+        }
+        return m_slots[i].entry->second;
+    }
+
+    // Same as emplace(key) except a full cache moves the evicted value into the new entry instead of destroying it
+    // Values which own buffers keep their capacity so the caller has to reset the stale contents
+    T& emplace_recycled(K key) {
+        if ((m_free == NONE) && (lookup(key, m_hasher(key)) == NONE)) {
+            T value = std::move(m_slots[m_tail].entry->second);
+            return emplace(std::move(key), std::move(value));
+        }
+        return emplace(std::move(key));
+    }
+
+    bool erase(const K& key) {
+        const index_t i = lookup(key, m_hasher(key));
+        if (i == NONE) {
+            return false;
+        }
+        release_slot(i);
+        return true;
+    }
+
+    void clear(void) {
+        while (m_head != NONE) {
+            release_slot(m_head);
         }
-        auto it = res->second;
-        promote(it);
-        return it->second;
     }
 
+    // iterate from most to least recently used
     auto begin() {
-        return m_lru_list.begin();
+        return Iterator<std::vector<Slot>>(&m_slots, m_head);
     }
 
     auto end() {
-        return m_lru_list.end();
+        return Iterator<std::vector<Slot>>(&m_slots, NONE);
     }
 private:
-    // cull list elements past max size
-    void remove_lru(void) {
-        if (m_lru_list.size() <= m_max_size) {
-            return;
+    void allocate(size_t max_size) {
+        // we always need space for at least one entry since insert(...) returns a reference
+        const size_t capacity = (max_size > 0) ? max_size : 1;
+        // keep load factor at or below 0.5 for short probe sequences
+        size_t nb_buckets = 1;
+        while (nb_buckets < capacity*2) nb_buckets *= 2;
+
+        m_slots.clear();
+        m_slots.resize(capacity);
+        m_buckets.assign(nb_buckets, NONE);
+        m_bucket_mask = nb_buckets-1;
+        m_head = NONE;
+        m_tail = NONE;
+        m_size = 0;
+        // thread all slots into the free list
+        m_free = 0;
+        for (size_t i = 0; i < capacity; i++) {
+            m_slots[i].next = (i+1 < capacity) ? index_t(i+1) : NONE;
         }
+    }
 
-        auto _start = m_lru_list.begin();
-        auto _end = m_lru_list.end();
-        std::advance(_start, m_max_size);
-        for (auto it = _start; it != _end; it++) {
-            auto key = it->first;
-            m_cache.erase(key);
+    index_t lookup(const K& key, const size_t hash) const {
+        for (size_t b = hash & m_bucket_mask; m_buckets[b] != NONE; b = (b+1) & m_bucket_mask) {
+            const auto& slot = m_slots[m_buckets[b]];
+            if ((slot.hash == hash) && (slot.entry->first == key)) {
+                return m_buckets[b];
+            }
         }
-        m_lru_list.erase(_start, _end);
+        return NONE;
+    }
+
+    void insert_bucket(const index_t i) {
+        size_t b = m_slots[i].hash & m_bucket_mask;
+        while (m_buckets[b] != NONE) b = (b+1) & m_bucket_mask;
+        m_buckets[b] = i;
+    }
+
+    void erase_bucket(const index_t i) {
+        size_t b = m_slots[i].hash & m_bucket_mask;
+        while (m_buckets[b] != i) b = (b+1) & m_bucket_mask;
+        // shift back any entries in the probe sequence which would become unreachable
+        size_t j = b;
+        while (true) {
+            j = (j+1) & m_bucket_mask;
+            if (m_buckets[j] == NONE) break;
+            const size_t home = m_slots[m_buckets[j]].hash & m_bucket_mask;
+            const bool is_reachable = (b <= j) ? ((b < home) && (home <= j)) : ((b < home) || (home <= j));
+            if (is_reachable) continue;
+            m_buckets[b] = m_buckets[j];
+            b = j;
+        }
+        m_buckets[b] = NONE;
+    }
+
+    // take a free slot or evict the least recently used entry
+    index_t acquire_slot(void) {
+        if (m_free != NONE) {
+            const index_t i = m_free;
+            m_free = m_slots[i].next;
+            return i;
+        }
+        const index_t i = m_tail;
+        erase_bucket(i);
+        unlink(i);
+        m_slots[i].entry.reset();
+        m_size--;
+        return i;
+    }
+
+    void release_slot(const index_t i) {
+        erase_bucket(i);
+        unlink(i);
+        m_slots[i].entry.reset();
+        m_slots[i].next = m_free;
+        m_free = i;
+        m_size--;
+    }
+
+    void unlink(const index_t i) {
+        auto& slot = m_slots[i];
+        if (slot.prev != NONE) m_slots[slot.prev].next = slot.next;
+        else m_head = slot.next;
+        if (slot.next != NONE) m_slots[slot.next].prev = slot.prev;
+        else m_tail = slot.prev;
+        slot.prev = NONE;
+        slot.next = NONE;
+    }
+
+    void link_front(const index_t i) {
+        auto& slot = m_slots[i];
+        slot.prev = NONE;
+        slot.next = m_head;
+        if (m_head != NONE) m_slots[m_head].prev = i;
+        m_head = i;
+        if (m_tail == NONE) m_tail = i;
     }
 
-    // move list element to the front
-    void promote(typename list_t::iterator& it) {
-        m_lru_list.splice(m_lru_list.begin(), m_lru_list, it);
+    // move entry to the front
+    void promote(const index_t i) {
+        if (m_head == i) return;
+        unlink(i);
+        link_front(i);
     }
-};
\ No newline at end of file
+};
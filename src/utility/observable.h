@@ -1,22 +1,66 @@
 #pragma once
 
-#include <functional>
+#include <stddef.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// Arguments are forwarded by const reference so large payloads aren't copied per listener
+// Listeners should take large arguments by const reference for this to be zero copy
 template <typename ... T>
-class Observable 
+class Observable
 {
+public:
+    // Listeners are stored inline without heap allocation so captures must fit in this size
+    static constexpr size_t MAX_LISTENER_SIZE = 64;
 private:
-    using Observer = std::function<void(T...)>;
+    struct VTable {
+        void (*invoke)(void*, const T&...);
+        void (*copy)(void*, const void*);
+        void (*move)(void*, void*);
+        void (*destroy)(void*);
+    };
+
+    template <typename F>
+    static inline const VTable VTABLE_INSTANCE = {
+        [](void* f, const T&... args) { (*static_cast<F*>(f))(args...); },
+        [](void* dst, const void* src) { new (dst) F(*static_cast<const F*>(src)); },
+        [](void* dst, void* src) { new (dst) F(std::move(*static_cast<F*>(src))); },
+        [](void* f) { static_cast<F*>(f)->~F(); },
+    };
+
+    class Observer
+    {
+    private:
+        alignas(std::max_align_t) unsigned char m_storage[MAX_LISTENER_SIZE];
+        const VTable* m_vtable;
+    public:
+        template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Observer>>>
+        explicit Observer(F&& f) {
+            using U = std::decay_t<F>;
+            static_assert(sizeof(U) <= MAX_LISTENER_SIZE, "Listener captures too much data to be stored inline");
+            static_assert(alignof(U) <= alignof(std::max_align_t), "Listener has unsupported alignment");
+            new (m_storage) U(std::forward<F>(f));
+            m_vtable = &VTABLE_INSTANCE<U>;
+        }
+        ~Observer() { m_vtable->destroy(m_storage); }
+        Observer(const Observer& other): m_vtable(other.m_vtable) { m_vtable->copy(m_storage, other.m_storage); }
+        Observer(Observer&& other) noexcept: m_vtable(other.m_vtable) { m_vtable->move(m_storage, other.m_storage); }
+        Observer& operator=(const Observer&) = delete;
+        Observer& operator=(Observer&&) = delete;
+        void operator()(const T&... args) const { m_vtable->invoke(const_cast<unsigned char*>(m_storage), args...); }
+    };
     std::vector<Observer> m_observers;
 public:
-    void Attach(const Observer& observer) {
-        m_observers.push_back(observer);
+    template <typename F>
+    void Attach(F&& observer) {
+        m_observers.emplace_back(std::forward<F>(observer));
     }
-    // Copies arguments to list of callbacks
-    void Notify(T ... args) {
+    void Notify(const T& ... args) {
         for (const auto& o: m_observers) {
             o(args...);
         }
     }
-};
\ No newline at end of file
+};
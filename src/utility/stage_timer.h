@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+// Total time spent in a processing stage and how many times it ran
+// Can be updated from multiple threads without locking
+class StageTimer
+{
+public:
+    using clock = std::chrono::steady_clock;
+private:
+    std::atomic<uint64_t> m_total_calls{0};
+    std::atomic<uint64_t> m_total_ns{0};
+public:
+    void add(clock::duration duration) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        m_total_calls.fetch_add(1, std::memory_order_relaxed);
+        m_total_ns.fetch_add((ns > 0) ? uint64_t(ns) : 0, std::memory_order_relaxed);
+    }
+    uint64_t get_total_calls() const { return m_total_calls.load(std::memory_order_relaxed); }
+    uint64_t get_total_ns() const { return m_total_ns.load(std::memory_order_relaxed); }
+};
+
+// Adds the time from construction until the end of the scope to a stage timer
+class ScopedStageTimer
+{
+private:
+    StageTimer& m_timer;
+    const StageTimer::clock::time_point m_time_start;
+public:
+    explicit ScopedStageTimer(StageTimer& timer): m_timer(timer), m_time_start(StageTimer::clock::now()) {}
+    ~ScopedStageTimer() { m_timer.add(StageTimer::clock::now() - m_time_start); }
+    ScopedStageTimer(ScopedStageTimer&) = delete;
+    ScopedStageTimer(ScopedStageTimer&&) = delete;
+    ScopedStageTimer& operator=(ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(ScopedStageTimer&&) = delete;
+};
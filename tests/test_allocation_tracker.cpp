@@ -0,0 +1,79 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+#include "utility/allocation_tracker.h"
+#include "./test_helpers.h"
+
+INITIALIZE_ALLOCATION_TRACKER
+
+struct alignas(64) AlignedBlock {
+    uint8_t data[64];
+};
+
+// nothrow variants must go through the tracker so they can be freed by any delete
+static void test_nothrow_variants() {
+    const auto start = AllocationTracker::get_thread_stats();
+    int* x = new (std::nothrow) int[10];
+    CHECK(x != nullptr);
+    delete[] x;
+    int* y = new (std::nothrow) int(1);
+    CHECK(y != nullptr);
+    delete y;
+    auto* z = new (std::nothrow) AlignedBlock[4];
+    CHECK(z != nullptr);
+    CHECK((reinterpret_cast<uintptr_t>(z) % alignof(AlignedBlock)) == 0);
+    delete[] z;
+    auto* w = static_cast<int*>(operator new(sizeof(int), std::nothrow));
+    operator delete(w, std::nothrow);
+    const auto end = AllocationTracker::get_thread_stats();
+    CHECK((end.total_allocations - start.total_allocations) == 4);
+    CHECK((end.total_frees - start.total_frees) == 4);
+    CHECK(end.curr_bytes == start.curr_bytes);
+}
+
+static void test_aligned_variants() {
+    auto blocks = std::vector<std::unique_ptr<AlignedBlock>>();
+    for (int i = 0; i < 16; i++) {
+        blocks.push_back(std::make_unique<AlignedBlock>());
+        CHECK((reinterpret_cast<uintptr_t>(blocks.back().get()) % alignof(AlignedBlock)) == 0);
+    }
+}
+
+// bytes freed on another thread are returned to the thread that allocated them
+static void test_cross_thread_free() {
+    const auto start = AllocationTracker::get_thread_stats();
+    constexpr size_t TOTAL_BYTES = 4096;
+    auto* block = new uint8_t[TOTAL_BYTES];
+    CHECK((AllocationTracker::get_thread_stats().curr_bytes - start.curr_bytes) == int64_t(TOTAL_BYTES));
+
+    AllocationStats other_start;
+    AllocationStats other_end;
+    auto thread = std::thread([&]() {
+        other_start = AllocationTracker::get_thread_stats();
+        delete[] block;
+        other_end = AllocationTracker::get_thread_stats();
+    });
+    thread.join();
+
+    const auto end = AllocationTracker::get_thread_stats();
+    CHECK(end.curr_bytes == start.curr_bytes);
+    CHECK(end.peak_bytes >= start.curr_bytes + int64_t(TOTAL_BYTES));
+    CHECK(other_end.curr_bytes == other_start.curr_bytes);
+    CHECK(other_end.curr_bytes >= 0);
+    CHECK((other_end.total_frees - other_start.total_frees) == 1);
+}
+
+int main(int /*argc*/, char** /*argv*/) {
+    CHECK(AllocationTracker::is_enabled());
+    const auto start = AllocationTracker::get_global_stats();
+    test_nothrow_variants();
+    test_aligned_variants();
+    test_cross_thread_free();
+    const auto end = AllocationTracker::get_global_stats();
+    CHECK(end.total_allocations > start.total_allocations);
+    return get_test_result();
+}
@@ -0,0 +1,139 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "gui/basic_radio/decoded_image_cache.h"
+#include "./test_helpers.h"
+
+// 2x2 RGBA png with red increasing along x and green along y
+static const std::vector<uint8_t> PNG_2x2 = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x08, 0x06, 0x00, 0x00, 0x00, 0x72, 0xB6, 0x0D,
+    0x24, 0x00, 0x00, 0x00, 0x15, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x60, 0x60, 0x60, 0xF8,
+    0xFF, 0x1F, 0x88, 0x41, 0xE8, 0x3F, 0x90, 0xF5, 0x1F, 0x00, 0x38, 0xD9, 0x07, 0xF9, 0xEC, 0xF5,
+    0x9E, 0x4F, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+// 3x1 RGBA png filled with half transparent blue
+static const std::vector<uint8_t> PNG_3x1 = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x08, 0x06, 0x00, 0x00, 0x00, 0x1B, 0xE0, 0x14,
+    0xB4, 0x00, 0x00, 0x00, 0x0E, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x60, 0x60, 0xF8, 0xDF,
+    0x00, 0xC3, 0x00, 0x19, 0x7B, 0x04, 0x7E, 0xD8, 0x55, 0x99, 0xF1, 0x00, 0x00, 0x00, 0x00, 0x49,
+    0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+static std::shared_ptr<const std::vector<uint8_t>> make_data(const std::vector<uint8_t>& data) {
+    return std::make_shared<const std::vector<uint8_t>>(data);
+}
+
+// polls the cache since decoding happens on a background thread
+static std::shared_ptr<const DecodedImage> wait_for_image(
+    DecodedImageCache& cache, const uint32_t key, const uint64_t hash,
+    std::shared_ptr<const std::vector<uint8_t>> data
+) {
+    const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < timeout) {
+        auto image = cache.Get(key, hash, data);
+        if (image != nullptr) return image;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return nullptr;
+}
+
+static void test_decode() {
+    const auto image = DecodedImageCache::Decode(PNG_2x2);
+    CHECK(image.is_success);
+    CHECK(image.width == 2);
+    CHECK(image.height == 2);
+    CHECK(image.rgba.size() == 2*2*4);
+    if (image.rgba.size() != 2*2*4) return;
+    const uint8_t expected[] = {
+        0x00, 0x00, 0x00, 0xFF,  0xFF, 0x00, 0x00, 0xFF,
+        0x00, 0xFF, 0x00, 0xFF,  0xFF, 0xFF, 0x00, 0xFF,
+    };
+    for (size_t i = 0; i < image.rgba.size(); i++) {
+        CHECK(image.rgba[i] == expected[i]);
+    }
+
+    const std::vector<uint8_t> garbage = { 0x00, 0x01, 0x02, 0x03 };
+    const auto bad_image = DecodedImageCache::Decode(garbage);
+    CHECK(!bad_image.is_success);
+    CHECK(bad_image.width == 0);
+    CHECK(bad_image.height == 0);
+    CHECK(bad_image.rgba.empty());
+}
+
+static void test_pending_then_ready() {
+    auto cache = DecodedImageCache(4);
+    auto data = make_data(PNG_2x2);
+    // the first request can never be ready since the decode was only just queued
+    CHECK(cache.Get(1, 100, data) == nullptr);
+    const auto image = wait_for_image(cache, 1, 100, data);
+    CHECK(image != nullptr);
+    if (image == nullptr) return;
+    CHECK(image->is_success);
+    CHECK(image->width == 2);
+    CHECK(image->height == 2);
+    // finished images are returned directly
+    CHECK(cache.Get(1, 100, data) == image);
+}
+
+static void test_failed_decode_is_cached() {
+    auto cache = DecodedImageCache(4);
+    auto data = make_data({ 0xDE, 0xAD, 0xBE, 0xEF });
+    const auto image = wait_for_image(cache, 1, 100, data);
+    CHECK(image != nullptr);
+    if (image == nullptr) return;
+    CHECK(!image->is_success);
+    CHECK(cache.Get(1, 100, data) == image);
+}
+
+static void test_replaced_hash_discards_stale() {
+    auto cache = DecodedImageCache(4);
+    auto old_data = make_data(PNG_2x2);
+    auto new_data = make_data(PNG_3x1);
+    // the old decode is still queued or running when the image under the key is replaced
+    CHECK(cache.Get(1, 100, old_data) == nullptr);
+    CHECK(cache.Get(1, 200, new_data) == nullptr);
+    const auto image = wait_for_image(cache, 1, 200, new_data);
+    CHECK(image != nullptr);
+    if (image == nullptr) return;
+    CHECK(image->width == 3);
+    CHECK(image->height == 1);
+    // let the stale decode land if it hasn't already and check it didn't overwrite the new image
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(cache.Get(1, 200, new_data) == image);
+}
+
+static void test_eviction() {
+    auto cache = DecodedImageCache(2);
+    auto data = make_data(PNG_2x2);
+    const auto image_0 = wait_for_image(cache, 0, 100, data);
+    const auto image_1 = wait_for_image(cache, 1, 101, data);
+    CHECK(image_0 != nullptr);
+    CHECK(image_1 != nullptr);
+    // touch key 0 so key 1 is the least recently used
+    CHECK(cache.Get(0, 100, data) == image_0);
+    const auto image_2 = wait_for_image(cache, 2, 102, data);
+    CHECK(image_2 != nullptr);
+    CHECK(cache.Get(0, 100, data) == image_0);
+    CHECK(cache.Get(2, 102, data) == image_2);
+    // evicted image has to be decoded again
+    CHECK(cache.Get(1, 101, data) == nullptr);
+    const auto image_1_again = wait_for_image(cache, 1, 101, data);
+    CHECK(image_1_again != nullptr);
+    CHECK(image_1_again != image_1);
+}
+
+int main(int /*argc*/, char** /*argv*/) {
+    test_decode();
+    test_pending_then_ready();
+    test_failed_decode_is_cached();
+    test_replaced_hash_discards_stale();
+    test_eviction();
+    return get_test_result();
+}
@@ -0,0 +1,274 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <easylogging++.h>
+#include "dab/audio/aac_frame_processor.h"
+#include "dab/audio/mp2_audio_decoder.h"
+#include "dab/constants/dab_parameters.h"
+#include "dab/dab_logging.h"
+#include "dab/dab_misc_info.h"
+#include "dab/database/dab_database.h"
+#include "dab/database/dab_database_entities.h"
+#include "dab/database/dab_database_updater.h"
+#include "dab/fic/fic_decoder.h"
+#include "dab/fic/fig_processor.h"
+#include "dab/mot/MOT_entities.h"
+#include "dab/mot/MOT_processor.h"
+#include "dab/msc/msc_data_packet_processor.h"
+#include "dab/msc/msc_decoder.h"
+#include "dab/radio_fig_handler.h"
+#include "ensemble/ensemble_config.h"
+#include "ensemble/ensemble_generator.h"
+#include "ensemble/test_image.h"
+#include "utility/span.h"
+#include "viterbi_config.h"
+#include "./test_helpers.h"
+
+INITIALIZE_EASYLOGGINGPP
+
+// Generated frames are fed through the decoders as soft bits to check the whole FEC and audio chain
+// The ensemble generator and decoders are written against the same standard so any mismatch shows up here
+constexpr int TOTAL_FRAMES = 48;
+// Size of the slides sent by MOT_Slideshow_Source
+constexpr uint32_t SLIDE_WIDTH = 64;
+constexpr uint32_t SLIDE_HEIGHT = 48;
+
+static EnsembleConfig create_config() {
+    EnsembleConfig config;
+    config.label = "Loopback";
+    config.services.push_back({ EnsembleServiceType::DAB_PLUS, 48, "Loopback AAC" });
+    config.services.push_back({ EnsembleServiceType::DAB, 64, "Loopback MP2" });
+    config.services.push_back({ EnsembleServiceType::DATA, 64, "Loopback Slides" });
+    return config;
+}
+
+// Labels are sent as a fixed 16 character field padded with spaces and stored in the database as is
+static std::string get_label_field(const std::string& label) {
+    constexpr size_t TOTAL_LABEL_CHARS = 16;
+    auto field = label.substr(0, TOTAL_LABEL_CHARS);
+    field.resize(TOTAL_LABEL_CHARS, ' ');
+    return field;
+}
+
+struct Completed_MOT_Entity {
+    std::string name;
+    std::vector<uint8_t> body;
+};
+
+struct LoopbackStats {
+    int total_fibs = 0;
+    int total_superframes = 0;
+    int total_access_units = 0;
+    int total_firecode_errors = 0;
+    int total_rs_errors = 0;
+    int total_au_crc_errors = 0;
+    int total_mp2_frames = 0;
+    int total_mp2_errors = 0;
+    std::vector<Completed_MOT_Entity> mot_entities;
+};
+
+// Stream and packet mode decoders for one subchannel
+struct LoopbackChannel {
+    std::unique_ptr<MSC_Decoder> msc_decoder;
+    std::unique_ptr<AAC_Frame_Processor> aac_frame_processor;
+    std::unique_ptr<MSC_Data_Packet_Processor> data_packet_processor;
+    plm_buffer_t* plm_buffer = nullptr;
+    plm_audio_t* plm_audio = nullptr;
+    LoopbackChannel() = default;
+    ~LoopbackChannel() {
+        if (plm_audio != nullptr) plm_audio_destroy(plm_audio);
+        if (plm_buffer != nullptr) plm_buffer_destroy(plm_buffer);
+    }
+    LoopbackChannel(LoopbackChannel&) = delete;
+    LoopbackChannel(LoopbackChannel&&) = delete;
+    LoopbackChannel& operator=(LoopbackChannel&) = delete;
+    LoopbackChannel& operator=(LoopbackChannel&&) = delete;
+};
+
+static const ServiceComponent* find_component(const DAB_Database& db, const subchannel_id_t subchannel_id) {
+    for (const auto& component: db.service_components) {
+        if (component.is_complete && (component.subchannel_id == subchannel_id)) return &component;
+    }
+    return nullptr;
+}
+
+static const Subchannel* find_subchannel(const DAB_Database& db, const subchannel_id_t subchannel_id) {
+    for (const auto& subchannel: db.subchannels) {
+        if (subchannel.is_complete && (subchannel.id == subchannel_id)) return &subchannel;
+    }
+    return nullptr;
+}
+
+static const Service* find_service(const DAB_Database& db, const service_id_t service_reference) {
+    for (const auto& service: db.services) {
+        if (service.reference == service_reference) return &service;
+    }
+    return nullptr;
+}
+
+// Channels are only created from what was decoded from the FIC
+static std::unique_ptr<LoopbackChannel> create_channel(const DAB_Database& db, const subchannel_id_t subchannel_id, LoopbackStats& stats) {
+    const auto* subchannel = find_subchannel(db, subchannel_id);
+    const auto* component = find_component(db, subchannel_id);
+    if ((subchannel == nullptr) || (component == nullptr)) return nullptr;
+
+    auto channel = std::make_unique<LoopbackChannel>();
+    channel->msc_decoder = std::make_unique<MSC_Decoder>(*subchannel);
+    if (component->transport_mode == TransportMode::PACKET_MODE_DATA) {
+        channel->data_packet_processor = std::make_unique<MSC_Data_Packet_Processor>();
+        channel->data_packet_processor->Get_MOT_Processor().OnEntityComplete().Attach([&stats](const MOT_Entity& entity) {
+            Completed_MOT_Entity completed;
+            completed.name = entity.header.content_name.name;
+            completed.body.assign(entity.body_buf.begin(), entity.body_buf.end());
+            stats.mot_entities.push_back(std::move(completed));
+        });
+    } else if (component->audio_service_type == AudioServiceType::DAB_PLUS) {
+        auto& processor = channel->aac_frame_processor;
+        processor = std::make_unique<AAC_Frame_Processor>();
+        processor->OnSuperFrameHeader().Attach([&stats](const SuperFrameHeader&) { stats.total_superframes++; });
+        processor->OnAccessUnit().Attach([&stats](const int, const int, tcb::span<uint8_t>) { stats.total_access_units++; });
+        processor->OnFirecodeError().Attach([&stats](const int, const uint16_t, const uint16_t) { stats.total_firecode_errors++; });
+        processor->OnRSError().Attach([&stats](const int, const int) { stats.total_rs_errors++; });
+        processor->OnAccessUnitCRCError().Attach([&stats](const int, const int, const uint16_t, const uint16_t) { stats.total_au_crc_errors++; });
+    } else {
+        channel->plm_buffer = plm_buffer_create_with_capacity(32);
+        channel->plm_audio = plm_audio_create_with_buffer(channel->plm_buffer);
+    }
+    return channel;
+}
+
+static void process_channel(LoopbackChannel& channel, tcb::span<const uint8_t> buf, LoopbackStats& stats) {
+    if (channel.aac_frame_processor != nullptr) {
+        channel.aac_frame_processor->Process(buf);
+    } else if (channel.data_packet_processor != nullptr) {
+        while (!buf.empty()) {
+            const size_t total_read = channel.data_packet_processor->ReadPacket(buf);
+            if (total_read == 0) break;
+            buf = buf.subspan(total_read);
+        }
+    } else {
+        // same decoding steps as Basic_DAB_Channel
+        plm_buffer_rewind(channel.plm_buffer);
+        plm_buffer_write(channel.plm_buffer, buf.data(), buf.size());
+        const int total_data_bytes = plm_audio_decode_header(channel.plm_audio);
+        const plm_samples_t* samples = (total_data_bytes > 0) ? plm_audio_decode(channel.plm_audio, total_data_bytes) : nullptr;
+        if (samples == nullptr) {
+            stats.total_mp2_errors++;
+        } else {
+            stats.total_mp2_frames++;
+        }
+    }
+}
+
+int main(int /*argc*/, char** /*argv*/) {
+    get_dab_logging_enabled() = false;
+    const auto config = create_config();
+    const auto params = get_dab_parameters(config.transmission_mode);
+    auto generator = EnsembleGenerator(config);
+
+    auto db_updater = DAB_Database_Updater();
+    auto misc_info = DAB_Misc_Info();
+    auto fig_handler = Radio_FIG_Handler();
+    auto fig_processor = FIG_Processor();
+    auto fic_decoder = FIC_Decoder(size_t(params.nb_fib_cif_bits), size_t(params.nb_fibs_per_cif));
+    fig_handler.SetUpdater(&db_updater);
+    fig_handler.SetMiscInfo(&misc_info);
+    fig_processor.SetHandler(&fig_handler);
+    LoopbackStats stats;
+    fic_decoder.OnFIB().Attach([&fig_processor, &stats](tcb::span<const uint8_t> buf) {
+        stats.total_fibs++;
+        fig_processor.ProcessFIB(buf);
+    });
+
+    const size_t total_services = config.services.size();
+    std::vector<std::unique_ptr<LoopbackChannel>> channels(total_services);
+    auto frame_bits = std::vector<uint8_t>(generator.get_nb_frame_bits());
+    auto soft_bits = std::vector<viterbi_bit_t>(frame_bits.size());
+    for (int frame = 0; frame < TOTAL_FRAMES; frame++) {
+        generator.generate_frame(frame_bits);
+        for (size_t i = 0; i < frame_bits.size(); i++) {
+            soft_bits[i] = frame_bits[i] ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+        }
+        const auto fic_bits = tcb::span<const viterbi_bit_t>(soft_bits).first(size_t(params.nb_fic_bits));
+        const auto msc_bits = tcb::span<const viterbi_bit_t>(soft_bits).subspan(size_t(params.nb_fic_bits), size_t(params.nb_msc_bits));
+        for (int i = 0; i < params.nb_cifs; i++) {
+            const size_t N = size_t(params.nb_fib_cif_bits);
+            fic_decoder.DecodeFIBGroup(fic_bits.subspan(size_t(i)*N, N), size_t(i));
+        }
+
+        // the generator assigns subchannel ids in the order of the configured services
+        for (size_t i = 0; i < total_services; i++) {
+            if (channels[i] == nullptr) {
+                channels[i] = create_channel(db_updater.GetDatabase(), subchannel_id_t(i), stats);
+            }
+        }
+        for (int i = 0; i < params.nb_cifs; i++) {
+            const size_t N = size_t(params.nb_cif_bits);
+            const auto cif_bits = msc_bits.subspan(size_t(i)*N, N);
+            for (auto& channel: channels) {
+                if (channel == nullptr) continue;
+                const auto buf = channel->msc_decoder->DecodeCIF(cif_bits);
+                // the time deinterleaver is still collecting the first CIFs
+                if (buf.empty()) continue;
+                process_channel(*channel, buf, stats);
+            }
+        }
+    }
+
+    // FIC: every FIB passed its crc and describes the ensemble we configured
+    CHECK(stats.total_fibs == TOTAL_FRAMES*params.nb_fibs);
+    const auto& db = db_updater.GetDatabase();
+    CHECK(db.ensemble.label == get_label_field(config.label));
+    CHECK(db.services.size() == total_services);
+    for (size_t i = 0; i < total_services; i++) {
+        CHECK(channels[i] != nullptr);
+        const auto* component = find_component(db, subchannel_id_t(i));
+        CHECK(component != nullptr);
+        if (component == nullptr) continue;
+        const auto* service = find_service(db, component->service_reference);
+        CHECK(service != nullptr);
+        if (service == nullptr) continue;
+        CHECK(service->label == get_label_field(config.services[i].label));
+        switch (config.services[i].type) {
+        case EnsembleServiceType::DAB_PLUS:
+            CHECK(component->transport_mode == TransportMode::STREAM_MODE_AUDIO);
+            CHECK(component->audio_service_type == AudioServiceType::DAB_PLUS);
+            break;
+        case EnsembleServiceType::DAB:
+            CHECK(component->transport_mode == TransportMode::STREAM_MODE_AUDIO);
+            CHECK(component->audio_service_type == AudioServiceType::DAB);
+            break;
+        case EnsembleServiceType::DATA:
+            CHECK(component->transport_mode == TransportMode::PACKET_MODE_DATA);
+            break;
+        }
+    }
+
+    // DAB+: superframes decode without any corrections failing
+    CHECK(stats.total_superframes > 0);
+    CHECK(stats.total_access_units > 0);
+    CHECK(stats.total_firecode_errors == 0);
+    CHECK(stats.total_rs_errors == 0);
+    CHECK(stats.total_au_crc_errors == 0);
+
+    // DAB: every mp2 frame has a valid header and decodes
+    CHECK(stats.total_mp2_frames > 0);
+    CHECK(stats.total_mp2_errors == 0);
+
+    // Data: the first slide is reassembled from its packets, data groups and MOT segments
+    CHECK(!stats.mot_entities.empty());
+    if (!stats.mot_entities.empty()) {
+        const auto& slide = stats.mot_entities.front();
+        CHECK(slide.name == "slide_0.png");
+        CHECK(slide.body == create_test_png(SLIDE_WIDTH, SLIDE_HEIGHT, 0));
+    }
+
+    fprintf(stderr, "frames=%d fibs=%d superframes=%d access_units=%d mp2_frames=%d mot_entities=%zu\n",
+        TOTAL_FRAMES, stats.total_fibs, stats.total_superframes, stats.total_access_units,
+        stats.total_mp2_frames, stats.mot_entities.size());
+    return get_test_result();
+}
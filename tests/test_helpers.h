@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdio.h>
+
+// Each test is a plain executable that returns non-zero if any check failed
+static int total_failures = 0;
+
+#define CHECK(cond) do {\
+    if (!(cond)) {\
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);\
+        total_failures++;\
+    }\
+} while (0)
+
+static int get_test_result() {
+    if (total_failures > 0) {
+        fprintf(stderr, "%d checks failed\n", total_failures);
+        return 1;
+    }
+    return 0;
+}
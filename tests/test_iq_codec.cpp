@@ -0,0 +1,182 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "utility/span.h"
+#include "app_helpers/app_io_buffers.h"
+#include "app_helpers/app_iq_codec.h"
+#include "./test_helpers.h"
+
+struct RawIQ {
+    uint8_t I;
+    uint8_t Q;
+};
+
+class MemoryOutput: public OutputBuffer<uint8_t>
+{
+public:
+    std::vector<uint8_t> data;
+    size_t write(tcb::span<const uint8_t> src) override {
+        data.insert(data.end(), src.begin(), src.end());
+        return src.size();
+    }
+};
+
+class MemoryInput: public InputBuffer<uint8_t>
+{
+private:
+    tcb::span<const uint8_t> m_data;
+public:
+    explicit MemoryInput(tcb::span<const uint8_t> data): m_data(data) {}
+    size_t read(tcb::span<uint8_t> dest) override {
+        const size_t length = std::min(dest.size(), m_data.size());
+        memcpy(dest.data(), m_data.data(), length);
+        m_data = m_data.subspan(length);
+        return length;
+    }
+};
+
+static std::vector<uint8_t> create_samples(const size_t nb_bytes) {
+    // slowly varying signal with noise so every codec mode is exercised
+    auto samples = std::vector<uint8_t>(nb_bytes);
+    uint32_t rng = 0x12345678;
+    for (size_t i = 0; i < nb_bytes; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        const int noise = int(rng % 9) - 4;
+        const int signal = int(64.0 * std::sin(double(i) * 0.01));
+        samples[i] = uint8_t(std::clamp(128 + signal + noise, 0, 255));
+    }
+    return samples;
+}
+
+static std::vector<uint8_t> compress(tcb::span<const uint8_t> raw, const size_t block_size, const uint8_t quantise_bits=0) {
+    auto output = std::make_shared<MemoryOutput>();
+    auto compressor = IQ_Compressor<uint8_t>(block_size, quantise_bits);
+    compressor.set_output_stream(output);
+    CHECK(compressor.write(raw) == raw.size());
+    CHECK(compressor.flush());
+    return output->data;
+}
+
+// read_view(...) must keep decoding across blocks until the request is filled
+// since readers treat a short view as the end of the stream
+template <typename T>
+static void test_read_view_across_blocks(const size_t block_size, const size_t request_size) {
+    const auto raw = create_samples(size_t(100'003)*sizeof(T));
+    const auto compressed = compress(raw, block_size);
+
+    auto decompressor = IQ_Decompressor<T>();
+    decompressor.set_input_stream(std::make_shared<MemoryInput>(compressed));
+    std::vector<uint8_t> decoded;
+    while (true) {
+        const auto view = decompressor.read_view(request_size);
+        CHECK(view.has_value());
+        if (!view.has_value()) break;
+        const auto bytes = tcb::span<const uint8_t>(reinterpret_cast<const uint8_t*>(view->data()), view->size_bytes());
+        decoded.insert(decoded.end(), bytes.begin(), bytes.end());
+        if (view->size() != request_size) break;
+    }
+    CHECK(!decompressor.get_is_error());
+    CHECK(decoded.size() == raw.size());
+    CHECK(decoded == raw);
+}
+
+static void test_read_across_blocks(const size_t block_size, const size_t request_size) {
+    const auto raw = create_samples(100'003);
+    const auto compressed = compress(raw, block_size);
+
+    auto decompressor = IQ_Decompressor<uint8_t>();
+    decompressor.set_input_stream(std::make_shared<MemoryInput>(compressed));
+    std::vector<uint8_t> decoded;
+    auto buf = std::vector<uint8_t>(request_size);
+    while (true) {
+        const size_t length = decompressor.read(buf);
+        decoded.insert(decoded.end(), buf.begin(), buf.begin() + length);
+        if (length != request_size) break;
+    }
+    CHECK(!decompressor.get_is_error());
+    CHECK(decoded == raw);
+}
+
+static std::vector<uint8_t> decompress(tcb::span<const uint8_t> compressed, bool& is_error) {
+    auto decompressor = IQ_Decompressor<uint8_t>();
+    decompressor.set_input_stream(std::make_shared<MemoryInput>(compressed));
+    std::vector<uint8_t> decoded;
+    auto buf = std::vector<uint8_t>(4096);
+    while (true) {
+        const size_t length = decompressor.read(buf);
+        decoded.insert(decoded.end(), buf.begin(), buf.begin() + length);
+        if (length != buf.size()) break;
+    }
+    is_error = decompressor.get_is_error();
+    return decoded;
+}
+
+// discarding k low bits reconstructs at the centre of the step so the error is at most 2^(k-1)
+static void test_near_lossless(const uint8_t quantise_bits) {
+    const auto raw = create_samples(100'003);
+    const auto compressed = compress(raw, 4096, quantise_bits);
+    CHECK(compressed.size() < raw.size());
+    bool is_error = false;
+    const auto decoded = decompress(compressed, is_error);
+    CHECK(!is_error);
+    CHECK(decoded.size() == raw.size());
+    if (decoded.size() != raw.size()) return;
+    const int max_error = 1 << (quantise_bits-1);
+    int peak_error = 0;
+    for (size_t i = 0; i < raw.size(); i++) {
+        peak_error = std::max(peak_error, std::abs(int(decoded[i]) - int(raw[i])));
+    }
+    CHECK(peak_error <= max_error);
+}
+
+static void test_corrupt_header() {
+    const auto raw = create_samples(10'000);
+    const auto compressed = compress(raw, 4096);
+    const auto check_corrupt = [](const std::vector<uint8_t>& data) {
+        bool is_error = false;
+        const auto decoded = decompress(data, is_error);
+        CHECK(is_error);
+        CHECK(decoded.empty());
+    };
+    // bad magic
+    auto data = compressed;
+    data[0] ^= 0xFF;
+    check_corrupt(data);
+    // raw size larger than any block the compressor produces
+    data = compressed;
+    iq_codec_write_u32(data.data()+4, 0xFFFFFFFF);
+    check_corrupt(data);
+    // payload larger than the raw block
+    data = compressed;
+    iq_codec_write_u32(data.data()+8, iq_codec_read_u32(data.data()+4) + 1);
+    check_corrupt(data);
+    // unknown mode
+    data = compressed;
+    data[12] = 0xFF;
+    check_corrupt(data);
+    // truncated header
+    data = std::vector<uint8_t>(compressed.begin(), compressed.begin() + IQ_CODEC_HEADER_SIZE/2);
+    check_corrupt(data);
+}
+
+int main(int /*argc*/, char** /*argv*/) {
+    // request sizes that don't line up with the block boundaries
+    test_read_view_across_blocks<uint8_t>(4096, 1000);
+    test_read_view_across_blocks<uint8_t>(4096, 65536);
+    test_read_view_across_blocks<RawIQ>(4096, 3001);
+    test_read_view_across_blocks<RawIQ>(1000, 1);
+    test_read_across_blocks(4096, 1000);
+    test_read_across_blocks(4096, 65536);
+    for (uint8_t quantise_bits = 1; quantise_bits <= 4; quantise_bits++) {
+        test_near_lossless(quantise_bits);
+    }
+    test_corrupt_header();
+    return get_test_result();
+}
@@ -0,0 +1,119 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <memory>
+#include <vector>
+#include <easylogging++.h>
+#include "basic_radio/basic_audio_channel.h"
+#include "basic_radio/basic_data_packet_channel.h"
+#include "basic_radio/basic_radio.h"
+#include "basic_radio/basic_radio_logging.h"
+#include "basic_radio/basic_slideshow.h"
+#include "dab/constants/dab_parameters.h"
+#include "dab/dab_logging.h"
+#include "ensemble/ensemble_config.h"
+#include "ensemble/ensemble_generator.h"
+#include "utility/allocation_tracker.h"
+#include "utility/span.h"
+#include "viterbi_config.h"
+#include "./test_helpers.h"
+
+INITIALIZE_ALLOCATION_TRACKER
+INITIALIZE_EASYLOGGINGPP
+
+// Channels and decoders are created in the first frames
+// The MOT processor then has to see more transport ids than it caches before it starts reusing their buffers
+// At 192kbps a slide takes about 5 frames so the warmup covers 30 slides
+constexpr int WARMUP_FRAMES = 150;
+// Covers a few more passes through the generator's carousel of 8 images
+constexpr int TOTAL_FRAMES = WARMUP_FRAMES + 100;
+
+static EnsembleConfig create_config() {
+    EnsembleConfig config;
+    config.label = "Allocations";
+    config.services.push_back({ EnsembleServiceType::DAB_PLUS, 48, "Alloc AAC" });
+    config.services.push_back({ EnsembleServiceType::DAB, 64, "Alloc MP2" });
+    config.services.push_back({ EnsembleServiceType::DATA, 192, "Alloc Slides" });
+    return config;
+}
+
+struct RadioStats {
+    int total_audio_channels = 0;
+    int total_data_channels = 0;
+    int total_audio_frames = 0;
+    int total_new_slideshows = 0;
+};
+
+int main(int /*argc*/, char** /*argv*/) {
+    // formatting log messages allocates
+    get_dab_logging_enabled() = false;
+    get_basic_radio_logging_enabled() = false;
+
+    const auto config = create_config();
+    const auto params = get_dab_parameters(config.transmission_mode);
+    auto generator = EnsembleGenerator(config);
+    auto radio = std::make_unique<BasicRadio>(params, 1);
+
+    // Listeners only count so they don't allocate themselves
+    RadioStats stats;
+    radio->On_Audio_Channel().Attach([&stats](subchannel_id_t /*id*/, Basic_Audio_Channel& channel) {
+        stats.total_audio_channels++;
+        auto& controls = channel.GetControls();
+        controls.SetIsDecodeAudio(true);
+        controls.SetIsDecodeData(true);
+        controls.SetIsPlayAudio(true);
+        channel.OnAudioData().Attach([&stats](const BasicAudioParams& /*params*/, tcb::span<const uint8_t> /*buf*/) {
+            stats.total_audio_frames++;
+        });
+    });
+    radio->On_Data_Packet_Channel().Attach([&stats](subchannel_id_t /*id*/, Basic_Data_Packet_Channel& channel) {
+        stats.total_data_channels++;
+        channel.GetSlideshowManager().OnNewSlideshow().Attach([&stats](const std::shared_ptr<Basic_Slideshow>& /*slideshow*/) {
+            stats.total_new_slideshows++;
+        });
+    });
+
+    // The generator allocates while building frames so only the radio is measured
+    auto frame_bits = std::vector<uint8_t>(generator.get_nb_frame_bits());
+    auto soft_bits = std::vector<viterbi_bit_t>(frame_bits.size());
+    int total_frames_with_allocations = 0;
+    uint64_t total_steady_allocations = 0;
+    for (int frame = 0; frame < TOTAL_FRAMES; frame++) {
+        generator.generate_frame(frame_bits);
+        for (size_t i = 0; i < frame_bits.size(); i++) {
+            soft_bits[i] = frame_bits[i] ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+        }
+        // the thread pool is idle between frames so every allocation in this window comes from decoding
+        const uint64_t start_allocations = AllocationTracker::get_global_stats().total_allocations;
+        radio->Process(soft_bits);
+        const uint64_t end_allocations = AllocationTracker::get_global_stats().total_allocations;
+        if (frame < WARMUP_FRAMES) continue;
+        const uint64_t total_allocations = end_allocations - start_allocations;
+        total_steady_allocations += total_allocations;
+        if (total_allocations > 0) {
+            total_frames_with_allocations++;
+            fprintf(stderr, "frame %d allocated %llu times\n", frame, static_cast<unsigned long long>(total_allocations));
+        }
+    }
+
+    // the decoders actually ran
+    CHECK(stats.total_audio_channels == 2);
+    CHECK(stats.total_data_channels == 1);
+    CHECK(stats.total_audio_frames > 0);
+    // each image in the carousel is only new the first time it is received
+    CHECK(stats.total_new_slideshows == 8);
+    auto* data_channel = radio->Get_Data_Packet_Channel(2);
+    CHECK(data_channel != nullptr);
+    if (data_channel != nullptr) {
+        auto& slideshow_manager = data_channel->GetSlideshowManager();
+        auto lock = std::unique_lock(slideshow_manager.GetSlideshowsMutex());
+        CHECK(slideshow_manager.GetSlideshows().size() == 8);
+    }
+
+    CHECK(total_frames_with_allocations == 0);
+    CHECK(total_steady_allocations == 0);
+    fprintf(stderr, "steady state allocations: %llu in %d/%d frames after %d warmup frames\n",
+        static_cast<unsigned long long>(total_steady_allocations), total_frames_with_allocations,
+        TOTAL_FRAMES-WARMUP_FRAMES, WARMUP_FRAMES);
+    return get_test_result();
+}